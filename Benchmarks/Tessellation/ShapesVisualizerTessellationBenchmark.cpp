@@ -0,0 +1,146 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerTessellation.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+//
+// ShapesVisualizerTessellationBenchmark - vertices, indices and triangles per second of every shape
+//
+// Runs ShapesVisualizerTessellation without the engine, so it needs neither a GPU nor Unreal. Every shape is
+// tessellated with 8 to 64 sides into buffers sized by GetShapeCounts, the written counts are checked against
+// them and every index against the vertex count. Heap allocations are counted by the global operator new
+// around the timed calls. --quick runs a short pass for the test runner, the exit code is 1 on any mismatch.
+//
+
+using namespace ShapesVisualizerTessellation;
+
+//
+// Internal functions
+//
+
+namespace
+{
+    size_t NumAllocations_Internal = 0;
+
+    const char* const ShapeNames_Internal[] = { "Sphere", "HalfSphere", "Box", "Cylinder", "Cone", "Capsule" };
+
+    struct FResult_Internal
+    {
+        FCounts Counts;
+        double Seconds = 0.0;
+        size_t Calls = 0;
+        size_t Allocations = 0;
+        bool Valid = true;
+    };
+
+    FResult_Internal Run_Internal(EShape Shape, int32_t NumSides, double MinSeconds)
+    {
+        using FClock = std::chrono::steady_clock;
+
+        FResult_Internal Result;
+        Result.Counts = GetShapeCounts(Shape, NumSides);
+        std::vector<FVertex> Vertices(Result.Counts.NumVertices);
+        std::vector<uint32_t> Indices(Result.Counts.NumIndices);
+        const float Extent[3] = { 50.f, 50.f, 50.f };
+
+        const FCounts Written = TessellateShape(Shape, 50.f, 100.f, Extent, NumSides, Vertices.data(), Indices.data());
+        Result.Valid = Written.NumVertices == Result.Counts.NumVertices && Written.NumIndices == Result.Counts.NumIndices
+            && Written.NumIndices % 3 == 0;
+        for (const uint32_t Index : Indices)
+            Result.Valid &= Index < Written.NumVertices;
+
+        // Batches of calls between the clock reads, so reading the clock stays out of the numbers
+        const size_t StartAllocations = NumAllocations_Internal;
+        const FClock::time_point StartTime = FClock::now();
+        size_t BatchSize = 16;
+        do
+        {
+            for (size_t Call = 0; Call < BatchSize; Call++)
+                TessellateShape(Shape, 50.f, 100.f, Extent, NumSides, Vertices.data(), Indices.data());
+            Result.Calls += BatchSize;
+            BatchSize *= 2;
+            Result.Seconds = std::chrono::duration<double>(FClock::now() - StartTime).count();
+        } while (Result.Seconds < MinSeconds);
+        Result.Allocations = NumAllocations_Internal - StartAllocations;
+        return Result;
+    }
+}
+
+//
+// Allocation counting
+//
+
+void* operator new(size_t Size)
+{
+    NumAllocations_Internal++;
+    if (void* const Memory = std::malloc(Size ? Size : 1))
+        return Memory;
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t Size)
+{
+    return operator new(Size);
+}
+
+void operator delete(void* Memory) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete[](void* Memory) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete[](void* Memory, size_t) noexcept
+{
+    std::free(Memory);
+}
+
+//
+// Entry point
+//
+
+int main(int Argc, char** Argv)
+{
+    const bool Quick = Argc > 1 && std::strcmp(Argv[1], "--quick") == 0;
+    const double MinSeconds = Quick ? 0.005 : 0.25;
+
+    std::printf("%-10s %5s %8s %8s %14s %14s %14s %12s\n",
+        "Shape", "Sides", "Verts", "Indices", "MVerts/s", "MIndices/s", "MTris/s", "Allocs/call");
+
+    bool Valid = true;
+    for (int32_t ShapeIndex = 0; ShapeIndex <= static_cast<int32_t>(EShape::Capsule); ShapeIndex++)
+    {
+        const EShape Shape = static_cast<EShape>(ShapeIndex);
+        for (int32_t NumSides = 8; NumSides <= MaxSides; NumSides += 8)
+        {
+            const FResult_Internal Result = Run_Internal(Shape, NumSides, MinSeconds);
+            const double Calls = static_cast<double>(Result.Calls);
+            std::printf("%-10s %5d %8u %8u %14.1f %14.1f %14.1f %12.2f%s\n",
+                ShapeNames_Internal[ShapeIndex], NumSides, Result.Counts.NumVertices, Result.Counts.NumIndices,
+                Result.Counts.NumVertices * Calls / Result.Seconds * 1e-6,
+                Result.Counts.NumIndices * Calls / Result.Seconds * 1e-6,
+                Result.Counts.NumIndices / 3 * Calls / Result.Seconds * 1e-6,
+                Result.Allocations / Calls,
+                Result.Valid ? "" : "  COUNTS MISMATCH");
+            Valid &= Result.Valid && Result.Allocations == 0;
+
+            // Box does not depend on the number of sides
+            if (Shape == EShape::Box)
+                break;
+        }
+    }
+    return Valid ? 0 : 1;
+}
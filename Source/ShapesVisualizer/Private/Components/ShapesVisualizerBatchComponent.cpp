@@ -0,0 +1,794 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/CollisionProfile.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialRenderProxy.h"
+#include "PrimitiveSceneProxy.h"
+#include "SceneManagement.h"
+#include "RenderingThread.h"
+#include "Serialization/CustomVersion.h"
+#include "Containers/Ticker.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "ShapesVisualizerBatchMesh.h"
+#include "ShapesVisualizerBudget.h"
+#include "ShapesVisualizerDrawing.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerLineMeshes.h"
+#include "ShapesVisualizerMaterialCache.h"
+#include "ShapesVisualizerStats.h"
+
+//
+// Internal functions
+//
+
+namespace
+{
+    constexpr int32 NumSizedShapes_Internal = static_cast<int32>(EVisualShape::Capsule) + 1;
+
+    FORCEINLINE bool IsSizedShape_Internal(EVisualShape Shape)
+    {
+        return static_cast<int32>(Shape) < NumSizedShapes_Internal;
+    }
+
+    // Batch shapes are saved with the component since SerializedShapes
+    struct FBatchVersion_Internal
+    {
+        enum Type
+        {
+            Initial = 0,
+            SerializedShapes,
+            LatestVersion = SerializedShapes
+        };
+
+        static const FGuid GUID;
+    };
+
+    const FGuid FBatchVersion_Internal::GUID{ 0x6B1F2C47, 0x93A54E08, 0xB7D1C2E9, 0x5F48A3D6 };
+    FCustomVersionRegistration GRegisterBatchVersion_Internal{ FBatchVersion_Internal::GUID,
+        FBatchVersion_Internal::LatestVersion, TEXT("ShapesVisualizerBatch") };
+}
+
+//
+// FShapesVisualizerBatchArrays
+//
+
+void FShapesVisualizerBatchArrays::Set(int32 Index, const FShapesVisualizerBatchShape& InShape)
+{
+    if (Index >= Num())
+    {
+        const int32 NewNum = Index + 1;
+        Shapes.SetNum(NewNum);
+        Transforms.SetNum(NewNum);
+        Radii.SetNum(NewNum);
+        Heights.SetNum(NewNum);
+        Extents.SetNum(NewNum);
+        Colors.SetNum(NewNum);
+        Flags.SetNumZeroed(NewNum);
+    }
+
+    Shapes[Index] = InShape.Shape;
+    Transforms[Index] = InShape.Transform;
+    Radii[Index] = InShape.Radii;
+    Heights[Index] = InShape.Height;
+    Extents[Index] = InShape.Extent;
+    Colors[Index] = InShape.Color;
+    // Half sphere has no wireframe mode
+    Flags[Index] = FlagUsed
+        | (InShape.Wireframe && InShape.Shape != EVisualShape::HalfSphere ? FlagWireframe : 0);
+}
+
+void FShapesVisualizerBatchArrays::Clear(int32 Index)
+{
+    if (Index < Num())
+        Flags[Index] = 0;
+}
+
+void FShapesVisualizerBatchArrays::Empty()
+{
+    Shapes.Empty();
+    Transforms.Empty();
+    Radii.Empty();
+    Heights.Empty();
+    Extents.Empty();
+    Colors.Empty();
+    Flags.Empty();
+}
+
+void FShapesVisualizerBatchArrays::Reset()
+{
+    Shapes.Reset();
+    Transforms.Reset();
+    Radii.Reset();
+    Heights.Reset();
+    Extents.Reset();
+    Colors.Reset();
+    Flags.Reset();
+}
+
+void FShapesVisualizerBatchArrays::CopyFrom(const FShapesVisualizerBatchArrays& Other)
+{
+    // Reset and Append keep the memory, unlike the assignment
+    Reset();
+    Shapes.Append(Other.Shapes);
+    Transforms.Append(Other.Transforms);
+    Radii.Append(Other.Radii);
+    Heights.Append(Other.Heights);
+    Extents.Append(Other.Extents);
+    Colors.Append(Other.Colors);
+    Flags.Append(Other.Flags);
+}
+
+void FShapesVisualizerBatchArrays::Serialize(FArchive& Ar)
+{
+    Ar << Shapes;
+    Ar << Transforms;
+    Ar << Radii;
+    Ar << Heights;
+    Ar << Extents;
+    Ar << Colors;
+    Ar << Flags;
+
+    // Arrays of different sizes would index past each other
+    const int32 NumSlots = Shapes.Num();
+    if (Ar.IsLoading() && (Transforms.Num() != NumSlots || Radii.Num() != NumSlots || Heights.Num() != NumSlots
+        || Extents.Num() != NumSlots || Colors.Num() != NumSlots || Flags.Num() != NumSlots))
+    {
+        Ar.SetError();
+        Empty();
+    }
+}
+
+FBox FShapesVisualizerBatchArrays::GetShapeBox(int32 Index) const
+{
+    return ShapesVisualizerDrawing::GetShapeBox(Shapes[Index], Radii[Index], Heights[Index], Extents[Index])
+        .TransformBy(Transforms[Index]);
+}
+
+SIZE_T FShapesVisualizerBatchArrays::GetAllocatedSize() const
+{
+    return Shapes.GetAllocatedSize() + Transforms.GetAllocatedSize()
+        + Radii.GetAllocatedSize() + Heights.GetAllocatedSize() + Extents.GetAllocatedSize()
+        + Colors.GetAllocatedSize() + Flags.GetAllocatedSize();
+}
+
+//
+// FShapesVisualizerBatchSceneProxy
+//
+
+class FShapesVisualizerBatchSceneProxy : public FPrimitiveSceneProxy
+{
+public:
+
+    FShapesVisualizerBatchSceneProxy(const UShapesVisualizerBatchComponent* InComponent)
+        : FPrimitiveSceneProxy(InComponent)
+        , Batch(InComponent->GetBatchArrays())
+        , LineThickness(InComponent->LineThickness)
+        , NumSides(FMath::Clamp(InComponent->NumSides, 8, 64))
+        , ShowOnlyWhenSelected(InComponent->ShowOnlyWhenSelected)
+        , Priority(InComponent->Priority)
+        , BatchMesh(GetScene().GetFeatureLevel())
+        , LineMeshes(GetScene().GetFeatureLevel())
+    {
+        bWantsSelectionOutline = InComponent->WantsSelectionOutline;
+        ShapesVisualizerStats::AddBatchProxy();
+    }
+
+    virtual ~FShapesVisualizerBatchSceneProxy() override
+    {
+        ShapesVisualizerStats::RemoveBatchProxy();
+        ShapesVisualizerStats::AddBatchMemory(-static_cast<int64>(StatMemoryBytes));
+        BatchMesh.Release();
+    }
+
+    virtual SIZE_T GetTypeHash() const override
+    {
+        static size_t UniquePointer;
+        return reinterpret_cast<size_t>(&UniquePointer);
+    }
+
+    virtual void CreateRenderThreadResources() override
+    {
+        BuildBatchMesh();
+    }
+
+    // Shape updates, the component sends only the changed slot. The merged mesh
+    // is rebuilt once per frame by UpdateBatchMesh_RenderThread
+
+    void SetShape_RenderThread(int32 Index, const FShapesVisualizerBatchShape& InShape)
+    {
+        Batch.Set(Index, InShape);
+        BatchMeshDirty = true;
+    }
+
+    void ClearShape_RenderThread(int32 Index)
+    {
+        Batch.Clear(Index);
+        BatchMeshDirty = true;
+    }
+
+    // Takes the arrays of the snapshot and leaves the old ones in it, the game thread refills them later
+    void SetShapes_RenderThread(FShapesVisualizerBatchArrays& InOutBatch)
+    {
+        Swap(Batch, InOutBatch);
+        BatchMeshDirty = true;
+    }
+
+    void UpdateBatchMesh_RenderThread()
+    {
+        if (BatchMeshDirty)
+            BuildBatchMesh();
+    }
+
+    virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views,
+        const FSceneViewFamily& ViewFamily, uint32 VisibilityMap,
+        FMeshElementCollector& Collector) const override
+    {
+        SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_GetDynamicMeshElements);
+        SHAPESVISUALIZER_COUNT_ALLOCATIONS(true);
+
+        const FMatrix& LTW = GetLocalToWorld();
+        const FBoxSphereBounds& WorldBounds = GetBounds();
+        const FBoxSphereBounds& LocalBounds = GetLocalBounds();
+        FShapesVisualizerFrameStats FrameStats;
+
+        // The whole batch is one proxy of the budget
+        const uint32 StartCycles = FPlatformTime::Cycles();
+        const bool WithinBudget = BudgetState.TryDraw(ViewFamily.FrameNumber, Priority, IsSelected(),
+            ShapesVisualizerDrawing::GetMaxScreenRadius(Views, VisibilityMap, WorldBounds));
+
+        if (WithinBudget)
+        {
+            // Entry spheres and the transforms of the thick wireframes do not depend on the view
+            const TArray<FSphere>& EntrySpheres = BatchMesh.GetEntrySpheres();
+            TArray<FSphere>& WorldSpheres = ScratchWorldSpheres;
+            WorldSpheres.SetNumUninitialized(EntrySpheres.Num(), false);
+            const float MaxScale = LTW.GetMaximumAxisScale();
+            ShapesVisualizerGeometry::ParallelForChunks(EntrySpheres.Num(), [&](int32 StartIndex, int32 EndIndex)
+            {
+                for (int32 Index = StartIndex; Index < EndIndex; Index++)
+                    WorldSpheres[Index] = FSphere{ LTW.TransformPosition(EntrySpheres[Index].Center), EntrySpheres[Index].W * MaxScale };
+            });
+
+            TArray<FMatrix>& ShapesToWorld = ScratchShapesToWorld;
+            ShapesToWorld.SetNumUninitialized(BatchMesh.GetNumThickShapes() > 0 ? Batch.Num() : 0, false);
+            ShapesVisualizerGeometry::ParallelForChunks(ShapesToWorld.Num(), [&](int32 StartIndex, int32 EndIndex)
+            {
+                for (int32 Index = StartIndex; Index < EndIndex; Index++)
+                {
+                    if (Batch.IsUsed(Index) && Batch.IsWireframe(Index))
+                        ShapesToWorld[Index] = Batch.Transforms[Index].ToMatrixWithScale() * LTW;
+                }
+            });
+        }
+
+        for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+        {
+            if (!(VisibilityMap & (1 << ViewIndex)) || !WithinBudget)
+                continue;
+
+            const FSceneView& View = *Views[ViewIndex];
+
+            // LOD of every entry on the task graph, the draws below only read them
+            TArray<uint8>& EntryLODs = ScratchEntryLODs;
+            EntryLODs.SetNumUninitialized(ScratchWorldSpheres.Num(), false);
+            for (int32 GroupIndex = 0; GroupIndex < BatchMesh.NumGroups(); GroupIndex++)
+            {
+                const FShapesVisualizerBatchMesh::FGroup& Group = BatchMesh.GetGroup(GroupIndex);
+                ShapesVisualizerGeometry::ParallelForChunks(Group.NumEntries, [&](int32 StartIndex, int32 EndIndex)
+                {
+                    for (int32 Index = Group.FirstEntry + StartIndex; Index < Group.FirstEntry + EndIndex; Index++)
+                    {
+                        const FSphere& WorldSphere = ScratchWorldSpheres[Index];
+                        const int32 ViewSides = ShapesVisualizerDrawing::GetViewSides(
+                            ShapesVisualizerDrawing::GetScreenRadius(View, WorldSphere.Center, WorldSphere.W), NumSides);
+                        EntryLODs[Index] = ViewSides == 0 ? CulledLOD : static_cast<uint8>(BatchMesh.GetEntryLOD(Group, ViewSides));
+                    }
+                });
+            }
+
+            // Colors are in the vertices, only selected line groups take the selection color of the view
+            const bool Outline = WantsSelectionOutline() && (IsSelected() || IsHovered());
+            const FMaterialRenderProxy* const VertexColorMaterial = GEngine->VertexColorMaterial->GetRenderProxy();
+            const FMaterialRenderProxy* const OutlineMaterial = Outline
+                ? Materials.Get(GEngine->WireframeMaterial->GetRenderProxy(),
+                    GetViewSelectionColor(FLinearColor::White, View, IsSelected(), IsHovered(), false, IsIndividuallySelected()),
+                    ViewFamily.FrameNumber)
+                : nullptr;
+
+            // One draw per run of entries of the same LOD
+            for (int32 GroupIndex = 0; GroupIndex < BatchMesh.NumGroups(); GroupIndex++)
+            {
+                const FShapesVisualizerBatchMesh::FGroup& Group = BatchMesh.GetGroup(GroupIndex);
+                const FMaterialRenderProxy* const GroupMaterial = Group.Lines && Outline ? OutlineMaterial : VertexColorMaterial;
+
+                int32 RunStart = Group.FirstEntry;
+                const int32 GroupEnd = Group.FirstEntry + Group.NumEntries;
+                for (int32 Index = Group.FirstEntry + 1; Index <= GroupEnd; Index++)
+                {
+                    if (Index < GroupEnd && EntryLODs[Index] == EntryLODs[RunStart])
+                        continue;
+
+                    const uint8 LODIndex = EntryLODs[RunStart];
+                    if (LODIndex != CulledLOD)
+                    {
+                        const int32 IndicesPerEntry = Group.IndicesPerEntry[LODIndex];
+                        FrameStats.AddPrimitives(Group.Shape, Group.Lines, ShapesVisualizerDrawing::GetMeshBuffers(*Group.Buffers[LODIndex], LTW,
+                            WorldBounds, LocalBounds, GroupMaterial, SDPG_World, ViewIndex, Collector,
+                            (RunStart - Group.FirstEntry) * IndicesPerEntry, (Index - RunStart) * IndicesPerEntry));
+                    }
+                    RunStart = Index;
+                }
+            }
+
+            // Thick wireframes of all shapes are quads of one mesh per view
+            if (BatchMesh.GetNumThickShapes() > 0)
+            {
+                TArray<FVector>& LineVerts = ScratchLineVerts;
+                TArray<FColor>& LineColors = ScratchLineColors;
+                LineVerts.Reset();
+                LineColors.Reset();
+                for (int32 Index = 0; Index < Batch.Num(); Index++)
+                {
+                    if (!Batch.IsUsed(Index) || !Batch.IsWireframe(Index))
+                        continue;
+
+                    const EVisualShape Shape = Batch.Shapes[Index];
+                    const FMatrix& ShapeToWorld = ScratchShapesToWorld[Index];
+                    const FBox ShapeBox = ShapesVisualizerDrawing::GetShapeBox(Shape, Batch.Radii[Index], Batch.Heights[Index], Batch.Extents[Index]);
+                    const int32 ViewSides = ShapesVisualizerDrawing::GetViewSides(ShapesVisualizerDrawing::GetScreenRadius(View,
+                        ShapeToWorld.TransformPosition(ShapeBox.GetCenter()),
+                        ShapeBox.GetExtent().Size() * ShapeToWorld.GetMaximumAxisScale()), NumSides);
+                    if (ViewSides == 0)
+                        continue;
+
+                    const FColor Color = GetViewSelectionColor(Batch.Colors[Index], View,
+                        Outline ? IsSelected() : false, Outline ? IsHovered() : false,
+                        false, IsIndividuallySelected()).ToFColor(true);
+                    const int32 NumLines = ShapesVisualizerDrawing::AddWireLines(Shape, Batch.Radii[Index], Batch.Heights[Index], Batch.Extents[Index],
+                        ShapeToWorld, ViewSides, LineVerts);
+                    LineColors.Reserve(LineColors.Num() + NumLines);
+                    for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+                        LineColors.Add(Color);
+                    FrameStats.AddPrimitives(Shape, true, NumLines);
+                }
+                LineMeshes.DrawLines(View, LineVerts, LineColors, LineThickness, WorldBounds, SDPG_World, ViewIndex, Collector);
+            }
+        }
+
+        if (WithinBudget)
+            BudgetState.EndDraw(FrameStats.GetNumPrimitives(), StartCycles);
+
+        FrameStats.Flush();
+    }
+
+    virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+    {
+        FPrimitiveViewRelevance Result;
+        Result.bDrawRelevance = IsShown(View) && (!ShowOnlyWhenSelected || IsSelected());
+        Result.bDynamicRelevance = true;
+        Result.bShadowRelevance = IsShadowCast(View);
+        Result.bEditorPrimitiveRelevance = UseEditorCompositing(View);
+        Result.bSeparateTranslucency = Result.bNormalTranslucency = IsShown(View);
+        return Result;
+    }
+
+    virtual uint32 GetMemoryFootprint(void) const override
+    {
+        return sizeof(*this) + GetAllocatedSize() + Batch.GetAllocatedSize() + BatchMesh.GetAllocatedSize() + Materials.GetAllocatedSize()
+            + ScratchWorldSpheres.GetAllocatedSize() + ScratchShapesToWorld.GetAllocatedSize() + ScratchEntryLODs.GetAllocatedSize()
+            + ScratchLineVerts.GetAllocatedSize() + ScratchLineColors.GetAllocatedSize() + LineMeshes.GetAllocatedSize();
+    }
+
+private:
+
+    static constexpr uint8 CulledLOD = MAX_uint8;
+
+    void BuildBatchMesh()
+    {
+        // Thin wireframes are merged into line meshes, thick ones are built as view quads every frame
+        BatchMesh.Build(Batch, NumSides, LineThickness <= 0.f);
+        BatchMeshDirty = false;
+
+        // Every change of the batch ends here, so the memory is counted at creation and per changed frame
+        const uint32 MemoryBytes = GetMemoryFootprint();
+        ShapesVisualizerStats::AddBatchMemory(static_cast<int64>(MemoryBytes) - StatMemoryBytes);
+        StatMemoryBytes = MemoryBytes;
+    }
+
+private:
+
+    FShapesVisualizerBatchArrays Batch;
+    float LineThickness;
+    int32 NumSides;
+    bool ShowOnlyWhenSelected;
+    int32 Priority;
+    // Shapes merged per shape type and LOD, rebuilt after the batch changed
+    FShapesVisualizerBatchMesh BatchMesh;
+    bool BatchMeshDirty = false;
+    // Colored materials and per frame scratch buffers, GetDynamicMeshElements of one proxy never runs concurrently
+    mutable FShapesVisualizerMaterialCache Materials;
+    mutable TArray<FSphere> ScratchWorldSpheres;
+    mutable TArray<FMatrix> ScratchShapesToWorld;
+    mutable TArray<uint8> ScratchEntryLODs;
+    mutable TArray<FVector> ScratchLineVerts;
+    mutable TArray<FColor> ScratchLineColors;
+    // Thick wireframes of the views, rewritten in place by the next frames
+    mutable FShapesVisualizerLineMeshes LineMeshes;
+    // Memory footprint last added to the stats
+    uint32 StatMemoryBytes = 0;
+    // Frame budget shared by all proxies
+    mutable FShapesVisualizerBudget::FProxyState BudgetState;
+};
+
+//
+// Shape updates
+//
+
+namespace
+{
+    // Runs the command on the existing proxy, false when the proxy is missing or about to be recreated
+    template <typename CommandType>
+    bool EnqueueBatchCommand_Internal(UShapesVisualizerBatchComponent* Component, CommandType&& Command)
+    {
+        FShapesVisualizerBatchSceneProxy* const Proxy = static_cast<FShapesVisualizerBatchSceneProxy*>(Component->SceneProxy);
+        if (!Proxy || Component->IsRenderStateDirty())
+            return false;
+
+        ENQUEUE_RENDER_COMMAND(ShapesVisualizerUpdateBatch)(
+            [Proxy, Command = MoveTemp(Command)](FRHICommandListImmediate& RHICmdList) mutable
+            {
+                Command(Proxy);
+            });
+        return true;
+    }
+}
+
+//
+// UShapesVisualizerBatchComponent
+//
+
+UShapesVisualizerBatchComponent::UShapesVisualizerBatchComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    // Tick
+    PrimaryComponentTick.bCanEverTick = false;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+
+    // Collision & Navigation
+    SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+    SetGenerateOverlapEvents(false);
+    CanCharacterStepUpOn = ECB_No;
+    SetCanEverAffectNavigation(false);
+
+    // Rendering
+    SetHiddenInGame(true);
+    SetCastShadow(false);
+    SetReceivesDecals(false);
+}
+
+void UShapesVisualizerBatchComponent::Serialize(FArchive& Ar)
+{
+    Super::Serialize(Ar);
+
+    Ar.UsingCustomVersion(FBatchVersion_Internal::GUID);
+    if (Ar.IsLoading() && Ar.CustomVer(FBatchVersion_Internal::GUID) < FBatchVersion_Internal::SerializedShapes)
+        return;
+
+    Batch.Serialize(Ar);
+    if (Ar.IsLoading())
+    {
+        // Handles are not saved, every loaded shape starts a new serial
+        Serials.Reset();
+        RebuildSlots();
+    }
+}
+
+void UShapesVisualizerBatchComponent::OnRegister()
+{
+    ShapesBox.Init();
+    for (int32 Index = 0; Index < Batch.Num(); Index++)
+    {
+        if (Batch.IsUsed(Index))
+            ShapesBox += Batch.GetShapeBox(Index);
+    }
+    Super::OnRegister();
+}
+
+FPrimitiveSceneProxy* UShapesVisualizerBatchComponent::CreateSceneProxy()
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_CreateSceneProxy);
+    return new FShapesVisualizerBatchSceneProxy(this);
+}
+
+FBoxSphereBounds UShapesVisualizerBatchComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_CalcBounds);
+    if (!ShapesBox.IsValid)
+        return FBoxSphereBounds{ LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f };
+    return FBoxSphereBounds{ ShapesBox }.TransformBy(LocalToWorld);
+}
+
+void UShapesVisualizerBatchComponent::GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials) const
+{
+    Super::GetUsedMaterials(OutMaterials, bGetDebugMaterials);
+    if (GEngine && GEngine->DebugMeshMaterial)
+        OutMaterials.Add(GEngine->DebugMeshMaterial);
+    if (GEngine && GEngine->WireframeMaterial)
+        OutMaterials.Add(GEngine->WireframeMaterial);
+    if (GEngine && GEngine->VertexColorMaterial)
+        OutMaterials.Add(GEngine->VertexColorMaterial);
+}
+
+void UShapesVisualizerBatchComponent::SendRenderDynamicData_Concurrent()
+{
+    Super::SendRenderDynamicData_Concurrent();
+
+    FShapesVisualizerBatchSceneProxy* const Proxy = static_cast<FShapesVisualizerBatchSceneProxy*>(SceneProxy);
+    if (!Proxy)
+        return;
+
+    ENQUEUE_RENDER_COMMAND(ShapesVisualizerUpdateBatchMesh)(
+        [Proxy](FRHICommandListImmediate& RHICmdList)
+        {
+            Proxy->UpdateBatchMesh_RenderThread();
+        });
+}
+
+//
+// Shapes
+//
+
+FShapesVisualizerBatchHandle UShapesVisualizerBatchComponent::AddShape(const FShapesVisualizerBatchShape& InShape)
+{
+    if (!IsSizedShape_Internal(InShape.Shape))
+        return FShapesVisualizerBatchHandle{};
+
+    FShapesVisualizerBatchHandle Handle;
+    Handle.Index = FreeSlots.Num() > 0 ? FreeSlots.Pop(false) : Serials.Add(0);
+    Handle.Serial = Serials[Handle.Index];
+
+    Batch.Set(Handle.Index, InShape);
+    NumShapes++;
+
+    const FBox OldBox = ShapesBox;
+    ShapesBox += Batch.GetShapeBox(Handle.Index);
+
+    const bool Sent = SendShape(Handle.Index, &InShape);
+    OnShapesChanged(Sent, !(ShapesBox == OldBox));
+    return Handle;
+}
+
+bool UShapesVisualizerBatchComponent::UpdateShape(const FShapesVisualizerBatchHandle& Handle, const FShapesVisualizerBatchShape& InShape)
+{
+    if (!IsValidHandle(Handle) || !IsSizedShape_Internal(InShape.Shape))
+        return false;
+
+    // Bounds stay conservative until the component is registered again
+    Batch.Set(Handle.Index, InShape);
+
+    const FBox OldBox = ShapesBox;
+    ShapesBox += Batch.GetShapeBox(Handle.Index);
+
+    const bool Sent = SendShape(Handle.Index, &InShape);
+    OnShapesChanged(Sent, !(ShapesBox == OldBox));
+    return true;
+}
+
+bool UShapesVisualizerBatchComponent::RemoveShape(const FShapesVisualizerBatchHandle& Handle)
+{
+    if (!IsValidHandle(Handle))
+        return false;
+
+    Batch.Clear(Handle.Index);
+    Serials[Handle.Index]++;
+    FreeSlots.Add(Handle.Index);
+    NumShapes--;
+
+    const bool Sent = SendShape(Handle.Index, nullptr);
+    OnShapesChanged(Sent, false);
+    return true;
+}
+
+void UShapesVisualizerBatchComponent::SetPriority(int32 InPriority)
+{
+    Priority = InPriority;
+    MarkRenderStateDirty();
+}
+
+void UShapesVisualizerBatchComponent::ClearShapes()
+{
+    // Serials survive, so the old handles stay invalid
+    for (int32 Index = 0; Index < Batch.Num(); Index++)
+    {
+        if (Batch.IsUsed(Index))
+            Serials[Index]++;
+    }
+
+    Batch.Empty();
+    FreeSlots.Reset();
+    for (int32 Index = Serials.Num() - 1; Index >= 0; Index--)
+        FreeSlots.Add(Index);
+    NumShapes = 0;
+    ShapesBox.Init();
+    // The new proxy gets the whole batch
+    PendingShapes.Reset();
+
+    UpdateBounds();
+    MarkRenderStateDirty();
+}
+
+void UShapesVisualizerBatchComponent::SetShapes(FShapesVisualizerBatchArrays& InOutShapes)
+{
+    // Serials survive, so the old handles stay invalid
+    for (int32 Index = 0; Index < Batch.Num(); Index++)
+    {
+        if (Batch.IsUsed(Index))
+            Serials[Index]++;
+    }
+
+    Swap(Batch, InOutShapes);
+    const FBox OldBox = ShapesBox;
+    RebuildSlots();
+    PendingShapes.Reset();
+
+    // Without a free snapshot the proxy keeps the old shapes until the core ticker finds one
+    bool Sent = false;
+    if (!SendSnapshot(Sent))
+    {
+        if (!SnapshotPending)
+        {
+            SnapshotPending = true;
+#if ENGINE_MAJOR_VERSION == 5
+            FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float DeltaTime)
+#else
+            FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float DeltaTime)
+#endif
+            {
+                // A later SetShapes may have sent the batch already
+                bool SnapshotSent = false;
+                if (SnapshotPending && !SendSnapshot(SnapshotSent))
+                    return true;
+                if (SnapshotPending && !SnapshotSent)
+                    MarkRenderStateDirty();
+                SnapshotPending = false;
+                return false;
+            }));
+        }
+        Sent = true;
+    }
+    else
+        SnapshotPending = false;
+
+    OnShapesChanged(Sent, !(ShapesBox == OldBox));
+}
+
+bool UShapesVisualizerBatchComponent::SendSnapshot(bool& OutSent)
+{
+    // A snapshot is free once the render thread has swapped it, the fence is checked but never waited for
+    int32 SnapshotIndex = INDEX_NONE;
+    for (int32 Index = 0; Index < UE_ARRAY_COUNT(Snapshots) && SnapshotIndex == INDEX_NONE; Index++)
+    {
+        if (SnapshotFences[Index].IsFenceComplete())
+            SnapshotIndex = Index;
+    }
+    if (SnapshotIndex == INDEX_NONE)
+        return false;
+
+    // The only copy of the batch per update, the proxy swaps the arrays with its own
+    FShapesVisualizerBatchArrays* const Snapshot = &Snapshots[SnapshotIndex];
+    Snapshot->CopyFrom(Batch);
+    OutSent = EnqueueBatchCommand_Internal(this,
+        [Snapshot](FShapesVisualizerBatchSceneProxy* Proxy)
+        {
+            Proxy->SetShapes_RenderThread(*Snapshot);
+        });
+    if (OutSent)
+        SnapshotFences[SnapshotIndex].BeginFence();
+    return true;
+}
+
+void UShapesVisualizerBatchComponent::BeginUpdate()
+{
+    UpdateDepth++;
+}
+
+void UShapesVisualizerBatchComponent::EndUpdate()
+{
+    check(UpdateDepth > 0);
+    if (--UpdateDepth > 0 || (PendingShapes.Num() == 0 && !PendingBoundsChanged))
+        return;
+
+    const bool Sent = PendingShapes.Num() == 0 || EnqueueBatchCommand_Internal(this,
+        [Shapes = MoveTemp(PendingShapes)](FShapesVisualizerBatchSceneProxy* Proxy)
+        {
+            for (const FPendingShape& Pending : Shapes)
+            {
+                if (Pending.Used)
+                    Proxy->SetShape_RenderThread(Pending.Index, Pending.Shape);
+                else
+                    Proxy->ClearShape_RenderThread(Pending.Index);
+            }
+        });
+    PendingShapes.Reset();
+
+    const bool BoundsChanged = PendingBoundsChanged;
+    PendingBoundsChanged = false;
+    OnShapesChanged(Sent, BoundsChanged);
+}
+
+void UShapesVisualizerBatchComponent::RebuildSlots()
+{
+    Serials.SetNumZeroed(FMath::Max(Serials.Num(), Batch.Num()));
+    FreeSlots.Reset();
+    for (int32 Index = Serials.Num() - 1; Index >= Batch.Num(); Index--)
+        FreeSlots.Add(Index);
+
+    ShapesBox.Init();
+    NumShapes = 0;
+    for (int32 Index = Batch.Num() - 1; Index >= 0; Index--)
+    {
+        if (Batch.IsUsed(Index))
+        {
+            ShapesBox += Batch.GetShapeBox(Index);
+            NumShapes++;
+        }
+        else
+        {
+            FreeSlots.Add(Index);
+        }
+    }
+}
+
+bool UShapesVisualizerBatchComponent::IsValidHandle(const FShapesVisualizerBatchHandle& Handle) const
+{
+    return Serials.IsValidIndex(Handle.Index)
+        && Handle.Index < Batch.Num() && Batch.IsUsed(Handle.Index)
+        && Serials[Handle.Index] == Handle.Serial;
+}
+
+bool UShapesVisualizerBatchComponent::SendShape(int32 Index, const FShapesVisualizerBatchShape* InShape)
+{
+    if (UpdateDepth > 0)
+    {
+        PendingShapes.Add(FPendingShape{ Index, InShape != nullptr, InShape ? *InShape : FShapesVisualizerBatchShape{} });
+        return true;
+    }
+
+    if (InShape)
+    {
+        return EnqueueBatchCommand_Internal(this,
+            [Index, Shape = *InShape](FShapesVisualizerBatchSceneProxy* Proxy)
+            {
+                Proxy->SetShape_RenderThread(Index, Shape);
+            });
+    }
+    return EnqueueBatchCommand_Internal(this,
+        [Index](FShapesVisualizerBatchSceneProxy* Proxy)
+        {
+            Proxy->ClearShape_RenderThread(Index);
+        });
+}
+
+void UShapesVisualizerBatchComponent::OnShapesChanged(bool Sent, bool BoundsChanged)
+{
+    // The update scope sends everything at its end
+    if (UpdateDepth > 0)
+    {
+        PendingBoundsChanged |= BoundsChanged;
+        return;
+    }
+
+    if (BoundsChanged || !Sent)
+        UpdateBounds();
+
+    if (!Sent)
+        MarkRenderStateDirty();
+    else
+    {
+        MarkRenderDynamicDataDirty();
+        if (BoundsChanged)
+            MarkRenderTransformDirty();
+    }
+}
@@ -3,390 +3,530 @@
 #include "Components/ShapesVisualizerComponent.h"
 #include "Engine/Engine.h"
 #include "Engine/CollisionProfile.h"
+#include "GameFramework/Actor.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialRenderProxy.h"
 #include "PrimitiveSceneProxy.h"
 #include "DynamicMeshBuilder.h"
 #include "SceneManagement.h"
+#include "RenderingThread.h"
+#include "Algo/Rotate.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/UObjectHash.h"
 #include "Runtime/Launch/Resources/Version.h"
+#include "ShapesVisualizerBudget.h"
+#include "ShapesVisualizerDrawing.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerGeometryPool.h"
+#include "ShapesVisualizerGridMesh.h"
+#include "ShapesVisualizerLineMeshes.h"
+#include "ShapesVisualizerMaterialCache.h"
+#include "ShapesVisualizerMeshBuffers.h"
+#include "ShapesVisualizerPointClusters.h"
+#include "ShapesVisualizerPolylineSimplifier.h"
+#include "ShapesVisualizerPointStorage.h"
+#include "ShapesVisualizerPointsMesh.h"
+#include "ShapesVisualizerStats.h"
 
 //
-// Internal functions
+// FShapesVisualizerDynamicData - appearance sent to the existing proxy
 //
 
+struct FShapesVisualizerDynamicData
+{
+    FColor Color;
+    bool Wireframe;
+    float LineThickness;
+    int32 NumSides;
+    int32 Priority;
+};
+
 namespace
 {
-    // Engine source 4.27
-    // .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
-    // Lines [1134-1152]: DrawWireChoppedCone
-    void DrawWireCone_Internal(FPrimitiveDrawInterface* PDI, const FVector& Base,
-        const FVector& X, const FVector& Y, const FVector& Z,
-        const FLinearColor& Color, float Radius, float TopRadius, float HalfHeight,
-        int32 NumSides, uint8 DepthPriority, float Thickness)
+    // Compact points of the component are shared, the others are encoded into the format of the proxy
+    FShapesVisualizerSharedPointStorage MakeProxyPoints_Internal(const UShapesVisualizerComponent* Component)
     {
-        const float AngleDelta = 2.0f * PI / NumSides;
-        FVector LastVertex = Base + X * Radius;
-        FVector LastTopVertex = Base + X * TopRadius;
+        const TSharedPtr<FShapesVisualizerPointStorage, ESPMode::ThreadSafe> CompactPoints = Component->ShareCompactPoints();
+        return CompactPoints
+            ? FShapesVisualizerSharedPointStorage{ CompactPoints.ToSharedRef() }
+            : FShapesVisualizerSharedPointStorage{ FShapesVisualizerPointStorage{ Component->PointsFormat, Component->Points } };
+    }
+}
 
-        for (int32 SideIndex = 0; SideIndex < NumSides; SideIndex++)
-        {
-            const FVector Vertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
-            const FVector TopVertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * TopRadius;
+//
+// FShapesVisualizerSceneProxy
+//
 
-            PDI->DrawLine(LastVertex - Z * HalfHeight, Vertex - Z * HalfHeight, Color, DepthPriority, Thickness);
-            PDI->DrawLine(LastTopVertex + Z * HalfHeight, TopVertex + Z * HalfHeight, Color, DepthPriority, Thickness);
-            PDI->DrawLine(LastVertex - Z * HalfHeight, LastTopVertex + Z * HalfHeight, Color, DepthPriority, Thickness);
+class FShapesVisualizerSceneProxy : public FPrimitiveSceneProxy
+{
+public:
 
-            LastVertex = Vertex;
-            LastTopVertex = TopVertex;
-        }
+    FShapesVisualizerSceneProxy(const UShapesVisualizerComponent* InComponent)
+        : FPrimitiveSceneProxy(InComponent)
+        , Shape(InComponent->Shape)
+        , Radii(InComponent->Radii)
+        , Height(InComponent->Height)
+        , Extent(InComponent->Extent)
+        , Points(MakeProxyPoints_Internal(InComponent))
+        , TrailCapacity(InComponent->GetTrailCapacity())
+        , TrailHead(InComponent->GetTrailHead())
+        , GridSize(InComponent->GridSize)
+        , CellSize(InComponent->CellSize)
+        , GridCells(InComponent->GridCells)
+        , BaseColor(InComponent->Color)
+        , Wireframe(SafeWireframe(InComponent->Shape, InComponent->Wireframe))
+        , LineThickness(InComponent->LineThickness)
+        , NumSides(FMath::Clamp(InComponent->NumSides, 8, 64))
+        , ShowOnlyWhenSelected(InComponent->ShowOnlyWhenSelected)
+        , Priority(InComponent->Priority)
+        , StaticDraw(SafeStaticDraw(InComponent->Shape, Wireframe, InComponent->StaticDraw))
+        , StaticBuffers(GetScene().GetFeatureLevel())
+        , PointsMesh(GetScene().GetFeatureLevel())
+        , GridMesh(GetScene().GetFeatureLevel())
+        , LineMeshes(GetScene().GetFeatureLevel())
+    {
+        bWantsSelectionOutline = InComponent->WantsSelectionOutline;
+        Points.Reserve(InComponent->GetReservedPoints());
+        PointsMesh.Reserve(InComponent->GetReservedPoints());
+        ShapesVisualizerStats::AddProxy(Shape);
     }
 
-    // Engine source 4.27
-    // .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
-    // Lines [549-650]: BuildCylinderVerts
-    void BuildConeVerts_Internal(const FVector& Base,
-        const FVector& XAxis, const FVector& YAxis, const FVector& ZAxis,
-        float Radius, float HalfHeight, uint32 Sides,
-        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+    virtual ~FShapesVisualizerSceneProxy() override
     {
-        const float AngleDelta = 2.0f * PI / Sides;
-        FVector LastVertex = Base + XAxis * Radius;
-
-        FVector2D TC = FVector2D(0.0f, 0.0f);
-        float TCStep = 1.0f / Sides;
-
-        FVector TopOffset = HalfHeight * ZAxis;
+        StaticBuffers.Release();
+        ReleaseDynamicGeometry();
+        ShapesVisualizerStats::RemoveProxy(Shape);
+        ShapesVisualizerStats::AddProxyMemory(Shape, -static_cast<int64>(StatMemoryBytes));
+    }
 
-        int32 BaseVertIndex = OutVerts.Num();
+    virtual SIZE_T GetTypeHash() const override
+    {
+        static size_t UniquePointer;
+        return reinterpret_cast<size_t>(&UniquePointer);
+    }
 
-        //Compute vertices for base circle.
-        for (uint32 SideIndex = 0; SideIndex < Sides; SideIndex++)
+    virtual void CreateRenderThreadResources() override
+    {
+        if (StaticDraw)
         {
-            const FVector Vertex = Base + (XAxis * FMath::Cos(AngleDelta * (SideIndex + 1)) + YAxis * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
-            FVector Normal = Vertex - Base;
-            Normal.Normalize();
-
-            FDynamicMeshVertex MeshVertex;
+            TArray<FDynamicMeshVertex> MeshVerts;
+            TArray<uint32> MeshIndices;
+            ShapesVisualizerGeometry::BuildShapeVerts(Shape, Radii, Height, Extent, NumSides, MeshVerts, MeshIndices);
+            StaticBuffers.Init(MeshVerts, MeshIndices);
 
-#if ENGINE_MAJOR_VERSION == 5
-            MeshVertex.Position = FVector3f(Vertex - TopOffset);
-            MeshVertex.TextureCoordinate[0] = FVector2f(TC);
-
-            MeshVertex.SetTangents(
-                (FVector3f)-ZAxis,
-                FVector3f((-ZAxis) ^ Normal),
-                (FVector3f)Normal
-            );
-#else
-            MeshVertex.Position = Vertex - TopOffset;
-            MeshVertex.TextureCoordinate[0] = TC;
+            StaticMaterial = MakeUnique<FColoredMaterialRenderProxy>(
+                GEngine->DebugMeshMaterial->GetRenderProxy(), FLinearColor{ BaseColor });
+        }
+        else
+            CreateDynamicGeometry();
 
-            MeshVertex.SetTangents(
-                -ZAxis,
-                (-ZAxis) ^ Normal,
-                Normal
-            );
-#endif
+        UpdateMemoryStat_RenderThread();
+    }
 
-            OutVerts.Add(MeshVertex); //Add bottom vertex
+    // Counts the change of the memory footprint, after creation and every change the component sends
+    void UpdateMemoryStat_RenderThread()
+    {
+        const uint32 MemoryBytes = GetMemoryFootprint();
+        ShapesVisualizerStats::AddProxyMemory(Shape, static_cast<int64>(MemoryBytes) - StatMemoryBytes);
+        StatMemoryBytes = MemoryBytes;
+    }
 
-            LastVertex = Vertex;
-            TC.X += TCStep;
-        }
+    virtual void OnTransformChanged() override
+    {
+        // Point sizes are kept in world units, only the positions depend on the scale
+        const FVector Scale = GetLocalToWorld().GetScaleVector();
+        if (PointsMesh.GetBuffers().IsInitialized() && !Scale.Equals(PointsMesh.GetScale()))
+            PointsMesh.SetScale(Points, Scale);
+    }
 
-        LastVertex = Base + XAxis * Radius;
-        TC = FVector2D(0.0f, 1.0f);
+    // Appearance changes keep the proxy, geometry is rebuilt only if wireframe or sides changed
 
-        //Compute vertices for the top circle
-        for (uint32 SideIndex = 0; SideIndex < Sides; SideIndex++)
+    void SetDynamicData_RenderThread(const FShapesVisualizerDynamicData& Data)
+    {
+        const bool NewWireframe = SafeWireframe(Shape, Data.Wireframe);
+        const int32 NewNumSides = FMath::Clamp(Data.NumSides, 8, 64);
+        const bool OldLineMesh = IsLineMesh();
+        // Grids have no sides and are always solid
+        const bool GeometryChanged = Shape != EVisualShape::Grid && (NewWireframe != Wireframe || NewNumSides != NumSides);
+
+        BaseColor = Data.Color;
+        Wireframe = NewWireframe;
+        LineThickness = Data.LineThickness;
+        NumSides = NewNumSides;
+        Priority = Data.Priority;
+
+        if ((GeometryChanged || OldLineMesh != IsLineMesh()) && !StaticDraw)
         {
-            const FVector Vertex = Base + (XAxis * FMath::Cos(AngleDelta * (SideIndex + 1)) + YAxis * FMath::Sin(AngleDelta * (SideIndex + 1))) * SMALL_NUMBER;
-            FVector Normal = Vertex - Base;
-            Normal.Normalize();
-
-            FDynamicMeshVertex MeshVertex;
-
-#if ENGINE_MAJOR_VERSION == 5
-            MeshVertex.Position = FVector3f(Vertex + TopOffset);
-            MeshVertex.TextureCoordinate[0] = FVector2f(TC);
+            ReleaseDynamicGeometry();
+            CreateDynamicGeometry();
+            UpdateMemoryStat_RenderThread();
+        }
+    }
 
-            MeshVertex.SetTangents(
-                (FVector3f)-ZAxis,
-                FVector3f((-ZAxis) ^ Normal),
-                (FVector3f)Normal
-            );
-#else
-            MeshVertex.Position = Vertex + TopOffset;
-            MeshVertex.TextureCoordinate[0] = TC;
+    // Grid updates, the cells of the box replace the old ones
+    void UpdateGridCells_RenderThread(const FIntVector& Start, const FIntVector& Size, const TArray<FColor>& NewCells)
+    {
+        GridMesh.Update(Start, Size, NewCells);
+    }
 
-            MeshVertex.SetTangents(
-                -ZAxis,
-                (-ZAxis) ^ Normal,
-                Normal
-            );
-#endif
+    // Points updates, the component sends only the changed range
 
-            OutVerts.Add(MeshVertex); //Add top vertex
+    void ReservePoints_RenderThread(int32 Number)
+    {
+        Points.Reserve(Number);
+        PointsMesh.Reserve(Number);
+    }
 
-            LastVertex = Vertex;
-            TC.X += TCStep;
+    void SetPoints_RenderThread(FShapesVisualizerSharedPointStorage&& NewPoints, int32 NewTrailCapacity, int32 NewTrailHead)
+    {
+        Points = MoveTemp(NewPoints);
+        TrailCapacity = NewTrailCapacity;
+        TrailHead = NewTrailHead;
+        // New points drop the reservation, ReservePoints follows if there is one
+        PointsMesh.Reserve(0);
+        Simplifier.Reset();
+        Simplifier.SetRange(0, Points.Num());
+        if (Shape == EVisualShape::Points)
+        {
+            PointPositions.Reset();
+            SortPoints(0);
         }
+        Clusters.Build(Points, IsTrailWrapped());
+        if (Shape == EVisualShape::Points)
+            PointsMesh.Build(Points, Radii, GetLocalToWorld().GetScaleVector(), NumSides, Wireframe);
+    }
 
-        //Add top/bottom triangles, in the style of a fan.
-        //Note if we wanted nice rendering of the caps then we need to duplicate the vertices and modify
-        //texture/tangent coordinates.
-        for (uint32 SideIndex = 1; SideIndex < Sides; SideIndex++)
+    void UpdatePoints_RenderThread(int32 StartIndex, const TArray<FVector>& NewPoints)
+    {
+        if (Shape == EVisualShape::Points)
         {
-            int32 V0 = BaseVertIndex;
-            int32 V1 = BaseVertIndex + SideIndex;
-            int32 V2 = BaseVertIndex + ((SideIndex + 1) % Sides);
-
-            //bottom
-            OutIndices.Add(V0);
-            OutIndices.Add(V1);
-            OutIndices.Add(V2);
-
-            // top
-            // OutIndices.Add(Sides + V2);
-            // OutIndices.Add(Sides + V1);
-            // OutIndices.Add(Sides + V0);
+            UpdateSortedPoints(StartIndex, NewPoints);
+            return;
         }
 
-        //Add sides.
+        Points.GetMutable().Update(StartIndex, NewPoints);
+        Simplifier.SetRange(Simplifier.GetFirstSequence(), Points.Num());
+        Simplifier.Invalidate(Simplifier.GetFirstSequence() + StartIndex);
+        Clusters.Update(Points, StartIndex, StartIndex + NewPoints.Num());
+    }
 
-        for (uint32 SideIndex = 0; SideIndex < Sides; SideIndex++)
+    void RemovePoints_RenderThread(int32 StartIndex, int32 Count)
+    {
+        if (Shape == EVisualShape::Points)
         {
-            int32 V0 = BaseVertIndex + SideIndex;
-            int32 V1 = BaseVertIndex + ((SideIndex + 1) % Sides);
-            int32 V2 = V0 + Sides;
-            int32 V3 = V1 + Sides;
-
-            OutIndices.Add(V0);
-            OutIndices.Add(V2);
-            OutIndices.Add(V1);
-
-            OutIndices.Add(V2);
-            OutIndices.Add(V3);
-            OutIndices.Add(V1);
+            RemoveSortedPoints(StartIndex, Count);
+            return;
         }
 
+        Points.GetMutable().RemoveAt(StartIndex, Count);
+        Simplifier.SetRange(Simplifier.GetFirstSequence(), Points.Num());
+        Simplifier.Invalidate(Simplifier.GetFirstSequence() + StartIndex);
+        Clusters.Update(Points, StartIndex, Points.Num());
     }
 
-    // Engine source 4.27
-    // .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
-    // Lines [688-697]: GetConeMesh
-    void GetConeMesh_Internal(const FMatrix& LocalToWorld,
-        float Radius, float HalfHeight, uint32 Sides,
-        const FMaterialRenderProxy* MaterialRenderProxy, uint8 DepthPriority,
-        int32 ViewIndex, FMeshElementCollector& Collector)
+    // Trail pushes, the oldest points leave the polyline once the ring is full
+    void PushTrailPoints_RenderThread(TArrayView<const FVector> NewPoints)
     {
-        TArray<FDynamicMeshVertex> MeshVerts;
-        TArray<uint32> MeshIndices;
-        BuildConeVerts_Internal(FVector::ZeroVector, FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector, 
-            Radius, HalfHeight, Sides, MeshVerts, MeshIndices);
-        FDynamicMeshBuilder MeshBuilder(Collector.GetFeatureLevel());
-        MeshBuilder.AddVertices(MeshVerts);
-        MeshBuilder.AddTriangles(MeshIndices);
-        MeshBuilder.GetMesh(LocalToWorld, MaterialRenderProxy, DepthPriority, false, false, ViewIndex, Collector);
-    }
+        const int32 NumAdded = FMath::Clamp(TrailCapacity - Points.Num(), 0, NewPoints.Num());
+        if (NumAdded > 0)
+        {
+            const int32 StartIndex = Points.Num();
+            FShapesVisualizerPointStorage& Storage = Points.GetMutable();
+            for (int32 Index = 0; Index < NumAdded; Index++)
+                Storage.Add(NewPoints[Index]);
+            Clusters.Update(Points, StartIndex, Points.Num());
+            Clusters.SetWrap(Points, IsTrailWrapped());
+        }
 
-    // Engine source 4.27
-    // .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
-    // Lines [699-710]: GetCapsuleMesh
-    void GetCapsuleMesh_Internal(const FMatrix& LocalToWorld, const FLinearColor& Color, float Radius, float HalfHeight, int32 NumSides, const FMaterialRenderProxy* MaterialRenderProxy, uint8 DepthPriority, bool bDisableBackfaceCulling, int32 ViewIndex, FMeshElementCollector& Collector)
-    {
-        const FVector XAxis = LocalToWorld.GetScaledAxis(EAxis::X);
-        const FVector YAxis = LocalToWorld.GetScaledAxis(EAxis::Y);
-        const FVector ZAxis = LocalToWorld.GetScaledAxis(EAxis::Z);
-        const FVector Origin = LocalToWorld.GetOrigin() - ZAxis * HalfHeight;
-        const FVector ScaledRadius = LocalToWorld.GetScaleVector() * Radius;
-        const float HalfAxis = FMath::Max<float>(HalfHeight - Radius, 1.f);
-        const FVector BottomEnd = Origin + Radius * ZAxis;
-        const FVector TopEnd = BottomEnd + (2 * HalfAxis) * ZAxis;
-        const float CylinderHalfHeight = (TopEnd - BottomEnd).Size() * 0.5;
-        const FVector CylinderLocation = BottomEnd + CylinderHalfHeight * ZAxis;
+        // Only the last lap of the ring survives, its points are at most two runs from TrailHead on
+        const int32 NumPushed = NewPoints.Num() - NumAdded;
+        const int32 NumWritten = FMath::Min(NumPushed, TrailCapacity);
+        if (NumWritten > 0)
+        {
+            TrailHead = (TrailHead + NumPushed - NumWritten) % TrailCapacity;
+            const int32 StartIndex = TrailHead;
+            FShapesVisualizerPointStorage& Storage = Points.GetMutable();
+            for (int32 Index = NewPoints.Num() - NumWritten; Index < NewPoints.Num(); Index++)
+            {
+                Storage.Set(TrailHead, NewPoints[Index]);
+                TrailHead = (TrailHead + 1) % TrailCapacity;
+            }
+            const int32 EndIndex = StartIndex + NumWritten;
+            Clusters.Update(Points, StartIndex, FMath::Min(EndIndex, TrailCapacity));
+            if (EndIndex > TrailCapacity)
+                Clusters.Update(Points, 0, EndIndex - TrailCapacity);
+        }
 
-        GetOrientedHalfSphereMesh(TopEnd, FRotationMatrix::MakeFromXY(XAxis, YAxis).Rotator(), ScaledRadius, NumSides, NumSides, 0, PI / 2, MaterialRenderProxy, DepthPriority, bDisableBackfaceCulling, ViewIndex, Collector);
-        GetCylinderMesh(CylinderLocation, XAxis, YAxis, ZAxis, Radius, CylinderHalfHeight, NumSides, MaterialRenderProxy, DepthPriority, ViewIndex, Collector);
-        GetOrientedHalfSphereMesh(BottomEnd, FRotationMatrix::MakeFromXY(XAxis, YAxis).Rotator(), ScaledRadius, NumSides, NumSides, PI / 2, PI, MaterialRenderProxy, DepthPriority, bDisableBackfaceCulling, ViewIndex, Collector);
+        // Every pushed point moves the polyline on by one, only its first and last blocks are simplified again
+        Simplifier.SetRange(Simplifier.GetFirstSequence() + NumPushed, Points.Num());
     }
-}
-
-//
-// FShapesVisualizerSceneProxy
-//
-
-class FShapesVisualizerSceneProxy : public FPrimitiveSceneProxy
-{
-public:
 
-    FShapesVisualizerSceneProxy(const UShapesVisualizerComponent* InComponent)
-        : FPrimitiveSceneProxy(InComponent)
-        , Shape(InComponent->Shape)
-        , Radii(InComponent->Radii)
-        , Height(InComponent->Height)
-        , Extent(InComponent->Extent)
-        , Points(InComponent->Points)
-        , BaseColor(InComponent->Color)
-        , Wireframe(SafeWireframe(InComponent->Shape, InComponent->Wireframe))
-        , LineThickness(InComponent->LineThickness)
-        , NumSides(InComponent->NumSides)
-        , ShowOnlyWhenSelected(InComponent->ShowOnlyWhenSelected)
+    virtual void DrawStaticElements(FStaticPrimitiveDrawInterface* PDI) override
     {
-        bWantsSelectionOutline = InComponent->WantsSelectionOutline;
-    }
+        if (!StaticBuffers.IsInitialized())
+            return;
 
-    virtual SIZE_T GetTypeHash() const override
-    {
-        static size_t UniquePointer;
-        return reinterpret_cast<size_t>(&UniquePointer);
+        FMeshBatch Mesh;
+        StaticBuffers.GetMeshBatch(Mesh, StaticMaterial.Get(), SDPG_World, IsLocalToWorldDeterminantNegative());
+        PDI->DrawMesh(Mesh, FLT_MAX);
     }
 
     virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views,
         const FSceneViewFamily& ViewFamily, uint32 VisibilityMap,
         FMeshElementCollector& Collector) const override
     {
+        SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_GetDynamicMeshElements);
+        SHAPESVISUALIZER_COUNT_ALLOCATIONS(true);
+
         const FMatrix& LTW = GetLocalToWorld();
-        const FVector WorldOrigin = LTW.GetOrigin();
-        const float HalfHeight = Height / 2.f;
+        const FBoxSphereBounds& WorldBounds = GetBounds();
+        const FBoxSphereBounds& LocalBounds = GetLocalBounds();
+        FShapesVisualizerFrameStats FrameStats;
+
+        // One budget decision for all views of the frame
+        const uint32 StartCycles = FPlatformTime::Cycles();
+        const bool WithinBudget = BudgetState.TryDraw(ViewFamily.FrameNumber, Priority, IsSelected(),
+            ShapesVisualizerDrawing::GetMaxScreenRadius(Views, VisibilityMap, WorldBounds));
 
         for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
         {
-            if (!(VisibilityMap & (1 << ViewIndex)))
+            if (!(VisibilityMap & (1 << ViewIndex)) || !WithinBudget)
                 continue;
 
-            FPrimitiveDrawInterface* PDI = Wireframe ? Collector.GetPDI(ViewIndex) : nullptr;
+            const FSceneView& View = *Views[ViewIndex];
+
+            // Points are sized in world units, so the closest one is the largest on screen
+            const float ScreenRadius = Shape == EVisualShape::Points
+                ? ShapesVisualizerDrawing::GetScreenRadius(View, Radii,
+                    WorldBounds.GetBox().ComputeSquaredDistanceToPoint(View.ViewMatrices.GetViewOrigin()))
+                : ShapesVisualizerDrawing::GetScreenRadius(View, WorldBounds.Origin, WorldBounds.SphereRadius);
+            const int32 ViewSides = Shape == EVisualShape::Polyline ? NumSides
+                : ShapesVisualizerDrawing::GetViewSides(ScreenRadius, NumSides);
+            if (ViewSides == 0)
+                continue;
+
+            // Large point sets are also culled per cluster, the primitive as a whole is already in the frustum
+            TArray<int32>& VisibleClusters = ScratchVisibleClusters;
+            const float ClusterMargin = (Shape == EVisualShape::Points ? Radii : 0.f) + FMath::Max(LineThickness, 0.f) * 0.5f;
+            const bool ClusterCulling = Clusters.Num() > 1
+                && Clusters.GetVisibleClusters(View, LTW, ClusterMargin, VisibleClusters) < Clusters.Num();
+
+            // Thick lines are quads of one mesh per view, thin polylines a line list of one
+            TArray<FVector>& LineVerts = ScratchLineVerts;
+            LineVerts.Reset();
 
             const bool Outline = Wireframe && WantsSelectionOutline();
-            const FLinearColor Color = GetViewSelectionColor(BaseColor, *Views[ViewIndex],
+            const FLinearColor Color = GetViewSelectionColor(BaseColor, View,
                 Outline ? IsSelected() : false, Outline ? IsHovered() : false,
                 false, IsIndividuallySelected());
-            const FMaterialRenderProxy* const ParentMaterial = Wireframe ? nullptr
-                : GEngine->DebugMeshMaterial->GetRenderProxy();
-            FMaterialRenderProxy* const MeshMaterial = ParentMaterial
-                ? new FColoredMaterialRenderProxy(ParentMaterial, Color)
+            // Thin wireframes are drawn as line list meshes
+            const bool LineMesh = IsLineMesh();
+            const FMaterialRenderProxy* const ParentMaterial = Shape == EVisualShape::Grid ? nullptr
+                : !Wireframe ? GEngine->DebugMeshMaterial->GetRenderProxy()
+                : LineMesh ? GEngine->WireframeMaterial->GetRenderProxy()
+                : nullptr;
+            const FMaterialRenderProxy* const MeshMaterial = ParentMaterial
+                ? Materials.Get(ParentMaterial, Color, ViewFamily.FrameNumber)
                 : nullptr;
-            if (MeshMaterial)
-                Collector.RegisterOneFrameMaterialProxy(MeshMaterial);
 
             switch (Shape)
             {
-            case EVisualShape::Sphere:
-                if (Wireframe)
-                    DrawWireSphere(PDI, FTransform{ LTW },
-                        Color, Radii, NumSides,
-                        SDPG_World, LineThickness);
-                else
-                    GetOrientedHalfSphereMesh(WorldOrigin,
-                        LTW.Rotator(), LTW.GetScaleVector() * Radii,
-                        NumSides, FMath::Max(3, NumSides / 2), 0.f, PI,
-                        MeshMaterial, SDPG_World, false, ViewIndex, Collector);
-                break;
-
-            case EVisualShape::HalfSphere:
-                GetOrientedHalfSphereMesh(WorldOrigin,
-                    LTW.Rotator(), LTW.GetScaleVector() * Radii,
-                    NumSides, NumSides, 0.f, HALF_PI,
-                    MeshMaterial, SDPG_World, false, ViewIndex, Collector);
+            case EVisualShape::Grid:
+            {
+                // Chunks are culled per view, the cells carry their own colors
+                const FMaterialRenderProxy* const GridMaterial = GEngine->VertexColorMaterial->GetRenderProxy();
+                for (int32 ChunkIndex = 0; ChunkIndex < GridMesh.NumChunks(); ChunkIndex++)
+                {
+                    if (GridMesh.GetNumQuads(ChunkIndex) == 0)
+                        continue;
+                    const FBox WorldBox = GridMesh.GetChunkBox(ChunkIndex).TransformBy(LTW);
+                    if (!View.ViewFrustum.IntersectBox(WorldBox.GetCenter(), WorldBox.GetExtent()))
+                        continue;
+                    FrameStats.AddPrimitives(Shape, false, ShapesVisualizerDrawing::GetMeshBuffers(GridMesh.GetBuffers(ChunkIndex), LTW,
+                        WorldBounds, LocalBounds, GridMaterial, SDPG_World, ViewIndex, Collector));
+                }
                 break;
+            }
 
-            case EVisualShape::Box:
-                if (Wireframe)
-                    DrawOrientedWireBox(PDI, WorldOrigin,
-                        LTW.GetScaledAxis(EAxis::X),
-                        LTW.GetScaledAxis(EAxis::Y),
-                        LTW.GetScaledAxis(EAxis::Z),
-                        Extent, Color, SDPG_World, LineThickness);
+            case EVisualShape::Points:
+                if (Wireframe && !LineMesh)
+                {
+                    // Transform and cull on the task graph, then every visible point adds its diamond
+                    TArray<FVector>& WorldPoints = ScratchWorldPoints;
+                    TArray<bool>& Visible = ScratchVisible;
+                    WorldPoints.SetNumUninitialized(Points.Num(), false);
+                    Visible.SetNumUninitialized(Points.Num(), false);
+                    ShapesVisualizerGeometry::ParallelForChunks(Points.Num(), [&](int32 StartIndex, int32 EndIndex)
+                    {
+                        for (int32 ClusterStart = StartIndex; ClusterStart < EndIndex; ClusterStart += FShapesVisualizerPointClusters::ClusterSize)
+                        {
+                            const int32 ClusterEnd = FMath::Min(ClusterStart + FShapesVisualizerPointClusters::ClusterSize, EndIndex);
+                            if (ClusterCulling && !FShapesVisualizerPointClusters::IsClusterVisible(VisibleClusters,
+                                FShapesVisualizerPointClusters::GetClusterIndex(ClusterStart)))
+                            {
+                                FMemory::Memzero(Visible.GetData() + ClusterStart, (ClusterEnd - ClusterStart) * sizeof(bool));
+                                continue;
+                            }
+
+                            Points.TransformPositions(LTW, ClusterStart, ClusterEnd, WorldPoints.GetData() + ClusterStart);
+                            for (int32 Index = ClusterStart; Index < ClusterEnd; Index++)
+                            {
+                                Visible[Index] = ShapesVisualizerDrawing::GetViewSides(
+                                    ShapesVisualizerDrawing::GetScreenRadius(View, WorldPoints[Index], Radii), NumSides) > 0;
+                            }
+                        }
+                    });
+
+                    // Same twelve edges as DrawWireDiamond, the corners are Radii away along the world axes
+                    const FVector Corners[6] = { FVector{ Radii, 0.f, 0.f }, FVector{ 0.f, Radii, 0.f }, FVector{ -Radii, 0.f, 0.f },
+                        FVector{ 0.f, -Radii, 0.f }, FVector{ 0.f, 0.f, Radii }, FVector{ 0.f, 0.f, -Radii } };
+                    int32 NumVisible = 0;
+                    for (int32 Index = 0; Index < WorldPoints.Num(); Index++)
+                        NumVisible += Visible[Index] ? 1 : 0;
+                    LineVerts.Reserve(NumVisible * 24);
+
+                    for (int32 Index = 0; Index < WorldPoints.Num(); Index++)
+                    {
+                        if (!Visible[Index])
+                            continue;
+
+                        const FVector& Center = WorldPoints[Index];
+                        for (int32 Corner = 0; Corner < 4; Corner++)
+                        {
+                            const FVector Equator = Center + Corners[Corner];
+                            LineVerts.Add(Equator);
+                            LineVerts.Add(Center + Corners[(Corner + 1) % 4]);
+                            LineVerts.Add(Equator);
+                            LineVerts.Add(Center + Corners[4]);
+                            LineVerts.Add(Equator);
+                            LineVerts.Add(Center + Corners[5]);
+                        }
+                    }
+                    const FColor LineColor = Color.ToFColor(true);
+                    FrameStats.AddPrimitives(Shape, true, LineMeshes.DrawLines(View, LineVerts, MakeArrayView(&LineColor, 1),
+                        LineThickness, WorldBounds, SDPG_World, ViewIndex, Collector));
+                    FrameStats.AddPoints(Shape, NumVisible);
+                }
                 else
-                    GetBoxMesh(LTW, Extent,
-                        MeshMaterial, SDPG_World, ViewIndex, Collector);
-                break;
-
-            case EVisualShape::Cylinder:
-                if (Wireframe)
                 {
-                    if (Height > 0.f)
-                        DrawWireCylinder(PDI, WorldOrigin,
-                            LTW.GetScaledAxis(EAxis::X),
-                            LTW.GetScaledAxis(EAxis::Y),
-                            LTW.GetScaledAxis(EAxis::Z),
-                            Color, Radii, HalfHeight, NumSides,
-                            SDPG_World, LineThickness);
+                    // Coarse spheres when even the closest point does not need more sides
+                    const int32 LODIndex = PointsMesh.GetNumLODs() > 1 && ViewSides <= PointsMesh.GetNumSides(1) ? 1 : 0;
+
+                    // Points of the visible clusters are contiguous ranges of the index buffer
+                    TArray<TPair<int32, int32>>& Ranges = ScratchRanges;
+                    Ranges.Reset();
+                    if (ClusterCulling)
+                        FShapesVisualizerPointClusters::GetVisibleRanges(VisibleClusters, Points.Num(), Ranges);
                     else
-                        DrawCircle(PDI, WorldOrigin,
-                            LTW.GetScaledAxis(EAxis::X),
-                            LTW.GetScaledAxis(EAxis::Y),
-                            Color, Radii, NumSides,
-                            SDPG_World, LineThickness);
+                        Ranges.Emplace(0, Points.Num());
+
+                    // Huge sets keep only every Stride-th point in the mesh
+                    const int32 IndicesPerPoint = PointsMesh.GetIndicesPerPoint(LODIndex);
+                    for (const TPair<int32, int32>& Range : Ranges)
+                    {
+                        const int32 StartSlot = PointsMesh.GetSlot(Range.Key);
+                        const int32 NumSlots = PointsMesh.GetSlot(Range.Value) - StartSlot;
+                        if (NumSlots <= 0)
+                            continue;
+
+                        FrameStats.AddPrimitives(Shape, Wireframe, ShapesVisualizerDrawing::GetMeshBuffers(PointsMesh.GetBuffers(LODIndex), LTW,
+                            WorldBounds, LocalBounds,
+                            MeshMaterial, SDPG_World, ViewIndex, Collector,
+                            StartSlot * IndicesPerPoint, NumSlots * IndicesPerPoint));
+                        FrameStats.AddPoints(Shape, NumSlots);
+                    }
                 }
-                else
-                    GetCylinderMesh(LTW, FVector::ZeroVector,
-                        FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector,
-                        Radii, HalfHeight, NumSides,
-                        MeshMaterial, SDPG_World, ViewIndex, Collector);
-                break;
-
-            case EVisualShape::Cone:
-                if (Wireframe)
-                    DrawWireCone_Internal(PDI, WorldOrigin,
-                        LTW.GetScaledAxis(EAxis::X),
-                        LTW.GetScaledAxis(EAxis::Y),
-                        LTW.GetScaledAxis(EAxis::Z),
-                        Color, Radii, 0.f, HalfHeight, NumSides,
-                        SDPG_World, LineThickness);
-                else
-                    GetConeMesh_Internal(LTW,
-                        Radii, HalfHeight, NumSides,
-                        MeshMaterial, SDPG_World, ViewIndex, Collector);
                 break;
 
-            case EVisualShape::Capsule:
-                if (Wireframe)
-                    DrawWireCapsule(PDI, WorldOrigin,
-                        LTW.GetScaledAxis(EAxis::X),
-                        LTW.GetScaledAxis(EAxis::Y),
-                        LTW.GetScaledAxis(EAxis::Z),
-                        Color, Radii, HalfHeight, NumSides,
-                        SDPG_World, LineThickness);
-                else
-                    GetCapsuleMesh_Internal(LTW,
-                        FLinearColor{ Color }, Radii, HalfHeight, NumSides,
-                        MeshMaterial, SDPG_World, false, ViewIndex, Collector);
-                break;
+            case EVisualShape::Polyline:
+            {
+                const TArray<int32>& Indices = GetPolylineIndices(View);
 
-            case EVisualShape::Points:
-                for (const FVector& Pt : Points)
+                // Segment i runs from the point Indices[i] to Indices[i + 1], through the skipped points
+                auto IsSegmentVisible = [&](int32 i)
+                {
+                    return !ClusterCulling || FShapesVisualizerPointClusters::IsPathVisible(VisibleClusters,
+                        GetPolylineStorageIndex(Indices[i]), GetPolylineStorageIndex(Indices[i + 1]));
+                };
+
+                // Every point of a visible segment is transformed once by the vectorized kernel, on the task graph
+                // for long polylines. Unculled unsimplified plain polylines are transformed straight from the storage,
+                // the others gather the points of the chunk and transform them in place
+                TArray<FVector>& WorldPoints = ScratchWorldPoints;
+                WorldPoints.SetNumUninitialized(Indices.Num(), false);
+                const bool Contiguous = !ClusterCulling && TrailHead == 0 && Indices.Num() == Points.Num();
+                ShapesVisualizerGeometry::ParallelForChunks(Indices.Num(), [&](int32 StartIndex, int32 EndIndex)
                 {
-                    if (Wireframe)
-                        DrawWireDiamond(PDI,
-                            FTranslationMatrix{ LTW.TransformPosition(Pt) }, Radii,
-                            Color, SDPG_World, LineThickness);
+                    if (Contiguous)
+                        Points.TransformPositions(LTW, StartIndex, EndIndex, WorldPoints.GetData() + StartIndex);
                     else
-                        GetSphereMesh(LTW.TransformPosition(Pt), FVector{ Radii },
-                            NumSides, NumSides,
-                            MeshMaterial, SDPG_World, false, ViewIndex, Collector);
+                    {
+                        for (int32 Index = StartIndex; Index < EndIndex; Index++)
+                        {
+                            const bool Used = (Index > 0 && IsSegmentVisible(Index - 1)) || (Index < Indices.Num() - 1 && IsSegmentVisible(Index));
+                            WorldPoints[Index] = Used ? GetPolylinePoint(Indices[Index]) : FVector::ZeroVector;
+                        }
+                        ShapesVisualizerGeometry::TransformPositions(LTW,
+                            MakeArrayView(WorldPoints.GetData() + StartIndex, EndIndex - StartIndex), WorldPoints.GetData() + StartIndex);
+                    }
+                });
+
+                LineVerts.Reserve(FMath::Max(WorldPoints.Num() - 1, 0) * 2);
+                int32 NumLinePoints = 0;
+                for (int32 i = 0; i < WorldPoints.Num() - 1; ++i)
+                {
+                    if (!IsSegmentVisible(i))
+                        continue;
+
+                    LineVerts.Add(WorldPoints[i]);
+                    LineVerts.Add(WorldPoints[i + 1]);
+                    NumLinePoints += i > 0 && IsSegmentVisible(i - 1) ? 1 : 2;
                 }
+                const FColor LineColor = Color.ToFColor(true);
+                FrameStats.AddPrimitives(Shape, true, LineMeshes.DrawLines(View, LineVerts, MakeArrayView(&LineColor, 1),
+                    LineThickness, WorldBounds, SDPG_World, ViewIndex, Collector));
+                FrameStats.AddPoints(Shape, NumLinePoints);
                 break;
+            }
 
-            case EVisualShape::Polyline:
-                for (int32 i = 0; i < Points.Num() - 1; ++i)
+            default:
+            {
+                // Lines follow the view exactly, solid meshes take the closest prebuilt LOD
+                const int32 LODIndex = ShapesVisualizerDrawing::GetLODIndex(NumSides, ViewSides);
+                if (CapsuleMeshes[LODIndex])
+                    FrameStats.AddPrimitives(Shape, false, ShapesVisualizerDrawing::GetMeshBuffers(*CapsuleMeshes[LODIndex], LTW,
+                        WorldBounds, LocalBounds, MeshMaterial, SDPG_World, ViewIndex, Collector));
+                else if (UnitMeshes[LODIndex])
+                    FrameStats.AddPrimitives(Shape, Wireframe, ShapesVisualizerDrawing::DrawShape(Shape, Radii, Height, Extent, LTW,
+                        *UnitMeshes[LODIndex], MeshMaterial, WorldBounds, LocalBounds, ViewIndex, Collector));
+                else if (Wireframe)
                 {
-                    PDI->DrawLine(
-                        LTW.TransformPosition(Points[i]),
-                        LTW.TransformPosition(Points[i + 1]),
-                        Color, SDPG_World, LineThickness);
+                    // Thick lines are quads of the wireframe with the sides of the view
+                    ShapesVisualizerDrawing::AddWireLines(Shape, Radii, Height, Extent, LTW, ViewSides, LineVerts);
+                    const FColor LineColor = Color.ToFColor(true);
+                    FrameStats.AddPrimitives(Shape, true, LineMeshes.DrawLines(View, LineVerts, MakeArrayView(&LineColor, 1),
+                        LineThickness, WorldBounds, SDPG_World, ViewIndex, Collector));
                 }
                 break;
+            }
             } // switch (Shape)
         }
+
+        if (WithinBudget)
+            BudgetState.EndDraw(FrameStats.GetNumPrimitives(), StartCycles);
+
+        FrameStats.Flush();
     }
 
     virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
     {
         FPrimitiveViewRelevance Result;
         Result.bDrawRelevance = IsShown(View) && (!ShowOnlyWhenSelected || IsSelected());
-        Result.bDynamicRelevance = true;
+        Result.bStaticRelevance = StaticDraw;
+        Result.bDynamicRelevance = !StaticDraw;
         Result.bShadowRelevance = IsShadowCast(View);
         Result.bEditorPrimitiveRelevance = UseEditorCompositing(View);
         Result.bSeparateTranslucency = Result.bNormalTranslucency = IsShown(View);
@@ -395,16 +535,247 @@ public:
 
     virtual uint32 GetMemoryFootprint(void) const override
     {
-        return sizeof(*this) + GetAllocatedSize() + Points.GetAllocatedSize();
+        return sizeof(*this) + GetAllocatedSize() + Points.GetAllocatedSize() + PointPositions.GetAllocatedSize() + Clusters.GetAllocatedSize()
+            + GridCells.GetAllocatedSize() + GridMesh.GetAllocatedSize() + PointsMesh.GetAllocatedSize()
+            + Simplifier.GetAllocatedSize() + Materials.GetAllocatedSize() + ScratchVisibleClusters.GetAllocatedSize()
+            + ScratchWorldPoints.GetAllocatedSize() + ScratchVisible.GetAllocatedSize() + ScratchLineVerts.GetAllocatedSize() + ScratchRanges.GetAllocatedSize()
+            + LineMeshes.GetAllocatedSize();
     }
 
 private:
 
+    // Points shapes keep their storage in Z-order, so the clusters are compact and the strided mesh
+    // samples the whole set. Positions [StartIndex, Num) hold the points [StartIndex, Num) of the
+    // component in its order and are sorted among themselves, earlier ones stay where they are.
+    // Points shared with the component are read only and keep its order, sorting would copy them
+    void SortPoints(int32 StartIndex)
+    {
+        const int32 NumSorted = Points.Num() - StartIndex;
+        PointPositions.SetNumUninitialized(Points.Num(), false);
+        if (NumSorted <= 0)
+            return;
+
+        if (Points.IsShared())
+        {
+            for (int32 Index = StartIndex; Index < Points.Num(); Index++)
+                PointPositions[Index] = Index;
+            return;
+        }
+
+        TArray<FVector> Unsorted;
+        Unsorted.SetNumUninitialized(NumSorted);
+        for (int32 Index = 0; Index < NumSorted; Index++)
+            Unsorted[Index] = Points[StartIndex + Index];
+
+        TArray<int32> Order;
+        ShapesVisualizerGeometry::GetSpatialOrder(Unsorted, Order);
+
+        TArray<FVector> Sorted;
+        Sorted.SetNumUninitialized(NumSorted);
+        for (int32 Index = 0; Index < NumSorted; Index++)
+        {
+            Sorted[Index] = Unsorted[Order[Index]];
+            PointPositions[StartIndex + Order[Index]] = StartIndex + Index;
+        }
+        Points.GetMutable().Update(StartIndex, Sorted);
+    }
+
+    // Changed points are scattered over the sorted storage and refit in runs, appended ones are sorted among themselves
+    void UpdateSortedPoints(int32 StartIndex, const TArray<FVector>& NewPoints)
+    {
+        const int32 OldNum = Points.Num();
+        const int32 NumUpdated = FMath::Min(NewPoints.Num(), OldNum - StartIndex);
+
+        FShapesVisualizerPointStorage& Storage = Points.GetMutable();
+        TArray<int32> Positions;
+        Positions.SetNumUninitialized(NumUpdated);
+        for (int32 Index = 0; Index < NumUpdated; Index++)
+        {
+            Positions[Index] = PointPositions[StartIndex + Index];
+            Storage.Set(Positions[Index], NewPoints[Index]);
+        }
+        Positions.Sort();
+
+        for (int32 RunStart = 0; RunStart < Positions.Num();)
+        {
+            int32 RunEnd = RunStart + 1;
+            while (RunEnd < Positions.Num() && Positions[RunEnd] == Positions[RunEnd - 1] + 1)
+                RunEnd++;
+            Clusters.Update(Points, Positions[RunStart], Positions[RunEnd - 1] + 1);
+            PointsMesh.Update(Points, Positions[RunStart], Positions[RunEnd - 1] + 1);
+            RunStart = RunEnd;
+        }
+
+        if (NumUpdated < NewPoints.Num())
+        {
+            Storage.Update(OldNum, MakeArrayView(NewPoints).Slice(NumUpdated, NewPoints.Num() - NumUpdated));
+            SortPoints(OldNum);
+            Clusters.Update(Points, OldNum, Points.Num());
+            PointsMesh.Update(Points, OldNum, Points.Num());
+        }
+    }
+
+    // Removed points leave holes in the sorted storage, which are filled with the points at its end so the
+    // storage is only cut at the end. Only the clusters and mesh slots of the holes are refit, the moved
+    // points loosen their new clusters a little until the set is sorted again
+    void RemoveSortedPoints(int32 StartIndex, int32 Count)
+    {
+        const int32 OldNum = Points.Num();
+        const int32 NewNum = OldNum - Count;
+
+        TArray<int32> Holes;
+        TArray<bool> TailRemoved;
+        TailRemoved.SetNumZeroed(Count);
+        for (int32 Index = StartIndex; Index < StartIndex + Count; Index++)
+        {
+            const int32 Position = PointPositions[Index];
+            if (Position < NewNum)
+                Holes.Add(Position);
+            else
+                TailRemoved[Position - NewNum] = true;
+        }
+        PointPositions.RemoveAt(StartIndex, Count, false);
+
+        // Owners of the surviving tail positions, one pass over the mapping
+        TArray<int32> TailOwners;
+        TailOwners.SetNumUninitialized(Count);
+        for (int32 Index = 0; Index < NewNum; Index++)
+        {
+            if (PointPositions[Index] >= NewNum)
+                TailOwners[PointPositions[Index] - NewNum] = Index;
+        }
+
+        Holes.Sort();
+        FShapesVisualizerPointStorage& Storage = Points.GetMutable();
+        int32 Mover = 0;
+        for (const int32 Hole : Holes)
+        {
+            while (TailRemoved[Mover])
+                Mover++;
+            Storage.Set(Hole, Storage[NewNum + Mover]);
+            PointPositions[TailOwners[Mover]] = Hole;
+            Mover++;
+        }
+        Storage.RemoveAt(NewNum, Count);
+
+        for (int32 RunStart = 0; RunStart < Holes.Num();)
+        {
+            int32 RunEnd = RunStart + 1;
+            while (RunEnd < Holes.Num() && Holes[RunEnd] == Holes[RunEnd - 1] + 1)
+                RunEnd++;
+            Clusters.Update(Points, Holes[RunStart], Holes[RunEnd - 1] + 1);
+            PointsMesh.Update(Points, Holes[RunStart], Holes[RunEnd - 1] + 1);
+            RunStart = RunEnd;
+        }
+
+        // The cut shrinks the last cluster and the drawn range of the mesh
+        Clusters.Update(Points, NewNum, NewNum);
+        PointsMesh.Update(Points, NewNum, NewNum);
+    }
+
+    // Polyline points oldest first, trails start at TrailHead
+    FORCEINLINE int32 GetPolylineStorageIndex(int32 Index) const
+    {
+        return TrailHead == 0 ? Index : (TrailHead + Index) % Points.Num();
+    }
+
+    FORCEINLINE FVector GetPolylinePoint(int32 Index) const
+    {
+        return Points[GetPolylineStorageIndex(Index)];
+    }
+
+    // Thin point diamonds and sized wireframes, polylines are drawn line by line
+    FORCEINLINE bool IsLineMesh() const
+    {
+        return Wireframe && LineThickness <= 0.f && Shape != EVisualShape::Polyline;
+    }
+
+    FORCEINLINE bool IsTrailWrapped() const
+    {
+        return TrailCapacity > 0 && Points.Num() == TrailCapacity;
+    }
+
+    // Points left after simplification with the tolerance of the view. Blocks of points which stayed the
+    // same keep their result, so a growing trail simplifies only its newest and oldest points again
+    const TArray<int32>& GetPolylineIndices(const FSceneView& View) const
+    {
+        const float DistanceSquared = GetBounds().GetBox().ComputeSquaredDistanceToPoint(View.ViewMatrices.GetViewOrigin());
+        const float Tolerance = ShapesVisualizerDrawing::GetPolylineTolerance(View, DistanceSquared)
+            / FMath::Max(GetLocalToWorld().GetMaximumAxisScale(), KINDA_SMALL_NUMBER);
+
+        return Simplifier.Simplify(Tolerance, [this](int32 Index) { return GetPolylinePoint(Index); });
+    }
+
+    void CreateDynamicGeometry()
+    {
+        if (Shape == EVisualShape::Grid)
+        {
+            GridMesh.Build(GridSize, CellSize, MoveTemp(GridCells));
+            return;
+        }
+
+        // Points come in the order of the component only with the new proxy
+        if (Shape == EVisualShape::Points && PointPositions.Num() != Points.Num())
+        {
+            PointPositions.Reset();
+            SortPoints(0);
+        }
+        if (Shape == EVisualShape::Points || Shape == EVisualShape::Polyline)
+            Clusters.Build(Points, IsTrailWrapped());
+        if (Shape == EVisualShape::Polyline)
+            Simplifier.SetRange(0, Points.Num());
+
+        if (Shape == EVisualShape::Points)
+        {
+            PointsMesh.Build(Points, Radii, GetLocalToWorld().GetScaleVector(), NumSides, Wireframe);
+            return;
+        }
+
+        // Thick lines are built for every view
+        if (Wireframe && !IsLineMesh())
+            return;
+
+        FShapesVisualizerGeometryPool& Pool = FShapesVisualizerGeometryPool::Get();
+        const ERHIFeatureLevel::Type FeatureLevel = GetScene().GetFeatureLevel();
+        for (int32 LODIndex = 0; LODIndex < ShapesVisualizerDrawing::GetNumLODs(NumSides); LODIndex++)
+        {
+            const int32 LODSides = ShapesVisualizerDrawing::GetLODSides(NumSides, LODIndex);
+            if (Shape == EVisualShape::Capsule && !Wireframe)
+            {
+                // The size is known, so the merged capsule is drawn at once instead of the caps and the body of the unit one
+                TArray<FDynamicMeshVertex> MeshVerts;
+                TArray<uint32> MeshIndices;
+                ShapesVisualizerGeometry::BuildShapeVerts(Shape, Radii, Height, Extent, LODSides, MeshVerts, MeshIndices);
+                CapsuleMeshes[LODIndex] = MakeUnique<FShapesVisualizerMeshBuffers>(FeatureLevel);
+                CapsuleMeshes[LODIndex]->Init(MeshVerts, MeshIndices);
+            }
+            else
+                UnitMeshes[LODIndex] = Pool.Acquire(Shape, LODSides, FeatureLevel, Wireframe);
+        }
+    }
+
+    void ReleaseDynamicGeometry()
+    {
+        PointsMesh.Release();
+        GridMesh.Release();
+
+        FShapesVisualizerGeometryPool& Pool = FShapesVisualizerGeometryPool::Get();
+        for (int32 LODIndex = 0; LODIndex < ShapesVisualizerDrawing::MaxLODs; LODIndex++)
+        {
+            Pool.Release(UnitMeshes[LODIndex]);
+            UnitMeshes[LODIndex] = nullptr;
+            if (CapsuleMeshes[LODIndex])
+                CapsuleMeshes[LODIndex]->Release();
+            CapsuleMeshes[LODIndex].Reset();
+        }
+    }
+
     FORCEINLINE static bool SafeWireframe(EVisualShape Shape, bool Wireframe)
     {
         switch (Shape)
         {
         case EVisualShape::HalfSphere:
+        case EVisualShape::Grid:
             return false;
         case EVisualShape::Polyline:
             return true;
@@ -412,6 +783,18 @@ private:
         return Wireframe;
     }
 
+    FORCEINLINE static bool SafeStaticDraw(EVisualShape Shape, bool Wireframe, bool StaticDraw)
+    {
+        switch (Shape)
+        {
+        case EVisualShape::Points:
+        case EVisualShape::Polyline:
+        case EVisualShape::Grid:
+            return false;
+        }
+        return StaticDraw && !Wireframe;
+    }
+
 private:
 
     // Shape
@@ -419,49 +802,461 @@ private:
     float Radii;
     float Height;
     FVector Extent;
-    TArray<FVector> Points;
+    FShapesVisualizerSharedPointStorage Points;
+    // Storage index of every point of the component, Points shapes only
+    TArray<int32> PointPositions;
+    int32 TrailCapacity;
+    int32 TrailHead;
+    FIntVector GridSize;
+    FVector CellSize;
+    // Cells until the grid mesh takes them over
+    TArray<FColor> GridCells;
     // Appearance
     FColor BaseColor;
     bool Wireframe;
     float LineThickness;
     int32 NumSides;
     bool ShowOnlyWhenSelected;
+    int32 Priority;
+    // Static draw path
+    bool StaticDraw;
+    FShapesVisualizerMeshBuffers StaticBuffers;
+    TUniquePtr<FColoredMaterialRenderProxy> StaticMaterial;
+    // Dynamic draw path, shared with other proxies, one per screen size LOD
+    const FShapesVisualizerUnitMesh* UnitMeshes[ShapesVisualizerDrawing::MaxLODs] = {};
+    // Solid capsule of this proxy, merged at its real size
+    TUniquePtr<FShapesVisualizerMeshBuffers> CapsuleMeshes[ShapesVisualizerDrawing::MaxLODs];
+    // Points merged into one draw
+    FShapesVisualizerPointsMesh PointsMesh;
+    // Greedy meshed chunks of the grid
+    FShapesVisualizerGridMesh GridMesh;
+    // Local bounds of runs of points for the per view culling
+    FShapesVisualizerPointClusters Clusters;
+    // Simplified polyline, GetDynamicMeshElements of one proxy never runs concurrently
+    mutable FShapesVisualizerPolylineSimplifier Simplifier;
+    // Colored materials and per view scratch buffers, reused by the next frames
+    mutable FShapesVisualizerMaterialCache Materials;
+    mutable TArray<int32> ScratchVisibleClusters;
+    mutable TArray<FVector> ScratchWorldPoints;
+    mutable TArray<bool> ScratchVisible;
+    mutable TArray<FVector> ScratchLineVerts;
+    mutable TArray<TPair<int32, int32>> ScratchRanges;
+    // Thin polylines and thick lines of the views, rewritten in place by the next frames
+    mutable FShapesVisualizerLineMeshes LineMeshes;
+    // Memory footprint last added to the stats
+    uint32 StatMemoryBytes = 0;
+    // Frame budget shared by all proxies
+    mutable FShapesVisualizerBudget::FProxyState BudgetState;
 };
 
 //
-// UShapesVisualizerComponent
+// Points and grid updates
 //
 
-UShapesVisualizerComponent::UShapesVisualizerComponent(const FObjectInitializer& ObjectInitializer)
-    : Super(ObjectInitializer)
+namespace
 {
-    // Tick
-    PrimaryComponentTick.bCanEverTick = false;
-    PrimaryComponentTick.bStartWithTickEnabled = false;
+    // Runs the command on the existing proxy, false when the proxy is missing or about to be recreated
+    template <typename CommandType>
+    bool EnqueueProxyCommand_Internal(UShapesVisualizerComponent* Component, CommandType&& Command)
+    {
+        FShapesVisualizerSceneProxy* const Proxy = static_cast<FShapesVisualizerSceneProxy*>(Component->SceneProxy);
+        if (!Proxy || Component->IsRenderStateDirty())
+            return false;
 
-    // Collision & Navigation
-    SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
-    SetGenerateOverlapEvents(false);
-    CanCharacterStepUpOn = ECB_No;
-    SetCanEverAffectNavigation(false);
+        ENQUEUE_RENDER_COMMAND(ShapesVisualizerUpdateProxy)(
+            [Proxy, Command = MoveTemp(Command)](FRHICommandListImmediate& RHICmdList) mutable
+            {
+                Command(Proxy);
+                Proxy->UpdateMemoryStat_RenderThread();
+            });
+        return true;
+    }
 
-    // Rendering
-    SetHiddenInGame(true);
-    SetCastShadow(false);
-    SetReceivesDecals(false);
-}
+    template <typename CommandType>
+    bool EnqueuePointsCommand_Internal(UShapesVisualizerComponent* Component, CommandType&& Command)
+    {
+        const bool PointsShape = Component->Shape == EVisualShape::Points || Component->Shape == EVisualShape::Polyline;
+        return PointsShape && EnqueueProxyCommand_Internal(Component, MoveTemp(Command));
+    }
 
-FPrimitiveSceneProxy* UShapesVisualizerComponent::CreateSceneProxy()
-{
-    return new FShapesVisualizerSceneProxy(this);
+    template <typename CommandType>
+    bool EnqueueGridCommand_Internal(UShapesVisualizerComponent* Component, CommandType&& Command)
+    {
+        return Component->Shape == EVisualShape::Grid && EnqueueProxyCommand_Internal(Component, MoveTemp(Command));
+    }
+
+    FORCEINLINE int32 GetNumCells_Internal(const FIntVector& Size)
+    {
+        return Size.X * Size.Y * Size.Z;
+    }
 }
 
-FBoxSphereBounds UShapesVisualizerComponent::CalcBounds(const FTransform& LocalToWorld) const
+//
+// Replication
+//
+
+namespace
 {
-    switch (Shape)
+    enum ENetFlag_Internal : uint8
     {
-    case EVisualShape::Sphere:
-        return FBoxSphereBounds{ LocalToWorld.GetLocation(), FVector{ Radii }, Radii };
+        NetFlagWireframe = 1 << 0,
+        NetFlagHiddenInGame = 1 << 1
+    };
+
+    // Rounded as the quantized vectors send them, so the values compare equal once sent
+    FORCEINLINE FVector QuantizeNet_Internal(const FVector& Vector, float Scale)
+    {
+        return FVector{ FMath::RoundToFloat(Vector.X * Scale), FMath::RoundToFloat(Vector.Y * Scale), FMath::RoundToFloat(Vector.Z * Scale) } / Scale;
+    }
+
+    FORCEINLINE FRotator QuantizeNet_Internal(const FRotator& Rotator)
+    {
+        return FRotator{
+            FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotator.Pitch)),
+            FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotator.Yaw)),
+            FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotator.Roll)) };
+    }
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice NetStatsCommand_Internal(
+        TEXT("ShapesVisualizer.NetStats"),
+        TEXT("Lists the replicated visualizers of the world by the bytes per second they write to all connections.\n")
+        TEXT("ShapesVisualizer.NetStats [Count]"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                TArray<UShapesVisualizerComponent*> Components;
+                float TotalBytesPerSecond = 0.f;
+                ForEachObjectOfClass(UShapesVisualizerComponent::StaticClass(), [&](UObject* Object)
+                {
+                    UShapesVisualizerComponent* const Component = static_cast<UShapesVisualizerComponent*>(Object);
+                    if (Component->GetWorld() == World && Component->GetIsReplicated() && !Component->IsTemplate())
+                    {
+                        Components.Add(Component);
+                        TotalBytesPerSecond += Component->GetNetBytesPerSecond();
+                    }
+                });
+                Components.Sort([](const UShapesVisualizerComponent& A, const UShapesVisualizerComponent& B)
+                {
+                    return A.GetNetBytesPerSecond() > B.GetNetBytesPerSecond();
+                });
+
+                const int32 Count = FMath::Min(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20, Components.Num());
+                Ar.Logf(TEXT("%d replicated visualizers, %.0f bytes/s"), Components.Num(), TotalBytesPerSecond);
+                for (int32 Index = 0; Index < Count; Index++)
+                    Ar.Logf(TEXT("%10.0f bytes/s %s"), Components[Index]->GetNetBytesPerSecond(), *Components[Index]->GetPathName());
+            }));
+}
+
+//
+// FShapesVisualizerNetState
+//
+
+namespace
+{
+    constexpr int32 NumNetStateMembers_Internal = 14;
+
+    // State a connection was sent last, the next delta of the connection is written against it
+    class FShapesVisualizerNetStateBase_Internal : public INetDeltaBaseState
+    {
+    public:
+
+        explicit FShapesVisualizerNetStateBase_Internal(const FShapesVisualizerNetState& InState)
+            : State(InState)
+        {
+        }
+
+        virtual bool IsStateEqual(INetDeltaBaseState* OtherState) override
+        {
+            const FShapesVisualizerNetStateBase_Internal* const Other = static_cast<FShapesVisualizerNetStateBase_Internal*>(OtherState);
+            return Other && State.GetChangedMembers(Other->State) == 0;
+        }
+
+        FShapesVisualizerNetState State;
+    };
+
+    void SerializePacked_Internal(FArchive& Ar, int32& Value)
+    {
+        uint32 Packed = static_cast<uint32>(Value);
+        Ar.SerializeIntPacked(Packed);
+        Value = static_cast<int32>(Packed);
+    }
+}
+
+bool FShapesVisualizerNetState::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+    if (FBitWriter* const Writer = DeltaParms.Writer)
+    {
+        // A new connection starts from the defaults, which its client has as well
+        const FShapesVisualizerNetStateBase_Internal* const OldState = static_cast<FShapesVisualizerNetStateBase_Internal*>(DeltaParms.OldState);
+        uint32 Members = GetChangedMembers(OldState ? OldState->State : FShapesVisualizerNetState{});
+        if (Members == 0)
+            return false;
+
+        const int64 StartBits = Writer->GetNumBits();
+        Writer->SerializeBits(&Members, NumNetStateMembers_Internal);
+        SerializeMembers(*Writer, Members, DeltaParms.Map);
+        BitsSent += Writer->GetNumBits() - StartBits;
+        INC_DWORD_STAT_BY(STAT_ShapesVisualizer_NetBytes, (Writer->GetNumBits() - StartBits + 7) / 8);
+
+        *DeltaParms.NewState = MakeShared<FShapesVisualizerNetStateBase_Internal>(*this);
+        return true;
+    }
+
+    if (FBitReader* const Reader = DeltaParms.Reader)
+    {
+        uint32 Members = 0;
+        Reader->SerializeBits(&Members, NumNetStateMembers_Internal);
+        SerializeMembers(*Reader, Members, DeltaParms.Map);
+        return !Reader->IsError();
+    }
+
+    // Nothing to gather or map, the state holds no object references
+    return false;
+}
+
+int64 FShapesVisualizerNetState::TakeBitsSent()
+{
+    const int64 Bits = BitsSent;
+    BitsSent = 0;
+    return Bits;
+}
+
+uint32 FShapesVisualizerNetState::GetChangedMembers(const FShapesVisualizerNetState& Old) const
+{
+    const bool Changed[NumNetStateMembers_Internal] = {
+        Location != Old.Location,
+        Rotation != Old.Rotation,
+        Scale != Old.Scale,
+        Shape != Old.Shape,
+        Dimensions != Old.Dimensions,
+        Extent != Old.Extent,
+        Color != Old.Color,
+        Flags != Old.Flags,
+        NumSides != Old.NumSides,
+        NumPoints != Old.NumPoints,
+        TrailCapacity != Old.TrailCapacity,
+        TrailHead != Old.TrailHead,
+        TrailPushes != Old.TrailPushes,
+        PointsResets != Old.PointsResets };
+
+    uint32 Members = 0;
+    for (int32 Index = 0; Index < NumNetStateMembers_Internal; Index++)
+        Members |= Changed[Index] ? 1u << Index : 0u;
+    return Members;
+}
+
+void FShapesVisualizerNetState::SerializeMembers(FArchive& Ar, uint32 Members, UPackageMap* Map)
+{
+    // Same order as GetChangedMembers
+    bool Success = true;
+    uint8 ShapeValue = static_cast<uint8>(Shape);
+    int32 Member = 0;
+    auto Has = [Members, &Member]() { return (Members & (1u << Member++)) != 0; };
+
+    if (Has())
+        Location.NetSerialize(Ar, Map, Success);
+    if (Has())
+        Rotation.NetSerialize(Ar, Map, Success);
+    if (Has())
+        Scale.NetSerialize(Ar, Map, Success);
+    if (Has())
+    {
+        Ar << ShapeValue;
+        Shape = static_cast<EVisualShape>(ShapeValue);
+    }
+    if (Has())
+        Dimensions.NetSerialize(Ar, Map, Success);
+    if (Has())
+        Extent.NetSerialize(Ar, Map, Success);
+    if (Has())
+        Ar << Color;
+    if (Has())
+        Ar << Flags;
+    if (Has())
+        Ar << NumSides;
+    if (Has())
+        SerializePacked_Internal(Ar, NumPoints);
+    if (Has())
+        SerializePacked_Internal(Ar, TrailCapacity);
+    if (Has())
+        SerializePacked_Internal(Ar, TrailHead);
+    if (Has())
+        Ar.SerializeIntPacked(TrailPushes);
+    if (Has())
+        Ar.SerializeIntPacked(PointsResets);
+
+    if (!Success)
+        Ar.SetError();
+}
+
+//
+// FShapesVisualizerNetPoints
+//
+
+void FShapesVisualizerNetPoints::SetPoints(TArrayView<const FVector> InPoints)
+{
+    const int32 NumChunks = FMath::DivideAndRoundUp(InPoints.Num(), ChunkSize);
+    if (Chunks.Num() > NumChunks)
+    {
+        Chunks.SetNum(NumChunks);
+        MarkArrayDirty();
+    }
+
+    for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+    {
+        if (ChunkIndex == Chunks.Num())
+            Chunks.AddDefaulted_GetRef().ChunkIndex = ChunkIndex;
+
+        FShapesVisualizerNetPointChunk& Chunk = Chunks[ChunkIndex];
+        const int32 StartIndex = ChunkIndex * ChunkSize;
+        const int32 Count = FMath::Min(ChunkSize, InPoints.Num() - StartIndex);
+
+        bool Changed = Chunk.Points.Num() != Count;
+        Chunk.Points.SetNum(Count);
+        for (int32 Index = 0; Index < Count; Index++)
+        {
+            const FVector Point = QuantizeNet_Internal(InPoints[StartIndex + Index], 10.f);
+            if (Changed || Chunk.Points[Index] != Point)
+            {
+                Chunk.Points[Index] = Point;
+                Changed = true;
+            }
+        }
+        if (Changed)
+            MarkItemDirty(Chunk);
+    }
+}
+
+void FShapesVisualizerNetPoints::GetPoints(int32 NumPoints, TArray<FVector>& OutPoints) const
+{
+    // Chunks may arrive in any order
+    OutPoints.SetNumZeroed(NumPoints);
+    for (const FShapesVisualizerNetPointChunk& Chunk : Chunks)
+    {
+        const int32 StartIndex = Chunk.ChunkIndex * ChunkSize;
+        const int32 Count = FMath::Min(Chunk.Points.Num(), NumPoints - StartIndex);
+        for (int32 Index = 0; Index < Count; Index++)
+            OutPoints[StartIndex + Index] = Chunk.Points[Index];
+    }
+}
+
+bool FShapesVisualizerNetPoints::GetPoints(int32 StartIndex, int32 Count, FVector* OutPoints) const
+{
+    int32 NumCopied = 0;
+    for (const FShapesVisualizerNetPointChunk& Chunk : Chunks)
+    {
+        const int32 ChunkStart = Chunk.ChunkIndex * ChunkSize;
+        const int32 First = FMath::Max(ChunkStart, StartIndex);
+        const int32 Last = FMath::Min(ChunkStart + Chunk.Points.Num(), StartIndex + Count);
+        for (int32 Index = First; Index < Last; Index++)
+            OutPoints[Index - StartIndex] = Chunk.Points[Index - ChunkStart];
+        NumCopied += FMath::Max(Last - First, 0);
+    }
+    return NumCopied == Count;
+}
+
+int64 FShapesVisualizerNetPoints::TakeBitsSent()
+{
+    const int64 Bits = BitsSent;
+    BitsSent = 0;
+    return Bits;
+}
+
+void FShapesVisualizerNetPoints::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+    for (const int32 Index : AddedIndices)
+        ReceivedChunks.Add(Chunks[Index].ChunkIndex);
+}
+
+void FShapesVisualizerNetPoints::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
+{
+    for (const int32 Index : ChangedIndices)
+        ReceivedChunks.Add(Chunks[Index].ChunkIndex);
+}
+
+bool FShapesVisualizerNetPoints::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+    // Called once per connection, what it writes is what the connection gets
+    const int64 StartBits = DeltaParms.Writer ? DeltaParms.Writer->GetNumBits() : 0;
+    const bool Result = FFastArraySerializer::FastArrayDeltaSerialize<FShapesVisualizerNetPointChunk, FShapesVisualizerNetPoints>(Chunks, DeltaParms, *this);
+    if (DeltaParms.Writer)
+    {
+        const int64 Bits = DeltaParms.Writer->GetNumBits() - StartBits;
+        BitsSent += Bits;
+        INC_DWORD_STAT_BY(STAT_ShapesVisualizer_NetBytes, (Bits + 7) / 8);
+    }
+    return Result;
+}
+
+//
+// UShapesVisualizerComponent
+//
+
+UShapesVisualizerComponent::UShapesVisualizerComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    // Tick
+    PrimaryComponentTick.bCanEverTick = false;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+
+    // Collision & Navigation
+    SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+    SetGenerateOverlapEvents(false);
+    CanCharacterStepUpOn = ECB_No;
+    SetCanEverAffectNavigation(false);
+
+    // Rendering
+    SetHiddenInGame(true);
+    SetCastShadow(false);
+    SetReceivesDecals(false);
+}
+
+void UShapesVisualizerComponent::OnRegister()
+{
+    UpdateCompactPoints();
+    PointsBox = CompactPoints ? CompactPoints->GetBox(0, CompactPoints->Num()) : FBox{ Points };
+    Super::OnRegister();
+}
+
+FPrimitiveSceneProxy* UShapesVisualizerComponent::CreateSceneProxy()
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_CreateSceneProxy);
+    return new FShapesVisualizerSceneProxy(this);
+}
+
+void UShapesVisualizerComponent::GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials) const
+{
+    Super::GetUsedMaterials(OutMaterials, bGetDebugMaterials);
+    if (GEngine && GEngine->DebugMeshMaterial)
+        OutMaterials.Add(GEngine->DebugMeshMaterial);
+    if (GEngine && GEngine->WireframeMaterial)
+        OutMaterials.Add(GEngine->WireframeMaterial);
+    if (GEngine && GEngine->VertexColorMaterial)
+        OutMaterials.Add(GEngine->VertexColorMaterial);
+}
+
+void UShapesVisualizerComponent::SendRenderDynamicData_Concurrent()
+{
+    Super::SendRenderDynamicData_Concurrent();
+
+    if (FShapesVisualizerSceneProxy* const Proxy = static_cast<FShapesVisualizerSceneProxy*>(SceneProxy))
+    {
+        const FShapesVisualizerDynamicData Data{ Color, Wireframe, LineThickness, NumSides, Priority };
+        ENQUEUE_RENDER_COMMAND(ShapesVisualizerDynamicData)(
+            [Proxy, Data](FRHICommandListImmediate& RHICmdList)
+            {
+                Proxy->SetDynamicData_RenderThread(Data);
+            });
+    }
+}
+
+FBoxSphereBounds UShapesVisualizerComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_CalcBounds);
+    switch (Shape)
+    {
+    case EVisualShape::Sphere:
+        return FBoxSphereBounds{ LocalToWorld.GetLocation(), FVector{ Radii }, Radii };
     case EVisualShape::HalfSphere:
         return FBoxSphereBounds{ FVector{ 0.f, 0.f, Radii / 2.f },
             FVector{ Radii, Radii, Radii / 2.f }, Radii }.TransformBy(LocalToWorld);
@@ -478,9 +1273,14 @@ FBoxSphereBounds UShapesVisualizerComponent::CalcBounds(const FTransform& LocalT
     case EVisualShape::Points:
     case EVisualShape::Polyline:
     {
-        const FBoxSphereBounds PointsBounds{ Points.GetData(), static_cast<uint32>(Points.Num()) };
-        return PointsBounds.ExpandBy(Radii).TransformBy(LocalToWorld);
+        // PointsBox is maintained by the setters, it is missing only before registration
+        const FBox Box = PointsBox.IsValid || Points.Num() == 0 ? PointsBox : FBox{ Points };
+        if (!Box.IsValid)
+            return FBoxSphereBounds{ LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f };
+        return FBoxSphereBounds{ Box }.ExpandBy(Radii).TransformBy(LocalToWorld);
     }
+    case EVisualShape::Grid:
+        return FBoxSphereBounds{ ShapesVisualizerGeometry::GetGridBox(GridSize, CellSize) }.TransformBy(LocalToWorld);
     }
     return FBoxSphereBounds{ LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f };
 }
@@ -540,37 +1340,756 @@ void UShapesVisualizerComponent::SetCapsuleShape(float InRadii, float InHeight)
     MarkRenderStateDirty();
 }
 
+void UShapesVisualizerComponent::SetSizedShape(EVisualShape InShape, float InRadii, float InHeight, const FVector& InExtent)
+{
+    switch (InShape)
+    {
+    case EVisualShape::Sphere: SetSphereShape(InRadii); break;
+    case EVisualShape::HalfSphere: SetHalfSphereShape(InRadii); break;
+    case EVisualShape::Box: SetBoxShape(InExtent); break;
+    case EVisualShape::Cylinder: SetCylinderShape(InRadii, InHeight); break;
+    case EVisualShape::Cone: SetConeShape(InRadii, InHeight); break;
+    case EVisualShape::Capsule: SetCapsuleShape(InRadii, InHeight); break;
+    default: break;
+    }
+}
+
 void UShapesVisualizerComponent::SetPointsShape(const TArray<FVector>& InPoints)
 {
-    Shape = EVisualShape::Points;
-    Points = InPoints;
-    UpdateBounds();
-    MarkRenderStateDirty();
+    SetPointsShape(TArray<FVector>{ InPoints });
+}
+
+void UShapesVisualizerComponent::SetPointsShape(TArray<FVector>&& InPoints)
+{
+    TrailCapacity = TrailHead = 0;
+    ResetPoints(EVisualShape::Points, MoveTemp(InPoints));
 }
 
 void UShapesVisualizerComponent::SetPolylineShape(const TArray<FVector>& InPoints)
 {
-    Shape = EVisualShape::Polyline;
-    Points = InPoints;
-    UpdateBounds();
-    MarkRenderStateDirty();
+    SetPolylineShape(TArray<FVector>{ InPoints });
+}
+
+void UShapesVisualizerComponent::SetPolylineShape(TArray<FVector>&& InPoints)
+{
+    TrailCapacity = TrailHead = 0;
+    ResetPoints(EVisualShape::Polyline, MoveTemp(InPoints));
+}
+
+void UShapesVisualizerComponent::AppendPoints(const TArray<FVector>& InPoints)
+{
+    AppendPoints(TArray<FVector>{ InPoints });
+}
+
+void UShapesVisualizerComponent::AppendPoints(TArray<FVector>&& InPoints)
+{
+    if (TrailCapacity > 0 && Shape == EVisualShape::Polyline)
+    {
+        // One command for all the points, the proxy keeps only the last lap of the ring
+        if (InPoints.Num() == 0)
+            return;
+
+        const FBox OldBox = PointsBox;
+        AddTrailPoints(InPoints);
+
+        const bool Sent = EnqueuePointsCommand_Internal(this,
+            [NewPoints = MoveTemp(InPoints)](FShapesVisualizerSceneProxy* Proxy)
+            {
+                Proxy->PushTrailPoints_RenderThread(NewPoints);
+            });
+        OnPointsChanged(Sent, !(PointsBox == OldBox));
+        return;
+    }
+
+    UpdatePointRange(GetNumPoints(), MoveTemp(InPoints));
+}
+
+void UShapesVisualizerComponent::UpdatePointRange(int32 StartIndex, const TArray<FVector>& InPoints)
+{
+    UpdatePointRange(StartIndex, TArray<FVector>{ InPoints });
+}
+
+void UShapesVisualizerComponent::UpdatePointRange(int32 StartIndex, TArray<FVector>&& InPoints)
+{
+    if (StartIndex < 0 || StartIndex > GetNumPoints() || InPoints.Num() == 0)
+        return;
+
+    // Clients follow a trail by its pushes, any other edit of the ring sends it whole
+    if (TrailCapacity > 0)
+        PointsResets++;
+    LinearizeTrail();
+
+    // Overwrites existing points and appends the rest
+    if (CompactPoints)
+        GetMutableCompactPoints().Update(StartIndex, InPoints);
+    else
+    {
+        const int32 NumUpdated = FMath::Min(InPoints.Num(), Points.Num() - StartIndex);
+        FMemory::Memcpy(Points.GetData() + StartIndex, InPoints.GetData(), NumUpdated * sizeof(FVector));
+        Points.Append(InPoints.GetData() + NumUpdated, InPoints.Num() - NumUpdated);
+    }
+
+    const FBox OldBox = PointsBox;
+    for (const FVector& Pt : InPoints)
+        PointsBox += Pt;
+
+    const bool Sent = EnqueuePointsCommand_Internal(this,
+        [StartIndex, NewPoints = MoveTemp(InPoints)](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->UpdatePoints_RenderThread(StartIndex, NewPoints);
+        });
+    OnPointsChanged(Sent, !(PointsBox == OldBox));
+
+    // Trail keeps only the newest points
+    if (TrailCapacity > 0 && Points.Num() > TrailCapacity)
+        RemovePointRange(0, Points.Num() - TrailCapacity);
+}
+
+void UShapesVisualizerComponent::RemovePointRange(int32 StartIndex, int32 Count)
+{
+    Count = FMath::Min(Count, GetNumPoints() - StartIndex);
+    if (StartIndex < 0 || Count <= 0)
+        return;
+
+    if (TrailCapacity > 0)
+        PointsResets++;
+    LinearizeTrail();
+
+    // Bounds stay conservative until the points are set again
+    if (CompactPoints)
+        GetMutableCompactPoints().RemoveAt(StartIndex, Count);
+    else
+        Points.RemoveAt(StartIndex, Count, false);
+
+    const bool Sent = EnqueuePointsCommand_Internal(this,
+        [StartIndex, Count](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->RemovePoints_RenderThread(StartIndex, Count);
+        });
+    OnPointsChanged(Sent, false);
+}
+
+void UShapesVisualizerComponent::SetTrailShape(int32 InCapacity)
+{
+    DecodeCompactPoints();
+    TArray<FVector> TrailPoints = Shape == EVisualShape::Polyline ? MoveTemp(Points) : TArray<FVector>{};
+    if (TrailHead != 0)
+        Algo::Rotate(TrailPoints, TrailHead);
+
+    TrailCapacity = FMath::Max(InCapacity, 2);
+    TrailHead = 0;
+    if (TrailPoints.Num() > TrailCapacity)
+        TrailPoints.RemoveAt(0, TrailPoints.Num() - TrailCapacity, false);
+    TrailPoints.Reserve(TrailCapacity);
+
+    ResetPoints(EVisualShape::Polyline, MoveTemp(TrailPoints));
+}
+
+void UShapesVisualizerComponent::PushTrailPoint(const FVector& InPoint)
+{
+    if (TrailCapacity <= 0 || Shape != EVisualShape::Polyline)
+    {
+        UpdatePointRange(GetNumPoints(), TArray<FVector>{ InPoint });
+        return;
+    }
+
+    const FBox OldBox = PointsBox;
+    AddTrailPoints(MakeArrayView(&InPoint, 1));
+
+    const bool Sent = EnqueuePointsCommand_Internal(this,
+        [InPoint](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->PushTrailPoints_RenderThread(MakeArrayView(&InPoint, 1));
+        });
+    OnPointsChanged(Sent, !(PointsBox == OldBox));
+}
+
+void UShapesVisualizerComponent::AddTrailPoints(TArrayView<const FVector> InPoints)
+{
+    TrailPushes += InPoints.Num();
+    bool Lapped = false;
+    for (const FVector& Pt : InPoints)
+    {
+        if (Points.Num() < TrailCapacity)
+            Points.Add(Pt);
+        else
+        {
+            Points[TrailHead] = Pt;
+            TrailHead = (TrailHead + 1) % TrailCapacity;
+            Lapped |= TrailHead == 0;
+        }
+        PointsBox += Pt;
+    }
+
+    // Bounds grow with every point and get exact again once per lap of the ring
+    if (Lapped)
+        PointsBox = FBox{ Points };
+}
+
+void UShapesVisualizerComponent::SetGridShape(const FIntVector& InGridSize, const FVector& InCellSize, const TArray<FColor>& InCells)
+{
+    SetGridShape(InGridSize, InCellSize, TArray<FColor>{ InCells });
+}
+
+void UShapesVisualizerComponent::SetGridShape(const FIntVector& InGridSize, const FVector& InCellSize, TArray<FColor>&& InCells)
+{
+    const FIntVector NewGridSize{ FMath::Max(InGridSize.X, 0), FMath::Max(InGridSize.Y, 0), FMath::Max(InGridSize.Z, 0) };
+    const bool SameGrid = Shape == EVisualShape::Grid && GridSize == NewGridSize && CellSize == InCellSize;
+
+    Shape = EVisualShape::Grid;
+    GridSize = NewGridSize;
+    CellSize = InCellSize;
+    GridCells = MoveTemp(InCells);
+    // Missing cells are empty
+    GridCells.SetNumZeroed(GetNumCells_Internal(GridSize));
+
+    // Same sized grids keep the proxy and its buffers, all chunks are remeshed
+    const bool Sent = SameGrid && EnqueueGridCommand_Internal(this,
+        [NewCells = GridCells, NewGridSize](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->UpdateGridCells_RenderThread(FIntVector::ZeroValue, NewGridSize, NewCells);
+        });
+    if (!Sent)
+    {
+        UpdateBounds();
+        MarkRenderStateDirty();
+    }
+}
+
+void UShapesVisualizerComponent::SetGridCells(const FIntVector& Start, const FIntVector& Size, const TArray<FColor>& InCells)
+{
+    const FIntVector End = Start + Size;
+    if (Shape != EVisualShape::Grid || Size.GetMin() <= 0 || Start.GetMin() < 0
+        || End.X > GridSize.X || End.Y > GridSize.Y || End.Z > GridSize.Z || InCells.Num() != GetNumCells_Internal(Size))
+        return;
+
+    for (int32 Z = 0; Z < Size.Z; Z++)
+    {
+        for (int32 Y = 0; Y < Size.Y; Y++)
+        {
+            FMemory::Memcpy(&GridCells[ShapesVisualizerGeometry::GetGridCellIndex(GridSize, Start.X, Start.Y + Y, Start.Z + Z)],
+                &InCells[ShapesVisualizerGeometry::GetGridCellIndex(Size, 0, Y, Z)], Size.X * sizeof(FColor));
+        }
+    }
+
+    const bool Sent = EnqueueGridCommand_Internal(this,
+        [Start, Size, NewCells = InCells](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->UpdateGridCells_RenderThread(Start, Size, NewCells);
+        });
+    if (!Sent)
+        MarkRenderStateDirty();
+}
+
+void UShapesVisualizerComponent::SetGridCell(const FIntVector& Cell, const FColor& InColor)
+{
+    SetGridCells(Cell, FIntVector{ 1 }, TArray<FColor>{ InColor });
+}
+
+void UShapesVisualizerComponent::SetGridValues(const TArray<float>& Values, float MinValue, float MaxValue,
+    FColor LowColor, FColor HighColor, int32 NumSteps)
+{
+    NumSteps = FMath::Max(NumSteps, 1);
+    TArray<FColor, TInlineAllocator<16>> Palette;
+    for (int32 Step = 0; Step < NumSteps; Step++)
+    {
+        const float Alpha = NumSteps > 1 ? static_cast<float>(Step) / (NumSteps - 1) : 0.f;
+        FColor& StepColor = Palette.Add_GetRef(
+            FLinearColor::LerpUsingHSV(FLinearColor{ LowColor }, FLinearColor{ HighColor }, Alpha).ToFColor(true));
+        StepColor.A = 255;
+    }
+
+    const float Range = MaxValue - MinValue;
+    TArray<FColor> Cells;
+    Cells.SetNumZeroed(GetNumCells_Internal(GridSize));
+    for (int32 Index = 0; Index < FMath::Min(Values.Num(), Cells.Num()); Index++)
+    {
+        const float Value = Values[Index];
+        if (Value < MinValue)
+            continue;
+        const int32 Step = Range > 0.f ? FMath::FloorToInt((Value - MinValue) / Range * NumSteps) : NumSteps - 1;
+        Cells[Index] = Palette[FMath::Clamp(Step, 0, NumSteps - 1)];
+    }
+    SetGridShape(GridSize, CellSize, MoveTemp(Cells));
+}
+
+void UShapesVisualizerComponent::SetPriority(int32 InPriority)
+{
+    Priority = InPriority;
+    MarkRenderDynamicDataDirty();
+}
+
+void UShapesVisualizerComponent::SetPointsFormat(EVisualPointsFormat InPointsFormat)
+{
+    if (PointsFormat == InPointsFormat)
+        return;
+
+    DecodeCompactPoints();
+    PointsFormat = InPointsFormat;
+    UpdateCompactPoints();
+    if (Shape == EVisualShape::Points || Shape == EVisualShape::Polyline)
+        MarkRenderStateDirty();
+}
+
+void UShapesVisualizerComponent::SetKeepPoints(bool InKeepPoints)
+{
+    // Only the game thread copy changes, the proxy keeps its points
+    KeepPoints = InKeepPoints;
+    UpdateCompactPoints();
+}
+
+TArray<FVector> UShapesVisualizerComponent::GetPoints() const
+{
+    TArray<FVector> Result;
+    if (CompactPoints)
+        CompactPoints->GetPoints(Result);
+    else
+        Result = Points;
+    return Result;
+}
+
+int32 UShapesVisualizerComponent::GetNumPoints() const
+{
+    return CompactPoints ? CompactPoints->Num() : Points.Num();
+}
+
+TArrayView<const FVector> UShapesVisualizerComponent::GetPoints(TArray<FVector>& Scratch) const
+{
+    if (!CompactPoints)
+        return Points;
+    CompactPoints->GetPoints(Scratch);
+    return Scratch;
+}
+
+void UShapesVisualizerComponent::ReservePoints(int32 Number)
+{
+    ReservedPoints = Number;
+    if (CompactPoints && (CompactPoints.GetSharedReferenceCount() == 1 || CompactPoints->Num() == 0))
+        GetMutableCompactPoints().Reserve(Number);
+    else
+        Points.Reserve(Number);
+
+    // A proxy made later reserves them itself
+    EnqueuePointsCommand_Internal(this,
+        [Number](FShapesVisualizerSceneProxy* Proxy)
+        {
+            Proxy->ReservePoints_RenderThread(Number);
+        });
 }
 
 void UShapesVisualizerComponent::SetColor(const FColor& InColor)
 {
     Color = InColor;
-    MarkRenderStateDirty();
+    MarkAppearanceDirty();
 }
 
 void UShapesVisualizerComponent::SetWireframe(bool InWireframe, float InLineThickness)
 {
     Wireframe = InWireframe;
     LineThickness = FMath::Max(0.f, InLineThickness);
-    MarkRenderStateDirty();
+    MarkAppearanceDirty();
 }
 
 void UShapesVisualizerComponent::SetNumSides(int32 InNumSides)
 {
     NumSides = FMath::Clamp(InNumSides, 8, 64);
-    MarkRenderStateDirty();
+    MarkAppearanceDirty();
+}
+
+bool UShapesVisualizerComponent::GetSolidMesh(FShapesVisualizerSolidMesh& OutMesh) const
+{
+    const int32 Sides = FMath::Clamp(NumSides, 8, 64);
+    TArray<FDynamicMeshVertex> MeshVerts;
+    TArray<uint32> MeshIndices;
+    OutMesh.Scale = FVector::OneVector;
+
+    switch (Shape)
+    {
+    case EVisualShape::Sphere:
+    case EVisualShape::HalfSphere:
+        // Same unit meshes as the geometry pool, scaled the way DrawShape does
+        ShapesVisualizerGeometry::BuildShapeVerts(Shape, 1.f, 2.f, FVector::OneVector, Sides, MeshVerts, MeshIndices);
+        OutMesh.Scale = FVector{ Radii };
+        break;
+    case EVisualShape::Box:
+        ShapesVisualizerGeometry::BuildShapeVerts(Shape, 1.f, 2.f, FVector::OneVector, Sides, MeshVerts, MeshIndices);
+        OutMesh.Scale = Extent;
+        break;
+    case EVisualShape::Cylinder:
+    case EVisualShape::Cone:
+        ShapesVisualizerGeometry::BuildShapeVerts(Shape, 1.f, 2.f, FVector::OneVector, Sides, MeshVerts, MeshIndices);
+        OutMesh.Scale = FVector{ Radii, Radii, Height / 2.f };
+        break;
+    case EVisualShape::Capsule:
+        // Scaling would stretch the caps
+        ShapesVisualizerGeometry::BuildShapeVerts(Shape, Radii, Height, Extent, Sides, MeshVerts, MeshIndices);
+        break;
+    case EVisualShape::Points:
+    {
+        TArray<FVector> Scratch;
+        const TArrayView<const FVector> MeshPoints = GetPoints(Scratch);
+        if (MeshPoints.Num() == 0)
+            return false;
+        ShapesVisualizerGeometry::BuildPointsVerts(MeshPoints, Radii, GetComponentScale(),
+            ShapesVisualizerGeometry::GetPointsSides(MeshPoints.Num(), Sides), MeshVerts, MeshIndices);
+        break;
+    }
+    case EVisualShape::Grid:
+        // All chunks at once, the faces between them are hidden the same way
+        if (ShapesVisualizerGeometry::BuildGridVerts(GridCells, GridSize, CellSize,
+            FIntVector::ZeroValue, GridSize, MeshVerts, MeshIndices) == 0)
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    OutMesh.Positions.Reset(MeshVerts.Num());
+    OutMesh.TangentsX.Reset(MeshVerts.Num());
+    OutMesh.TangentsY.Reset(MeshVerts.Num());
+    OutMesh.Normals.Reset(MeshVerts.Num());
+    OutMesh.UVs.Reset(MeshVerts.Num());
+    OutMesh.Colors.Reset(Shape == EVisualShape::Grid ? MeshVerts.Num() : 0);
+    for (const FDynamicMeshVertex& Vertex : MeshVerts)
+    {
+        if (Shape == EVisualShape::Grid)
+            OutMesh.Colors.Add(Vertex.Color);
+        OutMesh.Positions.Add(FVector{ Vertex.Position });
+        OutMesh.TangentsX.Add(FVector{ Vertex.TangentX.ToFVector() });
+        OutMesh.TangentsY.Add(FVector{ Vertex.GetTangentY() });
+        OutMesh.Normals.Add(FVector{ Vertex.TangentZ.ToFVector() });
+        OutMesh.UVs.Add(FVector2D{ Vertex.TextureCoordinate[0] });
+    }
+    OutMesh.Indices = MoveTemp(MeshIndices);
+    return true;
+}
+
+void UShapesVisualizerComponent::ResetPoints(EVisualShape InShape, TArray<FVector>&& InPoints)
+{
+    const bool SameShape = Shape == InShape;
+    Shape = InShape;
+    PointsResets++;
+    ReservedPoints = 0;
+    CompactPoints.Reset();
+    Points = MoveTemp(InPoints);
+    PointsBox = FBox{ Points };
+    UpdateCompactPoints();
+
+    // The existing proxy gets a single copy of the points in its format instead of being recreated,
+    // encoded here and moved through the command into the proxy. Compact points are encoded once
+    // and shared with the proxy
+    const bool Sent = SameShape && EnqueuePointsCommand_Internal(this,
+        [NewPoints = MakeProxyPoints_Internal(this), NewCapacity = TrailCapacity, NewHead = TrailHead](FShapesVisualizerSceneProxy* Proxy) mutable
+        {
+            Proxy->SetPoints_RenderThread(MoveTemp(NewPoints), NewCapacity, NewHead);
+        });
+    OnPointsChanged(Sent, true);
+}
+
+void UShapesVisualizerComponent::UpdateCompactPoints()
+{
+    // Trails rotate their ring in Points, editor worlds save Points with the level
+    const UWorld* const World = GetWorld();
+    const bool Compact = !KeepPoints && TrailCapacity == 0 && PointsFormat != EVisualPointsFormat::Vector
+        && (!World || World->IsGameWorld());
+    if (!Compact)
+    {
+        DecodeCompactPoints();
+        return;
+    }
+    if (CompactPoints)
+        return;
+
+    // Float is the same as Vector before UE5, there is nothing to save
+    TSharedRef<FShapesVisualizerPointStorage, ESPMode::ThreadSafe> NewPoints = MakeShared<FShapesVisualizerPointStorage, ESPMode::ThreadSafe>(PointsFormat, Points);
+    if (NewPoints->GetFormat() == EVisualPointsFormat::Vector)
+        return;
+    CompactPoints = NewPoints;
+    Points.Empty();
+}
+
+FShapesVisualizerPointStorage& UShapesVisualizerComponent::GetMutableCompactPoints()
+{
+    if (CompactPoints.GetSharedReferenceCount() > 1)
+        CompactPoints = MakeShared<FShapesVisualizerPointStorage, ESPMode::ThreadSafe>(*CompactPoints);
+    return *CompactPoints;
+}
+
+void UShapesVisualizerComponent::DecodeCompactPoints()
+{
+    if (!CompactPoints)
+        return;
+    CompactPoints->GetPoints(Points);
+    CompactPoints.Reset();
+}
+
+void UShapesVisualizerComponent::OnPointsChanged(bool Sent, bool BoundsChanged)
+{
+    PointsSerial++;
+    if (Shape != EVisualShape::Points && Shape != EVisualShape::Polyline)
+        return;
+
+    if (BoundsChanged || !Sent)
+        UpdateBounds();
+
+    if (!Sent)
+        MarkRenderStateDirty();
+    else if (BoundsChanged)
+        MarkRenderTransformDirty();
+}
+
+void UShapesVisualizerComponent::MarkAppearanceDirty()
+{
+    // Static draw bakes the appearance into the cached mesh draw commands
+    if (StaticDraw)
+        MarkRenderStateDirty();
+    else
+        MarkRenderDynamicDataDirty();
+}
+
+void UShapesVisualizerComponent::LinearizeTrail()
+{
+    if (TrailHead == 0)
+        return;
+
+    Algo::Rotate(Points, TrailHead);
+    TrailHead = 0;
+
+    const bool Sent = EnqueuePointsCommand_Internal(this,
+        [NewPoints = FShapesVisualizerSharedPointStorage{ FShapesVisualizerPointStorage{ PointsFormat, Points } }, NewCapacity = TrailCapacity](FShapesVisualizerSceneProxy* Proxy) mutable
+        {
+            Proxy->SetPoints_RenderThread(MoveTemp(NewPoints), NewCapacity, 0);
+        });
+    OnPointsChanged(Sent, false);
+}
+
+//
+// Replication
+//
+
+void UShapesVisualizerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    // The relative transform goes quantized in NetState
+    DISABLE_REPLICATED_PRIVATE_PROPERTY(USceneComponent, RelativeLocation);
+    DISABLE_REPLICATED_PRIVATE_PROPERTY(USceneComponent, RelativeRotation);
+    DISABLE_REPLICATED_PRIVATE_PROPERTY(USceneComponent, RelativeScale3D);
+
+    DOREPLIFETIME(UShapesVisualizerComponent, NetState);
+    DOREPLIFETIME(UShapesVisualizerComponent, NetPoints);
+}
+
+void UShapesVisualizerComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+    Super::PreReplication(ChangedPropertyTracker);
+    UpdateNetState();
+}
+
+void UShapesVisualizerComponent::UpdateNetState()
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_Replication);
+
+    // The connections were written after the last PreReplication
+    const float TimeSeconds = GetWorld()->GetTimeSeconds();
+    AddNetBytes(static_cast<int32>((NetState.TakeBitsSent() + NetPoints.TakeBitsSent() + 7) / 8), TimeSeconds);
+
+    if (TimeSeconds - LastNetUpdateTime < NetUpdateInterval)
+        return;
+    LastNetUpdateTime = TimeSeconds;
+
+    // Hidden visualizers have nothing to show on the clients, they keep the last sent state
+    // and only the hidden flag goes until they are shown again
+    FShapesVisualizerNetState NewState = NetState;
+    const bool Shown = IsVisible() && !bHiddenInGame;
+    if (Shown)
+    {
+        NewState.Location = QuantizeNet_Internal(GetRelativeLocation(), 10.f);
+        NewState.Rotation = QuantizeNet_Internal(GetRelativeRotation());
+        NewState.Scale = QuantizeNet_Internal(GetRelativeScale3D(), 100.f);
+        NewState.Shape = Shape;
+        NewState.Dimensions = QuantizeNet_Internal(FVector{ Radii, Height, LineThickness }, 10.f);
+        NewState.Extent = QuantizeNet_Internal(Extent, 10.f);
+        NewState.Color = Color;
+        NewState.Flags = static_cast<uint8>(Wireframe ? NetFlagWireframe : 0u);
+        NewState.NumSides = static_cast<uint8>(FMath::Clamp(NumSides, 8, 64));
+        NewState.NumPoints = GetNumPoints();
+        NewState.TrailCapacity = TrailCapacity;
+        NewState.TrailHead = TrailHead;
+        NewState.TrailPushes = TrailPushes;
+        NewState.PointsResets = PointsResets;
+    }
+    NewState.Flags = static_cast<uint8>((NewState.Flags & ~NetFlagHiddenInGame) | (bHiddenInGame ? NetFlagHiddenInGame : 0u));
+    NetState = NewState;
+
+    const bool PointsShape = Shape == EVisualShape::Points || Shape == EVisualShape::Polyline;
+    if (Shown && PointsShape && PointsSerial != NetPointsSerial)
+    {
+        NetPointsSerial = PointsSerial;
+        TArray<FVector> Scratch;
+        NetPoints.SetPoints(GetPoints(Scratch));
+    }
+}
+
+void UShapesVisualizerComponent::AddNetBytes(int32 Bytes, float TimeSeconds)
+{
+    NetBytes += Bytes;
+    if (TimeSeconds - NetBytesTime >= 1.f)
+    {
+        NetBytesPerSecond = NetBytes / (TimeSeconds - NetBytesTime);
+        NetBytes = 0;
+        NetBytesTime = TimeSeconds;
+    }
+}
+
+void UShapesVisualizerComponent::OnRep_NetState()
+{
+    const FShapesVisualizerNetState& State = NetState;
+    const FShapesVisualizerNetState OldNetState = AppliedNetState;
+    AppliedNetState = State;
+
+    // The root component moves with the replicated movement of its actor
+    const bool TransformChanged = State.Location != OldNetState.Location
+        || State.Rotation != OldNetState.Rotation || State.Scale != OldNetState.Scale;
+    if (TransformChanged && GetOwner() && GetOwner()->GetRootComponent() != this)
+        SetRelativeTransform(FTransform{ State.Rotation, State.Location, State.Scale });
+
+    SetHiddenInGame((State.Flags & NetFlagHiddenInGame) != 0);
+
+    if (State.Color != OldNetState.Color || State.Flags != OldNetState.Flags
+        || State.NumSides != OldNetState.NumSides || State.Dimensions.Z != OldNetState.Dimensions.Z)
+    {
+        Color = State.Color;
+        Wireframe = (State.Flags & NetFlagWireframe) != 0;
+        LineThickness = State.Dimensions.Z;
+        NumSides = State.NumSides;
+        MarkAppearanceDirty();
+    }
+
+    const bool SizeChanged = State.Shape != OldNetState.Shape
+        || State.Dimensions.X != OldNetState.Dimensions.X || State.Dimensions.Y != OldNetState.Dimensions.Y
+        || State.Extent != OldNetState.Extent;
+    if (State.Shape != EVisualShape::Points && State.Shape != EVisualShape::Polyline)
+    {
+        if (SizeChanged)
+            SetSizedShape(State.Shape, State.Dimensions.X, State.Dimensions.Y, State.Extent);
+        return;
+    }
+
+    // Points are applied in PostRepNotifies, together with the chunks of the same update
+    if (SizeChanged || State.NumPoints != OldNetState.NumPoints || State.TrailCapacity != OldNetState.TrailCapacity
+        || State.TrailHead != OldNetState.TrailHead || State.TrailPushes != OldNetState.TrailPushes
+        || State.PointsResets != OldNetState.PointsResets)
+    {
+        if (Radii != State.Dimensions.X)
+        {
+            Radii = State.Dimensions.X;
+            MarkRenderStateDirty();
+        }
+        NetPointsDirty = true;
+    }
+}
+
+void UShapesVisualizerComponent::OnRep_NetPoints()
+{
+    NetPointsDirty = true;
+}
+
+void UShapesVisualizerComponent::PostRepNotifies()
+{
+    Super::PostRepNotifies();
+
+    if (!NetPointsDirty)
+        return;
+    NetPointsDirty = false;
+    TArray<int32> Chunks = MoveTemp(NetPoints.ReceivedChunks);
+    const FShapesVisualizerNetState& State = NetState;
+    if (State.Shape != EVisualShape::Points && State.Shape != EVisualShape::Polyline)
+        return;
+
+    // Chunks and trail pushes change the points the client has, anything else rebuilds them
+    bool Rebuild = Shape != State.Shape || TrailCapacity != State.TrailCapacity || NetPointsResets != State.PointsResets;
+    if (!Rebuild)
+        Rebuild = TrailCapacity > 0 ? !ApplyNetTrailPushes(Chunks) : !ApplyNetChunks(MoveTemp(Chunks));
+    if (Rebuild)
+    {
+        TArray<FVector> NewPoints;
+        NetPoints.GetPoints(State.NumPoints, NewPoints);
+        TrailCapacity = State.TrailCapacity;
+        TrailHead = State.TrailHead < NewPoints.Num() ? State.TrailHead : 0;
+        ResetPoints(State.Shape, MoveTemp(NewPoints));
+    }
+    NetTrailPushes = State.TrailPushes;
+    NetPointsResets = State.PointsResets;
+}
+
+bool UShapesVisualizerComponent::ApplyNetChunks(TArray<int32>&& Chunks)
+{
+    // Runs of adjacent chunks go in one update, chunks past the end are removed below
+    const int32 NumPoints = NetState.NumPoints;
+    Chunks.Sort();
+    int32 Index = 0;
+    while (Index < Chunks.Num())
+    {
+        const int32 StartIndex = Chunks[Index] * FShapesVisualizerNetPoints::ChunkSize;
+        int32 EndChunk = Chunks[Index++] + 1;
+        for (; Index < Chunks.Num() && Chunks[Index] <= EndChunk; Index++)
+            EndChunk = Chunks[Index] + 1;
+
+        const int32 Count = FMath::Min(EndChunk * FShapesVisualizerNetPoints::ChunkSize, NumPoints) - StartIndex;
+        if (Count <= 0)
+            continue;
+        if (StartIndex > GetNumPoints())
+            return false;
+
+        TArray<FVector> RunPoints;
+        RunPoints.SetNumUninitialized(Count);
+        if (!NetPoints.GetPoints(StartIndex, Count, RunPoints.GetData()))
+            return false;
+        UpdatePointRange(StartIndex, MoveTemp(RunPoints));
+    }
+
+    if (GetNumPoints() > NumPoints)
+        RemovePointRange(NumPoints, GetNumPoints() - NumPoints);
+    return GetNumPoints() == NumPoints;
+}
+
+bool UShapesVisualizerComponent::ApplyNetTrailPushes(const TArray<int32>& Chunks)
+{
+    // Chunks without pushes arrived apart from their state, the ring is rebuilt from them
+    const FShapesVisualizerNetState& State = NetState;
+    const uint32 NumPushed = State.TrailPushes - NetTrailPushes;
+    if (NumPushed == 0)
+        return Chunks.Num() == 0 && GetNumPoints() == State.NumPoints && TrailHead == State.TrailHead;
+    if (NumPushed >= static_cast<uint32>(TrailCapacity) || static_cast<int32>(NumPushed) > State.NumPoints)
+        return false;
+
+    // The pushed points are the newest ones of the ring, oldest first from the head once it is full.
+    // They are at most two runs, both have to be in the chunks of this update
+    const int32 NumPoints = State.NumPoints;
+    const int32 Head = NumPoints < TrailCapacity ? 0 : State.TrailHead;
+    const int32 StartIndex = (Head + NumPoints - static_cast<int32>(NumPushed)) % NumPoints;
+    const int32 FirstCount = FMath::Min(static_cast<int32>(NumPushed), NumPoints - StartIndex);
+    const int32 Runs[2][2] = { { StartIndex, FirstCount }, { 0, static_cast<int32>(NumPushed) - FirstCount } };
+
+    TArray<FVector> Pushed;
+    Pushed.SetNumUninitialized(NumPushed);
+    FVector* Out = Pushed.GetData();
+    for (const auto& Run : Runs)
+    {
+        if (Run[1] == 0)
+            continue;
+        const int32 LastChunk = (Run[0] + Run[1] - 1) / FShapesVisualizerNetPoints::ChunkSize;
+        for (int32 ChunkIndex = Run[0] / FShapesVisualizerNetPoints::ChunkSize; ChunkIndex <= LastChunk; ChunkIndex++)
+        {
+            if (!Chunks.Contains(ChunkIndex))
+                return false;
+        }
+        if (!NetPoints.GetPoints(Run[0], Run[1], Out))
+            return false;
+        Out += Run[1];
+    }
+
+    AppendPoints(MoveTemp(Pushed));
+    return GetNumPoints() == State.NumPoints && TrailHead == State.TrailHead;
 }
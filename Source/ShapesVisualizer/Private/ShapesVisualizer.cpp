@@ -1,5 +1,31 @@
 // Copyright (c) 2003-2022 rionix. All Rights Reserved.
 
 #include "Modules/ModuleManager.h"
-	
-IMPLEMENT_MODULE(FDefaultModuleImpl, ShapesVisualizer)
\ No newline at end of file
+#include "Misc/CoreDelegates.h"
+#include "ShapesVisualizerCommands.h"
+
+//
+// FShapesVisualizerModule
+//
+
+class FShapesVisualizerModule : public IModuleInterface
+{
+public:
+
+    virtual void StartupModule() override
+    {
+        // Commands of the worker threads are applied before the world ticks
+        BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddStatic(&FShapesVisualizerCommands::Flush);
+    }
+
+    virtual void ShutdownModule() override
+    {
+        FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+    }
+
+private:
+
+    FDelegateHandle BeginFrameHandle;
+};
+
+IMPLEMENT_MODULE(FShapesVisualizerModule, ShapesVisualizer)
@@ -0,0 +1,242 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerBatchMesh.h"
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerGeometryPool.h"
+#include "ShapesVisualizerStats.h"
+
+//
+// Internal functions
+//
+
+namespace
+{
+    constexpr int32 NumSizedShapes_Internal = static_cast<int32>(EVisualShape::Capsule) + 1;
+
+    // Vertices referenced by a part of the unit mesh, copied once so every entry transforms them with the part
+    struct FUnitPart_Internal
+    {
+        TArray<FDynamicMeshVertex> Verts;
+        // Relative to the first vertex of the part
+        TArray<uint32> Indices;
+    };
+
+    void BuildUnitParts_Internal(const TArray<FDynamicMeshVertex>& UnitVerts, const TArray<uint32>& UnitIndices,
+        const ShapesVisualizerDrawing::FUnitMeshPart* Parts, int32 NumParts, FUnitPart_Internal OutParts[3])
+    {
+        TArray<int32> Remap;
+        for (int32 PartIndex = 0; PartIndex < NumParts; PartIndex++)
+        {
+            FUnitPart_Internal& OutPart = OutParts[PartIndex];
+            Remap.Init(INDEX_NONE, UnitVerts.Num());
+            for (int32 Index = Parts[PartIndex].FirstIndex; Index < Parts[PartIndex].FirstIndex + Parts[PartIndex].NumIndices; Index++)
+            {
+                const uint32 UnitIndex = UnitIndices[Index];
+                if (Remap[UnitIndex] == INDEX_NONE)
+                    Remap[UnitIndex] = OutPart.Verts.Add(UnitVerts[UnitIndex]);
+                OutPart.Indices.Add(Remap[UnitIndex]);
+            }
+        }
+    }
+}
+
+//
+// FShapesVisualizerBatchMesh
+//
+
+void FShapesVisualizerBatchMesh::Build(const FShapesVisualizerBatchArrays& Batch, int32 InNumSides, bool LineMeshes)
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_BuildBatchMesh);
+
+    Release();
+    NumSides = InNumSides;
+
+    // Solid and line slots of every shape type, in the slot order
+    TArray<int32> GroupSlots[NumSizedShapes_Internal * 2];
+    for (int32 Index = 0; Index < Batch.Num(); Index++)
+    {
+        if (!Batch.IsUsed(Index))
+            continue;
+
+        const bool Wireframe = Batch.IsWireframe(Index);
+        if (Wireframe && !LineMeshes)
+        {
+            NumThickShapes++;
+            continue;
+        }
+        GroupSlots[static_cast<int32>(Batch.Shapes[Index]) * 2 + (Wireframe ? 1 : 0)].Add(Index);
+    }
+
+    int32 NumEntries = 0;
+    for (const TArray<int32>& Slots : GroupSlots)
+        NumEntries += Slots.Num();
+    EntrySpheres.SetNumUninitialized(NumEntries);
+
+    NumEntries = 0;
+    for (int32 GroupIndex = 0; GroupIndex < UE_ARRAY_COUNT(GroupSlots); GroupIndex++)
+    {
+        if (GroupSlots[GroupIndex].Num() == 0)
+            continue;
+
+        FGroup* const Group = new FGroup;
+        Group->Shape = static_cast<EVisualShape>(GroupIndex / 2);
+        Group->Lines = (GroupIndex & 1) != 0;
+        Group->FirstEntry = NumEntries;
+        Group->NumEntries = GroupSlots[GroupIndex].Num();
+        BuildGroup(*Group, Batch, GroupSlots[GroupIndex]);
+        Groups.Add(Group);
+        NumEntries += Group->NumEntries;
+    }
+}
+
+void FShapesVisualizerBatchMesh::Release()
+{
+    for (FGroup& Group : Groups)
+    {
+        for (TUniquePtr<FShapesVisualizerMeshBuffers>& Buffers : Group.Buffers)
+        {
+            if (Buffers)
+                Buffers->Release();
+        }
+    }
+    Groups.Empty();
+    EntrySpheres.Reset();
+    NumThickShapes = 0;
+}
+
+SIZE_T FShapesVisualizerBatchMesh::GetAllocatedSize() const
+{
+    SIZE_T Size = Groups.GetAllocatedSize() + EntrySpheres.GetAllocatedSize();
+    for (const FGroup& Group : Groups)
+    {
+        Size += sizeof(FGroup);
+        for (const TUniquePtr<FShapesVisualizerMeshBuffers>& Buffers : Group.Buffers)
+            Size += Buffers ? sizeof(FShapesVisualizerMeshBuffers) + Buffers->GetAllocatedSize() : 0;
+    }
+    return Size;
+}
+
+int32 FShapesVisualizerBatchMesh::GetEntryLOD(const FGroup& Group, int32 ViewSides) const
+{
+    return FMath::Clamp(ShapesVisualizerDrawing::GetLODIndex(NumSides, ViewSides), Group.FirstLOD, Group.NumLODs - 1);
+}
+
+void FShapesVisualizerBatchMesh::BuildGroup(FGroup& Group, const FShapesVisualizerBatchArrays& Batch, TArrayView<const int32> Slots)
+{
+    // Spheres for the per view LOD, around the boxes CalcBounds sees
+    ShapesVisualizerGeometry::ParallelForChunks(Slots.Num(), [&](int32 StartIndex, int32 EndIndex)
+    {
+        for (int32 EntryIndex = StartIndex; EntryIndex < EndIndex; EntryIndex++)
+        {
+            const int32 Slot = Slots[EntryIndex];
+            const FTransform& Transform = Batch.Transforms[Slot];
+            const FBox ShapeBox = ShapesVisualizerDrawing::GetShapeBox(Batch.Shapes[Slot], Batch.Radii[Slot], Batch.Heights[Slot], Batch.Extents[Slot]);
+            EntrySpheres[Group.FirstEntry + EntryIndex] = FSphere{ Transform.TransformPosition(ShapeBox.GetCenter()),
+                ShapeBox.GetExtent().Size() * Transform.GetMaximumAxisScale() };
+        }
+    });
+
+    // Box does not depend on the number of sides
+    Group.NumLODs = Group.Shape == EVisualShape::Box ? 1 : ShapesVisualizerDrawing::GetNumLODs(NumSides);
+    Group.FirstLOD = Group.NumLODs - 1;
+
+    // Coarse to fine, the coarsest one is always built
+    for (int32 LODIndex = Group.NumLODs - 1; LODIndex >= 0; LODIndex--)
+    {
+        TArray<FDynamicMeshVertex> UnitVerts;
+        TArray<uint32> UnitIndices;
+        int32 SplitIndex = 0;
+        int32 BodyIndex = 0;
+        FShapesVisualizerGeometryPool::BuildUnitMesh(Group.Shape, ShapesVisualizerDrawing::GetLODSides(NumSides, LODIndex), Group.Lines,
+            UnitVerts, UnitIndices, SplitIndex, BodyIndex);
+
+        // Ranges of the parts are the same for every size
+        ShapesVisualizerDrawing::FUnitMeshPart Parts[3];
+        const int32 NumParts = ShapesVisualizerDrawing::GetUnitMeshParts(Group.Shape, 1.f, 2.f, FVector::OneVector,
+            SplitIndex, BodyIndex, UnitIndices.Num(), Parts);
+        FUnitPart_Internal UnitParts[3];
+        BuildUnitParts_Internal(UnitVerts, UnitIndices, Parts, NumParts, UnitParts);
+
+        int32 VertsPerEntry = 0;
+        int32 IndicesPerEntry = 0;
+        for (int32 PartIndex = 0; PartIndex < NumParts; PartIndex++)
+        {
+            VertsPerEntry += UnitParts[PartIndex].Verts.Num();
+            IndicesPerEntry += UnitParts[PartIndex].Indices.Num();
+        }
+
+        const int64 NumVerts = static_cast<int64>(Group.NumEntries) * VertsPerEntry;
+        if (LODIndex < Group.NumLODs - 1 && NumVerts > ShapesVisualizerGeometry::MaxPointsVertices)
+            break;
+        check(static_cast<int64>(Group.NumEntries) * IndicesPerEntry <= MAX_int32);
+
+        // The buffers copy the vertices and take the indices, nothing of the build outlives it
+        TArray<FDynamicMeshVertex> MeshVerts;
+        TArray<uint32> MeshIndices;
+        MeshVerts.SetNumUninitialized(static_cast<int32>(NumVerts));
+        MeshIndices.SetNumUninitialized(Group.NumEntries * IndicesPerEntry);
+
+        ShapesVisualizerGeometry::ParallelForChunks(Group.NumEntries, [&](int32 StartIndex, int32 EndIndex)
+        {
+            for (int32 EntryIndex = StartIndex; EntryIndex < EndIndex; EntryIndex++)
+            {
+                const int32 Slot = Slots[EntryIndex];
+                ShapesVisualizerDrawing::FUnitMeshPart EntryParts[3];
+                ShapesVisualizerDrawing::GetUnitMeshParts(Group.Shape, Batch.Radii[Slot], Batch.Heights[Slot], Batch.Extents[Slot],
+                    SplitIndex, BodyIndex, UnitIndices.Num(), EntryParts);
+                const FMatrix ShapeToComponent = Batch.Transforms[Slot].ToMatrixWithScale();
+                const FColor Color = Batch.Colors[Slot];
+
+                FDynamicMeshVertex* OutVert = MeshVerts.GetData() + EntryIndex * VertsPerEntry;
+                uint32* OutIndex = MeshIndices.GetData() + EntryIndex * IndicesPerEntry;
+                uint32 BaseVertIndex = EntryIndex * VertsPerEntry;
+
+                for (int32 PartIndex = 0; PartIndex < NumParts; PartIndex++)
+                {
+                    const FUnitPart_Internal& UnitPart = UnitParts[PartIndex];
+                    const FMatrix UnitToComponent = EntryParts[PartIndex].UnitToShape * ShapeToComponent;
+                    // Mirrored entries keep facing out, the draw itself is not reversed for them
+                    const bool Mirrored = UnitToComponent.Determinant() < 0.f;
+                    const FMatrix NormalMatrix = UnitToComponent.TransposeAdjoint();
+
+                    for (const FDynamicMeshVertex& UnitVert : UnitPart.Verts)
+                    {
+                        FDynamicMeshVertex& MeshVertex = *OutVert++;
+                        MeshVertex = UnitVert;
+                        MeshVertex.Position = FShapesVisualizerPosition(UnitToComponent.TransformPosition(FVector{ UnitVert.Position }));
+                        if (Group.Lines)
+                            MeshVertex.Color = Color;
+                        else
+                        {
+                            const FVector Normal = NormalMatrix.TransformVector(FVector{ UnitVert.TangentZ.ToFVector() }).GetSafeNormal()
+                                * (Mirrored ? -1.f : 1.f);
+                            MeshVertex.Color = ShapesVisualizerGeometry::GetShadedColor(Color, Normal);
+                        }
+                    }
+
+                    if (Mirrored && !Group.Lines)
+                    {
+                        for (int32 Index = 0; Index < UnitPart.Indices.Num(); Index += 3)
+                        {
+                            *OutIndex++ = BaseVertIndex + UnitPart.Indices[Index];
+                            *OutIndex++ = BaseVertIndex + UnitPart.Indices[Index + 2];
+                            *OutIndex++ = BaseVertIndex + UnitPart.Indices[Index + 1];
+                        }
+                    }
+                    else
+                    {
+                        for (uint32 Index : UnitPart.Indices)
+                            *OutIndex++ = BaseVertIndex + Index;
+                    }
+                    BaseVertIndex += UnitPart.Verts.Num();
+                }
+            }
+        });
+
+        Group.Buffers[LODIndex] = MakeUnique<FShapesVisualizerMeshBuffers>(FeatureLevel);
+        Group.Buffers[LODIndex]->Init(MeshVerts, MeshIndices, Group.Lines ? PT_LineList : PT_TriangleList);
+        Group.IndicesPerEntry[LODIndex] = IndicesPerEntry;
+        Group.FirstLOD = LODIndex;
+    }
+}
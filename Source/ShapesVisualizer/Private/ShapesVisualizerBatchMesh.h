@@ -0,0 +1,68 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerDrawing.h"
+#include "ShapesVisualizerMeshBuffers.h"
+
+enum class EVisualShape : uint8;
+struct FShapesVisualizerBatchArrays;
+
+//
+// FShapesVisualizerBatchMesh - shapes of a batch merged per shape type and LOD in the space of the component
+//
+// Every used slot becomes an entry of the group of its shape type, solid or lines. The entry is the unit
+// mesh of the shape sized, transformed and colored on the CPU, so all entries of a group have the same number
+// of indices per LOD and the entries [First, Last) are one range of its index buffer. A view draws a group with
+// one draw per run of entries which picked the same LOD. Solid colors are shaded by the normal like the grid
+// faces, so both kinds go through the vertex color material. Thick wireframes are left to the view quads.
+// Groups too large for ShapesVisualizerGeometry::MaxPointsVertices start at a coarser LOD. Render thread only.
+//
+
+class FShapesVisualizerBatchMesh
+{
+public:
+
+    struct FGroup
+    {
+        TUniquePtr<FShapesVisualizerMeshBuffers> Buffers[ShapesVisualizerDrawing::MaxLODs];
+        int32 IndicesPerEntry[ShapesVisualizerDrawing::MaxLODs] = {};
+        EVisualShape Shape = {};
+        bool Lines = false;
+        // Entries of the group are [FirstEntry, FirstEntry + NumEntries) of the entry spheres
+        int32 FirstEntry = 0;
+        int32 NumEntries = 0;
+        // Finer LODs than FirstLOD did not fit the budget and are drawn with it
+        int32 FirstLOD = 0;
+        int32 NumLODs = 0;
+    };
+
+    explicit FShapesVisualizerBatchMesh(ERHIFeatureLevel::Type InFeatureLevel) : FeatureLevel(InFeatureLevel) {}
+    ~FShapesVisualizerBatchMesh() { Release(); }
+
+    // Wireframes become line groups only with LineMeshes, otherwise they are counted in GetNumThickShapes
+    void Build(const FShapesVisualizerBatchArrays& Batch, int32 NumSides, bool LineMeshes);
+    void Release();
+
+    int32 NumGroups() const { return Groups.Num(); }
+    const FGroup& GetGroup(int32 GroupIndex) const { return Groups[GroupIndex]; }
+    // LOD to draw the entry of the group with, for the sides the view wants
+    int32 GetEntryLOD(const FGroup& Group, int32 ViewSides) const;
+    // Bounding spheres of the entries in the space of the component, group after group
+    const TArray<FSphere>& GetEntrySpheres() const { return EntrySpheres; }
+    int32 GetNumThickShapes() const { return NumThickShapes; }
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    void BuildGroup(FGroup& Group, const FShapesVisualizerBatchArrays& Batch, TArrayView<const int32> Slots);
+
+private:
+
+    ERHIFeatureLevel::Type FeatureLevel;
+    int32 NumSides = 0;
+    TIndirectArray<FGroup> Groups;
+    TArray<FSphere> EntrySpheres;
+    int32 NumThickShapes = 0;
+};
@@ -0,0 +1,174 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerBudget.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "ShapesVisualizerStats.h"
+
+//
+// Console variables
+//
+
+static TAutoConsoleVariable<int32> CVarShapesVisualizerBudgetPrimitives(
+    TEXT("r.ShapesVisualizer.Budget.Primitives"),
+    0,
+    TEXT("Lines and triangles all visualizers may draw per frame, 0 for no limit.\n")
+    TEXT("Once it is spent, the visualizers of the lowest priority wait for the next frames."),
+    ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<float> CVarShapesVisualizerBudgetMicroseconds(
+    TEXT("r.ShapesVisualizer.Budget.Microseconds"),
+    0.f,
+    TEXT("Render thread time all visualizers may take per frame, 0 for no limit."),
+    ECVF_RenderThreadSafe);
+
+namespace
+{
+    constexpr float SelectedScore_Internal = 1000000.f;
+    constexpr float PriorityScore_Internal = 1000.f;
+    constexpr float ScreenSizeScore_Internal = 10.f;
+    // A waiting proxy catches up with one a priority above in 20 frames, and with any screen size in 3
+    constexpr float DeferredFrameScore_Internal = 50.f;
+}
+
+//
+// FShapesVisualizerBudget::FProxyState
+//
+
+bool FShapesVisualizerBudget::FProxyState::TryDraw(uint32 FrameNumber, int32 Priority, bool Selected, float ScreenRadius)
+{
+    // Scene captures and other views of the frame follow the first view family
+    if (FrameNumber == AskedFrame)
+        return Drawn;
+    AskedFrame = FrameNumber;
+
+    FShapesVisualizerBudget& Budget = FShapesVisualizerBudget::Get();
+    const float Score = GetScore(Priority, Selected, ScreenRadius, DeferredFrames);
+    Drawn = Budget.TryDraw(FrameNumber, Score, LastPrimitives, LastCycles);
+    DeferredFrames = Drawn ? 0 : DeferredFrames + 1;
+    ReservedPrimitives = Drawn ? LastPrimitives : 0;
+    ReservedCycles = Drawn ? LastCycles : 0;
+    return Drawn;
+}
+
+void FShapesVisualizerBudget::FProxyState::EndDraw(int32 Primitives, uint32 StartCycles)
+{
+    const uint32 Cycles = FPlatformTime::Cycles() - StartCycles;
+    if (MeasuredFrame == AskedFrame)
+    {
+        LastPrimitives += Primitives;
+        LastCycles += Cycles;
+    }
+    else
+    {
+        LastPrimitives = Primitives;
+        LastCycles = Cycles;
+        MeasuredFrame = AskedFrame;
+    }
+
+    const int32 ExtraPrimitives = FMath::Max(Primitives - ReservedPrimitives, 0);
+    const uint32 ExtraCycles = Cycles > ReservedCycles ? Cycles - ReservedCycles : 0;
+    ReservedPrimitives -= Primitives - ExtraPrimitives;
+    ReservedCycles -= Cycles - ExtraCycles;
+    FShapesVisualizerBudget::Get().AddSpent(Primitives, Cycles, ExtraPrimitives, ExtraCycles);
+}
+
+//
+// FShapesVisualizerBudget
+//
+
+FShapesVisualizerBudget& FShapesVisualizerBudget::Get()
+{
+    check(IsInParallelRenderingThread());
+    static FShapesVisualizerBudget Budget;
+    return Budget;
+}
+
+float FShapesVisualizerBudget::GetScore(int32 Priority, bool Selected, float ScreenRadius, int32 DeferredFrames)
+{
+    return (Selected ? SelectedScore_Internal : 0.f)
+        + Priority * PriorityScore_Internal
+        + ScreenSizeScore_Internal * FMath::Log2(1.f + FMath::Max(ScreenRadius, 0.f))
+        + DeferredFrames * DeferredFrameScore_Internal;
+}
+
+bool FShapesVisualizerBudget::TryDraw(uint32 FrameNumber, float Score, int32 ExpectedPrimitives, uint32 ExpectedCycles)
+{
+    const int32 MaxPrimitives = CVarShapesVisualizerBudgetPrimitives.GetValueOnRenderThread();
+    const float MaxMicroseconds = CVarShapesVisualizerBudgetMicroseconds.GetValueOnRenderThread();
+    if (MaxPrimitives <= 0 && MaxMicroseconds <= 0.f)
+        return true;
+
+    const uint64 MaxCycles = MaxMicroseconds > 0.f
+        ? static_cast<uint64>(MaxMicroseconds / (FPlatformTime::GetSecondsPerCycle() * 1000000.0))
+        : 0;
+
+    FScopeLock Lock{ &Mutex };
+    if (FrameNumber != CurrentFrame)
+        BeginFrame(FrameNumber, MaxPrimitives, MaxCycles);
+
+    Requests.Add(FRequest{ Score, ExpectedPrimitives, ExpectedCycles });
+
+    // Nothing else would ever make room for it
+    const bool Oversized = (MaxPrimitives > 0 && ExpectedPrimitives > MaxPrimitives)
+        || (MaxCycles > 0 && ExpectedCycles > MaxCycles);
+    if (Oversized && !TopAdmitted && Score >= TopScore)
+    {
+        TopAdmitted = true;
+        SpentPrimitives += ExpectedPrimitives;
+        SpentCycles += ExpectedCycles;
+        return true;
+    }
+
+    // A proxy that has never been drawn costs nothing yet, it is measured by its first frame
+    const bool OverBudget = (MaxPrimitives > 0 && SpentPrimitives + ExpectedPrimitives > MaxPrimitives)
+        || (MaxCycles > 0 && SpentCycles + ExpectedCycles > MaxCycles);
+    if (OverBudget || Score <= Threshold)
+    {
+        INC_DWORD_STAT(STAT_ShapesVisualizer_DeferredProxies);
+        return false;
+    }
+
+    SpentPrimitives += ExpectedPrimitives;
+    SpentCycles += ExpectedCycles;
+    return true;
+}
+
+void FShapesVisualizerBudget::AddSpent(int32 Primitives, uint32 Cycles, int32 ExtraPrimitives, uint32 ExtraCycles)
+{
+    FScopeLock Lock{ &Mutex };
+    SpentPrimitives += ExtraPrimitives;
+    SpentCycles += ExtraCycles;
+
+    INC_DWORD_STAT_BY(STAT_ShapesVisualizer_BudgetPrimitives, Primitives);
+    INC_FLOAT_STAT_BY(STAT_ShapesVisualizer_BudgetMicroseconds, FPlatformTime::ToMilliseconds(Cycles) * 1000.f);
+}
+
+void FShapesVisualizerBudget::BeginFrame(uint32 FrameNumber, int32 MaxPrimitives, uint64 MaxCycles)
+{
+    // The best scores of the last frame that fitted the budget, the first one past it is the threshold.
+    // The best one always fits, even if it alone is over the budget
+    Requests.Sort([](const FRequest& A, const FRequest& B) { return A.Score > B.Score; });
+
+    Threshold = -FLT_MAX;
+    TopScore = Requests.Num() > 0 ? Requests[0].Score : -FLT_MAX;
+    TopAdmitted = false;
+    int64 Primitives = 0;
+    uint64 Cycles = 0;
+    for (int32 Index = 0; Index < Requests.Num(); Index++)
+    {
+        const FRequest& Request = Requests[Index];
+        Primitives += Request.Primitives;
+        Cycles += Request.Cycles;
+        if (Index > 0 && ((MaxPrimitives > 0 && Primitives > MaxPrimitives) || (MaxCycles > 0 && Cycles > MaxCycles)))
+        {
+            Threshold = Request.Score;
+            break;
+        }
+    }
+
+    Requests.Reset();
+    SpentPrimitives = 0;
+    SpentCycles = 0;
+    CurrentFrame = FrameNumber;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+//
+// FShapesVisualizerBudget - frame budget of all scene proxies (r.ShapesVisualizer.Budget.*)
+//
+// Every proxy asks once per frame with its score and what it cost the last time it was drawn,
+// further view families of the frame get the same answer. The scores of the last frame give the
+// threshold the budget fitted, proxies below it wait, and the budget spent in this frame is the
+// hard ceiling whatever the order of the proxies. Waiting proxies gain score every frame, so the
+// low priority ones are drawn in turns. A proxy which alone costs more than the budget goes once
+// it has the best score of the last frame, and is measured again.
+// Render thread and the parallel mesh gathering tasks, the shared state is locked.
+//
+
+class FShapesVisualizerBudget
+{
+public:
+
+    // Per proxy state, mutable member of the proxy
+    struct FProxyState
+    {
+        // Whether the proxy draws in this frame
+        bool TryDraw(uint32 FrameNumber, int32 Priority, bool Selected, float ScreenRadius);
+        // Cost of the drawn proxy, the estimate of its next frame. The view families of a frame add up
+        void EndDraw(int32 Primitives, uint32 StartCycles);
+
+        int32 DeferredFrames = 0;
+        int32 LastPrimitives = 0;
+        uint32 LastCycles = 0;
+        // Estimate spent when the proxy was let through, the draws spend only what goes past it
+        int32 ReservedPrimitives = 0;
+        uint32 ReservedCycles = 0;
+        // Frame of the last answer and of the last cost
+        uint32 AskedFrame = MAX_uint32;
+        uint32 MeasuredFrame = MAX_uint32;
+        bool Drawn = false;
+    };
+
+    static FShapesVisualizerBudget& Get();
+
+    // Selection first, then the priority, then the size on screen, which also covers the distance
+    static float GetScore(int32 Priority, bool Selected, float ScreenRadius, int32 DeferredFrames);
+
+    // Spends the expected cost of a proxy let through
+    bool TryDraw(uint32 FrameNumber, float Score, int32 ExpectedPrimitives, uint32 ExpectedCycles);
+    // Cost of a draw for the stats, the part of it past the expected cost is spent
+    void AddSpent(int32 Primitives, uint32 Cycles, int32 ExtraPrimitives, uint32 ExtraCycles);
+
+private:
+
+    void BeginFrame(uint32 FrameNumber, int32 MaxPrimitives, uint64 MaxCycles);
+
+private:
+
+    struct FRequest
+    {
+        float Score;
+        int32 Primitives;
+        uint32 Cycles;
+    };
+
+    FCriticalSection Mutex;
+    // Proxies of the current frame, drawn or not
+    TArray<FRequest> Requests;
+    uint32 CurrentFrame = 0;
+    // Proxies at or below the threshold wait
+    float Threshold = -FLT_MAX;
+    // Best score of the last frame, an oversized proxy with it goes whatever was spent
+    float TopScore = -FLT_MAX;
+    bool TopAdmitted = false;
+    int64 SpentPrimitives = 0;
+    uint64 SpentCycles = 0;
+};
@@ -0,0 +1,222 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerCommands.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "Containers/Queue.h"
+#include "ShapesVisualizerStats.h"
+#include <atomic>
+
+//
+// Internal functions
+//
+
+namespace
+{
+    struct FCommand_Internal
+    {
+        enum class EType : uint8
+        {
+            SetShape,
+            SetPoints,
+            AppendPoints,
+            PushTrailPoint,
+            SetColor,
+            SetWireframe,
+            AddShape,
+            UpdateShape,
+            RemoveShape,
+            ClearShapes
+        };
+
+        EType Type = EType::SetShape;
+        // UShapesVisualizerComponent or UShapesVisualizerBatchComponent, by Type
+        TWeakObjectPtr<UObject> Target;
+        // Shape parameters of both components, the point of PushTrailPoint is in Extent
+        FShapesVisualizerBatchShape Shape;
+        FShapesVisualizerBatchHandle Handle;
+        float LineThickness = 0.f;
+        TArray<FVector> Points;
+    };
+
+    TQueue<FCommand_Internal, EQueueMode::Mpsc> Commands_Internal;
+    // Enqueued and not yet applied, limits Flush to the commands queued before it
+    std::atomic<int32> NumCommands_Internal{ 0 };
+
+    FORCEINLINE void Submit_Internal(FCommand_Internal&& Command)
+    {
+        Commands_Internal.Enqueue(MoveTemp(Command));
+        NumCommands_Internal.fetch_add(1, std::memory_order_release);
+    }
+
+    FCommand_Internal MakeCommand_Internal(FCommand_Internal::EType Type, const TWeakObjectPtr<UObject>& Target)
+    {
+        FCommand_Internal Command;
+        Command.Type = Type;
+        Command.Target = Target;
+        return Command;
+    }
+
+    void ApplyCommand_Internal(FCommand_Internal& Command,
+        TArray<UShapesVisualizerBatchComponent*, TInlineAllocator<8>>& UpdatedBatches)
+    {
+        using EType = FCommand_Internal::EType;
+
+        UObject* const Target = Command.Target.Get();
+        if (!Target)
+            return;
+
+        if (Command.Type >= EType::AddShape)
+        {
+            UShapesVisualizerBatchComponent* const Batch = static_cast<UShapesVisualizerBatchComponent*>(Target);
+            if (!UpdatedBatches.Contains(Batch))
+            {
+                Batch->BeginUpdate();
+                UpdatedBatches.Add(Batch);
+            }
+
+            switch (Command.Type)
+            {
+            case EType::AddShape: Batch->AddShape(Command.Shape); break;
+            case EType::UpdateShape: Batch->UpdateShape(Command.Handle, Command.Shape); break;
+            case EType::RemoveShape: Batch->RemoveShape(Command.Handle); break;
+            case EType::ClearShapes: Batch->ClearShapes(); break;
+            default: break;
+            }
+            return;
+        }
+
+        UShapesVisualizerComponent* const Component = static_cast<UShapesVisualizerComponent*>(Target);
+        switch (Command.Type)
+        {
+        case EType::SetShape:
+            Component->SetSizedShape(Command.Shape.Shape, Command.Shape.Radii, Command.Shape.Height, Command.Shape.Extent);
+            break;
+        case EType::SetPoints:
+            if (Command.Shape.Shape == EVisualShape::Polyline)
+                Component->SetPolylineShape(MoveTemp(Command.Points));
+            else
+                Component->SetPointsShape(MoveTemp(Command.Points));
+            break;
+        case EType::AppendPoints:
+            Component->AppendPoints(MoveTemp(Command.Points));
+            break;
+        case EType::PushTrailPoint:
+            Component->PushTrailPoint(Command.Shape.Extent);
+            break;
+        case EType::SetColor:
+            Component->SetColor(Command.Shape.Color);
+            break;
+        case EType::SetWireframe:
+            Component->SetWireframe(Command.Shape.Wireframe, Command.LineThickness);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+//
+// FShapesVisualizerCommands
+//
+
+void FShapesVisualizerCommands::SetShape(const TWeakObjectPtr<UShapesVisualizerComponent>& Component,
+    EVisualShape Shape, float Radii, float Height, const FVector& Extent)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::SetShape, Component);
+    Command.Shape.Shape = Shape;
+    Command.Shape.Radii = Radii;
+    Command.Shape.Height = Height;
+    Command.Shape.Extent = Extent;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::SetPoints(const TWeakObjectPtr<UShapesVisualizerComponent>& Component,
+    EVisualShape Shape, TArray<FVector>&& Points)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::SetPoints, Component);
+    Command.Shape.Shape = Shape;
+    Command.Points = MoveTemp(Points);
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::AppendPoints(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, TArray<FVector>&& Points)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::AppendPoints, Component);
+    Command.Points = MoveTemp(Points);
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::PushTrailPoint(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, const FVector& Point)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::PushTrailPoint, Component);
+    Command.Shape.Extent = Point;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::SetColor(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, const FColor& Color)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::SetColor, Component);
+    Command.Shape.Color = Color;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::SetWireframe(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, bool Wireframe, float LineThickness)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::SetWireframe, Component);
+    Command.Shape.Wireframe = Wireframe;
+    Command.LineThickness = LineThickness;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::AddShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch, const FShapesVisualizerBatchShape& Shape)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::AddShape, Batch);
+    Command.Shape = Shape;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::UpdateShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch,
+    const FShapesVisualizerBatchHandle& Handle, const FShapesVisualizerBatchShape& Shape)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::UpdateShape, Batch);
+    Command.Handle = Handle;
+    Command.Shape = Shape;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::RemoveShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch, const FShapesVisualizerBatchHandle& Handle)
+{
+    FCommand_Internal Command = MakeCommand_Internal(FCommand_Internal::EType::RemoveShape, Batch);
+    Command.Handle = Handle;
+    Submit_Internal(MoveTemp(Command));
+}
+
+void FShapesVisualizerCommands::ClearShapes(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch)
+{
+    Submit_Internal(MakeCommand_Internal(FCommand_Internal::EType::ClearShapes, Batch));
+}
+
+void FShapesVisualizerCommands::Flush()
+{
+    check(IsInGameThread());
+
+    // Producers may outpace the loop, the commands queued meanwhile wait for the next frame
+    int32 NumCommands = NumCommands_Internal.load(std::memory_order_acquire);
+    if (NumCommands == 0)
+        return;
+
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_FlushCommands);
+
+    TArray<UShapesVisualizerBatchComponent*, TInlineAllocator<8>> UpdatedBatches;
+    FCommand_Internal Command;
+    // A node being linked by a producer is not seen yet, it is left for the next frame
+    for (; NumCommands > 0 && Commands_Internal.Dequeue(Command); NumCommands--)
+    {
+        NumCommands_Internal.fetch_sub(1, std::memory_order_relaxed);
+        ApplyCommand_Internal(Command, UpdatedBatches);
+    }
+
+    for (UShapesVisualizerBatchComponent* Batch : UpdatedBatches)
+        Batch->EndUpdate();
+}
@@ -0,0 +1,264 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerDrawing.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "DynamicMeshBuilder.h"
+#include "SceneManagement.h"
+#include "SceneView.h"
+#include "HAL/IConsoleManager.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerGeometryPool.h"
+#include "ShapesVisualizerMeshBuffers.h"
+
+//
+// Console variables
+//
+
+static TAutoConsoleVariable<int32> CVarShapesVisualizerLOD(
+    TEXT("r.ShapesVisualizer.LOD"),
+    1,
+    TEXT("Screen size LOD of the round shapes.\n")
+    TEXT(" 0: always draw NumSides sides\n")
+    TEXT(" 1: fewer sides for shapes small on screen (default)"),
+    ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarShapesVisualizerLODMinSides(
+    TEXT("r.ShapesVisualizer.LOD.MinSides"),
+    8,
+    TEXT("The smallest number of sides the screen size LOD goes down to."),
+    ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<float> CVarShapesVisualizerLODPixelsPerSide(
+    TEXT("r.ShapesVisualizer.LOD.PixelsPerSide"),
+    8.f,
+    TEXT("Length in pixels of one side of the silhouette, larger values give fewer sides."),
+    ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<float> CVarShapesVisualizerCullScreenRadius(
+    TEXT("r.ShapesVisualizer.CullScreenRadius"),
+    1.f,
+    TEXT("Shapes with the screen radius below this number of pixels are not drawn, 0 disables culling."),
+    ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<float> CVarShapesVisualizerPolylineTolerance(
+    TEXT("r.ShapesVisualizer.PolylineTolerance"),
+    1.f,
+    TEXT("Polyline points closer than this number of pixels to the simplified line are dropped, 0 draws every point."),
+    ECVF_RenderThreadSafe);
+
+//
+// Internal functions
+//
+
+namespace
+{
+    FORCEINLINE float SafeScale_Internal(float Scale)
+    {
+        return FMath::Max(Scale, KINDA_SMALL_NUMBER);
+    }
+}
+
+//
+// ShapesVisualizerDrawing
+//
+
+int32 ShapesVisualizerDrawing::GetNumLODs(int32 NumSides)
+{
+    int32 NumLODs = 1;
+    while (NumLODs < MaxLODs && GetLODSides(NumSides, NumLODs) >= MinLODSides)
+        NumLODs++;
+    return NumLODs;
+}
+
+int32 ShapesVisualizerDrawing::GetLODIndex(int32 NumSides, int32 Sides)
+{
+    const int32 NumLODs = GetNumLODs(NumSides);
+    int32 LODIndex = 0;
+    while (LODIndex + 1 < NumLODs && GetLODSides(NumSides, LODIndex + 1) >= Sides)
+        LODIndex++;
+    return LODIndex;
+}
+
+float ShapesVisualizerDrawing::GetScreenRadius(const FSceneView& View, float Radius, float DistanceSquared)
+{
+    // Same projection as ComputeBoundsScreenRadiusSquared, in pixels instead of screen fractions
+    const FMatrix& ProjMatrix = View.ViewMatrices.GetProjectionMatrix();
+    const float ScreenMultiple = FMath::Max(0.5f * ProjMatrix.M[0][0], 0.5f * ProjMatrix.M[1][1]);
+    const float ScreenSize = FMath::Max(View.UnscaledViewRect.Width(), View.UnscaledViewRect.Height());
+    const float Distance = View.ViewMatrices.IsPerspectiveProjection()
+        ? FMath::Sqrt(FMath::Max(1.f, DistanceSquared))
+        : 1.f;
+    return ScreenMultiple * Radius * ScreenSize / Distance;
+}
+
+float ShapesVisualizerDrawing::GetScreenRadius(const FSceneView& View, const FVector& Origin, float Radius)
+{
+    return GetScreenRadius(View, Radius, FVector::DistSquared(Origin, View.ViewMatrices.GetViewOrigin()));
+}
+
+float ShapesVisualizerDrawing::GetMaxScreenRadius(const TArray<const FSceneView*>& Views, uint32 VisibilityMap,
+    const FBoxSphereBounds& Bounds)
+{
+    float ScreenRadius = 0.f;
+    for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+    {
+        if (VisibilityMap & (1 << ViewIndex))
+            ScreenRadius = FMath::Max(ScreenRadius, GetScreenRadius(*Views[ViewIndex], Bounds.Origin, Bounds.SphereRadius));
+    }
+    return ScreenRadius;
+}
+
+int32 ShapesVisualizerDrawing::GetViewSides(float ScreenRadius, int32 NumSides)
+{
+    if (ScreenRadius < CVarShapesVisualizerCullScreenRadius.GetValueOnRenderThread())
+        return 0;
+
+    if (CVarShapesVisualizerLOD.GetValueOnRenderThread() == 0)
+        return NumSides;
+
+    // Sides of about PixelsPerSide pixels along the silhouette
+    const float PixelsPerSide = FMath::Max(CVarShapesVisualizerLODPixelsPerSide.GetValueOnRenderThread(), 1.f);
+    const int32 MinSides = FMath::Clamp(CVarShapesVisualizerLODMinSides.GetValueOnRenderThread(), MinLODSides, NumSides);
+    return FMath::Clamp(FMath::CeilToInt(2.f * PI * ScreenRadius / PixelsPerSide), MinSides, NumSides);
+}
+
+float ShapesVisualizerDrawing::GetPolylineTolerance(const FSceneView& View, float DistanceSquared)
+{
+    const float PixelTolerance = CVarShapesVisualizerPolylineTolerance.GetValueOnRenderThread();
+    if (PixelTolerance <= 0.f)
+        return 0.f;
+    return PixelTolerance / FMath::Max(GetScreenRadius(View, 1.f, DistanceSquared), KINDA_SMALL_NUMBER);
+}
+
+int32 ShapesVisualizerDrawing::GetMeshBuffers(const FShapesVisualizerMeshBuffers& Buffers, const FMatrix& LocalToWorld,
+    const FBoxSphereBounds& WorldBounds, const FBoxSphereBounds& LocalBounds,
+    const FMaterialRenderProxy* MaterialRenderProxy, uint8 DepthPriority,
+    int32 ViewIndex, FMeshElementCollector& Collector,
+    int32 FirstIndex, int32 NumIndices)
+{
+    if (!Buffers.IsInitialized() || Buffers.GetNumDrawIndices() == 0)
+        return 0;
+
+    // The batch and its uniform buffer are the collector's
+    FMeshBatch& Mesh = Collector.AllocateMesh();
+    Buffers.GetMeshBatch(Mesh, MaterialRenderProxy, DepthPriority,
+        LocalToWorld.Determinant() < 0.f, FirstIndex, NumIndices);
+
+    FDynamicPrimitiveUniformBuffer& UniformBuffer = Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+#if ENGINE_MAJOR_VERSION == 5
+    UniformBuffer.Set(LocalToWorld, LocalToWorld, WorldBounds, LocalBounds, LocalBounds, false, false, false, nullptr);
+#else
+    UniformBuffer.Set(LocalToWorld, LocalToWorld, WorldBounds, LocalBounds, false, false, false, false);
+#endif
+    Mesh.Elements[0].PrimitiveUniformBufferResource = &UniformBuffer.UniformBuffer;
+
+    Collector.AddMesh(ViewIndex, Mesh);
+    return Mesh.GetNumPrimitives();
+}
+
+int32 ShapesVisualizerDrawing::GetUnitMeshParts(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+    int32 SplitIndex, int32 BodyIndex, int32 NumIndices, FUnitMeshPart OutParts[3])
+{
+    const float HalfHeight = Height / 2.f;
+
+    switch (Shape)
+    {
+    case EVisualShape::Sphere:
+    case EVisualShape::HalfSphere:
+        OutParts[0] = FUnitMeshPart{ FScaleMatrix{ SafeScale_Internal(Radii) }, 0, NumIndices };
+        return 1;
+
+    case EVisualShape::Box:
+        OutParts[0] = FUnitMeshPart{ FScaleMatrix{ FVector{ SafeScale_Internal(Extent.X), SafeScale_Internal(Extent.Y), SafeScale_Internal(Extent.Z) } },
+            0, NumIndices };
+        return 1;
+
+    case EVisualShape::Cylinder:
+    case EVisualShape::Cone:
+        OutParts[0] = FUnitMeshPart{ FScaleMatrix{ FVector{ SafeScale_Internal(Radii), SafeScale_Internal(Radii), SafeScale_Internal(HalfHeight) } },
+            0, NumIndices };
+        return 1;
+
+    case EVisualShape::Capsule:
+    {
+        // Same layout as the capsule of ShapesVisualizerTessellation::TessellateShape
+        const float HalfAxis = FMath::Max<float>(HalfHeight - Radii, 1.f);
+        const float BottomEnd = Radii - HalfHeight;
+        const float TopEnd = BottomEnd + 2.f * HalfAxis;
+        const FScaleMatrix CapScale{ SafeScale_Internal(Radii) };
+
+        // Unit caps are centered at +-1 and the body between them follows the axis length
+        OutParts[0] = FUnitMeshPart{ FTranslationMatrix{ -FVector::ZAxisVector } * CapScale * FTranslationMatrix{ FVector{ 0.f, 0.f, TopEnd } },
+            0, SplitIndex };
+        OutParts[1] = FUnitMeshPart{ FTranslationMatrix{ FVector::ZAxisVector } * CapScale * FTranslationMatrix{ FVector{ 0.f, 0.f, BottomEnd } },
+            SplitIndex, BodyIndex - SplitIndex };
+        OutParts[2] = FUnitMeshPart{ FScaleMatrix{ FVector{ SafeScale_Internal(Radii), SafeScale_Internal(Radii), HalfAxis } }
+                * FTranslationMatrix{ FVector{ 0.f, 0.f, BottomEnd + HalfAxis } },
+            BodyIndex, NumIndices - BodyIndex };
+        return 3;
+    }
+    }
+    return 0;
+}
+
+int32 ShapesVisualizerDrawing::DrawShape(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+    const FMatrix& LTW, const FShapesVisualizerUnitMesh& UnitMesh, const FMaterialRenderProxy* MeshMaterial,
+    const FBoxSphereBounds& WorldBounds, const FBoxSphereBounds& LocalBounds,
+    int32 ViewIndex, FMeshElementCollector& Collector)
+{
+    FUnitMeshPart Parts[3];
+    const int32 NumParts = GetUnitMeshParts(Shape, Radii, Height, Extent,
+        UnitMesh.SplitIndex, UnitMesh.BodyIndex, UnitMesh.Buffers.GetNumIndices(), Parts);
+
+    int32 NumPrimitives = 0;
+    for (int32 PartIndex = 0; PartIndex < NumParts; PartIndex++)
+    {
+        NumPrimitives += GetMeshBuffers(UnitMesh.Buffers, Parts[PartIndex].UnitToShape * LTW,
+            WorldBounds, LocalBounds,
+            MeshMaterial, SDPG_World, ViewIndex, Collector,
+            Parts[PartIndex].FirstIndex, Parts[PartIndex].NumIndices);
+    }
+    return NumPrimitives;
+}
+
+int32 ShapesVisualizerDrawing::AddWireLines(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+    const FMatrix& LTW, int32 NumSides, TArray<FVector>& OutLineVerts)
+{
+    const FShapesVisualizerUnitLines& UnitLines = FShapesVisualizerGeometryPool::Get().GetUnitLines(Shape, NumSides);
+
+    FUnitMeshPart Parts[3];
+    const int32 NumParts = GetUnitMeshParts(Shape, Radii, Height, Extent,
+        UnitLines.SplitIndex, UnitLines.BodyIndex, UnitLines.LineVerts.Num(), Parts);
+
+    const int32 StartVert = OutLineVerts.Num();
+    OutLineVerts.AddUninitialized(UnitLines.LineVerts.Num());
+    for (int32 PartIndex = 0; PartIndex < NumParts; PartIndex++)
+    {
+        const FUnitMeshPart& Part = Parts[PartIndex];
+        ShapesVisualizerGeometry::TransformPositions(Part.UnitToShape * LTW,
+            MakeArrayView(UnitLines.LineVerts.GetData() + Part.FirstIndex, Part.NumIndices),
+            OutLineVerts.GetData() + StartVert + Part.FirstIndex);
+    }
+    return UnitLines.LineVerts.Num() / 2;
+}
+
+FBox ShapesVisualizerDrawing::GetShapeBox(EVisualShape Shape, float Radii, float Height, const FVector& Extent)
+{
+    const float HalfHeight = Height / 2.f;
+
+    switch (Shape)
+    {
+    case EVisualShape::Sphere:
+        return FBox{ FVector{ -Radii }, FVector{ Radii } };
+    case EVisualShape::HalfSphere:
+        return FBox{ FVector{ -Radii, -Radii, 0.f }, FVector{ Radii } };
+    case EVisualShape::Box:
+        return FBox{ -Extent, Extent };
+    case EVisualShape::Cylinder:
+    case EVisualShape::Cone:
+    case EVisualShape::Capsule:
+        return FBox{ FVector{ -Radii, -Radii, -HalfHeight }, FVector{ Radii, Radii, HalfHeight } };
+    }
+    return FBox{ FVector::ZeroVector, FVector::ZeroVector };
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EVisualShape : uint8;
+class FMaterialRenderProxy;
+class FMeshElementCollector;
+class FSceneView;
+class FShapesVisualizerMeshBuffers;
+struct FShapesVisualizerUnitMesh;
+
+//
+// ShapesVisualizerDrawing - per view drawing shared by the scene proxies
+//
+
+namespace ShapesVisualizerDrawing
+{
+    // Unit meshes of the LOD levels have NumSides, NumSides / 2, ... but not fewer than MinLODSides
+    constexpr int32 MaxLODs = 4;
+    constexpr int32 MinLODSides = 4;
+
+    int32 GetNumLODs(int32 NumSides);
+    FORCEINLINE int32 GetLODSides(int32 NumSides, int32 LODIndex) { return NumSides >> LODIndex; }
+    // Coarsest LOD level which still has at least Sides sides
+    int32 GetLODIndex(int32 NumSides, int32 Sides);
+
+    // Radius in pixels of the sphere DistanceSquared away from the view origin
+    float GetScreenRadius(const FSceneView& View, float Radius, float DistanceSquared);
+    float GetScreenRadius(const FSceneView& View, const FVector& Origin, float Radius);
+    // Largest screen radius of the bounds among the views of VisibilityMap
+    float GetMaxScreenRadius(const TArray<const FSceneView*>& Views, uint32 VisibilityMap, const FBoxSphereBounds& Bounds);
+
+    // Number of sides for a round shape of ScreenRadius pixels, between r.ShapesVisualizer.LOD.MinSides
+    // and NumSides. Zero if the shape is smaller than r.ShapesVisualizer.CullScreenRadius
+    int32 GetViewSides(float ScreenRadius, int32 NumSides);
+
+    // World distance under r.ShapesVisualizer.PolylineTolerance pixels at DistanceSquared from the view origin,
+    // zero if polylines are not simplified
+    float GetPolylineTolerance(const FSceneView& View, float DistanceSquared);
+
+    // Draws the prebuilt mesh (or the range of its indices) with its own LocalToWorld,
+    // unit meshes get the shape size baked into it. Returns the number of drawn primitives
+    int32 GetMeshBuffers(const FShapesVisualizerMeshBuffers& Buffers, const FMatrix& LocalToWorld,
+        const FBoxSphereBounds& WorldBounds, const FBoxSphereBounds& LocalBounds,
+        const FMaterialRenderProxy* MaterialRenderProxy, uint8 DepthPriority,
+        int32 ViewIndex, FMeshElementCollector& Collector,
+        int32 FirstIndex = 0, int32 NumIndices = INDEX_NONE);
+
+    // Part of the index buffer of a unit mesh and the transform which sizes it into the shape
+    struct FUnitMeshPart
+    {
+        FMatrix UnitToShape;
+        int32 FirstIndex;
+        int32 NumIndices;
+    };
+
+    // The whole unit mesh of NumIndices indices, or the upper cap, lower cap and body of a capsule split
+    // at the indices of FShapesVisualizerUnitMesh. Returns the number of parts
+    int32 GetUnitMeshParts(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+        int32 SplitIndex, int32 BodyIndex, int32 NumIndices, FUnitMeshPart OutParts[3]);
+
+    // Draws one of the sized shapes (all except Points and Polyline) with its solid or line unit mesh,
+    // sized into the shape. A unit capsule takes a draw per cap and one for the body.
+    // Returns the number of drawn lines or triangles
+    int32 DrawShape(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+        const FMatrix& LocalToWorld, const FShapesVisualizerUnitMesh& UnitMesh, const FMaterialRenderProxy* MeshMaterial,
+        const FBoxSphereBounds& WorldBounds, const FBoxSphereBounds& LocalBounds,
+        int32 ViewIndex, FMeshElementCollector& Collector);
+
+    // Appends the world space wireframe of the sized shape with NumSides sides, the lines of the line
+    // unit mesh as vertex pairs. Returns the number of appended lines
+    int32 AddWireLines(EVisualShape Shape, float Radii, float Height, const FVector& Extent,
+        const FMatrix& LocalToWorld, int32 NumSides, TArray<FVector>& OutLineVerts);
+
+    // Local box of the sized shape as CalcBounds of the component sees it
+    FBox GetShapeBox(EVisualShape Shape, float Radii, float Height, const FVector& Extent);
+}
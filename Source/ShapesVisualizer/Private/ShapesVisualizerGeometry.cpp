@@ -0,0 +1,515 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerTessellation.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+//
+// Console variables
+//
+
+static TAutoConsoleVariable<int32> CVarShapesVisualizerMaxParallelTasks(
+    TEXT("r.ShapesVisualizer.MaxParallelTasks"),
+    0,
+    TEXT("Upper bound of the tasks one parallel loop of the geometry is split into.\n")
+    TEXT(" 0: one task per chunk of points (default)\n")
+    TEXT(" 1: everything on the calling thread"));
+
+//
+// Internal functions
+//
+
+namespace
+{
+    FORCEINLINE FDynamicMeshVertex MakeVertex_Internal(const FVector& Position, const FVector2D& UV,
+        const FVector& TangentX, const FVector& TangentY, const FVector& TangentZ)
+    {
+        FDynamicMeshVertex MeshVertex;
+
+#if ENGINE_MAJOR_VERSION == 5
+        MeshVertex.Position = FVector3f(Position);
+        MeshVertex.TextureCoordinate[0] = FVector2f(UV);
+        MeshVertex.SetTangents((FVector3f)TangentX, (FVector3f)TangentY, (FVector3f)TangentZ);
+#else
+        MeshVertex.Position = Position;
+        MeshVertex.TextureCoordinate[0] = UV;
+        MeshVertex.SetTangents(TangentX, TangentY, TangentZ);
+#endif
+
+        MeshVertex.Color = FColor::White;
+        return MeshVertex;
+    }
+
+    FORCEINLINE FVector GetPosition_Internal(const FDynamicMeshVertex& MeshVertex)
+    {
+        return FVector{ MeshVertex.Position };
+    }
+
+    FORCEINLINE void SetPosition_Internal(FDynamicMeshVertex& MeshVertex, const FVector& Position)
+    {
+        MeshVertex.Position = FShapesVisualizerPosition(Position);
+    }
+
+    struct FRingTable_Internal
+    {
+        FRingTable_Internal()
+        {
+            for (int32 NumSides = ShapesVisualizerGeometry::MinRingSides; NumSides <= ShapesVisualizerGeometry::MaxRingSides; NumSides++)
+            {
+                FShapesVisualizerRing& Ring = Rings[NumSides];
+                Ring.Cos.SetNumUninitialized(NumSides + 1);
+                Ring.Sin.SetNumUninitialized(NumSides + 1);
+
+                for (int32 SideIndex = 0; SideIndex <= NumSides; SideIndex++)
+                    FMath::SinCos(&Ring.Sin[SideIndex], &Ring.Cos[SideIndex], 2.f * PI * SideIndex / NumSides);
+            }
+        }
+
+        FShapesVisualizerRing Rings[ShapesVisualizerGeometry::MaxRingSides + 1];
+    };
+
+    FORCEINLINE FDynamicMeshVertex MakeVertex_Internal(const ShapesVisualizerTessellation::FVertex& Vertex)
+    {
+        return MakeVertex_Internal(
+            FVector{ Vertex.Position[0], Vertex.Position[1], Vertex.Position[2] },
+            FVector2D{ Vertex.UV[0], Vertex.UV[1] },
+            FVector{ Vertex.TangentX[0], Vertex.TangentX[1], Vertex.TangentX[2] },
+            FVector{ Vertex.TangentY[0], Vertex.TangentY[1], Vertex.TangentY[2] },
+            FVector{ Vertex.TangentZ[0], Vertex.TangentZ[1], Vertex.TangentZ[2] });
+    }
+
+    // Sizes the outputs, lets Tessellate fill the plain buffers and converts them to mesh vertices
+    template <typename TessellateType>
+    void AppendTessellation_Internal(const ShapesVisualizerTessellation::FCounts& Counts, TessellateType&& Tessellate,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+    {
+        const int32 BaseVertIndex = OutVerts.Num();
+        const int32 BaseIndex = OutIndices.Num();
+
+        TArray<ShapesVisualizerTessellation::FVertex> Verts;
+        Verts.SetNumUninitialized(Counts.NumVertices);
+        OutIndices.AddUninitialized(Counts.NumIndices);
+        Tessellate(Verts.GetData(), OutIndices.GetData() + BaseIndex, static_cast<uint32>(BaseVertIndex));
+
+        OutVerts.Reserve(BaseVertIndex + Verts.Num());
+        for (const ShapesVisualizerTessellation::FVertex& Vertex : Verts)
+            OutVerts.Add(MakeVertex_Internal(Vertex));
+    }
+
+    // Vertices of one point sphere, its poles are single vertices
+    FORCEINLINE int64 GetPointVertices_Internal(int32 NumSides)
+    {
+        return ShapesVisualizerTessellation::GetSphereCounts(NumSides,
+            ShapesVisualizerTessellation::GetSphereRings(NumSides), 0.f, PI).NumVertices;
+    }
+
+    static_assert(static_cast<uint8>(EVisualShape::Sphere) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::Sphere) &&
+        static_cast<uint8>(EVisualShape::HalfSphere) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::HalfSphere) &&
+        static_cast<uint8>(EVisualShape::Box) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::Box) &&
+        static_cast<uint8>(EVisualShape::Cylinder) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::Cylinder) &&
+        static_cast<uint8>(EVisualShape::Cone) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::Cone) &&
+        static_cast<uint8>(EVisualShape::Capsule) == static_cast<uint8>(ShapesVisualizerTessellation::EShape::Capsule),
+        "ShapesVisualizerTessellation::EShape must follow EVisualShape");
+    static_assert(ShapesVisualizerGeometry::MinRingSides == ShapesVisualizerTessellation::MinSides &&
+        ShapesVisualizerGeometry::MaxRingSides == ShapesVisualizerTessellation::MaxSides,
+        "Ring limits must match the tessellation limits");
+
+    // Moves the 10 low bits of Value to every third bit
+    FORCEINLINE uint32 SpreadMortonBits_Internal(uint32 Value)
+    {
+        Value &= 0x3FF;
+        Value = (Value | (Value << 16)) & 0x030000FF;
+        Value = (Value | (Value << 8)) & 0x0300F00F;
+        Value = (Value | (Value << 4)) & 0x030C30C3;
+        Value = (Value | (Value << 2)) & 0x09249249;
+        return Value;
+    }
+}
+
+//
+// ShapesVisualizerGeometry
+//
+
+const FShapesVisualizerRing& ShapesVisualizerGeometry::GetRing(int32 NumSides)
+{
+    static const FRingTable_Internal Table;
+    return Table.Rings[FMath::Clamp(NumSides, MinRingSides, MaxRingSides)];
+}
+
+void ShapesVisualizerGeometry::BuildSphereVerts(const FVector& Center, float Radius,
+    int32 NumSides, int32 NumRings, float StartAngle, float EndAngle,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    const float SphereCenter[3] = { static_cast<float>(Center.X), static_cast<float>(Center.Y), static_cast<float>(Center.Z) };
+
+    AppendTessellation_Internal(ShapesVisualizerTessellation::GetSphereCounts(NumSides, NumRings, StartAngle, EndAngle),
+        [&](ShapesVisualizerTessellation::FVertex* Verts, uint32* Indices, uint32 BaseVertex)
+        {
+            ShapesVisualizerTessellation::TessellateSphere(SphereCenter, Radius, NumSides, NumRings,
+                StartAngle, EndAngle, Verts, Indices, BaseVertex);
+        },
+        OutVerts, OutIndices);
+}
+
+void ShapesVisualizerGeometry::BuildArcLines(const FVector& Center, const FVector& XAxis, const FVector& YAxis, float Radius,
+    int32 NumSegments, float StartAngle, float EndAngle,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    const uint32 BaseVertIndex = OutVerts.Num();
+    NumSegments = FMath::Max(NumSegments, 1);
+
+    for (int32 VertIndex = 0; VertIndex <= NumSegments; VertIndex++)
+    {
+        float Sin, Cos;
+        FMath::SinCos(&Sin, &Cos, StartAngle + (EndAngle - StartAngle) * VertIndex / NumSegments);
+        OutVerts.Add(MakeVertex_Internal(Center + (XAxis * Cos + YAxis * Sin) * Radius, FVector2D::ZeroVector,
+            FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector));
+    }
+
+    for (int32 SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+    {
+        OutIndices.Add(BaseVertIndex + SegmentIndex);
+        OutIndices.Add(BaseVertIndex + SegmentIndex + 1);
+    }
+}
+
+void ShapesVisualizerGeometry::BuildLine(const FVector& Start, const FVector& End,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    OutIndices.Add(OutVerts.Num());
+    OutVerts.Add(MakeVertex_Internal(Start, FVector2D::ZeroVector,
+        FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector));
+    OutIndices.Add(OutVerts.Num());
+    OutVerts.Add(MakeVertex_Internal(End, FVector2D::ZeroVector,
+        FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector));
+}
+
+bool ShapesVisualizerGeometry::BuildShapeVerts(EVisualShape Shape, float Radii, float Height, const FVector& Extent, int32 NumSides,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    if (Shape > EVisualShape::Capsule)
+        return false;
+
+    const ShapesVisualizerTessellation::EShape TessellationShape = static_cast<ShapesVisualizerTessellation::EShape>(Shape);
+    const float BoxExtent[3] = { static_cast<float>(Extent.X), static_cast<float>(Extent.Y), static_cast<float>(Extent.Z) };
+
+    AppendTessellation_Internal(ShapesVisualizerTessellation::GetShapeCounts(TessellationShape, NumSides),
+        [&](ShapesVisualizerTessellation::FVertex* Verts, uint32* Indices, uint32 BaseVertex)
+        {
+            ShapesVisualizerTessellation::TessellateShape(TessellationShape, Radii, Height, BoxExtent, NumSides,
+                Verts, Indices, BaseVertex);
+        },
+        OutVerts, OutIndices);
+    return true;
+}
+
+FBox ShapesVisualizerGeometry::GetGridBox(const FIntVector& GridSize, const FVector& CellSize)
+{
+    const FVector HalfSize = FVector(FMath::Max(GridSize.X, 0), FMath::Max(GridSize.Y, 0), FMath::Max(GridSize.Z, 0)) * CellSize * 0.5f;
+    return FBox{ -HalfSize, HalfSize };
+}
+
+FColor ShapesVisualizerGeometry::GetShadedColor(const FColor& Color, const FVector& Normal)
+{
+    // Squared components of a unit normal sum to one, so axis aligned faces get exactly the grid shades
+    const float Shade = Normal.X * Normal.X * 0.85f + Normal.Y * Normal.Y * 0.7f
+        + Normal.Z * Normal.Z * (Normal.Z > 0.f ? 1.f : 0.55f);
+    return FColor{ static_cast<uint8>(Color.R * Shade), static_cast<uint8>(Color.G * Shade), static_cast<uint8>(Color.B * Shade), Color.A };
+}
+
+int32 ShapesVisualizerGeometry::BuildGridVerts(TArrayView<const FColor> Cells, const FIntVector& GridSize, const FVector& CellSize,
+    const FIntVector& ChunkMin, const FIntVector& ChunkMax,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    if (Cells.Num() != GridSize.X * GridSize.Y * GridSize.Z)
+        return 0;
+
+    // Top faces are lit, sides and bottoms darker, so the cells read as solid with unlit vertex colors
+    const float AxisShades[3][2] = { { 0.85f, 0.85f }, { 0.7f, 0.7f }, { 1.f, 0.55f } };
+    const FVector Origin = GetGridBox(GridSize, CellSize).Min;
+
+    int32 NumQuads = 0;
+    TArray<uint32> Mask;
+
+    for (int32 Axis = 0; Axis < 3; Axis++)
+    {
+        const int32 U = (Axis + 1) % 3;
+        const int32 V = (Axis + 2) % 3;
+        const int32 SizeU = ChunkMax[U] - ChunkMin[U];
+        const int32 SizeV = ChunkMax[V] - ChunkMin[V];
+        if (SizeU <= 0 || SizeV <= 0)
+            continue;
+        Mask.SetNumUninitialized(SizeU * SizeV);
+
+        for (int32 SideIndex = 0; SideIndex < 2; SideIndex++)
+        {
+            // The positive side faces along the axis, U cross V is the axis
+            const int32 Side = SideIndex == 0 ? 1 : -1;
+            FVector Normal = FVector::ZeroVector;
+            Normal[Axis] = Side;
+            FVector AxisU = FVector::ZeroVector;
+            AxisU[U] = 1.f;
+            FVector AxisV = FVector::ZeroVector;
+            AxisV[V] = 1.f;
+            const FVector& TangentX = Side > 0 ? AxisU : AxisV;
+            const FVector& TangentY = Side > 0 ? AxisV : AxisU;
+            const float Shade = AxisShades[Axis][SideIndex];
+
+            for (int32 Slice = ChunkMin[Axis]; Slice < ChunkMax[Axis]; Slice++)
+            {
+                // Packed colors of the visible faces of the slice, zero where there is no face
+                FIntVector Cell;
+                Cell[Axis] = Slice;
+                const int32 NeighborSlice = Slice + Side;
+                const bool HasNeighbors = NeighborSlice >= 0 && NeighborSlice < GridSize[Axis];
+                for (int32 IndexV = 0; IndexV < SizeV; IndexV++)
+                {
+                    Cell[V] = ChunkMin[V] + IndexV;
+                    for (int32 IndexU = 0; IndexU < SizeU; IndexU++)
+                    {
+                        Cell[U] = ChunkMin[U] + IndexU;
+                        const FColor& Color = Cells[GetGridCellIndex(GridSize, Cell.X, Cell.Y, Cell.Z)];
+                        uint32& Face = Mask[IndexU + IndexV * SizeU];
+                        Face = Color.A != 0 ? Color.DWColor() : 0;
+                        if (Face != 0 && HasNeighbors)
+                        {
+                            FIntVector Neighbor = Cell;
+                            Neighbor[Axis] = NeighborSlice;
+                            if (Cells[GetGridCellIndex(GridSize, Neighbor.X, Neighbor.Y, Neighbor.Z)].A != 0)
+                                Face = 0;
+                        }
+                    }
+                }
+
+                const float Plane = Origin[Axis] + (Slice + (Side > 0 ? 1 : 0)) * CellSize[Axis];
+
+                // Greedy merge: widen along U, then grow along V while the whole row matches
+                for (int32 IndexV = 0; IndexV < SizeV; IndexV++)
+                {
+                    for (int32 IndexU = 0; IndexU < SizeU; )
+                    {
+                        const uint32 Face = Mask[IndexU + IndexV * SizeU];
+                        if (Face == 0)
+                        {
+                            IndexU++;
+                            continue;
+                        }
+
+                        int32 Width = 1;
+                        while (IndexU + Width < SizeU && Mask[IndexU + Width + IndexV * SizeU] == Face)
+                            Width++;
+
+                        int32 Height = 1;
+                        for (; IndexV + Height < SizeV; Height++)
+                        {
+                            const uint32* Row = &Mask[IndexU + (IndexV + Height) * SizeU];
+                            int32 Count = 0;
+                            while (Count < Width && Row[Count] == Face)
+                                Count++;
+                            if (Count < Width)
+                                break;
+                        }
+
+                        for (int32 RowIndex = 0; RowIndex < Height; RowIndex++)
+                            FMemory::Memzero(&Mask[IndexU + (IndexV + RowIndex) * SizeU], Width * sizeof(uint32));
+
+                        // Corners in the box order: (X0, Y0), (X0, Y1), (X1, Y1), (X1, Y0)
+                        const int32 CellU0 = ChunkMin[U] + IndexU;
+                        const int32 CellV0 = ChunkMin[V] + IndexV;
+                        const FVector2D Min{ static_cast<float>(Side > 0 ? CellU0 : CellV0), static_cast<float>(Side > 0 ? CellV0 : CellU0) };
+                        const FVector2D Max = Min + (Side > 0 ? FVector2D(Width, Height) : FVector2D(Height, Width));
+                        const FVector2D Corners[4] = { { Min.X, Min.Y }, { Min.X, Max.Y }, { Max.X, Max.Y }, { Max.X, Min.Y } };
+
+                        FColor Color{ Face };
+                        Color.R = static_cast<uint8>(Color.R * Shade);
+                        Color.G = static_cast<uint8>(Color.G * Shade);
+                        Color.B = static_cast<uint8>(Color.B * Shade);
+
+                        const uint32 BaseVertIndex = OutVerts.Num();
+                        for (const FVector2D& Corner : Corners)
+                        {
+                            FVector Position = Origin + (TangentX * Corner.X + TangentY * Corner.Y) * CellSize;
+                            Position[Axis] = Plane;
+                            FDynamicMeshVertex& MeshVertex = OutVerts.Add_GetRef(
+                                MakeVertex_Internal(Position, Corner, TangentX, TangentY, Normal));
+                            MeshVertex.Color = Color;
+                        }
+
+                        const uint32 QuadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+                        for (uint32 Index : QuadIndices)
+                            OutIndices.Add(BaseVertIndex + Index);
+
+                        NumQuads++;
+                        IndexU += Width;
+                    }
+                }
+            }
+        }
+    }
+    return NumQuads;
+}
+
+FVector ShapesVisualizerGeometry::GetWorldRadiusScale(float Radius, const FVector& Scale)
+{
+    return FVector{
+        Radius / FMath::Max(FMath::Abs(Scale.X), KINDA_SMALL_NUMBER),
+        Radius / FMath::Max(FMath::Abs(Scale.Y), KINDA_SMALL_NUMBER),
+        Radius / FMath::Max(FMath::Abs(Scale.Z), KINDA_SMALL_NUMBER) };
+}
+
+int32 ShapesVisualizerGeometry::GetPointsSides(int32 NumPoints, int32 NumSides)
+{
+    NumSides = FMath::Clamp(NumSides, MinRingSides, MaxRingSides);
+    while (NumSides > MinRingSides && static_cast<int64>(NumPoints) * GetPointVertices_Internal(NumSides) > MaxPointsVertices)
+        NumSides--;
+    return static_cast<int64>(NumPoints) * GetPointVertices_Internal(NumSides) > MaxPointsVertices ? 0 : NumSides;
+}
+
+int32 ShapesVisualizerGeometry::GetMaxParallelTasks()
+{
+    return CVarShapesVisualizerMaxParallelTasks.GetValueOnAnyThread();
+}
+
+int32 ShapesVisualizerGeometry::GetPointsStride(int64 NumPoints, int32 VertsPerPoint)
+{
+    return static_cast<int32>(FMath::Max<int64>(1, (NumPoints * VertsPerPoint + MaxPointsVertices - 1) / MaxPointsVertices));
+}
+
+void ShapesVisualizerGeometry::GetSpatialOrder(TArrayView<const FVector> Points, TArray<int32>& OutOrder)
+{
+    OutOrder.SetNumUninitialized(Points.Num(), false);
+    if (Points.Num() == 0)
+        return;
+
+    const FBox Box{ Points.GetData(), Points.Num() };
+    const FVector Size = Box.GetSize();
+    const FVector CellScale{ Size.X > 0.f ? 1023.f / Size.X : 0.f, Size.Y > 0.f ? 1023.f / Size.Y : 0.f, Size.Z > 0.f ? 1023.f / Size.Z : 0.f };
+
+    // Code in the high half and the index in the low one, so sorting the keys is a stable sort by the code
+    TArray<uint64> Keys;
+    Keys.SetNumUninitialized(Points.Num());
+    ParallelForChunks(Points.Num(), [&](int32 StartIndex, int32 EndIndex)
+    {
+        for (int32 Index = StartIndex; Index < EndIndex; Index++)
+        {
+            const FVector Cell = (Points[Index] - Box.Min) * CellScale;
+            const uint32 Code = SpreadMortonBits_Internal(static_cast<uint32>(Cell.X))
+                | (SpreadMortonBits_Internal(static_cast<uint32>(Cell.Y)) << 1)
+                | (SpreadMortonBits_Internal(static_cast<uint32>(Cell.Z)) << 2);
+            Keys[Index] = (static_cast<uint64>(Code) << 32) | static_cast<uint32>(Index);
+        }
+    });
+    Keys.Sort();
+
+    for (int32 Index = 0; Index < Keys.Num(); Index++)
+        OutOrder[Index] = static_cast<int32>(Keys[Index] & MAX_uint32);
+}
+
+void ShapesVisualizerGeometry::BuildPointsVerts(TArrayView<const FVector> Points, float Radius, const FVector& Scale, int32 NumSides,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    TArray<FDynamicMeshVertex> SphereVerts;
+    TArray<uint32> SphereIndices;
+    if (NumSides >= MinRingSides)
+    {
+        BuildSphereVerts(FVector::ZeroVector, 1.f, NumSides, ShapesVisualizerTessellation::GetSphereRings(NumSides), 0.f, PI,
+            SphereVerts, SphereIndices);
+    }
+    else
+    {
+        // Four vertices, the cheapest closed solid, its normals point away from the center like the sphere ones
+        const float OneOverRootThree = FMath::Sqrt(1.f / 3.f);
+        const FVector Corners[4] = { FVector(1, 1, 1), FVector(1, -1, -1), FVector(-1, 1, -1), FVector(-1, -1, 1) };
+        static const uint32 Triangles[12] = { 1, 2, 3, 0, 3, 2, 0, 1, 3, 0, 2, 1 };
+        for (const FVector& Corner : Corners)
+        {
+            const FVector Normal = Corner * OneOverRootThree;
+            const FVector TangentX = FVector::CrossProduct(FVector::ZAxisVector, Normal).GetSafeNormal();
+            SphereVerts.Add(MakeVertex_Internal(Normal, FVector2D::ZeroVector,
+                TangentX, FVector::CrossProduct(Normal, TangentX), Normal));
+        }
+        SphereIndices.Append(Triangles, UE_ARRAY_COUNT(Triangles));
+    }
+
+    const FVector RadiusScale = GetWorldRadiusScale(Radius, Scale);
+
+    OutVerts.Reserve(OutVerts.Num() + Points.Num() * SphereVerts.Num());
+    OutIndices.Reserve(OutIndices.Num() + Points.Num() * SphereIndices.Num());
+
+    for (const FVector& Pt : Points)
+    {
+        const uint32 BaseVertIndex = OutVerts.Num();
+
+        for (const FDynamicMeshVertex& SphereVert : SphereVerts)
+        {
+            FDynamicMeshVertex& MeshVertex = OutVerts.Add_GetRef(SphereVert);
+            SetPosition_Internal(MeshVertex, Pt + GetPosition_Internal(SphereVert) * RadiusScale);
+        }
+
+        for (uint32 Index : SphereIndices)
+            OutIndices.Add(BaseVertIndex + Index);
+    }
+}
+
+// Engine source 4.27
+// .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
+// Lines [1352-1374]: DrawWireDiamond
+void ShapesVisualizerGeometry::BuildPointsLines(TArrayView<const FVector> Points, float Radius, const FVector& Scale,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices)
+{
+    // Top, bottom and four square points
+    const float OneOverRootTwo = FMath::Sqrt(0.5f);
+    const FVector Corners[6] = {
+        FVector(0, 0, 1), FVector(0, 0, -1),
+        FVector(1, 1, 0) * OneOverRootTwo, FVector(1, -1, 0) * OneOverRootTwo,
+        FVector(-1, -1, 0) * OneOverRootTwo, FVector(-1, 1, 0) * OneOverRootTwo };
+    static const uint32 Lines[24] = { 0, 2, 0, 3, 0, 4, 0, 5, 1, 2, 1, 3, 1, 4, 1, 5, 2, 3, 3, 4, 4, 5, 5, 2 };
+
+    const FVector RadiusScale = GetWorldRadiusScale(Radius, Scale);
+
+    OutVerts.Reserve(OutVerts.Num() + Points.Num() * UE_ARRAY_COUNT(Corners));
+    OutIndices.Reserve(OutIndices.Num() + Points.Num() * UE_ARRAY_COUNT(Lines));
+
+    for (const FVector& Pt : Points)
+    {
+        const uint32 BaseVertIndex = OutVerts.Num();
+
+        for (const FVector& Corner : Corners)
+        {
+            OutVerts.Add(MakeVertex_Internal(Pt + Corner * RadiusScale, FVector2D::ZeroVector,
+                FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector));
+        }
+
+        for (uint32 Index : Lines)
+            OutIndices.Add(BaseVertIndex + Index);
+    }
+}
+
+void ShapesVisualizerGeometry::TransformPositions(const FMatrix& LocalToWorld, TArrayView<const FVector> InPositions, FVector* OutPositions)
+{
+#if PLATFORM_ENABLE_VECTORINTRINSICS
+    // Row vector times matrix: X * Row0 + Y * Row1 + Z * Row2 + Row3
+    const VectorRegister Row0 = VectorLoad(&LocalToWorld.M[0][0]);
+    const VectorRegister Row1 = VectorLoad(&LocalToWorld.M[1][0]);
+    const VectorRegister Row2 = VectorLoad(&LocalToWorld.M[2][0]);
+    const VectorRegister Row3 = VectorLoad(&LocalToWorld.M[3][0]);
+
+    for (int32 Index = 0; Index < InPositions.Num(); Index++)
+    {
+        const VectorRegister Position = VectorLoadFloat3(&InPositions[Index].X);
+        VectorRegister Result = VectorMultiplyAdd(VectorReplicate(Position, 2), Row2, Row3);
+        Result = VectorMultiplyAdd(VectorReplicate(Position, 1), Row1, Result);
+        Result = VectorMultiplyAdd(VectorReplicate(Position, 0), Row0, Result);
+        VectorStoreFloat3(Result, &OutPositions[Index].X);
+    }
+#else
+    TransformPositionsScalar(LocalToWorld, InPositions, OutPositions);
+#endif
+}
+
+void ShapesVisualizerGeometry::TransformPositionsScalar(const FMatrix& LocalToWorld, TArrayView<const FVector> InPositions, FVector* OutPositions)
+{
+    for (int32 Index = 0; Index < InPositions.Num(); Index++)
+        OutPositions[Index] = LocalToWorld.TransformPosition(InPositions[Index]);
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMeshBuilder.h"
+#include "Async/ParallelFor.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "ShapesVisualizerStats.h"
+
+enum class EVisualShape : uint8;
+
+// Type of FDynamicMeshVertex::Position and of the position vertex buffer elements
+#if ENGINE_MAJOR_VERSION == 5
+using FShapesVisualizerPosition = FVector3f;
+#else
+using FShapesVisualizerPosition = FVector;
+#endif
+
+//
+// FShapesVisualizerRing - cosines and sines of 2*PI*i/NumSides for i in [0, NumSides]
+//
+
+struct FShapesVisualizerRing
+{
+    TArray<float> Cos;
+    TArray<float> Sin;
+};
+
+//
+// ShapesVisualizerGeometry - engine meshes of the shapes in local space
+//
+// Solid shapes are tessellated by ShapesVisualizerTessellation and converted to FDynamicMeshVertex here.
+//
+
+namespace ShapesVisualizerGeometry
+{
+    constexpr int32 MinRingSides = 3;
+    constexpr int32 MaxRingSides = 64;
+    // Budget for the merged mesh of point spheres
+    constexpr int64 MaxPointsVertices = 1 << 22;
+    // Points per task of the parallel loops, smaller sets run serially on the calling thread
+    constexpr int32 ParallelChunkSize = 4096;
+
+    // Upper bound of the tasks of one parallel loop, 0 if any number (r.ShapesVisualizer.MaxParallelTasks)
+    int32 GetMaxParallelTasks();
+
+    // Runs Body(StartIndex, EndIndex) over chunks of [0, Num) on the task graph. Every chunk
+    // writes only its own range of the preallocated output, so nothing needs a lock
+    template <typename BodyType>
+    void ParallelForChunks(int32 Num, BodyType&& Body)
+    {
+        const int32 NumChunks = FMath::DivideAndRoundUp(Num, ParallelChunkSize);
+        const int32 MaxTasks = GetMaxParallelTasks();
+        const int32 NumTasks = MaxTasks > 0 ? FMath::Min(NumChunks, MaxTasks) : NumChunks;
+        if (NumTasks <= 1)
+        {
+            if (Num > 0)
+                Body(0, Num);
+            return;
+        }
+
+        // Capped loops give every task a run of whole chunks. The tasks count allocations as their caller does
+        const bool Counted = SHAPESVISUALIZER_IS_COUNTING_ALLOCATIONS();
+        ParallelFor(NumTasks, [Num, NumChunks, NumTasks, Counted, &Body](int32 TaskIndex)
+        {
+            SHAPESVISUALIZER_COUNT_ALLOCATIONS(Counted);
+            const int32 StartIndex = static_cast<int32>(static_cast<int64>(NumChunks) * TaskIndex / NumTasks) * ParallelChunkSize;
+            const int32 EndIndex = static_cast<int32>(static_cast<int64>(NumChunks) * (TaskIndex + 1) / NumTasks) * ParallelChunkSize;
+            Body(StartIndex, FMath::Min(EndIndex, Num));
+        });
+    }
+
+    // Precomputed once for every legal number of sides, thread safe
+    const FShapesVisualizerRing& GetRing(int32 NumSides);
+
+    // Part of a sphere between StartAngle and EndAngle measured from +Z
+    void BuildSphereVerts(const FVector& Center, float Radius,
+        int32 NumSides, int32 NumRings, float StartAngle, float EndAngle,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // Local offsets which stay Radius long in world space after the component scale
+    FVector GetWorldRadiusScale(float Radius, const FVector& Scale);
+
+    // Number of sides which keeps the merged points mesh within MaxPointsVertices,
+    // 0 when even the coarsest spheres do not fit and the points become tetrahedra
+    int32 GetPointsSides(int32 NumPoints, int32 NumSides);
+
+    // Every Stride-th point is drawn when NumPoints meshes of VertsPerPoint vertices would exceed
+    // MaxPointsVertices, 1 when all of them fit
+    int32 GetPointsStride(int64 NumPoints, int32 VertsPerPoint);
+
+    // Order of the points along the Z-order (Morton) curve through their box, 10 bits per axis.
+    // Runs of the order are compact in space and every n-th point of it samples the whole set
+    void GetSpatialOrder(TArrayView<const FVector> Points, TArray<int32>& OutOrder);
+
+    // Sphere at every point merged into one mesh, tetrahedra if NumSides is 0. Scale is the component scale,
+    // it is divided out so the radius stays in world units
+    void BuildPointsVerts(TArrayView<const FVector> Points, float Radius, const FVector& Scale, int32 NumSides,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // Diamond at every point merged into one line list
+    void BuildPointsLines(TArrayView<const FVector> Points, float Radius, const FVector& Scale,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // Arc from StartAngle to EndAngle of the circle around Center in the plane of XAxis and YAxis, as a line list
+    void BuildArcLines(const FVector& Center, const FVector& XAxis, const FVector& YAxis, float Radius,
+        int32 NumSegments, float StartAngle, float EndAngle,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    void BuildLine(const FVector& Start, const FVector& End,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // Solid mesh of the shape as the scene proxy draws it, false if the shape has no solid mesh
+    bool BuildShapeVerts(EVisualShape Shape, float Radii, float Height, const FVector& Extent, int32 NumSides,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // Color of a surface facing Normal, lit from above with the shades of the grid faces, for unlit vertex color materials
+    FColor GetShadedColor(const FColor& Color, const FVector& Normal);
+
+    // Local box of a grid, centered on the component like the box shape
+    FBox GetGridBox(const FIntVector& GridSize, const FVector& CellSize);
+
+    // Cells are X fastest, then Y and Z
+    FORCEINLINE int32 GetGridCellIndex(const FIntVector& GridSize, int32 X, int32 Y, int32 Z)
+    {
+        return X + GridSize.X * (Y + GridSize.Y * Z);
+    }
+
+    // Faces of the cells in [ChunkMin, ChunkMax) whose neighbor is empty, cells of zero alpha are empty.
+    // Faces between filled cells are hidden also across the chunk borders, and adjacent faces of the same
+    // color are merged into greedy quads. The face direction is shaded into the vertex colors for unlit
+    // materials. Returns the number of quads
+    int32 BuildGridVerts(TArrayView<const FColor> Cells, const FIntVector& GridSize, const FVector& CellSize,
+        const FIntVector& ChunkMin, const FIntVector& ChunkMax,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices);
+
+    // LocalToWorld.TransformPosition of every position, vectorized with VectorRegister (SSE on x86,
+    // NEON on ARM). OutPositions must have room for InPositions.Num() elements, or be InPositions itself
+    void TransformPositions(const FMatrix& LocalToWorld, TArrayView<const FVector> InPositions, FVector* OutPositions);
+    // One position at a time, the reference for the vectorized kernel and its fallback without intrinsics
+    void TransformPositionsScalar(const FMatrix& LocalToWorld, TArrayView<const FVector> InPositions, FVector* OutPositions);
+
+    // Douglas-Peucker simplification of the polyline, OutIndices gets the kept points in order.
+    // GetPoint(Index) returns the point Index of NumPoints, so ring buffers need no copy
+    template <typename GetPointType>
+    void SimplifyPolyline(int32 NumPoints, float Tolerance, GetPointType&& GetPoint, TArray<int32>& OutIndices)
+    {
+        OutIndices.Reset();
+        if (NumPoints < 3 || Tolerance <= 0.f)
+        {
+            for (int32 Index = 0; Index < NumPoints; Index++)
+                OutIndices.Add(Index);
+            return;
+        }
+
+        TBitArray<> Keep{ false, NumPoints };
+        Keep[0] = Keep[NumPoints - 1] = true;
+
+        const float ToleranceSquared = FMath::Square(Tolerance);
+        TArray<TPair<int32, int32>, TInlineAllocator<64>> Segments;
+        Segments.Emplace(0, NumPoints - 1);
+
+        while (Segments.Num() > 0)
+        {
+            const TPair<int32, int32> Segment = Segments.Pop(false);
+            const FVector Start = GetPoint(Segment.Key);
+            const FVector End = GetPoint(Segment.Value);
+
+            float MaxDistSquared = ToleranceSquared;
+            int32 MaxIndex = INDEX_NONE;
+            for (int32 Index = Segment.Key + 1; Index < Segment.Value; Index++)
+            {
+                const float DistSquared = FMath::PointDistToSegmentSquared(GetPoint(Index), Start, End);
+                if (DistSquared > MaxDistSquared)
+                {
+                    MaxDistSquared = DistSquared;
+                    MaxIndex = Index;
+                }
+            }
+
+            if (MaxIndex != INDEX_NONE)
+            {
+                Keep[MaxIndex] = true;
+                Segments.Emplace(Segment.Key, MaxIndex);
+                Segments.Emplace(MaxIndex, Segment.Value);
+            }
+        }
+
+        for (TConstSetBitIterator<> It(Keep); It; ++It)
+            OutIndices.Add(It.GetIndex());
+    }
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerGeometryPool.h"
+#include "Misc/ScopeLock.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerTessellation.h"
+#include "Components/ShapesVisualizerComponent.h"
+
+//
+// Internal functions
+//
+
+namespace
+{
+    void BuildUnitVerts_Internal(EVisualShape Shape, int32 NumSides,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices, int32& OutSplitIndex, int32& OutBodyIndex)
+    {
+        switch (Shape)
+        {
+        case EVisualShape::Capsule:
+        {
+            // Unit radius and half height 2 puts the caps at +-1, the merged mesh keeps the caps before the body
+            ShapesVisualizerGeometry::BuildShapeVerts(Shape, 1.f, 4.f, FVector::OneVector,
+                NumSides, OutVerts, OutIndices);
+            const int32 CapIndices = ShapesVisualizerTessellation::GetCapsuleCapCounts(NumSides).NumIndices;
+            OutSplitIndex = CapIndices;
+            OutBodyIndex = 2 * CapIndices;
+            break;
+        }
+
+        default:
+            ShapesVisualizerGeometry::BuildShapeVerts(Shape, 1.f, 2.f, FVector::OneVector,
+                NumSides, OutVerts, OutIndices);
+            break;
+        }
+    }
+
+    // Same lines as the engine wire helpers draw
+    void BuildUnitLines_Internal(EVisualShape Shape, int32 NumSides,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices, int32& OutSplitIndex, int32& OutBodyIndex)
+    {
+        const FVector Top{ 0.f, 0.f, 1.f };
+        const FVector Bottom{ 0.f, 0.f, -1.f };
+        const FShapesVisualizerRing& Ring = ShapesVisualizerGeometry::GetRing(NumSides);
+
+        switch (Shape)
+        {
+        case EVisualShape::Sphere:
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::XAxisVector, FVector::YAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::XAxisVector, FVector::ZAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::YAxisVector, FVector::ZAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            break;
+
+        case EVisualShape::HalfSphere:
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::XAxisVector, FVector::YAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::XAxisVector, FVector::ZAxisVector, 1.f,
+                NumSides / 2, 0.f, PI, OutVerts, OutIndices);
+            ShapesVisualizerGeometry::BuildArcLines(FVector::ZeroVector, FVector::YAxisVector, FVector::ZAxisVector, 1.f,
+                NumSides / 2, 0.f, PI, OutVerts, OutIndices);
+            break;
+
+        case EVisualShape::Box:
+            for (int32 Axis = 0; Axis < 3; Axis++)
+            {
+                // Four edges along every axis
+                for (int32 Corner = 0; Corner < 4; Corner++)
+                {
+                    FVector Start{ ForceInitToZero };
+                    Start[(Axis + 1) % 3] = Corner & 1 ? 1.f : -1.f;
+                    Start[(Axis + 2) % 3] = Corner & 2 ? 1.f : -1.f;
+                    FVector End = Start;
+                    Start[Axis] = -1.f;
+                    End[Axis] = 1.f;
+                    ShapesVisualizerGeometry::BuildLine(Start, End, OutVerts, OutIndices);
+                }
+            }
+            break;
+
+        case EVisualShape::Cylinder:
+        case EVisualShape::Cone:
+        {
+            const float TopRadius = Shape == EVisualShape::Cylinder ? 1.f : 0.f;
+            ShapesVisualizerGeometry::BuildArcLines(Bottom, FVector::XAxisVector, FVector::YAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            if (TopRadius > 0.f)
+                ShapesVisualizerGeometry::BuildArcLines(Top, FVector::XAxisVector, FVector::YAxisVector, TopRadius,
+                    NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            for (int32 SideIndex = 0; SideIndex < NumSides; SideIndex++)
+            {
+                const FVector Direction{ Ring.Cos[SideIndex], Ring.Sin[SideIndex], 0.f };
+                ShapesVisualizerGeometry::BuildLine(Bottom + Direction, Top + Direction * TopRadius, OutVerts, OutIndices);
+            }
+            break;
+        }
+
+        case EVisualShape::Capsule:
+            for (int32 Half = 0; Half < 2; Half++)
+            {
+                const float StartAngle = Half == 0 ? 0.f : PI;
+                const FVector& CapCenter = Half == 0 ? Top : Bottom;
+                ShapesVisualizerGeometry::BuildArcLines(CapCenter, FVector::XAxisVector, FVector::ZAxisVector, 1.f,
+                    NumSides / 2, StartAngle, StartAngle + PI, OutVerts, OutIndices);
+                ShapesVisualizerGeometry::BuildArcLines(CapCenter, FVector::YAxisVector, FVector::ZAxisVector, 1.f,
+                    NumSides / 2, StartAngle, StartAngle + PI, OutVerts, OutIndices);
+                if (Half == 0)
+                    OutSplitIndex = OutIndices.Num();
+            }
+
+            OutBodyIndex = OutIndices.Num();
+            ShapesVisualizerGeometry::BuildArcLines(Top, FVector::XAxisVector, FVector::YAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            ShapesVisualizerGeometry::BuildArcLines(Bottom, FVector::XAxisVector, FVector::YAxisVector, 1.f,
+                NumSides, 0.f, 2.f * PI, OutVerts, OutIndices);
+            for (const FVector& Direction : { FVector::XAxisVector, FVector::YAxisVector, -FVector::XAxisVector, -FVector::YAxisVector })
+                ShapesVisualizerGeometry::BuildLine(Bottom + Direction, Top + Direction, OutVerts, OutIndices);
+            break;
+        }
+    }
+
+    // Box does not depend on the number of sides
+    FORCEINLINE int32 GetKeySides_Internal(EVisualShape Shape, int32 NumSides)
+    {
+        return Shape == EVisualShape::Box ? 0
+            : FMath::Clamp(NumSides, ShapesVisualizerGeometry::MinRingSides, ShapesVisualizerGeometry::MaxRingSides);
+    }
+}
+
+//
+// FShapesVisualizerGeometryPool
+//
+
+FShapesVisualizerGeometryPool& FShapesVisualizerGeometryPool::Get()
+{
+    static FShapesVisualizerGeometryPool Pool;
+    return Pool;
+}
+
+const FShapesVisualizerUnitMesh* FShapesVisualizerGeometryPool::Acquire(EVisualShape Shape, int32 NumSides, ERHIFeatureLevel::Type FeatureLevel,
+    bool Lines)
+{
+    check(IsInRenderingThread());
+
+    NumSides = GetKeySides_Internal(Shape, NumSides);
+    const uint32 Key = (static_cast<uint32>(Lines) << 24) | (static_cast<uint32>(Shape) << 16)
+        | (static_cast<uint32>(FeatureLevel) << 8) | static_cast<uint32>(NumSides);
+
+    FShapesVisualizerUnitMesh*& Mesh = Meshes.FindOrAdd(Key);
+    if (!Mesh)
+    {
+        TArray<FDynamicMeshVertex> MeshVerts;
+        TArray<uint32> MeshIndices;
+        int32 SplitIndex = 0;
+        int32 BodyIndex = 0;
+        BuildUnitMesh(Shape, NumSides, Lines, MeshVerts, MeshIndices, SplitIndex, BodyIndex);
+
+        Mesh = new FShapesVisualizerUnitMesh(FeatureLevel);
+        Mesh->Key = Key;
+        Mesh->SplitIndex = SplitIndex;
+        Mesh->BodyIndex = BodyIndex;
+        Mesh->Buffers.Init(MeshVerts, MeshIndices, Lines ? PT_LineList : PT_TriangleList);
+    }
+
+    Mesh->RefCount++;
+    return Mesh;
+}
+
+void FShapesVisualizerGeometryPool::BuildUnitMesh(EVisualShape Shape, int32 NumSides, bool Lines,
+    TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices, int32& OutSplitIndex, int32& OutBodyIndex)
+{
+    if (Lines)
+        BuildUnitLines_Internal(Shape, NumSides, OutVerts, OutIndices, OutSplitIndex, OutBodyIndex);
+    else
+        BuildUnitVerts_Internal(Shape, NumSides, OutVerts, OutIndices, OutSplitIndex, OutBodyIndex);
+}
+
+const FShapesVisualizerUnitLines& FShapesVisualizerGeometryPool::GetUnitLines(EVisualShape Shape, int32 NumSides)
+{
+    NumSides = GetKeySides_Internal(Shape, NumSides);
+    const uint32 Key = (static_cast<uint32>(Shape) << 16) | static_cast<uint32>(NumSides);
+
+    FScopeLock Lock(&UnitLinesLock);
+    TUniquePtr<FShapesVisualizerUnitLines>& Lines = UnitLines.FindOrAdd(Key);
+    if (!Lines)
+    {
+        TArray<FDynamicMeshVertex> MeshVerts;
+        TArray<uint32> MeshIndices;
+        Lines = MakeUnique<FShapesVisualizerUnitLines>();
+        BuildUnitMesh(Shape, NumSides, true, MeshVerts, MeshIndices, Lines->SplitIndex, Lines->BodyIndex);
+
+        Lines->LineVerts.Reserve(MeshIndices.Num());
+        for (const uint32 Index : MeshIndices)
+            Lines->LineVerts.Add(FVector{ MeshVerts[Index].Position });
+    }
+    return *Lines;
+}
+
+void FShapesVisualizerGeometryPool::Release(const FShapesVisualizerUnitMesh* Mesh)
+{
+    check(IsInRenderingThread());
+
+    if (!Mesh)
+        return;
+
+    FShapesVisualizerUnitMesh* const* Found = Meshes.Find(Mesh->Key);
+    check(Found && *Found == Mesh);
+
+    FShapesVisualizerUnitMesh* MutableMesh = *Found;
+    if (--MutableMesh->RefCount > 0)
+        return;
+
+    Meshes.Remove(Mesh->Key);
+    MutableMesh->Buffers.Release();
+    delete MutableMesh;
+}
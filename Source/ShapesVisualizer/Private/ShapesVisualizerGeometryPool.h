@@ -0,0 +1,80 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHIDefinitions.h"
+#include "HAL/CriticalSection.h"
+#include "ShapesVisualizerMeshBuffers.h"
+
+enum class EVisualShape : uint8;
+
+//
+// FShapesVisualizerUnitMesh - shape of unit size shared by all proxies
+//
+
+struct FShapesVisualizerUnitMesh
+{
+    FShapesVisualizerUnitMesh(ERHIFeatureLevel::Type InFeatureLevel) : Buffers(InFeatureLevel) {}
+
+    FShapesVisualizerMeshBuffers Buffers;
+    // Capsule keeps its upper cap in [0, SplitIndex), the lower one in [SplitIndex, BodyIndex)
+    // and the body between the circles at +-1 in [BodyIndex, end)
+    int32 SplitIndex = 0;
+    int32 BodyIndex = 0;
+
+private:
+
+    friend class FShapesVisualizerGeometryPool;
+    uint32 Key = 0;
+    int32 RefCount = 0;
+};
+
+//
+// FShapesVisualizerUnitLines - CPU copy of a line unit mesh, for the lines drawn as quads
+//
+
+struct FShapesVisualizerUnitLines
+{
+    // Start and end of every line, the capsule parts split them like the indices of FShapesVisualizerUnitMesh
+    TArray<FVector> LineVerts;
+    int32 SplitIndex = 0;
+    int32 BodyIndex = 0;
+};
+
+//
+// FShapesVisualizerGeometryPool - render thread cache of unit meshes keyed by (EVisualShape, NumSides, Lines)
+//
+// Sphere, HalfSphere, Cylinder and Cone have unit radius and unit half height,
+// Box has unit extent and Capsule has unit radius with its caps centered at +-1.
+// Real sizes are applied with a per-draw scale.
+// Line meshes are the wireframes of the same shapes as line lists.
+//
+
+class FShapesVisualizerGeometryPool
+{
+public:
+
+    static FShapesVisualizerGeometryPool& Get();
+
+    // Builds the mesh on the first request, every Acquire must be paired with Release
+    const FShapesVisualizerUnitMesh* Acquire(EVisualShape Shape, int32 NumSides, ERHIFeatureLevel::Type FeatureLevel,
+        bool Lines = false);
+    void Release(const FShapesVisualizerUnitMesh* Mesh);
+
+    // CPU copy of the mesh Acquire builds, with the capsule part indices of FShapesVisualizerUnitMesh
+    static void BuildUnitMesh(EVisualShape Shape, int32 NumSides, bool Lines,
+        TArray<FDynamicMeshVertex>& OutVerts, TArray<uint32>& OutIndices, int32& OutSplitIndex, int32& OutBodyIndex);
+
+    // Lines of the line unit mesh as vertex pairs, built on the first request and kept for the whole run.
+    // Safe from any thread, the reference stays valid
+    const FShapesVisualizerUnitLines& GetUnitLines(EVisualShape Shape, int32 NumSides);
+
+    int32 GetNumMeshes() const { return Meshes.Num(); }
+
+private:
+
+    TMap<uint32, FShapesVisualizerUnitMesh*> Meshes;
+    TMap<uint32, TUniquePtr<FShapesVisualizerUnitLines>> UnitLines;
+    FCriticalSection UnitLinesLock;
+};
@@ -0,0 +1,125 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerGridMesh.h"
+#include "ShapesVisualizerGeometry.h"
+
+namespace
+{
+    FORCEINLINE FIntVector Min_Internal(const FIntVector& A, const FIntVector& B)
+    {
+        return FIntVector{ FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y), FMath::Min(A.Z, B.Z) };
+    }
+
+    FORCEINLINE FIntVector Max_Internal(const FIntVector& A, const FIntVector& B)
+    {
+        return FIntVector{ FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y), FMath::Max(A.Z, B.Z) };
+    }
+}
+
+//
+// FShapesVisualizerGridMesh
+//
+
+void FShapesVisualizerGridMesh::Build(const FIntVector& InGridSize, const FVector& InCellSize, TArray<FColor>&& InCells)
+{
+    Release();
+    if (InGridSize.GetMin() <= 0)
+        return;
+
+    // Grids sized in the details panel have no cells yet, the missing ones are empty
+    GridSize = InGridSize;
+    CellSize = InCellSize;
+    Cells = MoveTemp(InCells);
+    Cells.SetNumZeroed(GridSize.X * GridSize.Y * GridSize.Z);
+    NumChunksPerAxis = FIntVector{
+        FMath::DivideAndRoundUp(GridSize.X, ChunkSize),
+        FMath::DivideAndRoundUp(GridSize.Y, ChunkSize),
+        FMath::DivideAndRoundUp(GridSize.Z, ChunkSize) };
+
+    const int32 Count = NumChunksPerAxis.X * NumChunksPerAxis.Y * NumChunksPerAxis.Z;
+    Chunks.Reserve(Count);
+    for (int32 ChunkIndex = 0; ChunkIndex < Count; ChunkIndex++)
+        Chunks.Add(new FChunk{ FeatureLevel });
+
+    BuildChunks(FIntVector::ZeroValue, NumChunksPerAxis - FIntVector{ 1 });
+}
+
+void FShapesVisualizerGridMesh::Update(const FIntVector& Start, const FIntVector& Size, TArrayView<const FColor> InCells)
+{
+    if (Chunks.Num() == 0 || Size.GetMin() <= 0 || InCells.Num() != Size.X * Size.Y * Size.Z)
+        return;
+
+    const FIntVector End = Start + Size;
+    if (Start.GetMin() < 0 || End.X > GridSize.X || End.Y > GridSize.Y || End.Z > GridSize.Z)
+        return;
+
+    for (int32 Z = 0; Z < Size.Z; Z++)
+    {
+        for (int32 Y = 0; Y < Size.Y; Y++)
+        {
+            FMemory::Memcpy(&Cells[ShapesVisualizerGeometry::GetGridCellIndex(GridSize, Start.X, Start.Y + Y, Start.Z + Z)],
+                &InCells[ShapesVisualizerGeometry::GetGridCellIndex(Size, 0, Y, Z)], Size.X * sizeof(FColor));
+        }
+    }
+
+    // One cell around the box, the faces of the neighbors of changed cells may appear or hide
+    const FIntVector Border = FIntVector{ 1 };
+    const FIntVector FirstChunk = Max_Internal(Start - Border, FIntVector::ZeroValue) / ChunkSize;
+    const FIntVector LastChunk = Min_Internal(End, GridSize - Border) / ChunkSize;
+    BuildChunks(FirstChunk, LastChunk);
+}
+
+void FShapesVisualizerGridMesh::Release()
+{
+    for (FChunk& Chunk : Chunks)
+        Chunk.Buffers.Release();
+    Chunks.Empty();
+    Cells.Empty();
+    GridSize = FIntVector::ZeroValue;
+    NumChunksPerAxis = FIntVector::ZeroValue;
+}
+
+SIZE_T FShapesVisualizerGridMesh::GetAllocatedSize() const
+{
+    return Cells.GetAllocatedSize() + Chunks.GetAllocatedSize() + Chunks.Num() * sizeof(FChunk);
+}
+
+void FShapesVisualizerGridMesh::BuildChunks(const FIntVector& FirstChunk, const FIntVector& LastChunk)
+{
+    const FIntVector Count = LastChunk - FirstChunk + FIntVector{ 1 };
+    const int32 NumBuilds = Count.X * Count.Y * Count.Z;
+
+    struct FChunkBuild
+    {
+        int32 ChunkIndex;
+        TArray<FDynamicMeshVertex> Verts;
+        TArray<uint32> Indices;
+        int32 NumQuads;
+    };
+    TArray<FChunkBuild> Builds;
+    Builds.SetNum(NumBuilds);
+
+    // Meshing reads only the cells, the buffers are created afterwards on this thread
+    ParallelFor(NumBuilds, [&](int32 BuildIndex)
+    {
+        const FIntVector Chunk = FirstChunk + FIntVector{
+            BuildIndex % Count.X, (BuildIndex / Count.X) % Count.Y, BuildIndex / (Count.X * Count.Y) };
+        const FIntVector ChunkMin = Chunk * ChunkSize;
+        const FIntVector ChunkMax = Min_Internal(ChunkMin + FIntVector{ ChunkSize }, GridSize);
+
+        FChunkBuild& Build = Builds[BuildIndex];
+        Build.ChunkIndex = ShapesVisualizerGeometry::GetGridCellIndex(NumChunksPerAxis, Chunk.X, Chunk.Y, Chunk.Z);
+        Build.NumQuads = ShapesVisualizerGeometry::BuildGridVerts(Cells, GridSize, CellSize, ChunkMin, ChunkMax,
+            Build.Verts, Build.Indices);
+    });
+
+    for (FChunkBuild& Build : Builds)
+    {
+        FChunk& Chunk = Chunks[Build.ChunkIndex];
+        Chunk.NumQuads = Build.NumQuads;
+        Chunk.Box.Init();
+        for (const FDynamicMeshVertex& Vertex : Build.Verts)
+            Chunk.Box += FVector{ Vertex.Position };
+        Chunk.Buffers.Init(Build.Verts, Build.Indices);
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerMeshBuffers.h"
+
+//
+// FShapesVisualizerGridMesh - greedy meshed chunks of a grid of colored cells
+//
+// The grid is split into chunks of ChunkSize cells per axis, each one with its own buffers and local box,
+// so the chunks are culled per view and a change of some cells remeshes only the chunks around them.
+// Faces between filled cells of adjacent chunks are hidden, so a cell next to a chunk border also
+// remeshes the neighbor chunk. Render thread only.
+//
+
+class FShapesVisualizerGridMesh
+{
+public:
+
+    // 128 cells per axis are 64 chunks
+    static constexpr int32 ChunkSize = 32;
+
+    explicit FShapesVisualizerGridMesh(ERHIFeatureLevel::Type InFeatureLevel) : FeatureLevel(InFeatureLevel) {}
+
+    // Consumes the cells, X fastest, then Y and Z
+    void Build(const FIntVector& InGridSize, const FVector& InCellSize, TArray<FColor>&& InCells);
+    // Cells of the box [Start, Start + Size) in the same order
+    void Update(const FIntVector& Start, const FIntVector& Size, TArrayView<const FColor> InCells);
+    void Release();
+
+    int32 NumChunks() const { return Chunks.Num(); }
+    const FShapesVisualizerMeshBuffers& GetBuffers(int32 ChunkIndex) const { return Chunks[ChunkIndex].Buffers; }
+    const FBox& GetChunkBox(int32 ChunkIndex) const { return Chunks[ChunkIndex].Box; }
+    int32 GetNumQuads(int32 ChunkIndex) const { return Chunks[ChunkIndex].NumQuads; }
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    struct FChunk
+    {
+        explicit FChunk(ERHIFeatureLevel::Type InFeatureLevel) : Buffers(InFeatureLevel) {}
+
+        FShapesVisualizerMeshBuffers Buffers;
+        FBox Box{ ForceInit };
+        int32 NumQuads = 0;
+    };
+
+    // Remeshes the chunks of the inclusive chunk coordinates range
+    void BuildChunks(const FIntVector& FirstChunk, const FIntVector& LastChunk);
+
+private:
+
+    ERHIFeatureLevel::Type FeatureLevel;
+    FIntVector GridSize = FIntVector::ZeroValue;
+    FIntVector NumChunksPerAxis = FIntVector::ZeroValue;
+    FVector CellSize = FVector::ZeroVector;
+    TArray<FColor> Cells;
+    TIndirectArray<FChunk> Chunks;
+};
@@ -0,0 +1,147 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerLineMeshes.h"
+#include "Engine/Engine.h"
+#include "Materials/Material.h"
+#include "SceneView.h"
+#include "ShapesVisualizerDrawing.h"
+
+//
+// Internal functions
+//
+
+namespace
+{
+    // Smallest mesh, short lines of many frames share it without growing
+    constexpr int32 MinVertices_Internal = 256;
+}
+
+//
+// FShapesVisualizerLineMeshes
+//
+
+int32 FShapesVisualizerLineMeshes::DrawLines(const FSceneView& View, TArrayView<const FVector> LineVerts, TArrayView<const FColor> LineColors,
+    float Thickness, const FBoxSphereBounds& WorldBounds, uint8 DepthPriority, int32 ViewIndex, FMeshElementCollector& Collector)
+{
+    const int32 NumLines = LineVerts.Num() / 2;
+    if (NumLines == 0 || LineColors.Num() == 0)
+        return 0;
+
+    const bool Thick = Thickness > 0.f;
+    const int32 VertsPerLine = Thick ? 4 : 2;
+    const int32 NumVertices = NumLines * VertsPerLine;
+    FShapesVisualizerMeshBuffers& Buffers = AcquireMesh(View.Family->FrameNumber, Thick ? PT_TriangleList : PT_LineList, NumVertices);
+
+    FShapesVisualizerPosition* const Positions = Buffers.LockPositions(0, NumVertices);
+    if (Thick)
+    {
+        // Quads turn around their line to the view, an orthographic view looks the same way at all of them
+        const bool Perspective = View.ViewMatrices.IsPerspectiveProjection();
+        const FVector ViewOrigin = View.ViewMatrices.GetViewOrigin();
+        const FVector ToView = -View.GetViewDirection();
+        const float HalfThickness = Thickness * 0.5f;
+
+        for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+        {
+            const FVector& Start = LineVerts[LineIndex * 2];
+            const FVector& End = LineVerts[LineIndex * 2 + 1];
+            const FVector Side = FVector::CrossProduct(End - Start, Perspective ? ViewOrigin - (Start + End) * 0.5f : ToView)
+                .GetSafeNormal() * HalfThickness;
+
+            FShapesVisualizerPosition* const Quad = Positions + LineIndex * 4;
+            Quad[0] = FShapesVisualizerPosition(Start - Side);
+            Quad[1] = FShapesVisualizerPosition(Start + Side);
+            Quad[2] = FShapesVisualizerPosition(End + Side);
+            Quad[3] = FShapesVisualizerPosition(End - Side);
+        }
+    }
+    else
+    {
+        for (int32 Index = 0; Index < NumVertices; Index++)
+            Positions[Index] = FShapesVisualizerPosition(LineVerts[Index]);
+    }
+    Buffers.UnlockPositions();
+
+    FColor* const Colors = Buffers.LockColors(0, NumVertices);
+    for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+    {
+        const FColor& Color = LineColors[LineColors.Num() > 1 ? LineIndex : 0];
+        for (int32 Vertex = 0; Vertex < VertsPerLine; Vertex++)
+            Colors[LineIndex * VertsPerLine + Vertex] = Color;
+    }
+    Buffers.UnlockColors();
+
+    // The lines are in world space, the bounds of the proxy cover them
+    Buffers.SetDrawRange(NumVertices, NumLines * (Thick ? 6 : 2));
+    ShapesVisualizerDrawing::GetMeshBuffers(Buffers, FMatrix::Identity, WorldBounds, WorldBounds,
+        GEngine->VertexColorMaterial->GetRenderProxy(), DepthPriority, ViewIndex, Collector);
+    return NumLines;
+}
+
+void FShapesVisualizerLineMeshes::Release()
+{
+    for (FMesh& Mesh : Meshes)
+        Mesh.Buffers.Release();
+    Meshes.Empty();
+    NumUsed = 0;
+}
+
+SIZE_T FShapesVisualizerLineMeshes::GetAllocatedSize() const
+{
+    SIZE_T Size = Meshes.GetAllocatedSize();
+    for (const FMesh& Mesh : Meshes)
+        Size += sizeof(FMesh) + Mesh.Buffers.GetAllocatedSize();
+    return Size;
+}
+
+FShapesVisualizerMeshBuffers& FShapesVisualizerLineMeshes::AcquireMesh(uint32 InFrameNumber, EPrimitiveType PrimitiveType, int32 NumVertices)
+{
+    check(IsInRenderingThread());
+
+    // The renderer is done with the meshes of an earlier frame
+    if (InFrameNumber != FrameNumber)
+    {
+        FrameNumber = InFrameNumber;
+        NumUsed = 0;
+    }
+    if (NumUsed == Meshes.Num())
+        Meshes.Add(new FMesh(FeatureLevel));
+
+    FMesh& Mesh = Meshes[NumUsed++];
+    if (Mesh.PrimitiveType == PrimitiveType && Mesh.Buffers.GetNumVertices() >= NumVertices)
+        return Mesh.Buffers;
+
+    // Quads are two triangles of their four vertices, lines the pairs in order. Only the positions
+    // and colors change from draw to draw
+    const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(NumVertices, MinVertices_Internal));
+    TArray<FDynamicMeshVertex> Vertices;
+    Vertices.Init(FDynamicMeshVertex{ FShapesVisualizerPosition(FVector::ZeroVector) }, Capacity);
+    TArray<uint32> Indices;
+    if (PrimitiveType == PT_TriangleList)
+    {
+        Indices.SetNumUninitialized(Capacity / 4 * 6);
+        for (int32 Quad = 0; Quad < Capacity / 4; Quad++)
+        {
+            const uint32 FirstVertex = static_cast<uint32>(Quad * 4);
+            uint32* const QuadIndices = Indices.GetData() + Quad * 6;
+            QuadIndices[0] = FirstVertex;
+            QuadIndices[1] = FirstVertex + 1;
+            QuadIndices[2] = FirstVertex + 2;
+            QuadIndices[3] = FirstVertex;
+            QuadIndices[4] = FirstVertex + 2;
+            QuadIndices[5] = FirstVertex + 3;
+        }
+    }
+    else
+    {
+        Indices.SetNumUninitialized(Capacity);
+        for (int32 Index = 0; Index < Capacity; Index++)
+            Indices[Index] = static_cast<uint32>(Index);
+    }
+
+    Mesh.Buffers.Init(Vertices, Indices, PrimitiveType);
+    // Both faces of the quads, the winding depends on which side of the line the view is
+    Mesh.Buffers.SetTwoSided(PrimitiveType == PT_TriangleList);
+    Mesh.PrimitiveType = PrimitiveType;
+    return Mesh.Buffers;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerMeshBuffers.h"
+
+class FMeshElementCollector;
+class FSceneView;
+
+//
+// FShapesVisualizerLineMeshes - meshes of the lines a proxy draws per view, kept from frame to frame
+//
+// Thick lines are quads facing the view, thin ones a line list. Every draw of a frame takes a mesh of its own,
+// the renderer reads them after all proxies have drawn, and the next frame rewrites the same meshes in place.
+// A mesh grows to the next power of two vertices, so steady frames allocate nothing. Render thread only.
+//
+
+class FShapesVisualizerLineMeshes
+{
+public:
+
+    explicit FShapesVisualizerLineMeshes(ERHIFeatureLevel::Type InFeatureLevel) : FeatureLevel(InFeatureLevel) {}
+    ~FShapesVisualizerLineMeshes() { Release(); }
+
+    // Draws the lines of the world space vertex pairs with the vertex color material, as quads Thickness units
+    // wide facing the view or as thin lines if Thickness is not positive. LineColors has a color per line or
+    // a single one for all. Returns the number of drawn lines
+    int32 DrawLines(const FSceneView& View, TArrayView<const FVector> LineVerts, TArrayView<const FColor> LineColors,
+        float Thickness, const FBoxSphereBounds& WorldBounds, uint8 DepthPriority, int32 ViewIndex, FMeshElementCollector& Collector);
+
+    void Release();
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    struct FMesh
+    {
+        explicit FMesh(ERHIFeatureLevel::Type InFeatureLevel) : Buffers(InFeatureLevel) {}
+
+        FShapesVisualizerMeshBuffers Buffers;
+        EPrimitiveType PrimitiveType = PT_TriangleList;
+    };
+
+    // Next free mesh of the frame with room for NumVertices vertices, rebuilt larger if it has less
+    FShapesVisualizerMeshBuffers& AcquireMesh(uint32 InFrameNumber, EPrimitiveType PrimitiveType, int32 NumVertices);
+
+private:
+
+    ERHIFeatureLevel::Type FeatureLevel;
+    TIndirectArray<FMesh> Meshes;
+    // Meshes taken by the draws of FrameNumber, the view families of one frame draw one after another
+    int32 NumUsed = 0;
+    uint32 FrameNumber = 0;
+};
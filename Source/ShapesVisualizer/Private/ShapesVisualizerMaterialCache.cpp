@@ -0,0 +1,43 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerMaterialCache.h"
+#include "Materials/MaterialRenderProxy.h"
+
+namespace
+{
+    // Frames a material survives without being drawn, the renderer may still read the last ones
+    constexpr uint32 KeepFrames_Internal = 3;
+}
+
+//
+// FShapesVisualizerMaterialCache
+//
+
+FShapesVisualizerMaterialCache::FShapesVisualizerMaterialCache() = default;
+FShapesVisualizerMaterialCache::~FShapesVisualizerMaterialCache() = default;
+
+const FMaterialRenderProxy* FShapesVisualizerMaterialCache::Get(const FMaterialRenderProxy* Parent,
+    const FLinearColor& Color, uint32 FrameNumber)
+{
+    // Selection and color changes leave old materials behind, they go once the frames move on
+    if (FrameNumber != CurrentFrame)
+    {
+        CurrentFrame = FrameNumber;
+        for (auto It = Materials.CreateIterator(); It; ++It)
+        {
+            if (FrameNumber - It.Value().LastFrame > KeepFrames_Internal)
+                It.RemoveCurrent();
+        }
+    }
+
+    FEntry& Entry = Materials.FindOrAdd(FKey{ Parent, Color });
+    if (!Entry.Material)
+        Entry.Material = MakeUnique<FColoredMaterialRenderProxy>(Parent, Color);
+    Entry.LastFrame = FrameNumber;
+    return Entry.Material.Get();
+}
+
+SIZE_T FShapesVisualizerMaterialCache::GetAllocatedSize() const
+{
+    return Materials.GetAllocatedSize() + Materials.Num() * sizeof(FColoredMaterialRenderProxy);
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FColoredMaterialRenderProxy;
+class FMaterialRenderProxy;
+
+//
+// FShapesVisualizerMaterialCache - colored materials of one scene proxy kept between frames
+//
+// A material is created the first time its parent and color are drawn and reused by the
+// next frames, so the steady state allocates nothing. Materials unused for a few frames
+// are dropped, the ones of the current frame stay alive while its meshes reference them.
+// Render thread only.
+//
+
+class FShapesVisualizerMaterialCache
+{
+public:
+
+    FShapesVisualizerMaterialCache();
+    ~FShapesVisualizerMaterialCache();
+
+    const FMaterialRenderProxy* Get(const FMaterialRenderProxy* Parent, const FLinearColor& Color, uint32 FrameNumber);
+
+    int32 Num() const { return Materials.Num(); }
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    struct FKey
+    {
+        const FMaterialRenderProxy* Parent;
+        FLinearColor Color;
+
+        bool operator==(const FKey& Other) const { return Parent == Other.Parent && Color == Other.Color; }
+        friend uint32 GetTypeHash(const FKey& Key) { return HashCombine(PointerHash(Key.Parent), GetTypeHash(Key.Color)); }
+    };
+
+    struct FEntry
+    {
+        TUniquePtr<FColoredMaterialRenderProxy> Material;
+        uint32 LastFrame = 0;
+    };
+
+private:
+
+    TMap<FKey, FEntry> Materials;
+    uint32 CurrentFrame = 0;
+};
@@ -0,0 +1,150 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerMeshBuffers.h"
+#include "MeshBatch.h"
+#include "RHICommandList.h"
+
+//
+// FShapesVisualizerMeshBuffers
+//
+
+FShapesVisualizerMeshBuffers::FShapesVisualizerMeshBuffers(ERHIFeatureLevel::Type InFeatureLevel)
+    : VertexFactory(InFeatureLevel, "FShapesVisualizerMeshBuffers")
+{
+}
+
+FShapesVisualizerMeshBuffers::~FShapesVisualizerMeshBuffers()
+{
+    check(!IsInitialized());
+}
+
+void FShapesVisualizerMeshBuffers::Init(TArray<FDynamicMeshVertex>& Vertices, TArray<uint32>& Indices,
+    EPrimitiveType InPrimitiveType)
+{
+    check(IsInRenderingThread());
+
+    Release();
+    if (Vertices.Num() == 0 || Indices.Num() == 0)
+        return;
+
+    PrimitiveType = InPrimitiveType;
+    NumVertices = NumDrawVertices = Vertices.Num();
+    NumIndices = NumDrawIndices = Indices.Num();
+
+    // Initializes the vertex buffers and the vertex factory immediately on the render thread
+    VertexBuffers.InitFromDynamicVertex(&VertexFactory, Vertices);
+
+    Use16BitIndices = NumVertices <= MAX_uint16 + 1;
+    if (Use16BitIndices)
+    {
+        IndexBuffer16.Indices.SetNumUninitialized(NumIndices);
+        for (int32 Index = 0; Index < NumIndices; Index++)
+            IndexBuffer16.Indices[Index] = static_cast<uint16>(Indices[Index]);
+        Indices.Empty();
+        IndexBuffer16.InitResource();
+    }
+    else
+    {
+        IndexBuffer32.Indices = MoveTemp(Indices);
+        IndexBuffer32.InitResource();
+    }
+}
+
+void FShapesVisualizerMeshBuffers::Release()
+{
+    if (!IsInitialized())
+        return;
+
+    VertexBuffers.PositionVertexBuffer.ReleaseResource();
+    VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+    VertexBuffers.ColorVertexBuffer.ReleaseResource();
+    if (Use16BitIndices)
+        IndexBuffer16.ReleaseResource();
+    else
+        IndexBuffer32.ReleaseResource();
+    VertexFactory.ReleaseResource();
+
+    NumVertices = NumDrawVertices = 0;
+    NumIndices = NumDrawIndices = 0;
+}
+
+SIZE_T FShapesVisualizerMeshBuffers::GetAllocatedSize() const
+{
+    if (!IsInitialized())
+        return 0;
+    return VertexBuffers.PositionVertexBuffer.GetAllocatedSize() + VertexBuffers.StaticMeshVertexBuffer.GetResourceSize()
+        + VertexBuffers.ColorVertexBuffer.GetAllocatedSize()
+        + (Use16BitIndices ? IndexBuffer16.Indices.GetAllocatedSize() : IndexBuffer32.Indices.GetAllocatedSize());
+}
+
+void FShapesVisualizerMeshBuffers::SetDrawRange(int32 InNumDrawVertices, int32 InNumDrawIndices)
+{
+    NumDrawVertices = FMath::Min(InNumDrawVertices, NumVertices);
+    NumDrawIndices = FMath::Min(InNumDrawIndices, NumIndices);
+}
+
+FShapesVisualizerPosition* FShapesVisualizerMeshBuffers::LockPositions(int32 FirstVertex, int32 Count)
+{
+    check(IsInRenderingThread());
+    check(FirstVertex >= 0 && FirstVertex + Count <= NumVertices);
+
+    const uint32 Stride = sizeof(FShapesVisualizerPosition);
+#if ENGINE_MAJOR_VERSION == 5
+    void* Data = RHILockBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI, FirstVertex * Stride, Count * Stride, RLM_WriteOnly);
+#else
+    void* Data = RHILockVertexBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI, FirstVertex * Stride, Count * Stride, RLM_WriteOnly);
+#endif
+    return static_cast<FShapesVisualizerPosition*>(Data);
+}
+
+void FShapesVisualizerMeshBuffers::UnlockPositions()
+{
+#if ENGINE_MAJOR_VERSION == 5
+    RHIUnlockBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI);
+#else
+    RHIUnlockVertexBuffer(VertexBuffers.PositionVertexBuffer.VertexBufferRHI);
+#endif
+}
+
+FColor* FShapesVisualizerMeshBuffers::LockColors(int32 FirstVertex, int32 Count)
+{
+    check(IsInRenderingThread());
+    check(FirstVertex >= 0 && FirstVertex + Count <= NumVertices);
+
+    const uint32 Stride = sizeof(FColor);
+#if ENGINE_MAJOR_VERSION == 5
+    void* Data = RHILockBuffer(VertexBuffers.ColorVertexBuffer.VertexBufferRHI, FirstVertex * Stride, Count * Stride, RLM_WriteOnly);
+#else
+    void* Data = RHILockVertexBuffer(VertexBuffers.ColorVertexBuffer.VertexBufferRHI, FirstVertex * Stride, Count * Stride, RLM_WriteOnly);
+#endif
+    return static_cast<FColor*>(Data);
+}
+
+void FShapesVisualizerMeshBuffers::UnlockColors()
+{
+#if ENGINE_MAJOR_VERSION == 5
+    RHIUnlockBuffer(VertexBuffers.ColorVertexBuffer.VertexBufferRHI);
+#else
+    RHIUnlockVertexBuffer(VertexBuffers.ColorVertexBuffer.VertexBufferRHI);
+#endif
+}
+
+void FShapesVisualizerMeshBuffers::GetMeshBatch(FMeshBatch& OutMesh, const FMaterialRenderProxy* MaterialRenderProxy,
+    uint8 DepthPriority, bool ReverseCulling, int32 FirstIndex, int32 InNumIndices) const
+{
+    OutMesh.VertexFactory = &VertexFactory;
+    OutMesh.MaterialRenderProxy = MaterialRenderProxy;
+    OutMesh.ReverseCulling = ReverseCulling;
+    OutMesh.bDisableBackfaceCulling = TwoSided;
+    OutMesh.Type = PrimitiveType;
+    OutMesh.DepthPriorityGroup = DepthPriority;
+    OutMesh.bCanApplyViewModeOverrides = false;
+
+    FMeshBatchElement& BatchElement = OutMesh.Elements[0];
+    BatchElement.IndexBuffer = Use16BitIndices ? static_cast<const FIndexBuffer*>(&IndexBuffer16) : &IndexBuffer32;
+    BatchElement.FirstIndex = FirstIndex;
+    BatchElement.NumPrimitives = (InNumIndices == INDEX_NONE ? NumDrawIndices - FirstIndex : InNumIndices)
+        / (PrimitiveType == PT_LineList ? 2 : 3);
+    BatchElement.MinVertexIndex = 0;
+    BatchElement.MaxVertexIndex = NumDrawVertices - 1;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMeshBuilder.h"
+#include "LocalVertexFactory.h"
+#include "StaticMeshResources.h"
+#include "ShapesVisualizerGeometry.h"
+
+struct FMeshBatch;
+class FMaterialRenderProxy;
+
+//
+// FShapesVisualizerMeshBuffers - GPU vertex and index buffers of a prebuilt mesh
+//
+// Meshes of at most 65536 vertices keep 16 bit indices, half the memory and fetch bandwidth.
+//
+
+class FShapesVisualizerMeshBuffers
+{
+public:
+
+    FShapesVisualizerMeshBuffers(ERHIFeatureLevel::Type InFeatureLevel);
+    ~FShapesVisualizerMeshBuffers();
+
+    // Render thread only. Consumes the arrays
+    void Init(TArray<FDynamicMeshVertex>& Vertices, TArray<uint32>& Indices,
+        EPrimitiveType InPrimitiveType = PT_TriangleList);
+    void Release();
+
+    bool IsInitialized() const { return NumVertices > 0 && NumIndices > 0; }
+    int32 GetNumVertices() const { return NumVertices; }
+    int32 GetNumIndices() const { return NumIndices; }
+    // CPU copies the vertex and index buffers keep of their data
+    SIZE_T GetAllocatedSize() const;
+
+    // Limits drawing to the leading part of the buffers, the rest is reserved for growth
+    void SetDrawRange(int32 InNumDrawVertices, int32 InNumDrawIndices);
+    int32 GetNumDrawIndices() const { return NumDrawIndices; }
+
+    // Rewrites positions or colors in place, render thread only
+    FShapesVisualizerPosition* LockPositions(int32 FirstVertex, int32 Count);
+    void UnlockPositions();
+    FColor* LockColors(int32 FirstVertex, int32 Count);
+    void UnlockColors();
+
+    // Draws both faces of the triangles
+    void SetTwoSided(bool InTwoSided) { TwoSided = InTwoSided; }
+
+    // Fills the single element of the batch with the drawn range or the given range of indices
+    void GetMeshBatch(FMeshBatch& OutMesh, const FMaterialRenderProxy* MaterialRenderProxy,
+        uint8 DepthPriority, bool ReverseCulling, int32 FirstIndex = 0, int32 InNumIndices = INDEX_NONE) const;
+
+private:
+
+    FStaticMeshVertexBuffers VertexBuffers;
+    FDynamicMeshIndexBuffer16 IndexBuffer16;
+    FDynamicMeshIndexBuffer32 IndexBuffer32;
+    FLocalVertexFactory VertexFactory;
+    EPrimitiveType PrimitiveType = PT_TriangleList;
+    int32 NumVertices = 0;
+    int32 NumIndices = 0;
+    int32 NumDrawVertices = 0;
+    int32 NumDrawIndices = 0;
+    bool Use16BitIndices = false;
+    bool TwoSided = false;
+};
@@ -0,0 +1,435 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerPointCloud.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "ShapesVisualizerStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogShapesVisualizerPointCloud, Log, All);
+
+//
+// Internal functions
+//
+
+namespace
+{
+#if ENGINE_MAJOR_VERSION == 5
+    using FReal_Internal = FVector::FReal;
+#else
+    using FReal_Internal = float;
+#endif
+
+    // Longest ascii header or value that is parsed
+    constexpr int64 MaxPlyHeader_Internal = 64 * 1024;
+    constexpr int32 MaxPlyValue_Internal = 63;
+
+    // Bytes of a scalar PLY property type, 0 if unknown
+    int32 GetPlyTypeSize_Internal(const FString& Type)
+    {
+        if (Type == TEXT("char") || Type == TEXT("uchar") || Type == TEXT("int8") || Type == TEXT("uint8"))
+            return 1;
+        if (Type == TEXT("short") || Type == TEXT("ushort") || Type == TEXT("int16") || Type == TEXT("uint16"))
+            return 2;
+        if (Type == TEXT("int") || Type == TEXT("uint") || Type == TEXT("int32") || Type == TEXT("uint32")
+            || Type == TEXT("float") || Type == TEXT("float32"))
+            return 4;
+        if (Type == TEXT("double") || Type == TEXT("float64"))
+            return 8;
+        return 0;
+    }
+
+    FORCEINLINE bool IsPlyFloat_Internal(const FString& Type)
+    {
+        return Type == TEXT("float") || Type == TEXT("float32") || Type == TEXT("double") || Type == TEXT("float64");
+    }
+
+    FORCEINLINE bool IsSpace_Internal(uint8 Char)
+    {
+        return Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n';
+    }
+
+    // The mapping has no terminating zero, values are copied out before parsing
+    bool ReadPlyValue_Internal(const uint8* Data, int64 Size, int64& Offset, double& OutValue)
+    {
+        while (Offset < Size && IsSpace_Internal(Data[Offset]))
+            Offset++;
+
+        ANSICHAR Value[MaxPlyValue_Internal + 1];
+        int32 Length = 0;
+        while (Offset < Size && !IsSpace_Internal(Data[Offset]))
+        {
+            if (Length < MaxPlyValue_Internal)
+                Value[Length++] = static_cast<ANSICHAR>(Data[Offset]);
+            Offset++;
+        }
+        Value[Length] = 0;
+
+        OutValue = FCStringAnsi::Atod(Value);
+        return Length > 0;
+    }
+
+    FORCEINLINE FReal_Internal ReadBinaryValue_Internal(const uint8* Data, bool Doubles)
+    {
+        // Vertices of mixed property sizes leave the coordinates unaligned
+        if (Doubles)
+        {
+            double Value;
+            FMemory::Memcpy(&Value, Data, sizeof(Value));
+            return static_cast<FReal_Internal>(Value);
+        }
+        float Value;
+        FMemory::Memcpy(&Value, Data, sizeof(Value));
+        return Value;
+    }
+
+    FString GetPointCloudPath_Internal(const FString& FileName)
+    {
+        if (!FPaths::IsRelative(FileName))
+            return FileName;
+        return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ShapesVisualizer"), FileName));
+    }
+
+    // Load of the console command, one at a time
+    TUniquePtr<FShapesVisualizerPointCloudLoader> CommandLoader_Internal;
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice LoadPointsCommand_Internal(
+        TEXT("ShapesVisualizer.LoadPoints"),
+        TEXT("Streams a .svpc or .ply point cloud into a new visualizer at the world origin, Saved/ShapesVisualizer by default.\n")
+        TEXT("Logs the load time and the peak memory once the points are loaded.\n")
+        TEXT("ShapesVisualizer.LoadPoints File [Polyline]"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                if (!World || Args.Num() == 0)
+                {
+                    Ar.Logf(TEXT("Usage: ShapesVisualizer.LoadPoints File [Polyline]"));
+                    return;
+                }
+
+                // The load may outlive the console, it is stopped before the engine goes away
+                static const FDelegateHandle PreExitHandle = FCoreDelegates::OnPreExit.AddLambda([]() { CommandLoader_Internal.Reset(); });
+                CommandLoader_Internal.Reset();
+
+                AActor* const Actor = World->SpawnActor<AActor>();
+                if (!Actor)
+                    return;
+                UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(Actor, NAME_None, RF_Transient);
+                Actor->SetRootComponent(Component);
+                Component->RegisterComponent();
+
+                const FString Path = GetPointCloudPath_Internal(Args[0]);
+                const EVisualShape Shape = Args.Num() > 1 && Args[1] == TEXT("Polyline") ? EVisualShape::Polyline : EVisualShape::Points;
+                CommandLoader_Internal = FShapesVisualizerPointCloudLoader::Load(Component, Path, Shape);
+                if (!CommandLoader_Internal)
+                {
+                    Ar.Logf(TEXT("Cannot load points from %s"), *Path);
+                    Actor->Destroy();
+                    return;
+                }
+                Ar.Logf(TEXT("Loading %lld points from %s"), CommandLoader_Internal->GetNumPoints(), *Path);
+            }));
+}
+
+//
+// FShapesVisualizerPointCloudLoader
+//
+
+TUniquePtr<FShapesVisualizerPointCloudLoader> FShapesVisualizerPointCloudLoader::Load(UShapesVisualizerComponent* Component,
+    const FString& FileName, EVisualShape Shape)
+{
+    check(IsInGameThread());
+
+    if (!Component || (Shape != EVisualShape::Points && Shape != EVisualShape::Polyline))
+        return nullptr;
+
+    TUniquePtr<FShapesVisualizerPointCloudLoader> Loader{ new FShapesVisualizerPointCloudLoader };
+    if (!Loader->Open(FileName))
+        return nullptr;
+
+    Loader->Component = Component;
+    Loader->StartTime = FPlatformTime::Seconds();
+
+    // The chunks are appended into the reserved points, no reallocation of the whole cloud
+    if (Shape == EVisualShape::Polyline)
+        Component->SetPolylineShape(TArray<FVector>{});
+    else
+        Component->SetPointsShape(TArray<FVector>{});
+    Component->ReservePoints(static_cast<int32>(Loader->NumPoints));
+
+    Loader->SpaceEvent = FPlatformProcess::GetSynchEventFromPool();
+    Loader->BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(Loader.Get(), &FShapesVisualizerPointCloudLoader::AppendChunks);
+    Loader->Thread = FRunnableThread::Create(Loader.Get(), TEXT("ShapesVisualizerPointCloudLoader"), 0, TPri_BelowNormal);
+    return Loader;
+}
+
+FShapesVisualizerPointCloudLoader::~FShapesVisualizerPointCloudLoader()
+{
+    FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+    if (SpaceEvent)
+        FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+}
+
+double FShapesVisualizerPointCloudLoader::GetLoadSeconds() const
+{
+    return (Done ? EndTime : FPlatformTime::Seconds()) - StartTime;
+}
+
+uint32 FShapesVisualizerPointCloudLoader::Run()
+{
+    while (!Stopping.load())
+    {
+        // The game thread frees a slot with every appended chunk
+        if (NumPendingChunks.load() >= MaxPendingChunks)
+        {
+            SpaceEvent->Wait();
+            continue;
+        }
+        if (!ReadChunk())
+            break;
+    }
+    ReadDone.store(true);
+    return 0;
+}
+
+void FShapesVisualizerPointCloudLoader::Stop()
+{
+    Stopping.store(true);
+    if (SpaceEvent)
+        SpaceEvent->Trigger();
+}
+
+bool FShapesVisualizerPointCloudLoader::Open(const FString& FileName)
+{
+    Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FileName));
+    if (!Handle || Handle->GetFileSize() < static_cast<int64>(sizeof(FPointCloudHeader)))
+        return false;
+
+    Region.Reset(Handle->MapRegion());
+    if (!Region)
+        return false;
+
+    Data = Region->GetMappedPtr();
+    Size = Region->GetMappedSize();
+
+    if (Size >= 4 && FMemory::Memcmp(Data, "ply", 3) == 0 && IsSpace_Internal(Data[3]))
+    {
+        if (!ParsePlyHeader())
+            return false;
+    }
+    else
+    {
+        FPointCloudHeader Header;
+        FMemory::Memcpy(&Header, Data, sizeof(Header));
+        if (Header.Magic != Magic || Header.Version != Version)
+            return false;
+
+        Format = EFormat::Binary;
+        DataOffset = sizeof(FPointCloudHeader);
+        Stride = 3 * sizeof(float);
+        Offsets[0] = 0;
+        Offsets[1] = sizeof(float);
+        Offsets[2] = 2 * sizeof(float);
+        Doubles = false;
+        NumPoints = static_cast<int64>(FMath::Min<uint64>(Header.NumPoints, MAX_int64));
+    }
+
+    // Truncated binary files keep their whole points, the points storage is indexed by int32.
+    // An ascii value takes at least a digit and a separator, the last one may end the file
+    const int64 HeaderPoints = NumPoints;
+    if (Format == EFormat::Binary)
+        NumPoints = FMath::Min(NumPoints, (Size - DataOffset) / Stride);
+    else
+        NumPoints = FMath::Min(NumPoints, (Size - DataOffset + 1) / (2 * FMath::Max(NumProperties, 1)));
+    NumPoints = FMath::Min<int64>(NumPoints, MAX_int32);
+    if (NumPoints < HeaderPoints)
+        UE_LOG(LogShapesVisualizerPointCloud, Warning, TEXT("%s has %lld points in its header, only %lld are read"), *FileName, HeaderPoints, NumPoints);
+    ReadOffset = DataOffset;
+    return NumPoints > 0;
+}
+
+bool FShapesVisualizerPointCloudLoader::ParsePlyHeader()
+{
+    // The header is ascii lines up to end_header, the vertices follow the end of its line
+    const int64 HeaderSize = FMath::Min(Size, MaxPlyHeader_Internal);
+    const FString HeaderText{ static_cast<int32>(HeaderSize), reinterpret_cast<const ANSICHAR*>(Data) };
+    const int32 EndIndex = HeaderText.Find(TEXT("end_header"), ESearchCase::CaseSensitive);
+    if (EndIndex == INDEX_NONE)
+        return false;
+
+    const int32 NewLineIndex = HeaderText.Find(TEXT("\n"), ESearchCase::CaseSensitive, ESearchDir::FromStart, EndIndex);
+    if (NewLineIndex == INDEX_NONE)
+        return false;
+    DataOffset = NewLineIndex + 1;
+
+    TArray<FString> Lines;
+    HeaderText.Left(EndIndex).ParseIntoArrayLines(Lines);
+
+    bool HasFormat = false;
+    bool InVertex = false;
+    bool VertexDone = false;
+    int32 AxisSizes[3] = {};
+    for (const FString& Line : Lines)
+    {
+        TArray<FString> Tokens;
+        Line.ParseIntoArrayWS(Tokens);
+        if (Tokens.Num() == 0)
+            continue;
+
+        if (Tokens[0] == TEXT("format") && Tokens.Num() > 1)
+        {
+            // Big endian files are rare enough to be converted beforehand
+            if (Tokens[1] == TEXT("ascii"))
+                Format = EFormat::PlyAscii;
+            else if (Tokens[1] == TEXT("binary_little_endian"))
+                Format = EFormat::Binary;
+            else
+                return false;
+            HasFormat = true;
+        }
+        else if (Tokens[0] == TEXT("element") && Tokens.Num() > 2)
+        {
+            // Elements after the vertices are never read, the ones before them would have to be skipped
+            if (InVertex || VertexDone)
+            {
+                InVertex = false;
+                VertexDone = true;
+                continue;
+            }
+            if (Tokens[1] != TEXT("vertex"))
+                return false;
+            NumPoints = FCString::Atoi64(*Tokens[2]);
+            InVertex = true;
+        }
+        else if (Tokens[0] == TEXT("property") && InVertex && Tokens.Num() > 2)
+        {
+            const int32 TypeSize = GetPlyTypeSize_Internal(Tokens[1]);
+            if (TypeSize == 0)
+                return false;
+
+            const int32 Axis = Tokens[2] == TEXT("x") ? 0 : Tokens[2] == TEXT("y") ? 1 : Tokens[2] == TEXT("z") ? 2 : INDEX_NONE;
+            if (Axis != INDEX_NONE)
+            {
+                if (!IsPlyFloat_Internal(Tokens[1]))
+                    return false;
+                Offsets[Axis] = Stride;
+                PropertyIndices[Axis] = NumProperties;
+                AxisSizes[Axis] = TypeSize;
+            }
+            Stride += TypeSize;
+            NumProperties++;
+        }
+    }
+
+    // The coordinates are all floats or all doubles
+    if (!HasFormat || AxisSizes[0] == 0 || AxisSizes[0] != AxisSizes[1] || AxisSizes[0] != AxisSizes[2])
+        return false;
+    Doubles = AxisSizes[0] == sizeof(double);
+    return true;
+}
+
+bool FShapesVisualizerPointCloudLoader::ReadChunk()
+{
+    const int32 Count = static_cast<int32>(FMath::Min<int64>(ChunkSize, NumPoints - NumRead));
+    if (Count <= 0)
+        return false;
+
+    TArray<FVector> Chunk;
+    Chunk.SetNumUninitialized(Count);
+
+    bool Complete = true;
+    if (Format == EFormat::Binary)
+    {
+        const uint8* Vertex = Data + DataOffset + NumRead * Stride;
+        for (FVector& Point : Chunk)
+        {
+            Point = FVector(
+                ReadBinaryValue_Internal(Vertex + Offsets[0], Doubles),
+                ReadBinaryValue_Internal(Vertex + Offsets[1], Doubles),
+                ReadBinaryValue_Internal(Vertex + Offsets[2], Doubles));
+            Vertex += Stride;
+        }
+    }
+    else
+    {
+        for (int32 Index = 0; Index < Count && Complete; Index++)
+        {
+            double Point[3] = {};
+            for (int32 PropertyIndex = 0; PropertyIndex < NumProperties && Complete; PropertyIndex++)
+            {
+                double Value;
+                Complete = ReadPlyValue_Internal(Data, Size, ReadOffset, Value);
+                for (int32 Axis = 0; Axis < 3; Axis++)
+                {
+                    if (PropertyIndices[Axis] == PropertyIndex)
+                        Point[Axis] = Value;
+                }
+            }
+
+            // A truncated file ends with the last whole vertex
+            if (!Complete)
+                Chunk.SetNum(Index, false);
+            else
+                Chunk[Index] = FVector(static_cast<FReal_Internal>(Point[0]), static_cast<FReal_Internal>(Point[1]),
+                    static_cast<FReal_Internal>(Point[2]));
+        }
+    }
+
+    NumRead += Chunk.Num();
+    if (Chunk.Num() > 0)
+    {
+        Chunks.Enqueue(MoveTemp(Chunk));
+        NumPendingChunks.fetch_add(1);
+    }
+    return Complete && NumRead < NumPoints;
+}
+
+void FShapesVisualizerPointCloudLoader::AppendChunks()
+{
+    if (Done)
+        return;
+
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_LoadPoints);
+
+    // No threads on this platform, one chunk per frame
+    if (!Thread && !ReadDone.load() && !ReadChunk())
+        ReadDone.store(true);
+
+    // Chunks queued before the end of the reading are all seen by the loop below
+    const bool ReadAll = ReadDone.load();
+    UShapesVisualizerComponent* const Target = Component.Get();
+
+    TArray<FVector> Chunk;
+    while (Chunks.Dequeue(Chunk))
+    {
+        NumPendingChunks.fetch_sub(1);
+        SpaceEvent->Trigger();
+        NumAppended += Chunk.Num();
+        if (Target)
+            Target->AppendPoints(MoveTemp(Chunk));
+    }
+
+    if (!ReadAll && Target)
+        return;
+
+    Stop();
+    Done = true;
+    EndTime = FPlatformTime::Seconds();
+
+    const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+    UE_LOG(LogShapesVisualizerPointCloud, Log, TEXT("Loaded %lld of %lld points in %.2f s, peak used physical memory %.1f MB"),
+        NumAppended, NumPoints, GetLoadSeconds(), MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0));
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerPointClusters.h"
+#include "SceneView.h"
+
+//
+// FShapesVisualizerPointClusters
+//
+
+void FShapesVisualizerPointClusters::Build(const FShapesVisualizerPointStorage& Points, bool InWrap)
+{
+    Wrap = InWrap;
+    Boxes.SetNumUninitialized(FMath::DivideAndRoundUp(Points.Num(), ClusterSize));
+    FitClusters(Points, 0, Boxes.Num());
+}
+
+void FShapesVisualizerPointClusters::Update(const FShapesVisualizerPointStorage& Points, int32 StartIndex, int32 EndIndex)
+{
+    const int32 NumPoints = Points.Num();
+    Boxes.SetNum(FMath::DivideAndRoundUp(NumPoints, ClusterSize), false);
+    if (NumPoints == 0)
+        return;
+
+    // The cluster before the range links to its first point
+    const int32 FirstCluster = GetClusterIndex(FMath::Clamp(StartIndex - 1, 0, NumPoints - 1));
+    const int32 LastCluster = FMath::Max(GetClusterIndex(FMath::Clamp(EndIndex - 1, 0, NumPoints - 1)), FirstCluster);
+    FitClusters(Points, FirstCluster, LastCluster + 1);
+
+    if (Wrap && StartIndex == 0 && LastCluster < Boxes.Num() - 1)
+        FitClusters(Points, Boxes.Num() - 1, Boxes.Num());
+}
+
+void FShapesVisualizerPointClusters::SetWrap(const FShapesVisualizerPointStorage& Points, bool InWrap)
+{
+    if (Wrap == InWrap)
+        return;
+
+    Wrap = InWrap;
+    if (Boxes.Num() > 0)
+        FitClusters(Points, Boxes.Num() - 1, Boxes.Num());
+}
+
+void FShapesVisualizerPointClusters::Reset()
+{
+    Boxes.Reset();
+    Wrap = false;
+}
+
+int32 FShapesVisualizerPointClusters::GetVisibleClusters(const FSceneView& View, const FMatrix& LocalToWorld, float WorldMargin,
+    TArray<int32>& OutVisiblePrefix) const
+{
+    OutVisiblePrefix.SetNumUninitialized(Boxes.Num() + 1, false);
+    OutVisiblePrefix[0] = 0;
+
+    for (int32 ClusterIndex = 0; ClusterIndex < Boxes.Num(); ClusterIndex++)
+    {
+        const FBox WorldBox = Boxes[ClusterIndex].TransformBy(LocalToWorld).ExpandBy(WorldMargin);
+        const bool Visible = View.ViewFrustum.IntersectBox(WorldBox.GetCenter(), WorldBox.GetExtent());
+        OutVisiblePrefix[ClusterIndex + 1] = OutVisiblePrefix[ClusterIndex] + (Visible ? 1 : 0);
+    }
+    return OutVisiblePrefix.Last();
+}
+
+void FShapesVisualizerPointClusters::GetVisibleRanges(const TArray<int32>& VisiblePrefix, int32 NumPoints,
+    TArray<TPair<int32, int32>>& OutRanges)
+{
+    OutRanges.Reset();
+    for (int32 ClusterIndex = 0; ClusterIndex < VisiblePrefix.Num() - 1; ClusterIndex++)
+    {
+        if (!IsClusterVisible(VisiblePrefix, ClusterIndex))
+            continue;
+
+        const int32 StartIndex = ClusterIndex * ClusterSize;
+        const int32 EndIndex = FMath::Min(StartIndex + ClusterSize, NumPoints);
+        if (OutRanges.Num() > 0 && OutRanges.Last().Value == StartIndex)
+            OutRanges.Last().Value = EndIndex;
+        else
+            OutRanges.Emplace(StartIndex, EndIndex);
+    }
+}
+
+bool FShapesVisualizerPointClusters::IsPathVisible(const TArray<int32>& VisiblePrefix, int32 StartIndex, int32 EndIndex)
+{
+    // Segment from point K to point K + 1 is inside the box of the cluster of K
+    auto AnyVisible = [&VisiblePrefix](int32 FirstCluster, int32 LastCluster)
+    {
+        return VisiblePrefix[LastCluster + 1] > VisiblePrefix[FirstCluster];
+    };
+
+    if (StartIndex <= EndIndex)
+        return AnyVisible(GetClusterIndex(StartIndex), GetClusterIndex(FMath::Max(EndIndex - 1, StartIndex)));
+
+    // Through the end of the storage and the link of the last cluster
+    return AnyVisible(GetClusterIndex(StartIndex), VisiblePrefix.Num() - 2)
+        || (EndIndex > 0 && AnyVisible(0, GetClusterIndex(EndIndex - 1)));
+}
+
+void FShapesVisualizerPointClusters::FitClusters(const FShapesVisualizerPointStorage& Points, int32 FirstCluster, int32 EndCluster)
+{
+    const int32 FirstPoint = FirstCluster * ClusterSize;
+    const int32 EndPoint = FMath::Min(EndCluster * ClusterSize, Points.Num());
+
+    // Chunks start at multiples of ClusterSize, so every cluster is fitted by one task
+    ShapesVisualizerGeometry::ParallelForChunks(EndPoint - FirstPoint, [&](int32 ChunkStart, int32 ChunkEnd)
+    {
+        for (int32 StartIndex = FirstPoint + ChunkStart; StartIndex < FirstPoint + ChunkEnd; StartIndex += ClusterSize)
+        {
+            const int32 EndIndex = FMath::Min(StartIndex + ClusterSize, Points.Num());
+            FBox& Box = Boxes[GetClusterIndex(StartIndex)];
+
+            Box = Points.GetBox(StartIndex, EndIndex);
+            if (EndIndex < Points.Num())
+                Box += Points[EndIndex];
+            else if (Wrap)
+                Box += Points[0];
+        }
+    });
+}
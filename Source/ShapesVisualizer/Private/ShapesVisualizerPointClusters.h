@@ -0,0 +1,66 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerPointStorage.h"
+
+class FSceneView;
+
+//
+// FShapesVisualizerPointClusters - local bounds of fixed size runs of points
+//
+// Cluster i holds the points [i * ClusterSize, (i + 1) * ClusterSize) in storage order,
+// plus the first point of the next cluster, so its box also covers the polyline segment
+// leaving it. Wrapped clusters (full trails) link the last point back to the first one.
+// Changed points refit only their own clusters. The boxes fit the point centers, the views
+// grow them by the world size of the points and lines. Scene proxies keep the storage of
+// point sets in Z-order, so the clusters stay compact. Render thread only.
+//
+
+class FShapesVisualizerPointClusters
+{
+public:
+
+    // A chunk of the parallel loops is a whole number of clusters
+    static constexpr int32 ClusterSize = 1024;
+    static_assert(ShapesVisualizerGeometry::ParallelChunkSize % ClusterSize == 0, "Chunk must hold whole clusters");
+
+    void Build(const FShapesVisualizerPointStorage& Points, bool InWrap = false);
+    // Points in [StartIndex, EndIndex) changed, Points.Num() is the new number of points
+    void Update(const FShapesVisualizerPointStorage& Points, int32 StartIndex, int32 EndIndex);
+    void SetWrap(const FShapesVisualizerPointStorage& Points, bool InWrap);
+    void Reset();
+
+    int32 Num() const { return Boxes.Num(); }
+    SIZE_T GetAllocatedSize() const { return Boxes.GetAllocatedSize(); }
+
+    FORCEINLINE static int32 GetClusterIndex(int32 PointIndex) { return PointIndex / ClusterSize; }
+    FORCEINLINE static bool IsClusterVisible(const TArray<int32>& VisiblePrefix, int32 ClusterIndex)
+    {
+        return VisiblePrefix[ClusterIndex + 1] > VisiblePrefix[ClusterIndex];
+    }
+
+    // Frustum test of every cluster grown by WorldMargin, the radius of the points and half the line thickness.
+    // OutVisiblePrefix[i] is the number of visible clusters before cluster i (Num() + 1 entries),
+    // returns the number of visible clusters
+    int32 GetVisibleClusters(const FSceneView& View, const FMatrix& LocalToWorld, float WorldMargin,
+        TArray<int32>& OutVisiblePrefix) const;
+
+    // Points [StartIndex, EndIndex) of the visible clusters merged into runs
+    static void GetVisibleRanges(const TArray<int32>& VisiblePrefix, int32 NumPoints, TArray<TPair<int32, int32>>& OutRanges);
+
+    // Whether the polyline path from point StartIndex to point EndIndex (storage indices,
+    // through the end of the storage if EndIndex < StartIndex) may be seen
+    static bool IsPathVisible(const TArray<int32>& VisiblePrefix, int32 StartIndex, int32 EndIndex);
+
+private:
+
+    void FitClusters(const FShapesVisualizerPointStorage& Points, int32 FirstCluster, int32 EndCluster);
+
+private:
+
+    TArray<FBox> Boxes;
+    bool Wrap = false;
+};
@@ -0,0 +1,247 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerPointStorage.h"
+#include "ShapesVisualizerGeometry.h"
+
+namespace
+{
+    constexpr float MaxQuantized_Internal = 65535.f;
+    // Compact points are decoded on the stack in runs of this size before the transform
+    constexpr int32 DecodeChunkSize_Internal = 256;
+
+    // True once the points, with the room a grown box gets, take less than half of the box on an axis
+    bool IsLoose_Internal(const FBox& PointsBox, const FBox& QuantizeBox)
+    {
+        const FVector Size = QuantizeBox.GetSize();
+        return (PointsBox.GetSize() * 3.f).ComponentMin(Size) != Size;
+    }
+}
+
+//
+// FShapesVisualizerPointStorage
+//
+
+void FShapesVisualizerPointStorage::Reset(EVisualPointsFormat InFormat, TArrayView<const FVector> InPoints)
+{
+    // FVector is already made of floats before UE5
+    Format = InFormat == EVisualPointsFormat::Float && sizeof(FVector) == sizeof(FFloatPoint)
+        ? EVisualPointsFormat::Vector : InFormat;
+    NumPoints = 0;
+    Vectors.Empty();
+    Floats.Empty();
+    Quantized.Empty();
+    QuantizeBox.Init();
+    NumOverwritten = 0;
+    Update(0, InPoints);
+}
+
+void FShapesVisualizerPointStorage::Update(int32 StartIndex, TArrayView<const FVector> InPoints)
+{
+    check(StartIndex >= 0 && StartIndex <= NumPoints);
+    const int32 NewNum = FMath::Max(NumPoints, StartIndex + InPoints.Num());
+
+    switch (Format)
+    {
+    case EVisualPointsFormat::Vector:
+        Vectors.SetNumUninitialized(NewNum, false);
+        FMemory::Memcpy(Vectors.GetData() + StartIndex, InPoints.GetData(), InPoints.Num() * sizeof(FVector));
+        break;
+    case EVisualPointsFormat::Float:
+        Floats.SetNumUninitialized(NewNum, false);
+        for (int32 Index = 0; Index < InPoints.Num(); Index++)
+        {
+            const FVector& Point = InPoints[Index];
+            Floats[StartIndex + Index] = FFloatPoint{ static_cast<float>(Point.X), static_cast<float>(Point.Y), static_cast<float>(Point.Z) };
+        }
+        break;
+    case EVisualPointsFormat::Quantized:
+        FitQuantization(StartIndex, InPoints);
+        Quantized.SetNumUninitialized(NewNum, false);
+        for (int32 Index = 0; Index < InPoints.Num(); Index++)
+            Quantized[StartIndex + Index] = Quantize(InPoints[Index]);
+        break;
+    }
+
+    NumPoints = NewNum;
+    if (Format == EVisualPointsFormat::Quantized && NumOverwritten >= NumPoints)
+        ShrinkQuantization();
+}
+
+void FShapesVisualizerPointStorage::Add(const FVector& Point)
+{
+    Update(NumPoints, MakeArrayView(&Point, 1));
+}
+
+void FShapesVisualizerPointStorage::Set(int32 Index, const FVector& Point)
+{
+    Update(Index, MakeArrayView(&Point, 1));
+}
+
+void FShapesVisualizerPointStorage::RemoveAt(int32 StartIndex, int32 Count)
+{
+    switch (Format)
+    {
+    case EVisualPointsFormat::Vector: Vectors.RemoveAt(StartIndex, Count, false); break;
+    case EVisualPointsFormat::Float: Floats.RemoveAt(StartIndex, Count, false); break;
+    case EVisualPointsFormat::Quantized: Quantized.RemoveAt(StartIndex, Count, false); break;
+    }
+    NumPoints -= Count;
+
+    // The shift is linear already, so is the check
+    if (Format == EVisualPointsFormat::Quantized)
+        ShrinkQuantization();
+}
+
+void FShapesVisualizerPointStorage::Reserve(int32 Number)
+{
+    switch (Format)
+    {
+    case EVisualPointsFormat::Vector: Vectors.Reserve(Number); break;
+    case EVisualPointsFormat::Float: Floats.Reserve(Number); break;
+    case EVisualPointsFormat::Quantized: Quantized.Reserve(Number); break;
+    }
+}
+
+void FShapesVisualizerPointStorage::GetPoints(TArray<FVector>& OutPoints) const
+{
+    if (Format == EVisualPointsFormat::Vector)
+    {
+        OutPoints = Vectors;
+        return;
+    }
+
+    OutPoints.SetNumUninitialized(NumPoints, false);
+    for (int32 Index = 0; Index < NumPoints; Index++)
+        OutPoints[Index] = (*this)[Index];
+}
+
+SIZE_T FShapesVisualizerPointStorage::GetAllocatedSize() const
+{
+    return Vectors.GetAllocatedSize() + Floats.GetAllocatedSize() + Quantized.GetAllocatedSize();
+}
+
+void FShapesVisualizerPointStorage::TransformPositions(const FMatrix& LocalToWorld, int32 StartIndex, int32 EndIndex,
+    FVector* OutPositions) const
+{
+    if (Format == EVisualPointsFormat::Vector)
+    {
+        ShapesVisualizerGeometry::TransformPositions(LocalToWorld,
+            MakeArrayView(Vectors.GetData() + StartIndex, EndIndex - StartIndex), OutPositions);
+        return;
+    }
+
+    FVector Decoded[DecodeChunkSize_Internal];
+    for (int32 ChunkStart = StartIndex; ChunkStart < EndIndex; ChunkStart += DecodeChunkSize_Internal)
+    {
+        const int32 ChunkNum = FMath::Min(DecodeChunkSize_Internal, EndIndex - ChunkStart);
+        for (int32 Index = 0; Index < ChunkNum; Index++)
+            Decoded[Index] = (*this)[ChunkStart + Index];
+
+        ShapesVisualizerGeometry::TransformPositions(LocalToWorld,
+            MakeArrayView(Decoded, ChunkNum), OutPositions + (ChunkStart - StartIndex));
+    }
+}
+
+FBox FShapesVisualizerPointStorage::GetBox(int32 StartIndex, int32 EndIndex) const
+{
+    if (StartIndex >= EndIndex)
+        return FBox{ ForceInit };
+
+    switch (Format)
+    {
+    case EVisualPointsFormat::Vector:
+        return FBox{ Vectors.GetData() + StartIndex, EndIndex - StartIndex };
+
+    case EVisualPointsFormat::Float:
+    {
+        FBox Box{ ForceInit };
+        for (int32 Index = StartIndex; Index < EndIndex; Index++)
+            Box += (*this)[Index];
+        return Box;
+    }
+
+    case EVisualPointsFormat::Quantized:
+    {
+        // Dequantization is monotonic, so the box of the integers is enough
+        FQuantizedPoint Min = Quantized[StartIndex];
+        FQuantizedPoint Max = Min;
+        for (int32 Index = StartIndex + 1; Index < EndIndex; Index++)
+        {
+            const FQuantizedPoint& Point = Quantized[Index];
+            Min = FQuantizedPoint{ FMath::Min(Min.X, Point.X), FMath::Min(Min.Y, Point.Y), FMath::Min(Min.Z, Point.Z) };
+            Max = FQuantizedPoint{ FMath::Max(Max.X, Point.X), FMath::Max(Max.Y, Point.Y), FMath::Max(Max.Z, Point.Z) };
+        }
+        return FBox{ Dequantize(Min), Dequantize(Max) };
+    }
+    }
+    return FBox{ ForceInit };
+}
+
+FShapesVisualizerPointStorage::FQuantizedPoint FShapesVisualizerPointStorage::Quantize(const FVector& Point) const
+{
+    const FVector Q = (Point - QuantizeOrigin) / QuantizeStep;
+    return FQuantizedPoint{
+        static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Q.X), 0, 65535)),
+        static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Q.Y), 0, 65535)),
+        static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Q.Z), 0, 65535)) };
+}
+
+void FShapesVisualizerPointStorage::FitQuantization(int32 StartIndex, TArrayView<const FVector> InPoints)
+{
+    if (InPoints.Num() == 0)
+        return;
+
+    const FBox PointsBox{ InPoints.GetData(), InPoints.Num() };
+    const bool Fits = QuantizeBox.IsValid && QuantizeBox.IsInsideOrOn(PointsBox.Min) && QuantizeBox.IsInsideOrOn(PointsBox.Max);
+    if (StartIndex == 0 && InPoints.Num() >= NumPoints)
+    {
+        // Nothing stored survives, the box only has to fit the new points, tightly the first time
+        // and with room to grow afterwards unless they take less than half of it
+        if (!QuantizeBox.IsValid)
+            SetQuantizeBox(PointsBox, 0);
+        else if (!Fits || IsLoose_Internal(PointsBox, QuantizeBox))
+            SetQuantizeBox(PointsBox.ExpandBy(PointsBox.GetSize() * 0.25f), 0);
+        NumOverwritten = 0;
+        return;
+    }
+
+    if (Fits)
+    {
+        NumOverwritten += FMath::Min(InPoints.Num(), NumPoints - StartIndex);
+        return;
+    }
+
+    // Growing boxes get a quarter of the size of the points on each side, so streamed points rarely
+    // requantize. The stored points are decoded anyway, their exact box keeps the growth from compounding
+    FBox Box = PointsBox;
+    if (NumPoints > 0)
+        Box += GetBox(0, NumPoints);
+    SetQuantizeBox(Box.ExpandBy(Box.GetSize() * 0.25f), NumPoints);
+}
+
+void FShapesVisualizerPointStorage::ShrinkQuantization()
+{
+    NumOverwritten = 0;
+    if (NumPoints == 0)
+        return;
+
+    const FBox PointsBox = GetBox(0, NumPoints);
+    if (IsLoose_Internal(PointsBox, QuantizeBox))
+        SetQuantizeBox(PointsBox.ExpandBy(PointsBox.GetSize() * 0.25f), NumPoints);
+}
+
+void FShapesVisualizerPointStorage::SetQuantizeBox(const FBox& Box, int32 NumKept)
+{
+    TArray<FVector> OldPoints;
+    OldPoints.SetNumUninitialized(NumKept);
+    for (int32 Index = 0; Index < NumKept; Index++)
+        OldPoints[Index] = (*this)[Index];
+
+    QuantizeBox = Box;
+    QuantizeOrigin = QuantizeBox.Min;
+    QuantizeStep = (QuantizeBox.GetSize() / MaxQuantized_Internal).ComponentMax(FVector{ KINDA_SMALL_NUMBER });
+
+    for (int32 Index = 0; Index < NumKept; Index++)
+        Quantized[Index] = Quantize(OldPoints[Index]);
+    NumOverwritten = 0;
+}
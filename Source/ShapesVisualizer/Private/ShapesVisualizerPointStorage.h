@@ -0,0 +1,151 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ShapesVisualizerComponent.h"
+
+//
+// FShapesVisualizerPointStorage - points of the scene proxy in one of EVisualPointsFormat
+//
+// Vector keeps the points as they are. Float halves them where FVector is made of doubles.
+// Quantized keeps 16 bits per axis inside a box around the points, the box grows with spare
+// room when a point falls outside, and the stored points are requantized then. The box is fitted
+// again once the points take less than half of it, checked after removals and whenever as many
+// points as stored have been overwritten.
+// Points are decoded when they are read, chunk by chunk for the transforms.
+//
+
+class FShapesVisualizerPointStorage
+{
+public:
+
+    FShapesVisualizerPointStorage() = default;
+    FShapesVisualizerPointStorage(EVisualPointsFormat InFormat, TArrayView<const FVector> InPoints) { Reset(InFormat, InPoints); }
+
+    void Reset(EVisualPointsFormat InFormat, TArrayView<const FVector> InPoints);
+    // Overwrites the points from StartIndex, the ones past the end are appended
+    void Update(int32 StartIndex, TArrayView<const FVector> InPoints);
+    void Add(const FVector& Point);
+    void Set(int32 Index, const FVector& Point);
+    void RemoveAt(int32 StartIndex, int32 Count);
+    void Reserve(int32 Number);
+
+    EVisualPointsFormat GetFormat() const { return Format; }
+    int32 Num() const { return NumPoints; }
+    SIZE_T GetAllocatedSize() const;
+
+    FORCEINLINE FVector operator[](int32 Index) const
+    {
+        switch (Format)
+        {
+        case EVisualPointsFormat::Float: return FVector{ Floats[Index].X, Floats[Index].Y, Floats[Index].Z };
+        case EVisualPointsFormat::Quantized: return Dequantize(Quantized[Index]);
+        default: return Vectors[Index];
+        }
+    }
+
+    // Decodes all the points
+    void GetPoints(TArray<FVector>& OutPoints) const;
+
+    // Points [StartIndex, EndIndex) in the space of LocalToWorld
+    void TransformPositions(const FMatrix& LocalToWorld, int32 StartIndex, int32 EndIndex, FVector* OutPositions) const;
+    // Local box of the points [StartIndex, EndIndex)
+    FBox GetBox(int32 StartIndex, int32 EndIndex) const;
+
+private:
+
+    struct FFloatPoint
+    {
+        float X, Y, Z;
+    };
+
+    struct FQuantizedPoint
+    {
+        uint16 X, Y, Z;
+    };
+
+    FORCEINLINE FVector Dequantize(const FQuantizedPoint& Point) const
+    {
+        return QuantizeOrigin + FVector{ static_cast<float>(Point.X), static_cast<float>(Point.Y), static_cast<float>(Point.Z) } * QuantizeStep;
+    }
+
+    FQuantizedPoint Quantize(const FVector& Point) const;
+    // Makes sure the points written from StartIndex fit the quantization box, requantizes the stored ones
+    // if it grows or the points overwrite all of them
+    void FitQuantization(int32 StartIndex, TArrayView<const FVector> InPoints);
+    // Fits the box again once the stored points take less than half of it
+    void ShrinkQuantization();
+    // Requantizes the first NumKept stored points into the box, the rest are about to be overwritten
+    void SetQuantizeBox(const FBox& Box, int32 NumKept);
+
+private:
+
+    EVisualPointsFormat Format = {};
+    int32 NumPoints = 0;
+    // Only the array of the format is used
+    TArray<FVector> Vectors;
+    TArray<FFloatPoint> Floats;
+    TArray<FQuantizedPoint> Quantized;
+    // Quantized point is QuantizeOrigin + Q * QuantizeStep
+    FBox QuantizeBox{ ForceInit };
+    FVector QuantizeOrigin = FVector::ZeroVector;
+    FVector QuantizeStep = FVector::OneVector;
+    // Points overwritten since the box was fitted
+    int32 NumOverwritten = 0;
+};
+
+//
+// FShapesVisualizerSharedPointStorage - point storage shared by a component and its proxy, copied on write
+//
+// A component without KeepPoints hands its compact points to the proxy without a copy. The storage is read
+// only while both hold it, the first side which writes copies it for itself. Reads go through the handle or
+// its conversion, writes through GetMutable. The reference count is thread safe, each side uses its handle
+// from its own thread only.
+//
+
+class FShapesVisualizerSharedPointStorage
+{
+public:
+
+    using FStorageRef = TSharedRef<FShapesVisualizerPointStorage, ESPMode::ThreadSafe>;
+
+    explicit FShapesVisualizerSharedPointStorage(const FStorageRef& InStorage) : Storage(InStorage) {}
+    explicit FShapesVisualizerSharedPointStorage(FShapesVisualizerPointStorage&& InStorage)
+        : Storage(MakeShared<FShapesVisualizerPointStorage, ESPMode::ThreadSafe>(MoveTemp(InStorage)))
+    {
+    }
+
+    // The other side still holds the storage
+    bool IsShared() const { return Storage.GetSharedReferenceCount() > 1; }
+
+    const FShapesVisualizerPointStorage& Get() const { return *Storage; }
+    operator const FShapesVisualizerPointStorage&() const { return *Storage; }
+
+    FShapesVisualizerPointStorage& GetMutable()
+    {
+        if (IsShared())
+            Storage = MakeShared<FShapesVisualizerPointStorage, ESPMode::ThreadSafe>(*Storage);
+        return *Storage;
+    }
+
+    // A shared storage with points is not copied only to reserve room
+    void Reserve(int32 Number)
+    {
+        if (!IsShared() || Storage->Num() == 0)
+            GetMutable().Reserve(Number);
+    }
+
+    EVisualPointsFormat GetFormat() const { return Storage->GetFormat(); }
+    int32 Num() const { return Storage->Num(); }
+    SIZE_T GetAllocatedSize() const { return Storage->GetAllocatedSize(); }
+    FORCEINLINE FVector operator[](int32 Index) const { return (*Storage)[Index]; }
+    void TransformPositions(const FMatrix& LocalToWorld, int32 StartIndex, int32 EndIndex, FVector* OutPositions) const
+    {
+        Storage->TransformPositions(LocalToWorld, StartIndex, EndIndex, OutPositions);
+    }
+
+private:
+
+    FStorageRef Storage;
+};
@@ -0,0 +1,174 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerPointsMesh.h"
+#include "ShapesVisualizerGeometry.h"
+
+//
+// FShapesVisualizerPointsMesh
+//
+
+FShapesVisualizerPointsMesh::FShapesVisualizerPointsMesh(ERHIFeatureLevel::Type InFeatureLevel)
+{
+    for (int32 LODIndex = 0; LODIndex < MaxLODs; LODIndex++)
+        LODs.Add(new FLOD(InFeatureLevel));
+}
+
+void FShapesVisualizerPointsMesh::Build(const FShapesVisualizerPointStorage& Points, float InRadius, const FVector& InScale,
+    int32 InNumSides, bool InWireframe, int32 InCapacity)
+{
+    Radius = InRadius;
+    Scale = InScale;
+    NumSides = InNumSides;
+    Wireframe = InWireframe;
+    Capacity = FMath::Max(Points.Num(), InCapacity);
+
+    // Diamonds are not tessellated, spheres get the coarse copy only when it is really coarser
+    const int32 Sides = ShapesVisualizerGeometry::GetPointsSides(Capacity, NumSides);
+    NumLODs = !Wireframe && Sides > CoarseSides ? 2 : 1;
+
+    // The full detail mesh is the largest one, its stride keeps both within the budget
+    TArray<FDynamicMeshVertex> PointVerts;
+    TArray<uint32> PointIndices;
+    BuildTemplate(LODs[0], Sides, PointVerts, PointIndices);
+    Stride = ShapesVisualizerGeometry::GetPointsStride(Capacity, PointVerts.Num());
+
+    BuildLOD(LODs[0], Points, Sides);
+    if (NumLODs > 1)
+        BuildLOD(LODs[1], Points, CoarseSides);
+    else
+        LODs[1].Buffers.Release();
+}
+
+void FShapesVisualizerPointsMesh::Update(const FShapesVisualizerPointStorage& Points, int32 StartIndex, int32 EndIndex)
+{
+    // Grow geometrically so appending stays amortized O(added points). Up to the reserved number the mesh
+    // is built once, doubling past it would sample a streamed cloud coarser than its stride needs
+    if (Points.Num() > Capacity || !LODs[0].Buffers.IsInitialized())
+    {
+        const int32 NewCapacity = Points.Num() <= ReservedCapacity ? ReservedCapacity : FMath::Max(Points.Num(), Capacity * 2);
+        Build(Points, Radius, Scale, NumSides, Wireframe, NewCapacity);
+        return;
+    }
+
+    const int32 NumSlots = GetSlot(Points.Num());
+    for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++)
+    {
+        FLOD& LOD = LODs[LODIndex];
+        WritePositions(LOD, Points, GetSlot(StartIndex), GetSlot(FMath::Min(EndIndex, Points.Num())));
+        LOD.Buffers.SetDrawRange(NumSlots * LOD.TemplatePositions.Num(), NumSlots * LOD.IndicesPerPoint);
+    }
+}
+
+void FShapesVisualizerPointsMesh::SetScale(const FShapesVisualizerPointStorage& Points, const FVector& InScale)
+{
+    Scale = InScale;
+    // Reserved slots are written when their points arrive
+    for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++)
+        WritePositions(LODs[LODIndex], Points, 0, GetSlot(Points.Num()));
+}
+
+void FShapesVisualizerPointsMesh::Release()
+{
+    for (FLOD& LOD : LODs)
+        LOD.Buffers.Release();
+    NumLODs = 0;
+    Capacity = 0;
+    Stride = 1;
+}
+
+SIZE_T FShapesVisualizerPointsMesh::GetAllocatedSize() const
+{
+    SIZE_T Size = LODs.GetAllocatedSize();
+    for (const FLOD& LOD : LODs)
+        Size += sizeof(FLOD) + LOD.TemplatePositions.GetAllocatedSize() + LOD.Buffers.GetAllocatedSize();
+    return Size;
+}
+
+void FShapesVisualizerPointsMesh::BuildTemplate(FLOD& LOD, int32 LODSides,
+    TArray<FDynamicMeshVertex>& OutPointVerts, TArray<uint32>& OutPointIndices) const
+{
+    const FVector Origin = FVector::ZeroVector;
+    if (Wireframe)
+        ShapesVisualizerGeometry::BuildPointsLines(MakeArrayView(&Origin, 1), 1.f, FVector::OneVector,
+            OutPointVerts, OutPointIndices);
+    else
+        ShapesVisualizerGeometry::BuildPointsVerts(MakeArrayView(&Origin, 1), 1.f, FVector::OneVector,
+            LODSides, OutPointVerts, OutPointIndices);
+
+    LOD.TemplatePositions.Reset(OutPointVerts.Num());
+    for (const FDynamicMeshVertex& PointVert : OutPointVerts)
+        LOD.TemplatePositions.Add(FVector{ PointVert.Position });
+    LOD.IndicesPerPoint = OutPointIndices.Num();
+    LOD.NumSides = LODSides;
+}
+
+void FShapesVisualizerPointsMesh::BuildLOD(FLOD& LOD, const FShapesVisualizerPointStorage& Points, int32 LODSides)
+{
+    TArray<FDynamicMeshVertex> PointVerts;
+    TArray<uint32> PointIndices;
+    BuildTemplate(LOD, LODSides, PointVerts, PointIndices);
+
+    const FVector RadiusScale = ShapesVisualizerGeometry::GetWorldRadiusScale(Radius, Scale);
+
+    const int32 VertsPerPoint = PointVerts.Num();
+    const int32 IndicesPerPoint = PointIndices.Num();
+    const int32 NumSlots = GetSlot(Capacity);
+
+    // The stride keeps the vertices within the budget, the indices must still fit an int32
+    const int64 NumVerts = static_cast<int64>(NumSlots) * VertsPerPoint;
+    const int64 NumIndices = static_cast<int64>(NumSlots) * IndicesPerPoint;
+    check(NumVerts <= ShapesVisualizerGeometry::MaxPointsVertices && NumIndices <= MAX_int32);
+
+    // The vertex buffers copy the vertices and take the indices, nothing of the build outlives it
+    TArray<FDynamicMeshVertex> MeshVerts;
+    TArray<uint32> MeshIndices;
+    MeshVerts.SetNumUninitialized(static_cast<int32>(NumVerts));
+    MeshIndices.SetNumUninitialized(static_cast<int32>(NumIndices));
+
+    // Reserved slots are parked at the origin until they are drawn
+    ShapesVisualizerGeometry::ParallelForChunks(NumSlots, [&](int32 StartSlot, int32 EndSlot)
+    {
+        for (int32 Slot = StartSlot; Slot < EndSlot; Slot++)
+        {
+            const int32 PointIndex = Slot * Stride;
+            const FVector Pt = PointIndex < Points.Num() ? Points[PointIndex] : FVector::ZeroVector;
+            const uint32 BaseVertIndex = Slot * VertsPerPoint;
+
+            for (int32 VertIndex = 0; VertIndex < VertsPerPoint; VertIndex++)
+            {
+                FDynamicMeshVertex& MeshVertex = MeshVerts[BaseVertIndex + VertIndex];
+                MeshVertex = PointVerts[VertIndex];
+                MeshVertex.Position = FShapesVisualizerPosition(Pt + LOD.TemplatePositions[VertIndex] * RadiusScale);
+            }
+
+            uint32* const OutIndices = MeshIndices.GetData() + Slot * IndicesPerPoint;
+            for (int32 Index = 0; Index < IndicesPerPoint; Index++)
+                OutIndices[Index] = BaseVertIndex + PointIndices[Index];
+        }
+    });
+
+    LOD.Buffers.Init(MeshVerts, MeshIndices, Wireframe ? PT_LineList : PT_TriangleList);
+    LOD.Buffers.SetDrawRange(GetSlot(Points.Num()) * VertsPerPoint, GetSlot(Points.Num()) * IndicesPerPoint);
+}
+
+void FShapesVisualizerPointsMesh::WritePositions(FLOD& LOD, const FShapesVisualizerPointStorage& Points, int32 StartSlot, int32 EndSlot)
+{
+    if (StartSlot >= EndSlot)
+        return;
+
+    const FVector RadiusScale = ShapesVisualizerGeometry::GetWorldRadiusScale(Radius, Scale);
+    const int32 VertsPerPoint = LOD.TemplatePositions.Num();
+
+    FShapesVisualizerPosition* const Positions = LOD.Buffers.LockPositions(StartSlot * VertsPerPoint, (EndSlot - StartSlot) * VertsPerPoint);
+    ShapesVisualizerGeometry::ParallelForChunks(EndSlot - StartSlot, [&](int32 ChunkStart, int32 ChunkEnd)
+    {
+        FShapesVisualizerPosition* ChunkPositions = Positions + ChunkStart * VertsPerPoint;
+        for (int32 Slot = StartSlot + ChunkStart; Slot < StartSlot + ChunkEnd; Slot++)
+        {
+            const FVector Pt = Points[Slot * Stride];
+            for (const FVector& TemplatePosition : LOD.TemplatePositions)
+                *ChunkPositions++ = FShapesVisualizerPosition(Pt + TemplatePosition * RadiusScale);
+        }
+    });
+    LOD.Buffers.UnlockPositions();
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerMeshBuffers.h"
+#include "ShapesVisualizerPointStorage.h"
+
+//
+// FShapesVisualizerPointsMesh - all points of a component merged into one mesh
+//
+// Spheres in solid mode and diamonds (line list) in wireframe mode. The buffers
+// keep spare room for appended points, changed ranges are rewritten in place.
+// Solid spheres also get a coarse copy for views where every point is small.
+// The mesh never exceeds ShapesVisualizerGeometry::MaxPointsVertices: spheres lose
+// sides first, then become tetrahedra, and beyond that only every Stride-th point
+// gets a slot in the buffers. Render thread only.
+//
+
+class FShapesVisualizerPointsMesh
+{
+public:
+
+    // Full detail and coarse spheres
+    static constexpr int32 MaxLODs = 2;
+    static constexpr int32 CoarseSides = 8;
+
+    FShapesVisualizerPointsMesh(ERHIFeatureLevel::Type InFeatureLevel);
+    ~FShapesVisualizerPointsMesh() { Release(); }
+
+    void Build(const FShapesVisualizerPointStorage& Points, float InRadius, const FVector& InScale,
+        int32 InNumSides, bool InWireframe, int32 InCapacity = 0);
+    // Points in [StartIndex, EndIndex) changed, Points.Num() is the new number of points
+    void Update(const FShapesVisualizerPointStorage& Points, int32 StartIndex, int32 EndIndex);
+    // Number of points expected, the mesh grows to it at once and keeps the stride of the whole set
+    void Reserve(int32 Number) { ReservedCapacity = Number; }
+    // Rewrites the positions for the new component scale, the indices and the other vertex data stay
+    void SetScale(const FShapesVisualizerPointStorage& Points, const FVector& InScale);
+    void Release();
+
+    const FShapesVisualizerMeshBuffers& GetBuffers(int32 LODIndex = 0) const { return LODs[LODIndex].Buffers; }
+    int32 GetNumLODs() const { return NumLODs; }
+    int32 GetNumSides(int32 LODIndex) const { return LODs[LODIndex].NumSides; }
+    // Indices of slot i are [i * IndicesPerPoint, (i + 1) * IndicesPerPoint)
+    int32 GetIndicesPerPoint(int32 LODIndex) const { return LODs[LODIndex].IndicesPerPoint; }
+    const FVector& GetScale() const { return Scale; }
+    int32 GetCapacity() const { return Capacity; }
+    SIZE_T GetAllocatedSize() const;
+    // Slot i holds the point i * Stride
+    int32 GetStride() const { return Stride; }
+    // First slot of a point at or after PointIndex, the points in [StartIndex, EndIndex)
+    // have the slots [GetSlot(StartIndex), GetSlot(EndIndex))
+    FORCEINLINE int32 GetSlot(int32 PointIndex) const { return (PointIndex + Stride - 1) / Stride; }
+
+private:
+
+    struct FLOD
+    {
+        FLOD(ERHIFeatureLevel::Type InFeatureLevel) : Buffers(InFeatureLevel) {}
+
+        FShapesVisualizerMeshBuffers Buffers;
+        // Unit sphere or diamond of one point
+        TArray<FVector> TemplatePositions;
+        int32 IndicesPerPoint = 0;
+        int32 NumSides = 0;
+    };
+
+    // Mesh of one point at the origin, the template for all of them
+    void BuildTemplate(FLOD& LOD, int32 LODSides, TArray<FDynamicMeshVertex>& OutPointVerts, TArray<uint32>& OutPointIndices) const;
+    void BuildLOD(FLOD& LOD, const FShapesVisualizerPointStorage& Points, int32 LODSides);
+    void WritePositions(FLOD& LOD, const FShapesVisualizerPointStorage& Points, int32 StartSlot, int32 EndSlot);
+
+private:
+
+    TIndirectArray<FLOD> LODs;
+    int32 NumLODs = 0;
+    int32 Capacity = 0;
+    int32 ReservedCapacity = 0;
+    int32 Stride = 1;
+    // Build parameters
+    float Radius = 0.f;
+    FVector Scale = FVector::OneVector;
+    int32 NumSides = 0;
+    bool Wireframe = false;
+};
@@ -0,0 +1,84 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerPolylineSimplifier.h"
+
+//
+// FShapesVisualizerPolylineSimplifier
+//
+
+void FShapesVisualizerPolylineSimplifier::SetRange(int64 InFirstSequence, int32 InNumPoints)
+{
+    if (InFirstSequence == FirstSequence && InNumPoints == NumPoints)
+        return;
+
+    // Sequences never go back, the blocks would cover other points
+    if (InFirstSequence < FirstSequence)
+        Reset();
+
+    FirstSequence = InFirstSequence;
+    NumPoints = InNumPoints;
+    IndicesValid = false;
+}
+
+void FShapesVisualizerPolylineSimplifier::Invalidate(int64 Sequence)
+{
+    // The segment ending at Sequence changed too
+    const int64 FirstDirty = FMath::Max<int64>(Sequence - 1, 0) / BlockSize - FirstBlock;
+    for (int64 Index = FMath::Max<int64>(FirstDirty, 0); Index < Blocks.Num(); Index++)
+        Blocks[Index].Valid = false;
+    IndicesValid = false;
+}
+
+void FShapesVisualizerPolylineSimplifier::Reset()
+{
+    FirstSequence = 0;
+    NumPoints = 0;
+    FirstBlock = 0;
+    Blocks.Reset();
+    Tolerance = 0.f;
+    Indices.Reset();
+    IndicesValid = false;
+}
+
+SIZE_T FShapesVisualizerPolylineSimplifier::GetAllocatedSize() const
+{
+    SIZE_T Size = Blocks.GetAllocatedSize() + Indices.GetAllocatedSize();
+    for (const FBlock& Block : Blocks)
+        Size += Block.Indices.GetAllocatedSize();
+    return Size;
+}
+
+void FShapesVisualizerPolylineSimplifier::UpdateBlocks(TArray<int32>& OutDirtyBlocks)
+{
+    if (NumPoints < 2)
+    {
+        Blocks.Reset();
+        return;
+    }
+
+    // Block of the first and the last segment
+    const int64 LastSequence = FirstSequence + NumPoints - 1;
+    const int64 NewFirstBlock = FirstSequence / BlockSize;
+    const int64 NewLastBlock = (LastSequence - 1) / BlockSize;
+
+    const int64 NumDropped = FMath::Min<int64>(NewFirstBlock - FirstBlock, Blocks.Num());
+    if (NumDropped > 0)
+        Blocks.RemoveAt(0, static_cast<int32>(NumDropped), false);
+    FirstBlock = NewFirstBlock;
+    Blocks.SetNum(static_cast<int32>(NewLastBlock - NewFirstBlock + 1), false);
+
+    for (int32 Index = 0; Index < Blocks.Num(); Index++)
+    {
+        FBlock& Block = Blocks[Index];
+        const int64 BlockIndex = FirstBlock + Index;
+        const int64 Start = FMath::Max(BlockIndex * BlockSize, FirstSequence);
+        const int64 End = FMath::Min((BlockIndex + 1) * BlockSize, LastSequence);
+        if (!Block.Valid || Block.Start != Start || Block.End != End)
+        {
+            Block.Start = Start;
+            Block.End = End;
+            Block.Valid = false;
+            OutDirtyBlocks.Add(Index);
+        }
+    }
+}
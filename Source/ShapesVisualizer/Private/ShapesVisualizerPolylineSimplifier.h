@@ -0,0 +1,105 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShapesVisualizerGeometry.h"
+
+//
+// FShapesVisualizerPolylineSimplifier - view dependent simplification of a growing polyline, block by block
+//
+// Points are numbered by a sequence which only grows: appended points get the next numbers and the oldest
+// points of a wrapped trail leave at the front. Blocks of BlockSize segments are simplified on their own and
+// keep their result while their points and the tolerance stay, so a pushed trail point redoes only the last
+// block, and the first one when the oldest point left. Block ends are always kept, so the result has at most
+// one point per block more than the simplification of the whole polyline. Render thread only.
+//
+
+class FShapesVisualizerPolylineSimplifier
+{
+public:
+
+    static constexpr int32 BlockSize = 1024;
+
+    // The polyline is the points [InFirstSequence, InFirstSequence + InNumPoints) now
+    void SetRange(int64 InFirstSequence, int32 InNumPoints);
+    // Points from Sequence on changed
+    void Invalidate(int64 Sequence);
+    void Reset();
+
+    int64 GetFirstSequence() const { return FirstSequence; }
+    SIZE_T GetAllocatedSize() const;
+
+    // Indices of the kept points in [0, NumPoints), GetPoint(Index) returns the point Index of the polyline.
+    // The result is reused while the points stay the same and the tolerance is at most twice the cached one
+    template <typename GetPointType>
+    const TArray<int32>& Simplify(float InTolerance, GetPointType&& GetPoint);
+
+private:
+
+    struct FBlock
+    {
+        // Sequences of the first and the last simplified point
+        int64 Start = 0;
+        int64 End = -1;
+        // Kept points relative to Start
+        TArray<int32> Indices;
+        bool Valid = false;
+    };
+
+    // Drops the blocks before FirstSequence and adds the missing ones, returns the blocks to simplify
+    void UpdateBlocks(TArray<int32>& OutDirtyBlocks);
+
+private:
+
+    int64 FirstSequence = 0;
+    int32 NumPoints = 0;
+    // Blocks from FirstBlock on, block b covers the segments between the sequences b * BlockSize and (b + 1) * BlockSize
+    int64 FirstBlock = 0;
+    TArray<FBlock> Blocks;
+    float Tolerance = 0.f;
+    TArray<int32> Indices;
+    bool IndicesValid = false;
+};
+
+template <typename GetPointType>
+const TArray<int32>& FShapesVisualizerPolylineSimplifier::Simplify(float InTolerance, GetPointType&& GetPoint)
+{
+    if (InTolerance < Tolerance || InTolerance > 2.f * Tolerance)
+    {
+        Invalidate(FirstSequence);
+        Tolerance = InTolerance;
+    }
+    if (IndicesValid)
+        return Indices;
+
+    TArray<int32> Dirty;
+    UpdateBlocks(Dirty);
+
+    // Blocks are independent, long polylines redo several of them at once
+    ParallelFor(Dirty.Num(), [&](int32 DirtyIndex)
+    {
+        FBlock& Block = Blocks[Dirty[DirtyIndex]];
+        const int64 BlockStart = Block.Start;
+        ShapesVisualizerGeometry::SimplifyPolyline(static_cast<int32>(Block.End - Block.Start + 1), Tolerance,
+            [&](int32 Index) { return GetPoint(static_cast<int32>(BlockStart - FirstSequence) + Index); },
+            Block.Indices);
+        Block.Valid = true;
+    }, Dirty.Num() < 2);
+
+    // Consecutive blocks share their end points
+    Indices.Reset();
+    for (const FBlock& Block : Blocks)
+    {
+        const int32 BlockOffset = static_cast<int32>(Block.Start - FirstSequence);
+        for (int32 Index = Indices.Num() > 0 ? 1 : 0; Index < Block.Indices.Num(); Index++)
+            Indices.Add(BlockOffset + Block.Indices[Index]);
+    }
+    if (Blocks.Num() == 0)
+    {
+        for (int32 Index = 0; Index < NumPoints; Index++)
+            Indices.Add(Index);
+    }
+    IndicesValid = true;
+    return Indices;
+}
@@ -0,0 +1,587 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerRecorder.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Algo/Rotate.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectHash.h"
+#include "ShapesVisualizerStats.h"
+
+using namespace ShapesVisualizerRecording;
+
+DEFINE_LOG_CATEGORY_STATIC(LogShapesVisualizerRecorder, Log, All);
+
+//
+// Console variables
+//
+
+static TAutoConsoleVariable<float> CVarShapesVisualizerRecordPointStep(
+    TEXT("r.ShapesVisualizer.Record.PointStep"),
+    0.1f,
+    TEXT("Recorded points are rounded to multiples of this many units, read when a recording starts."),
+    ECVF_Default);
+
+//
+// Internal functions
+//
+
+namespace
+{
+    template <typename T>
+    FORCEINLINE void Write_Internal(TArray<uint8>& Buffer, const T& Value)
+    {
+        Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+    }
+
+    // Blocks are 4 byte aligned in the mapping, so they are used in place
+    template <typename T>
+    FORCEINLINE const T& Read_Internal(const uint8*& Cursor)
+    {
+        const T& Value = *reinterpret_cast<const T*>(Cursor);
+        Cursor += sizeof(T);
+        return Value;
+    }
+
+    FORCEINLINE bool CanRead_Internal(const uint8* Cursor, const uint8* End, int64 Bytes)
+    {
+        return Bytes >= 0 && End - Cursor >= Bytes;
+    }
+
+    // The run lies within the points and only its own points grow them, so a damaged
+    // header cannot ask for more points than the file holds
+    bool IsPointsHeaderValid_Internal(const FPointsHeader& Header, int32 OldNumPoints)
+    {
+        return Header.NumPoints >= 0 && Header.StartIndex >= 0 && Header.Count >= 0
+            && static_cast<int64>(Header.StartIndex) + Header.Count <= Header.NumPoints
+            && (Header.NumPoints <= OldNumPoints || Header.StartIndex + Header.Count == Header.NumPoints)
+            && static_cast<int64>(Header.Count) * 3 <= Header.Bytes
+            && Header.TrailHead >= 0 && (Header.TrailHead == 0 || Header.TrailHead < Header.NumPoints);
+    }
+
+    FORCEINLINE bool IsPointsShape_Internal(EVisualShape Shape)
+    {
+        return Shape == EVisualShape::Points || Shape == EVisualShape::Polyline;
+    }
+
+    FString GetRecordingPath_Internal(const FString& FileName)
+    {
+        const FString Name = FileName.IsEmpty()
+            ? FString::Printf(TEXT("Recording-%s.svrec"), *FDateTime::Now().ToString())
+            : FileName;
+        if (!FPaths::IsRelative(Name))
+            return Name;
+        return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ShapesVisualizer"), Name));
+    }
+
+    FTransformField MakeTransformField_Internal(const FTransform& Transform)
+    {
+        const FVector Location = Transform.GetLocation();
+        const FQuat Rotation = Transform.GetRotation();
+        const FVector Scale = Transform.GetScale3D();
+        return FTransformField{
+            { static_cast<float>(Location.X), static_cast<float>(Location.Y), static_cast<float>(Location.Z) },
+            { static_cast<float>(Rotation.X), static_cast<float>(Rotation.Y), static_cast<float>(Rotation.Z), static_cast<float>(Rotation.W) },
+            { static_cast<float>(Scale.X), static_cast<float>(Scale.Y), static_cast<float>(Scale.Z) } };
+    }
+
+    UShapesVisualizerRecorder* GetRecorder_Internal(UWorld* World)
+    {
+        return World ? World->GetSubsystem<UShapesVisualizerRecorder>() : nullptr;
+    }
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice RecordCommand_Internal(
+        TEXT("ShapesVisualizer.Record"),
+        TEXT("Records the visualizers of the world into the file, Saved/ShapesVisualizer by default.\n")
+        TEXT("ShapesVisualizer.Record [File]"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                UShapesVisualizerRecorder* const Recorder = GetRecorder_Internal(World);
+                const FString Path = GetRecordingPath_Internal(Args.Num() > 0 ? Args[0] : FString{});
+                if (Recorder && Recorder->StartRecording(Path))
+                    Ar.Logf(TEXT("Recording visualizers to %s"), *Path);
+                else
+                    Ar.Logf(TEXT("Cannot record visualizers to %s"), *Path);
+            }));
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice ReplayCommand_Internal(
+        TEXT("ShapesVisualizer.Replay"),
+        TEXT("Replays the recorded visualizers in the world, optionally from Time seconds.\n")
+        TEXT("ShapesVisualizer.Replay File [Time]"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                UShapesVisualizerRecorder* const Recorder = GetRecorder_Internal(World);
+                if (!Recorder || Args.Num() == 0 || !Recorder->StartReplay(Args[0]))
+                {
+                    Ar.Logf(TEXT("Cannot replay visualizers from %s"), Args.Num() > 0 ? *Args[0] : TEXT("nothing"));
+                    return;
+                }
+                if (Args.Num() > 1)
+                    Recorder->SeekReplay(FCString::Atof(*Args[1]));
+            }));
+
+    FAutoConsoleCommandWithWorld StopCommand_Internal(
+        TEXT("ShapesVisualizer.Stop"),
+        TEXT("Stops the visualizers recording or replay."),
+        FConsoleCommandWithWorldDelegate::CreateLambda(
+            [](UWorld* World)
+            {
+                if (UShapesVisualizerRecorder* const Recorder = GetRecorder_Internal(World))
+                    Recorder->Stop();
+            }));
+}
+
+//
+// UShapesVisualizerRecorder
+//
+
+bool UShapesVisualizerRecorder::StartRecording(const FString& FileName)
+{
+    Stop();
+
+    PointStep = FMath::Max(CVarShapesVisualizerRecordPointStep.GetValueOnGameThread(), KINDA_SMALL_NUMBER);
+    Writer = FShapesVisualizerRecordWriter::Create(GetRecordingPath_Internal(FileName), PointStep);
+    if (!Writer)
+        return false;
+
+    NextId = 0;
+    NumRecordedFrames = 0;
+    NumDroppedFrames = 0;
+    ForceKeyframe = false;
+    RecordStartTime = GetWorld()->GetTimeSeconds();
+    return true;
+}
+
+bool UShapesVisualizerRecorder::StartReplay(const FString& FileName)
+{
+    Stop();
+
+    ReplayFile = FShapesVisualizerReplayFile::Open(GetRecordingPath_Internal(FileName));
+    if (!ReplayFile)
+        return false;
+
+    SeekReplay(0.f);
+    return true;
+}
+
+void UShapesVisualizerRecorder::SeekReplay(float Time)
+{
+    if (!ReplayFile)
+        return;
+
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_Replay);
+
+    ReplayTime = FMath::Max(Time, 0.f);
+    const int32 TargetFrame = ReplayFile->FindFrame(ReplayTime);
+    if (TargetFrame == INDEX_NONE)
+    {
+        DestroyReplayComponents();
+        ReplayFrame = INDEX_NONE;
+        return;
+    }
+
+    const int32 Keyframe = ReplayFile->FindKeyframe(TargetFrame);
+
+    // Backwards or past the next keyframe the state is rebuilt from the keyframe
+    if (TargetFrame < ReplayFrame || Keyframe > ReplayFrame)
+        ReplayFrames(Keyframe - 1, TargetFrame);
+    else
+        ReplayFrames(ReplayFrame, TargetFrame);
+}
+
+void UShapesVisualizerRecorder::Stop()
+{
+    if (NumDroppedFrames > 0)
+        UE_LOG(LogShapesVisualizerRecorder, Warning, TEXT("The recording dropped %d of %d frames, the disk fell behind"),
+            NumDroppedFrames, NumRecordedFrames + NumDroppedFrames);
+    NumDroppedFrames = 0;
+
+    // The writer finishes the queued frames
+    Writer.Reset();
+    RecordedStates.Reset();
+    FrameBuffer.Empty();
+    PointsScratch.Empty();
+
+    ReplayFile.Reset();
+    ReplayFrame = INDEX_NONE;
+    DestroyReplayComponents();
+}
+
+void UShapesVisualizerRecorder::Deinitialize()
+{
+    Stop();
+    Super::Deinitialize();
+}
+
+void UShapesVisualizerRecorder::Tick(float DeltaTime)
+{
+    if (Writer)
+    {
+        SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_Record);
+        RecordFrame();
+    }
+    else if (ReplayFile)
+    {
+        SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_Replay);
+        ReplayTime += DeltaTime;
+        const int32 TargetFrame = ReplayFile->FindFrame(ReplayTime);
+        if (TargetFrame > ReplayFrame)
+            ReplayFrames(ReplayFrame, TargetFrame);
+    }
+}
+
+ETickableTickType UShapesVisualizerRecorder::GetTickableTickType() const
+{
+    return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+TStatId UShapesVisualizerRecorder::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UShapesVisualizerRecorder, STATGROUP_Tickables);
+}
+
+//
+// Recording
+//
+
+void UShapesVisualizerRecorder::RecordFrame()
+{
+    // The queue stays bounded, the frame after the dropped ones restates everything
+    if (Writer->IsFull())
+    {
+        NumDroppedFrames++;
+        ForceKeyframe = true;
+        return;
+    }
+
+    UWorld* const World = GetWorld();
+    const bool Keyframe = NumRecordedFrames++ % KeyframeInterval == 0 || ForceKeyframe;
+    ForceKeyframe = false;
+
+    FrameBuffer.Reset();
+    FrameBuffer.AddUninitialized(sizeof(FFrameHeader));
+    uint32 NumRecords = 0;
+
+    for (TPair<TWeakObjectPtr<UShapesVisualizerComponent>, FRecordedState>& Pair : RecordedStates)
+        Pair.Value.Seen = false;
+
+    ForEachObjectOfClass(UShapesVisualizerComponent::StaticClass(), [&](UObject* Object)
+    {
+        UShapesVisualizerComponent* const Component = static_cast<UShapesVisualizerComponent*>(Object);
+        // Components of the replay are not recorded again. Grids have no fields in the file format
+        if (!Component->IsRegistered() || Component->GetWorld() != World || Component->GetOuter() == this
+            || Component->Shape == EVisualShape::Grid)
+            return;
+
+        FRecordedState* State = RecordedStates.Find(Component);
+        const bool Full = Keyframe || !State;
+        if (!State)
+        {
+            State = &RecordedStates.Add(Component);
+            State->Id = NextId++;
+        }
+        State->Seen = true;
+
+        if (RecordComponent(*Component, *State, Full))
+            NumRecords++;
+    });
+
+    for (auto It = RecordedStates.CreateIterator(); It; ++It)
+    {
+        if (It.Value().Seen)
+            continue;
+
+        // Keyframes tell the removed components by their absence
+        if (!Keyframe)
+        {
+            Write_Internal(FrameBuffer, FRecordHeader{ It.Value().Id, FieldRemoved });
+            NumRecords++;
+        }
+        It.RemoveCurrent();
+    }
+
+    if (NumRecords == 0 && !Keyframe)
+        return;
+
+    FFrameHeader& Header = *reinterpret_cast<FFrameHeader*>(FrameBuffer.GetData());
+    Header.Size = FrameBuffer.Num() - sizeof(FFrameHeader);
+    Header.Time = World->GetTimeSeconds() - RecordStartTime;
+    Header.NumRecords = NumRecords;
+    Header.Keyframe = Keyframe ? 1 : 0;
+    Writer->Write(MoveTemp(FrameBuffer));
+}
+
+bool UShapesVisualizerRecorder::RecordComponent(const UShapesVisualizerComponent& Component, FRecordedState& State, bool Full)
+{
+    const FTransformField Transform = MakeTransformField_Internal(Component.GetComponentTransform());
+    const FShapeField Shape{ static_cast<uint32>(Component.Shape), Component.Radii, Component.Height,
+        { static_cast<float>(Component.Extent.X), static_cast<float>(Component.Extent.Y), static_cast<float>(Component.Extent.Z) } };
+    const FAppearanceField Appearance{ Component.Color.DWColor(),
+        (Component.Wireframe ? FlagWireframe : 0u) | (Component.IsVisible() ? FlagVisible : 0u) | (Component.bHiddenInGame ? FlagHiddenInGame : 0u),
+        Component.LineThickness, Component.NumSides };
+
+    uint32 Fields = 0;
+    if (Full || FMemory::Memcmp(&Transform, &State.Transform, sizeof(Transform)) != 0)
+        Fields |= FieldTransform;
+    if (Full || FMemory::Memcmp(&Shape, &State.Shape, sizeof(Shape)) != 0)
+        Fields |= FieldShape;
+    if (Full || FMemory::Memcmp(&Appearance, &State.Appearance, sizeof(Appearance)) != 0)
+        Fields |= FieldAppearance;
+
+    // Changed points are the run between the first and the last changed one, or the new tail
+    const int32 NumPoints = IsPointsShape_Internal(Component.Shape) ? Component.GetNumPoints() : 0;
+    int32 StartIndex = 0;
+    int32 EndIndex = NumPoints;
+    const bool PointsChanged = Full || (Fields & FieldShape) != 0
+        || Component.GetPointsSerial() != State.PointsSerial || NumPoints * 3 != State.Points.Num();
+    if (NumPoints > 0 && PointsChanged)
+    {
+        // Changes below the step are not recorded
+        TArray<FVector> Decoded;
+        const TArrayView<const FVector> Points = Component.GetPoints(Decoded);
+        PointsScratch.SetNumUninitialized(NumPoints * 3);
+        for (int32 Index = 0; Index < NumPoints; Index++)
+        {
+            PointsScratch[Index * 3 + 0] = QuantizeCoordinate(Points[Index].X, PointStep);
+            PointsScratch[Index * 3 + 1] = QuantizeCoordinate(Points[Index].Y, PointStep);
+            PointsScratch[Index * 3 + 2] = QuantizeCoordinate(Points[Index].Z, PointStep);
+        }
+
+        if (!Full && (Fields & FieldShape) == 0)
+        {
+            const int32 OldNumPoints = State.Points.Num() / 3;
+            const int32 NumCommon = FMath::Min(NumPoints, OldNumPoints);
+            auto SamePoint = [this, &State](int32 Index)
+            {
+                return FMemory::Memcmp(&PointsScratch[Index * 3], &State.Points[Index * 3], 3 * sizeof(int32)) == 0;
+            };
+
+            while (StartIndex < NumCommon && SamePoint(StartIndex))
+                StartIndex++;
+            if (NumPoints == OldNumPoints)
+            {
+                while (EndIndex > StartIndex && SamePoint(EndIndex - 1))
+                    EndIndex--;
+            }
+        }
+    }
+    else if (!PointsChanged)
+    {
+        StartIndex = EndIndex;
+    }
+
+    const int32 TrailHead = Component.GetTrailHead();
+    if (IsPointsShape_Internal(Component.Shape) && (Full || (Fields & FieldShape) != 0 || StartIndex < EndIndex
+        || NumPoints * 3 != State.Points.Num() || TrailHead != State.TrailHead))
+    {
+        Fields |= FieldPoints;
+    }
+
+    State.PointsSerial = Component.GetPointsSerial();
+    if (Fields == 0)
+        return false;
+
+    Write_Internal(FrameBuffer, FRecordHeader{ State.Id, Fields });
+    if (Fields & FieldTransform)
+        Write_Internal(FrameBuffer, State.Transform = Transform);
+    if (Fields & FieldShape)
+        Write_Internal(FrameBuffer, State.Shape = Shape);
+    if (Fields & FieldAppearance)
+        Write_Internal(FrameBuffer, State.Appearance = Appearance);
+    if (Fields & FieldPoints)
+    {
+        const int32 Count = EndIndex - StartIndex;
+        const int32 HeaderOffset = FrameBuffer.Num();
+        Write_Internal(FrameBuffer, FPointsHeader{ NumPoints, StartIndex, Count, TrailHead, 0 });
+        const int32 Bytes = EncodePoints(MakeArrayView(PointsScratch.GetData() + StartIndex * 3, Count * 3), FrameBuffer);
+        reinterpret_cast<FPointsHeader*>(FrameBuffer.GetData() + HeaderOffset)->Bytes = Bytes;
+
+        if (PointsChanged)
+            Swap(State.Points, PointsScratch);
+        State.Points.SetNum(NumPoints * 3, false);
+        State.TrailHead = TrailHead;
+    }
+    return true;
+}
+
+//
+// Replay
+//
+
+void UShapesVisualizerRecorder::ReplayFrames(int32 FirstFrame, int32 LastFrame)
+{
+    TSet<int32> KeyframeIds;
+    for (int32 FrameIndex = FirstFrame + 1; FrameIndex <= LastFrame; FrameIndex++)
+    {
+        const FFrameHeader& Frame = ReplayFile->GetFrame(FrameIndex);
+        const uint8* Cursor = ReplayFile->GetFrameData(FrameIndex);
+        const uint8* const FrameEnd = ReplayFile->GetFrameEnd(FrameIndex);
+
+        KeyframeIds.Reset();
+        bool Damaged = false;
+        for (uint32 RecordIndex = 0; RecordIndex < Frame.NumRecords && !Damaged; RecordIndex++)
+            Damaged = !ReplayRecord(Cursor, FrameEnd, Frame.Keyframe ? &KeyframeIds : nullptr);
+        if (Damaged)
+            UE_LOG(LogShapesVisualizerRecorder, Warning, TEXT("Frame %d of the replay is damaged, the rest of it is skipped"), FrameIndex);
+
+        // Components missing from the keyframe are gone, unless the keyframe was cut short
+        if (Frame.Keyframe && !Damaged)
+        {
+            for (auto It = ReplayComponents.CreateIterator(); It; ++It)
+            {
+                if (KeyframeIds.Contains(It.Key()))
+                    continue;
+                if (It.Value())
+                    It.Value()->DestroyComponent();
+                ReplayPoints.Remove(It.Key());
+                It.RemoveCurrent();
+            }
+        }
+    }
+    ReplayFrame = LastFrame;
+}
+
+bool UShapesVisualizerRecorder::ReplayRecord(const uint8*& Cursor, const uint8* End, TSet<int32>* KeyframeIds)
+{
+    if (!CanRead_Internal(Cursor, End, sizeof(FRecordHeader)))
+        return false;
+    const FRecordHeader& Record = Read_Internal<FRecordHeader>(Cursor);
+    if (Record.Fields & FieldRemoved)
+    {
+        UShapesVisualizerComponent* Component = nullptr;
+        if (ReplayComponents.RemoveAndCopyValue(Record.Id, Component) && Component)
+            Component->DestroyComponent();
+        ReplayPoints.Remove(Record.Id);
+        return true;
+    }
+
+    // The whole record is checked and its points decoded before anything is applied
+    if (Record.Fields & ~FieldAll)
+        return false;
+    const int64 FieldsSize = ((Record.Fields & FieldTransform) ? sizeof(FTransformField) : 0)
+        + ((Record.Fields & FieldShape) ? sizeof(FShapeField) : 0)
+        + ((Record.Fields & FieldAppearance) ? sizeof(FAppearanceField) : 0);
+    if (!CanRead_Internal(Cursor, End, FieldsSize))
+        return false;
+    if ((Record.Fields & FieldShape)
+        && reinterpret_cast<const FShapeField*>(Cursor + ((Record.Fields & FieldTransform) ? sizeof(FTransformField) : 0))->Shape
+            >= static_cast<uint32>(EVisualShape::Grid))
+        return false;
+
+    const FPointsHeader* PointsHeader = nullptr;
+    const uint8* RecordEnd = Cursor + FieldsSize;
+    if (Record.Fields & FieldPoints)
+    {
+        if (!CanRead_Internal(RecordEnd, End, sizeof(FPointsHeader)))
+            return false;
+        PointsHeader = &Read_Internal<FPointsHeader>(RecordEnd);
+        const TArray<FVector>* const OldPoints = ReplayPoints.Find(Record.Id);
+        if (!IsPointsHeaderValid_Internal(*PointsHeader, OldPoints ? OldPoints->Num() : 0)
+            || !CanRead_Internal(RecordEnd, End, Align(static_cast<int64>(PointsHeader->Bytes), 4)))
+            return false;
+
+        PointsScratch.SetNumUninitialized(PointsHeader->Count * 3, false);
+        if (!DecodePoints(RecordEnd, PointsHeader->Bytes, PointsHeader->Count, PointsScratch.GetData()))
+            return false;
+        RecordEnd += Align(static_cast<int64>(PointsHeader->Bytes), 4);
+    }
+
+    if (KeyframeIds)
+        KeyframeIds->Add(Record.Id);
+
+    UShapesVisualizerComponent*& Component = ReplayComponents.FindOrAdd(Record.Id);
+    if (!Component)
+    {
+        Component = NewObject<UShapesVisualizerComponent>(this, NAME_None, RF_Transient);
+        Component->RegisterComponentWithWorld(GetWorld());
+    }
+
+    if (Record.Fields & FieldTransform)
+    {
+        const FTransformField& Field = Read_Internal<FTransformField>(Cursor);
+        Component->SetWorldTransform(FTransform{
+            FQuat{ Field.Rotation[0], Field.Rotation[1], Field.Rotation[2], Field.Rotation[3] },
+            FVector{ Field.Location[0], Field.Location[1], Field.Location[2] },
+            FVector{ Field.Scale[0], Field.Scale[1], Field.Scale[2] } });
+    }
+
+    EVisualShape PointsShape = Component->Shape;
+    if (Record.Fields & FieldShape)
+    {
+        const FShapeField& Field = Read_Internal<FShapeField>(Cursor);
+        const EVisualShape Shape = static_cast<EVisualShape>(Field.Shape);
+        if (IsPointsShape_Internal(Shape))
+        {
+            // The points field follows with the shape
+            PointsShape = Shape;
+            Component->Radii = Field.Radii;
+            Component->UpdateBounds();
+            Component->MarkRenderStateDirty();
+        }
+        else
+        {
+            Component->SetSizedShape(Shape, Field.Radii, Field.Height, FVector{ Field.Extent[0], Field.Extent[1], Field.Extent[2] });
+        }
+    }
+
+    if (Record.Fields & FieldAppearance)
+    {
+        const FAppearanceField& Field = Read_Internal<FAppearanceField>(Cursor);
+        Component->SetColor(FColor{ Field.Color });
+        Component->SetWireframe((Field.Flags & FlagWireframe) != 0, Field.LineThickness);
+        Component->SetNumSides(Field.NumSides);
+        Component->SetVisibility((Field.Flags & FlagVisible) != 0);
+        Component->SetHiddenInGame((Field.Flags & FlagHiddenInGame) != 0);
+    }
+    Cursor = RecordEnd;
+
+    if (PointsHeader)
+    {
+        const FPointsHeader& Header = *PointsHeader;
+        TArray<FVector>& Points = ReplayPoints.FindOrAdd(Record.Id);
+        const int32 OldNumPoints = Points.Num();
+        Points.SetNum(Header.NumPoints, false);
+        const double Step = ReplayFile->GetPointStep();
+        for (int32 Index = 0; Index < Header.Count; Index++)
+        {
+            const int32* const Point = PointsScratch.GetData() + Index * 3;
+            Points[Header.StartIndex + Index] = FVector{ Point[0] * Step, Point[1] * Step, Point[2] * Step };
+        }
+
+        // Trails and new shapes are set whole, plain points get only the changed run
+        const bool SetWhole = Component->Shape != PointsShape || Header.TrailHead != 0
+            || (Header.StartIndex == 0 && Header.Count == Header.NumPoints);
+        if (SetWhole)
+        {
+            TArray<FVector> NewPoints{ Points };
+            if (Header.TrailHead != 0)
+                Algo::Rotate(NewPoints, Header.TrailHead);
+            if (PointsShape == EVisualShape::Polyline)
+                Component->SetPolylineShape(MoveTemp(NewPoints));
+            else
+                Component->SetPointsShape(MoveTemp(NewPoints));
+        }
+        else
+        {
+            if (Header.NumPoints < OldNumPoints)
+                Component->RemovePointRange(Header.NumPoints, OldNumPoints - Header.NumPoints);
+            if (Header.Count > 0)
+                Component->UpdatePointRange(Header.StartIndex, TArray<FVector>{ Points.GetData() + Header.StartIndex, Header.Count });
+        }
+    }
+    return true;
+}
+
+void UShapesVisualizerRecorder::DestroyReplayComponents()
+{
+    for (TPair<int32, UShapesVisualizerComponent*>& Pair : ReplayComponents)
+    {
+        if (Pair.Value)
+            Pair.Value->DestroyComponent();
+    }
+    ReplayComponents.Reset();
+    ReplayPoints.Reset();
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShapesVisualizerRecording.h"
+#include "ShapesVisualizerRecorder.generated.h"
+
+class UShapesVisualizerComponent;
+
+//
+// UShapesVisualizerRecorder - recording and replay of the visualizers of the world
+//
+// Recording captures every registered UShapesVisualizerComponent of the world once per frame.
+// Only the changed fields of the changed components are written, points quantized and delta
+// encoded as the run between the first and the last changed point, a keyframe with the full
+// state follows every few seconds. The file is written on a background thread, frames are dropped
+// while it is too far behind. Replay maps the file into memory and applies its frames in world
+// time to components of its own, damaged records end the replay of their frame.
+// Console: ShapesVisualizer.Record [File], ShapesVisualizer.Replay File, ShapesVisualizer.Stop
+//
+
+UCLASS()
+class UShapesVisualizerRecorder : public UWorldSubsystem, public FTickableGameObject
+{
+    GENERATED_BODY()
+
+public:
+
+    // Relative names go to Saved/ShapesVisualizer, an empty name is made of the date
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer")
+    bool StartRecording(const FString& FileName);
+
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer")
+    bool StartReplay(const FString& FileName);
+
+    // Moves the replay to Time seconds from its start
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer")
+    void SeekReplay(float Time);
+
+    // Ends the recording or the replay, the replayed components are destroyed
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer")
+    void Stop();
+
+    UFUNCTION(BlueprintPure, Category = "ShapesVisualizer")
+    bool IsRecording() const { return Writer.IsValid(); }
+
+    UFUNCTION(BlueprintPure, Category = "ShapesVisualizer")
+    bool IsReplaying() const { return ReplayFile.IsValid(); }
+
+    // USubsystem Interface
+
+    virtual void Deinitialize() override;
+
+    // FTickableGameObject Interface
+
+    virtual void Tick(float DeltaTime) override;
+    virtual ETickableTickType GetTickableTickType() const override;
+    virtual bool IsTickableInEditor() const override { return true; }
+    virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+    virtual TStatId GetStatId() const override;
+
+private:
+
+    // Last written fields of a recorded component
+    struct FRecordedState
+    {
+        int32 Id = 0;
+        ShapesVisualizerRecording::FTransformField Transform;
+        ShapesVisualizerRecording::FShapeField Shape;
+        ShapesVisualizerRecording::FAppearanceField Appearance;
+        uint32 PointsSerial = 0;
+        int32 TrailHead = 0;
+        // Quantized, 3 per point
+        TArray<int32> Points;
+        bool Seen = false;
+    };
+
+    void RecordFrame();
+    // Writes the changed fields of the component, all of them if Full. False if nothing changed
+    bool RecordComponent(const UShapesVisualizerComponent& Component, FRecordedState& State, bool Full);
+    // Applies frames (FirstFrame, LastFrame]
+    void ReplayFrames(int32 FirstFrame, int32 LastFrame);
+    // False if the record is damaged or runs past End, nothing of it is applied then
+    bool ReplayRecord(const uint8*& Cursor, const uint8* End, TSet<int32>* KeyframeIds);
+    void DestroyReplayComponents();
+
+private:
+
+    // Recording
+    TUniquePtr<FShapesVisualizerRecordWriter> Writer;
+    TMap<TWeakObjectPtr<UShapesVisualizerComponent>, FRecordedState> RecordedStates;
+    TArray<uint8> FrameBuffer;
+    // Quantized points of the current component as written to or read from the file
+    TArray<int32> PointsScratch;
+    float PointStep = 1.f;
+    int32 NextId = 0;
+    int32 NumRecordedFrames = 0;
+    int32 NumDroppedFrames = 0;
+    // Frames were dropped, the next one has to be a keyframe
+    bool ForceKeyframe = false;
+    float RecordStartTime = 0.f;
+
+    // Replay
+    TUniquePtr<FShapesVisualizerReplayFile> ReplayFile;
+    // Recorded storage of the points, trails are given to the components from the oldest point
+    TMap<int32, TArray<FVector>> ReplayPoints;
+    int32 ReplayFrame = INDEX_NONE;
+    float ReplayTime = 0.f;
+
+    UPROPERTY(Transient)
+    TMap<int32, UShapesVisualizerComponent*> ReplayComponents;
+};
@@ -0,0 +1,260 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerRecording.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/Paths.h"
+
+using namespace ShapesVisualizerRecording;
+
+static_assert(sizeof(FFrameHeader) % 4 == 0 && sizeof(FRecordHeader) % 4 == 0 && sizeof(FTransformField) % 4 == 0
+    && sizeof(FShapeField) % 4 == 0 && sizeof(FAppearanceField) % 4 == 0 && sizeof(FPointsHeader) % 4 == 0,
+    "Recording blocks keep 4 byte alignment");
+
+//
+// Console variables
+//
+
+static TAutoConsoleVariable<int32> CVarShapesVisualizerRecordMaxQueuedMB(
+    TEXT("r.ShapesVisualizer.Record.MaxQueuedMB"),
+    64,
+    TEXT("Megabytes of recorded frames waiting for the disk before the recorder drops frames.\n")
+    TEXT("The first frame after the drop is a keyframe, so the replay stays consistent."),
+    ECVF_Default);
+
+//
+// Point encoding
+//
+
+int32 ShapesVisualizerRecording::EncodePoints(TArrayView<const int32> Quantized, TArray<uint8>& OutData)
+{
+    // Five bytes hold any 32 bit varint
+    const int32 StartSize = OutData.Num();
+    OutData.AddUninitialized(Quantized.Num() * 5 + 3);
+    uint8* Out = OutData.GetData() + StartSize;
+
+    uint32 Previous[3] = {};
+    for (int32 Index = 0; Index < Quantized.Num(); Index++)
+    {
+        // Differences wrap around like the decoder adds them, zigzag keeps small negative ones short
+        const uint32 Value = static_cast<uint32>(Quantized[Index]);
+        const int32 Delta = static_cast<int32>(Value - Previous[Index % 3]);
+        Previous[Index % 3] = Value;
+        uint32 ZigZag = (static_cast<uint32>(Delta) << 1) ^ static_cast<uint32>(Delta >> 31);
+        while (ZigZag >= 0x80)
+        {
+            *Out++ = static_cast<uint8>(ZigZag | 0x80);
+            ZigZag >>= 7;
+        }
+        *Out++ = static_cast<uint8>(ZigZag);
+    }
+
+    const int32 Bytes = static_cast<int32>(Out - (OutData.GetData() + StartSize));
+    const int32 Padded = Align(Bytes, 4);
+    FMemory::Memzero(Out, Padded - Bytes);
+    OutData.SetNum(StartSize + Padded, false);
+    return Bytes;
+}
+
+bool ShapesVisualizerRecording::DecodePoints(const uint8* Data, int32 Bytes, int32 Count, int32* OutQuantized)
+{
+    const uint8* const End = Data + Bytes;
+    uint32 Previous[3] = {};
+    for (int64 Index = 0; Index < static_cast<int64>(Count) * 3; Index++)
+    {
+        uint32 ZigZag = 0;
+        for (int32 Shift = 0;; Shift += 7)
+        {
+            if (Data == End || Shift > 28)
+                return false;
+            const uint8 Byte = *Data++;
+            ZigZag |= static_cast<uint32>(Byte & 0x7f) << Shift;
+            if (!(Byte & 0x80))
+                break;
+        }
+
+        const uint32 Delta = (ZigZag >> 1) ^ (0u - (ZigZag & 1));
+        Previous[Index % 3] += Delta;
+        OutQuantized[Index] = static_cast<int32>(Previous[Index % 3]);
+    }
+    return Data == End;
+}
+
+//
+// FShapesVisualizerRecordWriter
+//
+
+TUniquePtr<FShapesVisualizerRecordWriter> FShapesVisualizerRecordWriter::Create(const FString& FileName, float PointStep)
+{
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FileName));
+
+    TUniquePtr<IFileHandle> File{ PlatformFile.OpenWrite(*FileName) };
+    if (!File)
+        return nullptr;
+
+    const FFileHeader Header{ Magic, Version, PointStep };
+    if (!File->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header)))
+        return nullptr;
+
+    return TUniquePtr<FShapesVisualizerRecordWriter>{ new FShapesVisualizerRecordWriter(MoveTemp(File)) };
+}
+
+FShapesVisualizerRecordWriter::FShapesVisualizerRecordWriter(TUniquePtr<IFileHandle>&& InFile)
+    : File(MoveTemp(InFile))
+{
+    WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+    Thread = FRunnableThread::Create(this, TEXT("ShapesVisualizerRecordWriter"), 0, TPri_BelowNormal);
+}
+
+FShapesVisualizerRecordWriter::~FShapesVisualizerRecordWriter()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+void FShapesVisualizerRecordWriter::Write(TArray<uint8>&& Data)
+{
+    // No threads on this platform
+    if (!Thread)
+    {
+        File->Write(Data.GetData(), Data.Num());
+        return;
+    }
+
+    BytesQueued.fetch_add(Data.Num(), std::memory_order_relaxed);
+    Pending.Enqueue(MoveTemp(Data));
+    WorkEvent->Trigger();
+}
+
+bool FShapesVisualizerRecordWriter::IsFull() const
+{
+    return GetBytesQueued() > static_cast<int64>(FMath::Max(CVarShapesVisualizerRecordMaxQueuedMB.GetValueOnGameThread(), 1)) * 1024 * 1024;
+}
+
+uint32 FShapesVisualizerRecordWriter::Run()
+{
+    TArray<uint8> Data;
+    for (;;)
+    {
+        // Everything queued before the stop request is still written
+        const bool Stopped = Stopping.load();
+        while (Pending.Dequeue(Data))
+        {
+            File->Write(Data.GetData(), Data.Num());
+            BytesQueued.fetch_sub(Data.Num(), std::memory_order_relaxed);
+        }
+        if (Stopped)
+            break;
+
+        WorkEvent->Wait();
+    }
+
+    File->Flush();
+    return 0;
+}
+
+void FShapesVisualizerRecordWriter::Stop()
+{
+    Stopping.store(true);
+    WorkEvent->Trigger();
+}
+
+//
+// FShapesVisualizerReplayFile
+//
+
+TUniquePtr<FShapesVisualizerReplayFile> FShapesVisualizerReplayFile::Open(const FString& FileName)
+{
+    TUniquePtr<FShapesVisualizerReplayFile> Replay{ new FShapesVisualizerReplayFile };
+    Replay->Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FileName));
+    if (!Replay->Handle || Replay->Handle->GetFileSize() < static_cast<int64>(sizeof(FFileHeader)))
+        return nullptr;
+
+    Replay->Region.Reset(Replay->Handle->MapRegion());
+    if (!Replay->Region)
+        return nullptr;
+
+    Replay->Data = Replay->Region->GetMappedPtr();
+    const int64 Size = Replay->Region->GetMappedSize();
+
+    if (Size < static_cast<int64>(sizeof(FFileHeader)))
+        return nullptr;
+    const FFileHeader& Header = *reinterpret_cast<const FFileHeader*>(Replay->Data);
+    if (Header.Magic != Magic || Header.Version != Version || !(Header.PointStep > 0.f))
+        return nullptr;
+    Replay->PointStep = Header.PointStep;
+
+    // An interrupted recording may end with a partial frame, it is left out
+    int64 Offset = sizeof(FFileHeader);
+    while (Offset + static_cast<int64>(sizeof(FFrameHeader)) <= Size)
+    {
+        // Records are read in place, a frame which would break their alignment is damaged
+        const FFrameHeader& Frame = *reinterpret_cast<const FFrameHeader*>(Replay->Data + Offset);
+        const int64 NextOffset = Offset + sizeof(FFrameHeader) + Frame.Size;
+        if (NextOffset > Size || Frame.Size % 4 != 0)
+            break;
+
+        if (Frame.Keyframe)
+            Replay->Keyframes.Add(Replay->FrameOffsets.Num());
+        Replay->FrameOffsets.Add(Offset);
+        Offset = NextOffset;
+    }
+    return Replay;
+}
+
+FShapesVisualizerReplayFile::~FShapesVisualizerReplayFile()
+{
+    // The region goes before its file
+    Region.Reset();
+    Handle.Reset();
+}
+
+const FFrameHeader& FShapesVisualizerReplayFile::GetFrame(int32 FrameIndex) const
+{
+    return *reinterpret_cast<const FFrameHeader*>(Data + FrameOffsets[FrameIndex]);
+}
+
+const uint8* FShapesVisualizerReplayFile::GetFrameData(int32 FrameIndex) const
+{
+    return Data + FrameOffsets[FrameIndex] + sizeof(FFrameHeader);
+}
+
+const uint8* FShapesVisualizerReplayFile::GetFrameEnd(int32 FrameIndex) const
+{
+    return GetFrameData(FrameIndex) + GetFrame(FrameIndex).Size;
+}
+
+int32 FShapesVisualizerReplayFile::FindFrame(float Time) const
+{
+    int32 First = 0;
+    int32 Count = FrameOffsets.Num();
+    while (Count > 0)
+    {
+        const int32 Half = Count / 2;
+        if (GetFrame(First + Half).Time <= Time)
+        {
+            First += Half + 1;
+            Count -= Half + 1;
+        }
+        else
+        {
+            Count = Half;
+        }
+    }
+    return First - 1;
+}
+
+int32 FShapesVisualizerReplayFile::FindKeyframe(int32 FrameIndex) const
+{
+    const int32 Index = Algo::UpperBound(Keyframes, FrameIndex) - 1;
+    return Index >= 0 ? Keyframes[Index] : INDEX_NONE;
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//
+// ShapesVisualizerRecording - binary format of the visualizer recordings
+//
+// The file header is followed by frames. A frame is FFrameHeader and NumRecords records, a record
+// is FRecordHeader and the fields of its Fields mask in the order of EField. The points field is
+// FPointsHeader and the run [StartIndex, StartIndex + Count) of the NumPoints points in storage
+// order. Points are quantized to multiples of the PointStep of the file header and every coordinate
+// is stored as the zigzag varint of its difference to the previous point of the run, Bytes bytes
+// padded to 4. Every block is a multiple of 4 bytes, so a mapped file is read in place. Keyframes
+// hold all fields of every live component.
+//
+
+namespace ShapesVisualizerRecording
+{
+    constexpr uint32 Magic = 0x43525653; // SVRC
+    constexpr uint32 Version = 2;
+    constexpr int32 KeyframeInterval = 300;
+
+    enum EField : uint32
+    {
+        FieldTransform = 1 << 0,
+        FieldShape = 1 << 1,
+        FieldAppearance = 1 << 2,
+        FieldPoints = 1 << 3,
+        // The component is gone, no other fields
+        FieldRemoved = 1 << 4,
+        FieldAll = FieldTransform | FieldShape | FieldAppearance | FieldPoints
+    };
+
+    enum EFlag : uint32
+    {
+        FlagWireframe = 1 << 0,
+        FlagVisible = 1 << 1,
+        FlagHiddenInGame = 1 << 2
+    };
+
+    struct FFileHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        // Size of the point quantization grid
+        float PointStep;
+    };
+
+    struct FFrameHeader
+    {
+        // Bytes of the records after the header
+        uint32 Size;
+        float Time;
+        uint32 NumRecords;
+        uint32 Keyframe;
+    };
+
+    struct FRecordHeader
+    {
+        int32 Id;
+        uint32 Fields;
+    };
+
+    struct FTransformField
+    {
+        float Location[3];
+        float Rotation[4];
+        float Scale[3];
+    };
+
+    struct FShapeField
+    {
+        uint32 Shape;
+        float Radii;
+        float Height;
+        float Extent[3];
+    };
+
+    struct FAppearanceField
+    {
+        uint32 Color;
+        uint32 Flags;
+        float LineThickness;
+        int32 NumSides;
+    };
+
+    struct FPointsHeader
+    {
+        int32 NumPoints;
+        int32 StartIndex;
+        int32 Count;
+        int32 TrailHead;
+        // Encoded run without the padding
+        int32 Bytes;
+    };
+
+    FORCEINLINE int32 QuantizeCoordinate(double Value, float PointStep)
+    {
+        return static_cast<int32>(FMath::Clamp<double>(FMath::RoundToDouble(Value / PointStep), MIN_int32, MAX_int32));
+    }
+
+    // Appends the delta varints of the quantized points (3 per point) and the padding, returns the bytes without it
+    int32 EncodePoints(TArrayView<const int32> Quantized, TArray<uint8>& OutData);
+    // Decodes Count points from the Bytes bytes of Data, false if they are not exactly Count points
+    bool DecodePoints(const uint8* Data, int32 Bytes, int32 Count, int32* OutQuantized);
+}
+
+//
+// FShapesVisualizerRecordWriter - appends the frames to the file on its own thread
+//
+
+class FShapesVisualizerRecordWriter : public FRunnable
+{
+public:
+
+    // Null if the file cannot be created
+    static TUniquePtr<FShapesVisualizerRecordWriter> Create(const FString& FileName, float PointStep);
+    // Writes the queued frames and closes the file
+    virtual ~FShapesVisualizerRecordWriter() override;
+
+    // Game thread
+    void Write(TArray<uint8>&& Data);
+    // The file falls behind by more than r.ShapesVisualizer.Record.MaxQueuedMB, the recorder drops frames then
+    bool IsFull() const;
+    int64 GetBytesQueued() const { return BytesQueued.load(std::memory_order_relaxed); }
+
+    // FRunnable Interface
+
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+
+    FShapesVisualizerRecordWriter(TUniquePtr<IFileHandle>&& InFile);
+
+private:
+
+    TUniquePtr<IFileHandle> File;
+    TQueue<TArray<uint8>, EQueueMode::Spsc> Pending;
+    FEvent* WorkEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> Stopping{ false };
+    // Queued and not yet written
+    std::atomic<int64> BytesQueued{ 0 };
+};
+
+//
+// FShapesVisualizerReplayFile - memory mapped recording
+//
+// Only the frame headers are visited on open to index the frames, the records
+// are read in place from the mapping when the frames are replayed.
+//
+
+class FShapesVisualizerReplayFile
+{
+public:
+
+    // Null if the file is missing or not a recording
+    static TUniquePtr<FShapesVisualizerReplayFile> Open(const FString& FileName);
+    ~FShapesVisualizerReplayFile();
+
+    int32 GetNumFrames() const { return FrameOffsets.Num(); }
+    float GetPointStep() const { return PointStep; }
+    const ShapesVisualizerRecording::FFrameHeader& GetFrame(int32 FrameIndex) const;
+    // Records of the frame
+    const uint8* GetFrameData(int32 FrameIndex) const;
+    // End of the records of the frame, nothing of the frame is read past it
+    const uint8* GetFrameEnd(int32 FrameIndex) const;
+
+    // Last frame at or before Time, INDEX_NONE if Time is before the first frame
+    int32 FindFrame(float Time) const;
+    // Last keyframe at or before the frame
+    int32 FindKeyframe(int32 FrameIndex) const;
+
+private:
+
+    FShapesVisualizerReplayFile() = default;
+
+private:
+
+    TUniquePtr<IMappedFileHandle> Handle;
+    TUniquePtr<IMappedFileRegion> Region;
+    const uint8* Data = nullptr;
+    float PointStep = 1.f;
+    TArray<int64> FrameOffsets;
+    TArray<int32> Keyframes;
+};
@@ -0,0 +1,206 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerStats.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include <atomic>
+
+DEFINE_STAT(STAT_ShapesVisualizer_GetDynamicMeshElements);
+DEFINE_STAT(STAT_ShapesVisualizer_CreateSceneProxy);
+DEFINE_STAT(STAT_ShapesVisualizer_CalcBounds);
+DEFINE_STAT(STAT_ShapesVisualizer_FlushCommands);
+DEFINE_STAT(STAT_ShapesVisualizer_ImmediateShapes);
+DEFINE_STAT(STAT_ShapesVisualizer_Record);
+DEFINE_STAT(STAT_ShapesVisualizer_Replay);
+DEFINE_STAT(STAT_ShapesVisualizer_LoadPoints);
+DEFINE_STAT(STAT_ShapesVisualizer_Replication);
+DEFINE_STAT(STAT_ShapesVisualizer_BuildBatchMesh);
+
+#define SHAPESVISUALIZER_DEFINE_SHAPE_STATS(Shape) \
+    DEFINE_STAT(STAT_ShapesVisualizer_Proxies_##Shape); \
+    DEFINE_STAT(STAT_ShapesVisualizer_Lines_##Shape); \
+    DEFINE_STAT(STAT_ShapesVisualizer_Triangles_##Shape); \
+    DEFINE_STAT(STAT_ShapesVisualizer_Points_##Shape); \
+    DEFINE_STAT(STAT_ShapesVisualizer_Memory_##Shape);
+
+SHAPESVISUALIZER_STAT_SHAPES(SHAPESVISUALIZER_DEFINE_SHAPE_STATS)
+
+DEFINE_STAT(STAT_ShapesVisualizer_Proxies_Batch);
+DEFINE_STAT(STAT_ShapesVisualizer_Memory_Batch);
+DEFINE_STAT(STAT_ShapesVisualizer_NetBytes);
+DEFINE_STAT(STAT_ShapesVisualizer_BudgetPrimitives);
+DEFINE_STAT(STAT_ShapesVisualizer_BudgetMicroseconds);
+DEFINE_STAT(STAT_ShapesVisualizer_DeferredProxies);
+
+UE_TRACE_CHANNEL_DEFINE(ShapesVisualizerChannel);
+
+UE_TRACE_EVENT_BEGIN(ShapesVisualizer, Memory)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    // EVisualShape, BatchShape_Internal for the batch proxies
+    UE_TRACE_EVENT_FIELD(uint8, Shape)
+    UE_TRACE_EVENT_FIELD(int64, Bytes)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(ShapesVisualizer, Draw)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, Lines)
+    UE_TRACE_EVENT_FIELD(uint32, Triangles)
+    UE_TRACE_EVENT_FIELD(uint32, Points)
+UE_TRACE_EVENT_END()
+
+//
+// Internal functions
+//
+
+namespace
+{
+    constexpr uint8 BatchShape_Internal = 0xFF;
+
+    // Memory of the live proxies per EVisualShape and of the batch proxies last, for the trace events
+    std::atomic<int64> MemoryBytes_Internal[FShapesVisualizerFrameStats::NumShapes + 1];
+
+    void TraceMemory_Internal(uint8 Shape, int32 Slot, int64 DeltaBytes)
+    {
+        const int64 Bytes = MemoryBytes_Internal[Slot].fetch_add(DeltaBytes) + DeltaBytes;
+        UE_TRACE_LOG(ShapesVisualizer, Memory, ShapesVisualizerChannel)
+            << Memory.Cycle(FPlatformTime::Cycles64())
+            << Memory.Shape(Shape)
+            << Memory.Bytes(Bytes);
+    }
+}
+
+#if STATS
+
+namespace
+{
+    static_assert(FShapesVisualizerFrameStats::NumShapes == static_cast<int32>(EVisualShape::Grid) + 1,
+        "FShapesVisualizerFrameStats must cover every EVisualShape");
+
+    // Stat names indexed by EVisualShape
+    struct FShapeStatNames_Internal
+    {
+#define SHAPESVISUALIZER_STAT_NAME(Prefix) \
+    GET_STATFNAME(Prefix##Sphere), GET_STATFNAME(Prefix##HalfSphere), GET_STATFNAME(Prefix##Box), GET_STATFNAME(Prefix##Cylinder), \
+    GET_STATFNAME(Prefix##Cone), GET_STATFNAME(Prefix##Capsule), GET_STATFNAME(Prefix##Points), GET_STATFNAME(Prefix##Polyline), \
+    GET_STATFNAME(Prefix##Grid)
+
+        FName Proxies[FShapesVisualizerFrameStats::NumShapes] = { SHAPESVISUALIZER_STAT_NAME(STAT_ShapesVisualizer_Proxies_) };
+        FName Lines[FShapesVisualizerFrameStats::NumShapes] = { SHAPESVISUALIZER_STAT_NAME(STAT_ShapesVisualizer_Lines_) };
+        FName Triangles[FShapesVisualizerFrameStats::NumShapes] = { SHAPESVISUALIZER_STAT_NAME(STAT_ShapesVisualizer_Triangles_) };
+        FName Points[FShapesVisualizerFrameStats::NumShapes] = { SHAPESVISUALIZER_STAT_NAME(STAT_ShapesVisualizer_Points_) };
+        FName Memory[FShapesVisualizerFrameStats::NumShapes] = { SHAPESVISUALIZER_STAT_NAME(STAT_ShapesVisualizer_Memory_) };
+
+#undef SHAPESVISUALIZER_STAT_NAME
+    };
+
+    const FShapeStatNames_Internal& GetShapeStatNames_Internal()
+    {
+        static const FShapeStatNames_Internal Names;
+        return Names;
+    }
+
+    FORCEINLINE void IncStats_Internal(const FName (&Names)[FShapesVisualizerFrameStats::NumShapes],
+        const uint32 (&Values)[FShapesVisualizerFrameStats::NumShapes])
+    {
+        for (int32 ShapeIndex = 0; ShapeIndex < FShapesVisualizerFrameStats::NumShapes; ShapeIndex++)
+        {
+            if (Values[ShapeIndex] > 0)
+                INC_DWORD_STAT_BY_FName(Names[ShapeIndex], Values[ShapeIndex]);
+        }
+    }
+}
+
+#endif // STATS
+
+//
+// FShapesVisualizerAllocationScope
+//
+
+#if WITH_DEV_AUTOMATION_TESTS
+thread_local int32 FShapesVisualizerAllocationScope::Depth = 0;
+#endif
+
+//
+// FShapesVisualizerFrameStats
+//
+
+void FShapesVisualizerFrameStats::Flush()
+{
+#if STATS
+    const FShapeStatNames_Internal& Names = GetShapeStatNames_Internal();
+    IncStats_Internal(Names.Lines, Lines);
+    IncStats_Internal(Names.Triangles, Triangles);
+    IncStats_Internal(Names.Points, Points);
+#endif
+
+    uint32 NumLines = 0;
+    uint32 NumTriangles = 0;
+    uint32 NumPoints = 0;
+    for (int32 ShapeIndex = 0; ShapeIndex < NumShapes; ShapeIndex++)
+    {
+        NumLines += Lines[ShapeIndex];
+        NumTriangles += Triangles[ShapeIndex];
+        NumPoints += Points[ShapeIndex];
+    }
+    UE_TRACE_LOG(ShapesVisualizer, Draw, ShapesVisualizerChannel)
+        << Draw.Cycle(FPlatformTime::Cycles64())
+        << Draw.Lines(NumLines)
+        << Draw.Triangles(NumTriangles)
+        << Draw.Points(NumPoints);
+
+    *this = FShapesVisualizerFrameStats{};
+}
+
+//
+// ShapesVisualizerStats
+//
+
+void ShapesVisualizerStats::AddProxy(EVisualShape Shape)
+{
+#if STATS
+    INC_DWORD_STAT_FName(GetShapeStatNames_Internal().Proxies[static_cast<int32>(Shape)]);
+#endif
+}
+
+void ShapesVisualizerStats::RemoveProxy(EVisualShape Shape)
+{
+#if STATS
+    DEC_DWORD_STAT_FName(GetShapeStatNames_Internal().Proxies[static_cast<int32>(Shape)]);
+#endif
+}
+
+void ShapesVisualizerStats::AddBatchProxy()
+{
+    INC_DWORD_STAT(STAT_ShapesVisualizer_Proxies_Batch);
+}
+
+void ShapesVisualizerStats::RemoveBatchProxy()
+{
+    DEC_DWORD_STAT(STAT_ShapesVisualizer_Proxies_Batch);
+}
+
+void ShapesVisualizerStats::AddProxyMemory(EVisualShape Shape, int64 DeltaBytes)
+{
+    if (DeltaBytes == 0)
+        return;
+
+#if STATS
+    const FName StatName = GetShapeStatNames_Internal().Memory[static_cast<int32>(Shape)];
+    if (DeltaBytes > 0)
+        INC_MEMORY_STAT_BY_FName(StatName, DeltaBytes);
+    else
+        DEC_MEMORY_STAT_BY_FName(StatName, -DeltaBytes);
+#endif
+    TraceMemory_Internal(static_cast<uint8>(Shape), static_cast<int32>(Shape), DeltaBytes);
+}
+
+void ShapesVisualizerStats::AddBatchMemory(int64 DeltaBytes)
+{
+    if (DeltaBytes == 0)
+        return;
+
+    if (DeltaBytes > 0)
+        INC_MEMORY_STAT_BY(STAT_ShapesVisualizer_Memory_Batch, DeltaBytes);
+    else
+        DEC_MEMORY_STAT_BY(STAT_ShapesVisualizer_Memory_Batch, -DeltaBytes);
+    TraceMemory_Internal(BatchShape_Internal, FShapesVisualizerFrameStats::NumShapes, DeltaBytes);
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+enum class EVisualShape : uint8;
+
+//
+// stat ShapesVisualizer - cost of the components and their scene proxies
+//
+// Cycle stats cover proxy creation, CalcBounds, GetDynamicMeshElements, the command queue,
+// the immediate shapes, the recorder, the point cloud loader, the replication and the merged batch meshes. Counters are per frame and split by EVisualShape,
+// only the live proxies and their memory are kept between frames. The memory is counted when a proxy is created,
+// changed by the component and destroyed, never while drawing.
+// The cycle scopes are also CPU events of the ShapesVisualizer trace channel (-trace=cpu,ShapesVisualizer),
+// which also gets the ShapesVisualizer.Memory events with the memory per shape type and a
+// ShapesVisualizer.Draw event with the counters of every drawn proxy.
+//
+
+DECLARE_STATS_GROUP(TEXT("ShapesVisualizer"), STATGROUP_ShapesVisualizer, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetDynamicMeshElements"), STAT_ShapesVisualizer_GetDynamicMeshElements, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CreateSceneProxy"), STAT_ShapesVisualizer_CreateSceneProxy, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CalcBounds"), STAT_ShapesVisualizer_CalcBounds, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flush Commands"), STAT_ShapesVisualizer_FlushCommands, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Immediate Shapes"), STAT_ShapesVisualizer_ImmediateShapes, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Record"), STAT_ShapesVisualizer_Record, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replay"), STAT_ShapesVisualizer_Replay, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load Points"), STAT_ShapesVisualizer_LoadPoints, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replication"), STAT_ShapesVisualizer_Replication, STATGROUP_ShapesVisualizer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Batch Mesh"), STAT_ShapesVisualizer_BuildBatchMesh, STATGROUP_ShapesVisualizer, );
+
+// Op(Shape) for every EVisualShape, in the enum order
+#define SHAPESVISUALIZER_STAT_SHAPES(Op) \
+    Op(Sphere) Op(HalfSphere) Op(Box) Op(Cylinder) Op(Cone) Op(Capsule) Op(Points) Op(Polyline) Op(Grid)
+
+#define SHAPESVISUALIZER_DECLARE_SHAPE_STATS(Shape) \
+    DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT(#Shape " Proxies"), STAT_ShapesVisualizer_Proxies_##Shape, STATGROUP_ShapesVisualizer, ); \
+    DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT(#Shape " Lines"), STAT_ShapesVisualizer_Lines_##Shape, STATGROUP_ShapesVisualizer, ); \
+    DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT(#Shape " Triangles"), STAT_ShapesVisualizer_Triangles_##Shape, STATGROUP_ShapesVisualizer, ); \
+    DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT(#Shape " Points"), STAT_ShapesVisualizer_Points_##Shape, STATGROUP_ShapesVisualizer, ); \
+    DECLARE_MEMORY_STAT_EXTERN(TEXT(#Shape " Memory Footprint"), STAT_ShapesVisualizer_Memory_##Shape, STATGROUP_ShapesVisualizer, );
+
+SHAPESVISUALIZER_STAT_SHAPES(SHAPESVISUALIZER_DECLARE_SHAPE_STATS)
+
+// Batch proxies hold mixed shapes, their lines and triangles go to the shapes above
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Batch Proxies"), STAT_ShapesVisualizer_Proxies_Batch, STATGROUP_ShapesVisualizer, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Batch Memory Footprint"), STAT_ShapesVisualizer_Memory_Batch, STATGROUP_ShapesVisualizer, );
+
+// Replicated state and points written to the connections, every connection counts
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Bytes"), STAT_ShapesVisualizer_NetBytes, STATGROUP_ShapesVisualizer, );
+
+// Spent budget of the drawn proxies and the proxies left for the next frames
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Budget Primitives"), STAT_ShapesVisualizer_BudgetPrimitives, STATGROUP_ShapesVisualizer, );
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Budget Microseconds"), STAT_ShapesVisualizer_BudgetMicroseconds, STATGROUP_ShapesVisualizer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Deferred Proxies"), STAT_ShapesVisualizer_DeferredProxies, STATGROUP_ShapesVisualizer, );
+
+UE_TRACE_CHANNEL_EXTERN(ShapesVisualizerChannel);
+
+// Cycle stat of stat ShapesVisualizer and the CPU event of the ShapesVisualizer trace channel
+#define SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(Stat) \
+    SCOPE_CYCLE_COUNTER(Stat); \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, ShapesVisualizerChannel)
+
+//
+// FShapesVisualizerFrameStats - counters of one GetDynamicMeshElements call
+//
+// Summed locally and sent to the stats system once by Flush, so big batches
+// do not post a stat message for every shape.
+//
+
+struct FShapesVisualizerFrameStats
+{
+    static constexpr int32 NumShapes = 9;
+
+    uint32 Lines[NumShapes] = {};
+    uint32 Triangles[NumShapes] = {};
+    uint32 Points[NumShapes] = {};
+
+    // Lines of the wireframe shapes, triangles of the solid ones
+    FORCEINLINE void AddPrimitives(EVisualShape Shape, bool Wireframe, int32 Count)
+    {
+        (Wireframe ? Lines : Triangles)[static_cast<int32>(Shape)] += Count;
+    }
+
+    FORCEINLINE void AddPoints(EVisualShape Shape, int32 Count)
+    {
+        Points[static_cast<int32>(Shape)] += Count;
+    }
+
+    uint32 GetNumPrimitives() const
+    {
+        uint32 NumPrimitives = 0;
+        for (int32 ShapeIndex = 0; ShapeIndex < NumShapes; ShapeIndex++)
+            NumPrimitives += Lines[ShapeIndex] + Triangles[ShapeIndex];
+        return NumPrimitives;
+    }
+
+    void Flush();
+};
+
+//
+// FShapesVisualizerAllocationScope - heap allocations the proxies make while they draw
+//
+// The allocation test counts the allocations of a thread inside a counted scope. The depth is per thread,
+// so the parallel loops open a scope of the same kind in their tasks. Everything a drawing proxy asks for
+// is counted, the mesh batches and one frame resources of the collector and the stat messages as well.
+// Only built with the automation tests.
+//
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+struct FShapesVisualizerAllocationScope
+{
+    explicit FShapesVisualizerAllocationScope(bool Counted)
+        : SavedDepth(Depth)
+    {
+        Depth = Counted ? Depth + 1 : 0;
+    }
+
+    ~FShapesVisualizerAllocationScope()
+    {
+        Depth = SavedDepth;
+    }
+
+    static bool IsCounting() { return Depth > 0; }
+
+private:
+
+    int32 SavedDepth;
+    static thread_local int32 Depth;
+};
+
+#define SHAPESVISUALIZER_COUNT_ALLOCATIONS(Counted) \
+    const FShapesVisualizerAllocationScope ANONYMOUS_VARIABLE(AllocationScope){ Counted }
+#define SHAPESVISUALIZER_IS_COUNTING_ALLOCATIONS() FShapesVisualizerAllocationScope::IsCounting()
+
+#else
+
+#define SHAPESVISUALIZER_COUNT_ALLOCATIONS(Counted) (void)(Counted)
+#define SHAPESVISUALIZER_IS_COUNTING_ALLOCATIONS() false
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+namespace ShapesVisualizerStats
+{
+    // Live proxies, the batch proxies are counted apart from the shapes
+    void AddProxy(EVisualShape Shape);
+    void RemoveProxy(EVisualShape Shape);
+    void AddBatchProxy();
+    void RemoveBatchProxy();
+
+    // Memory footprint of a live proxy changed by DeltaBytes, proxies remove what they added when destroyed
+    void AddProxyMemory(EVisualShape Shape, int64 DeltaBytes);
+    void AddBatchMemory(int64 DeltaBytes);
+}
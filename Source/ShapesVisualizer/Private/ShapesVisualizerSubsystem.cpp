@@ -0,0 +1,97 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerSubsystem.h"
+#include "Engine/World.h"
+#include "ShapesVisualizerStats.h"
+
+//
+// UShapesVisualizerSubsystem
+//
+
+void UShapesVisualizerSubsystem::DrawShape(EVisualShape Shape, const FTransform& Transform,
+    const FShapesVisualizerDrawParams& Params, float Duration)
+{
+    check(IsInGameThread());
+    if (Shape == EVisualShape::Points || Shape == EVisualShape::Polyline || Shape == EVisualShape::Grid)
+        return;
+
+    FShapesVisualizerBatchShape& BatchShape = Duration > 0.f
+        ? TimedShapes.AddDefaulted_GetRef()
+        : FrameShapes.AddDefaulted_GetRef();
+    BatchShape.Shape = Shape;
+    BatchShape.Transform = Transform;
+    BatchShape.Radii = Params.Radii;
+    BatchShape.Height = Params.Height;
+    BatchShape.Extent = Params.Extent;
+    BatchShape.Color = Params.Color;
+    BatchShape.Wireframe = Params.Wireframe;
+
+    if (Duration > 0.f)
+        ExpireTimes.Add(GetWorld()->GetTimeSeconds() + Duration);
+}
+
+void UShapesVisualizerSubsystem::ClearShapes()
+{
+    FrameShapes.Reset();
+    TimedShapes.Reset();
+    ExpireTimes.Reset();
+}
+
+void UShapesVisualizerSubsystem::Deinitialize()
+{
+    if (BatchComponent)
+    {
+        BatchComponent->DestroyComponent();
+        BatchComponent = nullptr;
+    }
+    Super::Deinitialize();
+}
+
+void UShapesVisualizerSubsystem::Tick(float DeltaTime)
+{
+    SHAPESVISUALIZER_SCOPE_CYCLE_COUNTER(STAT_ShapesVisualizer_ImmediateShapes);
+
+    // The expired shapes of the last frame are gone already
+    const bool IsEmpty = GetNumShapes() == 0;
+    if (IsEmpty && WasEmpty)
+        return;
+    WasEmpty = IsEmpty;
+
+    if (!BatchComponent)
+    {
+        // Not owned by any actor, like the line batchers of the world
+        BatchComponent = NewObject<UShapesVisualizerBatchComponent>(this, NAME_None, RF_Transient);
+        BatchComponent->SetHiddenInGame(false);
+        BatchComponent->RegisterComponentWithWorld(GetWorld());
+    }
+
+    BatchShapes.Reset();
+    int32 Index = 0;
+    for (const FShapesVisualizerBatchShape& Shape : TimedShapes)
+        BatchShapes.Set(Index++, Shape);
+    for (const FShapesVisualizerBatchShape& Shape : FrameShapes)
+        BatchShapes.Set(Index++, Shape);
+    BatchComponent->SetShapes(BatchShapes);
+
+    // Bulk expiry, the frame arena at once and the timed shapes by their lifetime
+    FrameShapes.Reset();
+    const float TimeSeconds = GetWorld()->GetTimeSeconds();
+    for (Index = TimedShapes.Num() - 1; Index >= 0; Index--)
+    {
+        if (ExpireTimes[Index] <= TimeSeconds)
+        {
+            TimedShapes.RemoveAtSwap(Index, 1, false);
+            ExpireTimes.RemoveAtSwap(Index, 1, false);
+        }
+    }
+}
+
+ETickableTickType UShapesVisualizerSubsystem::GetTickableTickType() const
+{
+    return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+TStatId UShapesVisualizerSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UShapesVisualizerSubsystem, STATGROUP_Tickables);
+}
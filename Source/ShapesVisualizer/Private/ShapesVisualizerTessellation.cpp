@@ -0,0 +1,436 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerTessellation.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace ShapesVisualizerTessellation;
+
+//
+// Internal functions
+//
+
+namespace
+{
+    constexpr float Pi_Internal = 3.1415926535897932f;
+    // Rings closer to the axis than this are poles
+    constexpr float PoleAngle_Internal = 1.e-4f;
+    // Rows per band of the triangle order, two columns of a band fit a 16 entry post transform cache
+    constexpr int32_t CacheBandRows_Internal = 7;
+
+    inline int32_t ClampSides_Internal(int32_t NumSides)
+    {
+        return std::min(std::max(NumSides, MinSides), MaxSides);
+    }
+
+    inline int32_t GetCapRings_Internal(int32_t NumSides)
+    {
+        return std::max(2, GetSphereRings(NumSides) / 2);
+    }
+
+    inline void Set_Internal(float Out[3], float X, float Y, float Z)
+    {
+        Out[0] = X;
+        Out[1] = Y;
+        Out[2] = Z;
+    }
+
+    inline FCounts GetCylinderCounts_Internal(int32_t NumSides, bool Cone)
+    {
+        // Cylinder has a ring at each end, fans on both caps and two triangles per side.
+        // Cone has one ring and the apex, a single fan and one triangle per side
+        const uint32_t Sides = ClampSides_Internal(NumSides);
+        return Cone
+            ? FCounts{ Sides + 1, 3 * (Sides - 2) + 3 * Sides }
+            : FCounts{ 2 * Sides, 6 * (Sides - 2) + 6 * Sides };
+    }
+
+    inline void AddTriangle_Internal(uint32_t*& OutIndices, uint32_t A, uint32_t B, uint32_t C)
+    {
+        *OutIndices++ = A;
+        *OutIndices++ = B;
+        *OutIndices++ = C;
+    }
+
+    // Cosines and sines of the yaws 2 * PI * s / Sides for s in [0, Sides], computed once per call
+    // and shared by every row or ring of the shape instead of the trig per vertex
+    struct FYawTable_Internal
+    {
+        float Cos[MaxSides + 1];
+        float Sin[MaxSides + 1];
+
+        explicit FYawTable_Internal(uint32_t Sides)
+        {
+            for (uint32_t s = 0; s <= Sides; s++)
+            {
+                const float Yaw = 2.f * Pi_Internal * s / Sides;
+                Cos[s] = std::cos(Yaw);
+                Sin[s] = std::sin(Yaw);
+            }
+        }
+    };
+
+    // Rings of a surface of revolution: polar angle from +Z, Z offset of the ring center and texture V
+    struct FRow_Internal
+    {
+        float Angle;
+        float Offset;
+        float V;
+    };
+
+    // Vertices of the rows one after another. A pole row is one vertex,
+    // the others have Sides + 1 vertices, the first and the last on top of each other for the UVs
+    struct FRowLayout_Internal
+    {
+        uint32_t Sides;
+        int32_t NumRows;
+        bool TopPole;
+        bool BottomPole;
+        uint32_t BaseVertex;
+
+        bool IsPole(int32_t Row) const
+        {
+            return (Row == 0 && TopPole) || (Row == NumRows - 1 && BottomPole);
+        }
+
+        uint32_t GetNumVertices() const
+        {
+            const uint32_t Poles = static_cast<uint32_t>(TopPole) + static_cast<uint32_t>(BottomPole);
+            return (NumRows - Poles) * (Sides + 1) + Poles;
+        }
+
+        uint32_t GetVertex(int32_t Row, uint32_t Side) const
+        {
+            const uint32_t RowStart = Row == 0 ? 0 : (TopPole ? 1 : Sides + 1) + (Row - 1) * (Sides + 1);
+            return BaseVertex + RowStart + (IsPole(Row) ? 0 : Side);
+        }
+
+        // Triangles between the rows StartRow and EndRow, a pole row has one per side instead of two
+        uint32_t GetNumIndices(int32_t StartRow, int32_t EndRow) const
+        {
+            if (StartRow >= EndRow)
+                return 0;
+
+            uint32_t NumTriangles = 2 * Sides * (EndRow - StartRow);
+            NumTriangles -= IsPole(StartRow) ? Sides : 0;
+            NumTriangles -= IsPole(EndRow) ? Sides : 0;
+            return 3 * NumTriangles;
+        }
+    };
+
+    template <typename GetRowType>
+    FVertex* BuildRowVerts_Internal(const float Center[3], float Radius, const FRowLayout_Internal& Layout,
+        GetRowType&& GetRow, FVertex* OutVertices)
+    {
+        const FYawTable_Internal Yaws{ Layout.Sides };
+        for (int32_t r = 0; r < Layout.NumRows; r++)
+        {
+            const FRow_Internal Row = GetRow(r);
+            const float ArcSin = std::sin(Row.Angle);
+            const float ArcCos = std::cos(Row.Angle);
+            const uint32_t RowSides = Layout.IsPole(r) ? 0 : Layout.Sides;
+
+            for (uint32_t s = 0; s <= RowSides; s++)
+            {
+                const float CosYaw = Yaws.Cos[s];
+                const float SinYaw = Yaws.Sin[s];
+
+                // Unit sphere, so the normal is also the position. TangentY is Normal ^ TangentX
+                FVertex& Vertex = *OutVertices++;
+                Set_Internal(Vertex.TangentZ, ArcSin * CosYaw, ArcSin * SinYaw, ArcCos);
+                Set_Internal(Vertex.TangentX, -SinYaw, CosYaw, 0.f);
+                Set_Internal(Vertex.TangentY, -ArcCos * CosYaw, -ArcCos * SinYaw, ArcSin);
+                Set_Internal(Vertex.Position,
+                    Center[0] + Vertex.TangentZ[0] * Radius,
+                    Center[1] + Vertex.TangentZ[1] * Radius,
+                    Center[2] + Vertex.TangentZ[2] * Radius + Row.Offset);
+                Vertex.UV[0] = RowSides > 0 ? static_cast<float>(s) / RowSides : 0.5f;
+                Vertex.UV[1] = Row.V;
+            }
+        }
+        return OutVertices;
+    }
+
+    // Triangles between the rows StartRow and EndRow. Bands of CacheBandRows_Internal rows are walked
+    // side by side, so every column of a band reuses the vertices of the previous one
+    uint32_t* AddRowTriangles_Internal(const FRowLayout_Internal& Layout, int32_t StartRow, int32_t EndRow,
+        uint32_t* OutIndices)
+    {
+        for (int32_t BandStart = StartRow; BandStart < EndRow; BandStart += CacheBandRows_Internal)
+        {
+            const int32_t BandEnd = std::min(BandStart + CacheBandRows_Internal, EndRow);
+            for (uint32_t s = 0; s < Layout.Sides; s++)
+            {
+                for (int32_t r = BandStart; r < BandEnd; r++)
+                {
+                    // Triangles with two corners on a pole would be degenerate
+                    if (!Layout.IsPole(r))
+                        AddTriangle_Internal(OutIndices, Layout.GetVertex(r, s), Layout.GetVertex(r, s + 1), Layout.GetVertex(r + 1, s));
+                    if (!Layout.IsPole(r + 1))
+                        AddTriangle_Internal(OutIndices, Layout.GetVertex(r, s + 1), Layout.GetVertex(r + 1, s + 1), Layout.GetVertex(r + 1, s));
+                }
+            }
+        }
+        return OutIndices;
+    }
+
+    inline FRowLayout_Internal GetSphereLayout_Internal(int32_t NumSides, int32_t NumRings, float StartAngle, float EndAngle,
+        uint32_t BaseVertex)
+    {
+        const int32_t Rings = std::min(std::max(NumRings, 1), MaxSides);
+        return FRowLayout_Internal{ static_cast<uint32_t>(ClampSides_Internal(NumSides)), Rings + 1,
+            StartAngle <= PoleAngle_Internal, EndAngle >= Pi_Internal - PoleAngle_Internal, BaseVertex };
+    }
+
+    // Upper cap rows [0, CapRings], lower cap rows after them, the body is between the two equators
+    inline FRowLayout_Internal GetCapsuleLayout_Internal(int32_t NumSides, uint32_t BaseVertex)
+    {
+        return FRowLayout_Internal{ static_cast<uint32_t>(ClampSides_Internal(NumSides)),
+            2 * (GetCapRings_Internal(NumSides) + 1), true, true, BaseVertex };
+    }
+
+    // Engine source 4.27
+    // .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
+    // Lines [549-650]: BuildCylinderVerts
+    FVertex* BuildRingVerts_Internal(const float Center[3], float Radius, float Offset, int32_t Sides, float TexCoordY,
+        const FYawTable_Internal& Yaws, FVertex* OutVertices)
+    {
+        for (int32_t SideIndex = 0; SideIndex < Sides; SideIndex++)
+        {
+            const float Cos = Yaws.Cos[SideIndex + 1];
+            const float Sin = Yaws.Sin[SideIndex + 1];
+
+            FVertex& Vertex = *OutVertices++;
+            Set_Internal(Vertex.Position, Center[0] + Cos * Radius, Center[1] + Sin * Radius, Center[2] + Offset);
+            Set_Internal(Vertex.TangentX, 0.f, 0.f, -1.f);
+            Set_Internal(Vertex.TangentY, Sin, -Cos, 0.f);
+            Set_Internal(Vertex.TangentZ, Cos, Sin, 0.f);
+            Vertex.UV[0] = static_cast<float>(SideIndex) / Sides;
+            Vertex.UV[1] = TexCoordY;
+        }
+        return OutVertices;
+    }
+}
+
+//
+// ShapesVisualizerTessellation
+//
+
+int32_t ShapesVisualizerTessellation::GetSphereRings(int32_t NumSides)
+{
+    return std::max(3, ClampSides_Internal(NumSides) / 2);
+}
+
+FCounts ShapesVisualizerTessellation::GetSphereCounts(int32_t NumSides, int32_t NumRings, float StartAngle, float EndAngle)
+{
+    const FRowLayout_Internal Layout = GetSphereLayout_Internal(NumSides, NumRings, StartAngle, EndAngle, 0);
+    return FCounts{ Layout.GetNumVertices(), Layout.GetNumIndices(0, Layout.NumRows - 1) };
+}
+
+FCounts ShapesVisualizerTessellation::GetCapsuleCapCounts(int32_t NumSides)
+{
+    const FRowLayout_Internal Layout = GetCapsuleLayout_Internal(NumSides, 0);
+    const int32_t CapRings = GetCapRings_Internal(NumSides);
+    return FCounts{ Layout.GetNumVertices() / 2, Layout.GetNumIndices(0, CapRings) };
+}
+
+FCounts ShapesVisualizerTessellation::GetShapeCounts(EShape Shape, int32_t NumSides)
+{
+    NumSides = ClampSides_Internal(NumSides);
+
+    switch (Shape)
+    {
+    case EShape::Sphere:
+        return GetSphereCounts(NumSides, GetSphereRings(NumSides), 0.f, Pi_Internal);
+    case EShape::HalfSphere:
+        return GetSphereCounts(NumSides, GetCapRings_Internal(NumSides), 0.f, Pi_Internal / 2.f);
+    case EShape::Box:
+        return FCounts{ 24, 36 };
+    case EShape::Cylinder:
+        return GetCylinderCounts_Internal(NumSides, false);
+    case EShape::Cone:
+        return GetCylinderCounts_Internal(NumSides, true);
+    case EShape::Capsule:
+    {
+        // Two caps and two triangles per side of the body
+        const FCounts Cap = GetCapsuleCapCounts(NumSides);
+        return FCounts{ 2 * Cap.NumVertices, 2 * Cap.NumIndices + 6 * static_cast<uint32_t>(NumSides) };
+    }
+    }
+    return FCounts{};
+}
+
+FCounts ShapesVisualizerTessellation::TessellateShape(EShape Shape, float Radius, float Height, const float Extent[3], int32_t NumSides,
+    FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex)
+{
+    static const float Origin[3] = { 0.f, 0.f, 0.f };
+    const float HalfHeight = Height / 2.f;
+    NumSides = ClampSides_Internal(NumSides);
+
+    switch (Shape)
+    {
+    case EShape::Sphere:
+        return TessellateSphere(Origin, Radius, NumSides, GetSphereRings(NumSides), 0.f, Pi_Internal,
+            OutVertices, OutIndices, BaseVertex);
+    case EShape::HalfSphere:
+        return TessellateSphere(Origin, Radius, NumSides, GetCapRings_Internal(NumSides), 0.f, Pi_Internal / 2.f,
+            OutVertices, OutIndices, BaseVertex);
+    case EShape::Box:
+        return TessellateBox(Extent, OutVertices, OutIndices, BaseVertex);
+    case EShape::Cylinder:
+        return TessellateCylinder(Origin, Radius, Radius, HalfHeight, NumSides, OutVertices, OutIndices, BaseVertex);
+    case EShape::Cone:
+        return TessellateCylinder(Origin, Radius, 0.f, HalfHeight, NumSides, OutVertices, OutIndices, BaseVertex);
+    case EShape::Capsule:
+    {
+        // Short capsules keep the minimal body and grow upwards
+        const float HalfAxis = std::max(HalfHeight - Radius, 1.f);
+        const float Middle[3] = { 0.f, 0.f, Radius - HalfHeight + HalfAxis };
+        return TessellateCapsule(Middle, Radius, HalfAxis, NumSides, OutVertices, OutIndices, BaseVertex);
+    }
+    }
+    return FCounts{};
+}
+
+// Engine source 4.27
+// .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
+// Lines [1005-1080]: GetOrientedHalfSphereMesh
+FCounts ShapesVisualizerTessellation::TessellateSphere(const float Center[3], float Radius, int32_t NumSides, int32_t NumRings,
+    float StartAngle, float EndAngle, FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex)
+{
+    const FRowLayout_Internal Layout = GetSphereLayout_Internal(NumSides, NumRings, StartAngle, EndAngle, BaseVertex);
+    const int32_t Rings = Layout.NumRows - 1;
+
+    FVertex* Vertex = BuildRowVerts_Internal(Center, Radius, Layout, [&](int32_t Row)
+        {
+            return FRow_Internal{ StartAngle + (EndAngle - StartAngle) * Row / Rings, 0.f, static_cast<float>(Row) / Rings };
+        },
+        OutVertices);
+    uint32_t* Index = AddRowTriangles_Internal(Layout, 0, Rings, OutIndices);
+
+    return FCounts{ static_cast<uint32_t>(Vertex - OutVertices), static_cast<uint32_t>(Index - OutIndices) };
+}
+
+FCounts ShapesVisualizerTessellation::TessellateCylinder(const float Center[3], float Radius, float TopRadius, float HalfHeight, int32_t NumSides,
+    FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex)
+{
+    const uint32_t Sides = ClampSides_Internal(NumSides);
+    const bool Cone = TopRadius <= 0.f;
+    uint32_t* Index = OutIndices;
+
+    const FYawTable_Internal Yaws{ Sides };
+    FVertex* Vertex = BuildRingVerts_Internal(Center, Radius, -HalfHeight, Sides, 0.f, Yaws, OutVertices);
+    if (Cone)
+    {
+        // Single apex shared by all sides
+        FVertex& Apex = *Vertex++;
+        Set_Internal(Apex.Position, Center[0], Center[1], Center[2] + HalfHeight);
+        Set_Internal(Apex.TangentX, 1.f, 0.f, 0.f);
+        Set_Internal(Apex.TangentY, 0.f, 1.f, 0.f);
+        Set_Internal(Apex.TangentZ, 0.f, 0.f, 1.f);
+        Apex.UV[0] = 0.5f;
+        Apex.UV[1] = 1.f;
+    }
+    else
+        Vertex = BuildRingVerts_Internal(Center, TopRadius, HalfHeight, Sides, 1.f, Yaws, Vertex);
+
+    // Bottom and top triangles, in the style of a fan
+    for (uint32_t SideIndex = 1; SideIndex + 1 < Sides; SideIndex++)
+    {
+        const uint32_t V0 = BaseVertex;
+        const uint32_t V1 = BaseVertex + SideIndex;
+        const uint32_t V2 = BaseVertex + SideIndex + 1;
+
+        AddTriangle_Internal(Index, V0, V1, V2);
+        if (!Cone)
+            AddTriangle_Internal(Index, Sides + V2, Sides + V1, Sides + V0);
+    }
+
+    // Sides
+    for (uint32_t SideIndex = 0; SideIndex < Sides; SideIndex++)
+    {
+        const uint32_t V0 = BaseVertex + SideIndex;
+        const uint32_t V1 = BaseVertex + ((SideIndex + 1) % Sides);
+
+        if (Cone)
+            AddTriangle_Internal(Index, V0, BaseVertex + Sides, V1);
+        else
+        {
+            AddTriangle_Internal(Index, V0, V0 + Sides, V1);
+            AddTriangle_Internal(Index, V0 + Sides, V1 + Sides, V1);
+        }
+    }
+
+    return FCounts{ static_cast<uint32_t>(Vertex - OutVertices), static_cast<uint32_t>(Index - OutIndices) };
+}
+
+FCounts ShapesVisualizerTessellation::TessellateCapsule(const float Center[3], float Radius, float HalfAxis, int32_t NumSides,
+    FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex)
+{
+    const FRowLayout_Internal Layout = GetCapsuleLayout_Internal(NumSides, BaseVertex);
+    const int32_t CapRings = GetCapRings_Internal(NumSides);
+    const int32_t LastRow = Layout.NumRows - 1;
+
+    FVertex* Vertex = BuildRowVerts_Internal(Center, Radius, Layout, [&](int32_t Row)
+        {
+            const bool Upper = Row <= CapRings;
+            const int32_t CapRow = Upper ? Row : Row - CapRings - 1;
+            return FRow_Internal{ (Upper ? 0.f : Pi_Internal / 2.f) + Pi_Internal / 2.f * CapRow / CapRings,
+                Upper ? HalfAxis : -HalfAxis, static_cast<float>(Row) / LastRow };
+        },
+        OutVertices);
+
+    // Caps first, so a unit capsule can also draw them apart from the body
+    uint32_t* Index = AddRowTriangles_Internal(Layout, 0, CapRings, OutIndices);
+    Index = AddRowTriangles_Internal(Layout, CapRings + 1, LastRow, Index);
+    Index = AddRowTriangles_Internal(Layout, CapRings, CapRings + 1, Index);
+
+    return FCounts{ static_cast<uint32_t>(Vertex - OutVertices), static_cast<uint32_t>(Index - OutIndices) };
+}
+
+// Engine source 4.27
+// .\Engine\Source\Runtime\Engine\Private\PrimitiveDrawingUtils.cpp
+// Lines [652-686]: GetBoxMesh
+FCounts ShapesVisualizerTessellation::TessellateBox(const float Extent[3],
+    FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex)
+{
+    // Face pointing up Z, rotated 6 times. Axes of the face rotations of the engine version
+    static const float Positions[4][2] = { { -1, -1 }, { -1, +1 }, { +1, +1 }, { +1, -1 } };
+    static const float UVs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+    static const float FaceAxes[6][3][3] = {
+        { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+        { { 0, 0, 1 }, { 0, 1, 0 }, { -1, 0, 0 } },
+        { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+        { { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+        { { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 } },
+        { { -1, 0, 0 }, { 0, 1, 0 }, { 0, 0, -1 } } };
+
+    FVertex* Vertex = OutVertices;
+    uint32_t* Index = OutIndices;
+
+    for (int32_t f = 0; f < 6; f++)
+    {
+        const float (&Axes)[3][3] = FaceAxes[f];
+        const uint32_t FaceBaseVertex = BaseVertex + static_cast<uint32_t>(Vertex - OutVertices);
+
+        for (int32_t VertexIndex = 0; VertexIndex < 4; VertexIndex++)
+        {
+            for (int32_t Axis = 0; Axis < 3; Axis++)
+            {
+                Vertex->Position[Axis] = (Axes[0][Axis] * Positions[VertexIndex][0]
+                    + Axes[1][Axis] * Positions[VertexIndex][1] + Axes[2][Axis]) * Extent[Axis];
+                Vertex->TangentX[Axis] = Axes[0][Axis];
+                Vertex->TangentY[Axis] = Axes[1][Axis];
+                Vertex->TangentZ[Axis] = Axes[2][Axis];
+            }
+            Vertex->UV[0] = UVs[VertexIndex][0];
+            Vertex->UV[1] = UVs[VertexIndex][1];
+            Vertex++;
+        }
+
+        AddTriangle_Internal(Index, FaceBaseVertex + 0, FaceBaseVertex + 1, FaceBaseVertex + 2);
+        AddTriangle_Internal(Index, FaceBaseVertex + 0, FaceBaseVertex + 2, FaceBaseVertex + 3);
+    }
+
+    return FCounts{ static_cast<uint32_t>(Vertex - OutVertices), static_cast<uint32_t>(Index - OutIndices) };
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include <cstdint>
+
+//
+// ShapesVisualizerTessellation - solid meshes of the shapes in plain C++
+//
+// Depends on nothing from the engine, so it builds and runs without a renderer.
+// Every function writes into the caller's buffers, sized with the matching Get*Counts,
+// and never allocates. Z is up, triangles are clockwise as the engine expects.
+// Poles and the cone apex are single vertices, the capsule is one mesh whose caps share
+// their equators with the body. Triangles of round shapes are ordered in bands of rings,
+// so the vertices of a band stay in the post transform cache of the GPU.
+//
+
+namespace ShapesVisualizerTessellation
+{
+    // Same order as EVisualShape
+    enum class EShape : uint8_t
+    {
+        Sphere,
+        HalfSphere,
+        Box,
+        Cylinder,
+        Cone,
+        Capsule
+    };
+
+    constexpr int32_t MinSides = 3;
+    constexpr int32_t MaxSides = 64;
+
+    struct FVertex
+    {
+        float Position[3];
+        float TangentX[3];
+        float TangentY[3];
+        // Normal
+        float TangentZ[3];
+        float UV[2];
+    };
+
+    struct FCounts
+    {
+        uint32_t NumVertices = 0;
+        uint32_t NumIndices = 0;
+    };
+
+    FCounts GetShapeCounts(EShape Shape, int32_t NumSides);
+    FCounts GetSphereCounts(int32_t NumSides, int32_t NumRings, float StartAngle, float EndAngle);
+    // One cap of the capsule, its indices come first, the lower cap follows and the body is last
+    FCounts GetCapsuleCapCounts(int32_t NumSides);
+
+    // Rings of the sphere with NumSides sides, the half sphere and the capsule caps get half of them
+    int32_t GetSphereRings(int32_t NumSides);
+
+    // Shape centered at the origin. Indices are offset by BaseVertex, returns the written counts
+    FCounts TessellateShape(EShape Shape, float Radius, float Height, const float Extent[3], int32_t NumSides,
+        FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex = 0);
+
+    // Part of a sphere between StartAngle and EndAngle measured from +Z, a pole at 0 or PI is a single vertex
+    FCounts TessellateSphere(const float Center[3], float Radius, int32_t NumSides, int32_t NumRings,
+        float StartAngle, float EndAngle, FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex = 0);
+
+    // Capped cylinder, or a cone with a single apex when TopRadius is zero, around Z between -HalfHeight and +HalfHeight
+    FCounts TessellateCylinder(const float Center[3], float Radius, float TopRadius, float HalfHeight, int32_t NumSides,
+        FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex = 0);
+
+    // Half spheres centered at +-HalfAxis on Z joined by the body, without the hidden cylinder caps
+    FCounts TessellateCapsule(const float Center[3], float Radius, float HalfAxis, int32_t NumSides,
+        FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex = 0);
+
+    FCounts TessellateBox(const float Extent[3], FVertex* OutVertices, uint32_t* OutIndices, uint32_t BaseVertex = 0);
+}
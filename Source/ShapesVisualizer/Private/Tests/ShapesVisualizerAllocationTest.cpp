@@ -0,0 +1,231 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Engine/World.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "CanvasTypes.h"
+#include "EngineModule.h"
+#include "LegacyScreenPercentageDriver.h"
+#include "RenderingThread.h"
+#include "RendererInterface.h"
+#include "SceneView.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "ShapesVisualizerStats.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // Forwards to the allocator it stands in for, counting the allocations of the counted scopes
+    class FCountingMalloc_Internal : public FMalloc
+    {
+    public:
+
+        explicit FCountingMalloc_Internal(FMalloc* InInner)
+            : Inner(InInner)
+        {
+        }
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Count_Internal(Count);
+            return Inner->Malloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            // Growing a block allocates as well, a realloc to zero frees
+            if (Count > 0)
+                Count_Internal(Count);
+            return Inner->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override { Inner->Free(Original); }
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+        virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+        std::atomic<int64> NumAllocations{ 0 };
+        std::atomic<int64> NumBytes{ 0 };
+
+    private:
+
+        void Count_Internal(SIZE_T Count)
+        {
+            if (!FShapesVisualizerAllocationScope::IsCounting())
+                return;
+            NumAllocations.fetch_add(1, std::memory_order_relaxed);
+            NumBytes.fetch_add(static_cast<int64>(Count), std::memory_order_relaxed);
+        }
+
+        FMalloc* Inner;
+    };
+
+    TArray<FVector> MakePoints_Internal(FRandomStream& Random, int32 NumPoints, float Radius)
+    {
+        TArray<FVector> Points;
+        for (int32 Index = 0; Index < NumPoints; Index++)
+            Points.Add(Random.GetUnitVector() * Random.FRandRange(0.f, Radius));
+        return Points;
+    }
+}
+
+//
+// FShapesVisualizerAllocationTest - drawing proxies leave the heap alone in steady state
+//
+// Every kind of proxy, solid and wireframe, thin and thick, and a batch are rendered into a render target
+// from a fixed view. After the warm up frames GMalloc is replaced by a counting allocator and the proxies
+// have to draw NumFrames frames without a single allocation. Everything they ask for is counted, the mesh
+// batches and uniform buffers of the collector, the stat messages and the tasks of their parallel loops.
+// Needs a RHI, with -nullrhi nothing is drawn and the test only warns.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerAllocationTest, "ShapesVisualizer.Rendering.SteadyStateAllocations",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerAllocationTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumWarmUpFrames = 8;
+    constexpr int32 NumFrames = 32;
+    constexpr int32 TargetSize = 256;
+
+    if (GUsingNullRHI || !FApp::CanEverRender())
+    {
+        AddWarning(TEXT("Nothing is drawn without a RHI, the allocations are not counted"));
+        return true;
+    }
+
+    UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+    FRandomStream Random{ 19 };
+
+    // Shapes in a row in front of the view, which looks down +X from the origin
+    TArray<UPrimitiveComponent*> Components;
+    auto AddComponent = [World, &Components](UPrimitiveComponent* Component)
+    {
+        Component->SetWorldLocation(FVector{ 600.f, (Components.Num() - 4.5f) * 120.f, 0.f });
+        Component->SetHiddenInGame(false);
+        Component->RegisterComponentWithWorld(World);
+        Components.Add(Component);
+    };
+    auto NewVisualizer = [World]()
+    {
+        return NewObject<UShapesVisualizerComponent>(World);
+    };
+
+    UShapesVisualizerComponent* Visualizer = NewVisualizer();
+    Visualizer->SetSphereShape(50.f);
+    AddComponent(Visualizer);
+
+    Visualizer = NewVisualizer();
+    Visualizer->SetBoxShape(FVector{ 40.f });
+    Visualizer->SetWireframe(true);
+    AddComponent(Visualizer);
+
+    Visualizer = NewVisualizer();
+    Visualizer->SetCapsuleShape(30.f, 120.f);
+    Visualizer->SetWireframe(true, 2.f);
+    AddComponent(Visualizer);
+
+    for (const bool Wireframe : { false, true })
+    {
+        Visualizer = NewVisualizer();
+        Visualizer->Radii = 2.f;
+        Visualizer->SetPointsShape(MakePoints_Internal(Random, 1000, 50.f));
+        Visualizer->SetWireframe(Wireframe, Wireframe ? 1.f : 0.f);
+        AddComponent(Visualizer);
+    }
+
+    for (const float Thickness : { 0.f, 2.f })
+    {
+        Visualizer = NewVisualizer();
+        Visualizer->SetPolylineShape(MakePoints_Internal(Random, 500, 50.f));
+        Visualizer->SetWireframe(false, Thickness);
+        AddComponent(Visualizer);
+    }
+
+    TArray<FColor> Cells;
+    for (int32 Index = 0; Index < 8 * 8 * 8; Index++)
+        Cells.Add(Random.RandHelper(3) == 0 ? FColor::Transparent : FColor::MakeRandomColor());
+    Visualizer = NewVisualizer();
+    Visualizer->SetGridShape(FIntVector{ 8 }, FVector{ 10.f }, MoveTemp(Cells));
+    AddComponent(Visualizer);
+
+    UShapesVisualizerBatchComponent* const Batch = NewObject<UShapesVisualizerBatchComponent>(World);
+    Batch->LineThickness = 2.f;
+    for (int32 Index = 0; Index < 32; Index++)
+    {
+        FShapesVisualizerBatchShape Shape;
+        Shape.Shape = static_cast<EVisualShape>(Index % 6);
+        Shape.Transform.SetLocation(Random.GetUnitVector() * 50.f);
+        Shape.Radii = 10.f;
+        Shape.Height = 20.f;
+        Shape.Extent = FVector{ 10.f };
+        Shape.Wireframe = Index % 2 == 1;
+        Batch->AddShape(Shape);
+    }
+    AddComponent(Batch);
+
+    UTextureRenderTarget2D* const Target = NewObject<UTextureRenderTarget2D>();
+    Target->InitAutoFormat(TargetSize, TargetSize);
+    Target->UpdateResourceImmediate(true);
+    FRenderTarget* const RenderTarget = Target->GameThread_GetRenderTargetResource();
+
+    auto RenderFrame = [&](uint32 FrameNumber)
+    {
+        FSceneViewFamilyContext ViewFamily{ FSceneViewFamily::ConstructionValues(RenderTarget, World->Scene, FEngineShowFlags{ ESFIM_Game })
+            .SetRealtimeUpdate(true) };
+        ViewFamily.FrameNumber = FrameNumber;
+
+        FSceneViewInitOptions ViewOptions;
+        ViewOptions.ViewFamily = &ViewFamily;
+        ViewOptions.SetViewRectangle(FIntRect{ 0, 0, TargetSize, TargetSize });
+        ViewOptions.ViewOrigin = FVector::ZeroVector;
+        // X forward, Y right and Z up of the world are Z, X and Y of the view
+        ViewOptions.ViewRotationMatrix = FMatrix{ FPlane{ 0.f, 0.f, 1.f, 0.f }, FPlane{ 1.f, 0.f, 0.f, 0.f },
+            FPlane{ 0.f, 1.f, 0.f, 0.f }, FPlane{ 0.f, 0.f, 0.f, 1.f } };
+        ViewOptions.ProjectionMatrix = FReversedZPerspectiveMatrix{ PI / 4.f, static_cast<float>(TargetSize), static_cast<float>(TargetSize), 10.f };
+        ViewFamily.Views.Add(new FSceneView(ViewOptions));
+#if ENGINE_MAJOR_VERSION == 5
+        ViewFamily.SetScreenPercentageInterface(new FLegacyScreenPercentageDriver(ViewFamily, 1.f));
+#else
+        ViewFamily.SetScreenPercentageInterface(new FLegacyScreenPercentageDriver(ViewFamily, 1.f, false));
+#endif
+
+        FCanvas Canvas{ RenderTarget, nullptr, World, World->FeatureLevel };
+        GetRendererModule().BeginRenderingViewFamily(&Canvas, &ViewFamily);
+    };
+
+    // Materials, scratch buffers and LODs settle in the first frames
+    uint32 FrameNumber = GFrameNumber;
+    for (int32 Frame = 0; Frame < NumWarmUpFrames; Frame++)
+        RenderFrame(++FrameNumber);
+    FlushRenderingCommands();
+
+    FMalloc* const SavedMalloc = GMalloc;
+    FCountingMalloc_Internal CountingMalloc{ SavedMalloc };
+    GMalloc = &CountingMalloc;
+    for (int32 Frame = 0; Frame < NumFrames; Frame++)
+        RenderFrame(++FrameNumber);
+    FlushRenderingCommands();
+    GMalloc = SavedMalloc;
+
+    const int64 NumAllocations = CountingMalloc.NumAllocations.load();
+    AddInfo(FString::Printf(TEXT("%d proxies in %d frames: %lld allocations, %lld bytes"),
+        Components.Num(), NumFrames, NumAllocations, CountingMalloc.NumBytes.load()));
+    TestEqual(TEXT("Proxies allocate nothing in steady state"), NumAllocations, static_cast<int64>(0));
+
+    for (UPrimitiveComponent* Component : Components)
+        Component->DestroyComponent();
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
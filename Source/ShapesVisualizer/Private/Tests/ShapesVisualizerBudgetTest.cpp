@@ -0,0 +1,143 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderingThread.h"
+#include "ShapesVisualizerBudget.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerBudgetStressTest - thousands of proxies share a budget for hundreds of frames
+//
+// Proxies of four priorities ask in a shuffled order every frame, twice like with a scene capture,
+// and spend half of their cost per view family. One proxy alone costs twice the budget. After the first
+// frame, which measures everyone, the frames have to stay within the budget unless the oversized proxy is
+// drawn. Every proxy has to be drawn in turns, higher priorities more often, and a proxy has to wait one
+// frame per frame it is not drawn. Runs on the render thread, the budget belongs to it.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerBudgetStressTest, "ShapesVisualizer.Budget.Stress",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerBudgetStressTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumProxies = 3000;
+    constexpr int32 NumPriorities = 4;
+    constexpr int32 NumFrames = 600;
+    constexpr int32 MaxPrimitives = 20000;
+    constexpr int32 OversizedPrimitives = MaxPrimitives * 2;
+    // Far from the frame numbers of the engine
+    constexpr uint32 FirstFrame = 0x40000000;
+
+    IConsoleVariable* const PrimitivesVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ShapesVisualizer.Budget.Primitives"));
+    IConsoleVariable* const MicrosecondsVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ShapesVisualizer.Budget.Microseconds"));
+    if (!TestNotNull(TEXT("The budget has its console variables"), PrimitivesVar) || !MicrosecondsVar)
+        return false;
+    const int32 SavedPrimitives = PrimitivesVar->GetInt();
+    const float SavedMicroseconds = MicrosecondsVar->GetFloat();
+    PrimitivesVar->Set(MaxPrimitives, ECVF_SetByCode);
+    MicrosecondsVar->Set(0.f, ECVF_SetByCode);
+
+    struct FProxy
+    {
+        FShapesVisualizerBudget::FProxyState State;
+        int32 Priority = 0;
+        float ScreenRadius = 0.f;
+        int32 Primitives = 0;
+        int32 NumDrawn = 0;
+        int32 Waiting = 0;
+    };
+
+    FRandomStream Random{ 21 };
+    TArray<FProxy> Proxies;
+    Proxies.SetNum(NumProxies);
+    for (FProxy& Proxy : Proxies)
+    {
+        Proxy.Priority = Random.RandHelper(NumPriorities);
+        Proxy.ScreenRadius = Random.FRandRange(1.f, 500.f);
+        Proxy.Primitives = 10 + Random.RandHelper(190);
+    }
+    Proxies[0].Primitives = OversizedPrimitives;
+
+    int32 NumFramesOver = 0;
+    int32 NumWaitMismatches = 0;
+    int64 MaxFramePrimitives = 0;
+    ENQUEUE_RENDER_COMMAND(ShapesVisualizerBudgetStressTest)(
+        [&](FRHICommandListImmediate& RHICmdList)
+        {
+            TArray<int32> Order;
+            for (int32 Index = 0; Index < NumProxies; Index++)
+                Order.Add(Index);
+
+            for (int32 Frame = 0; Frame < NumFrames; Frame++)
+            {
+                for (int32 Index = Order.Num() - 1; Index > 0; Index--)
+                    Order.Swap(Index, Random.RandHelper(Index + 1));
+
+                int64 FramePrimitives = 0;
+                for (int32 Family = 0; Family < 2; Family++)
+                {
+                    for (const int32 Index : Order)
+                    {
+                        FProxy& Proxy = Proxies[Index];
+                        if (!Proxy.State.TryDraw(FirstFrame + Frame, Proxy.Priority, false, Proxy.ScreenRadius))
+                            continue;
+                        const int32 Primitives = Proxy.Primitives / 2 + (Family == 0 ? Proxy.Primitives % 2 : 0);
+                        Proxy.State.EndDraw(Primitives, FPlatformTime::Cycles());
+                        FramePrimitives += Primitives;
+                    }
+                }
+
+                for (FProxy& Proxy : Proxies)
+                {
+                    const bool Drawn = Proxy.State.DeferredFrames == 0;
+                    Proxy.Waiting = Drawn ? 0 : Proxy.Waiting + 1;
+                    Proxy.NumDrawn += Drawn && Frame > 0 ? 1 : 0;
+                    NumWaitMismatches += Proxy.State.DeferredFrames != Proxy.Waiting ? 1 : 0;
+                }
+
+                // The first frame measures the proxies, nothing is known about them before it
+                const bool OversizedDrawn = Proxies[0].State.DeferredFrames == 0;
+                if (Frame > 0 && !OversizedDrawn)
+                {
+                    MaxFramePrimitives = FMath::Max(MaxFramePrimitives, FramePrimitives);
+                    NumFramesOver += FramePrimitives > MaxPrimitives ? 1 : 0;
+                }
+            }
+        });
+    FlushRenderingCommands();
+
+    PrimitivesVar->Set(SavedPrimitives, ECVF_SetByCode);
+    MicrosecondsVar->Set(SavedMicroseconds, ECVF_SetByCode);
+
+    int32 NumNeverDrawn = 0;
+    int64 DrawnPerPriority[NumPriorities] = {};
+    int32 ProxiesPerPriority[NumPriorities] = {};
+    for (int32 Index = 1; Index < NumProxies; Index++)
+    {
+        NumNeverDrawn += Proxies[Index].NumDrawn == 0 ? 1 : 0;
+        DrawnPerPriority[Proxies[Index].Priority] += Proxies[Index].NumDrawn;
+        ProxiesPerPriority[Proxies[Index].Priority]++;
+    }
+
+    AddInfo(FString::Printf(TEXT("%d proxies, %d frames: at most %lld of %d primitives per frame, the oversized proxy drawn %d times"),
+        NumProxies, NumFrames - 1, MaxFramePrimitives, MaxPrimitives, Proxies[0].NumDrawn));
+    TestEqual(TEXT("Frames stay within the budget"), NumFramesOver, 0);
+    TestEqual(TEXT("Every proxy is drawn"), NumNeverDrawn, 0);
+    TestTrue(TEXT("The oversized proxy is drawn"), Proxies[0].NumDrawn > 0);
+    TestEqual(TEXT("Proxies wait one frame per frame"), NumWaitMismatches, 0);
+
+    float LastRate = 0.f;
+    for (int32 Priority = 0; Priority < NumPriorities; Priority++)
+    {
+        const float Rate = ProxiesPerPriority[Priority] > 0 ? static_cast<float>(DrawnPerPriority[Priority]) / ProxiesPerPriority[Priority] : 0.f;
+        AddInfo(FString::Printf(TEXT("Priority %d: drawn %.1f times per proxy"), Priority, Rate));
+        TestTrue(FString::Printf(TEXT("Priority %d is drawn at least as often as the one below"), Priority), Rate >= LastRate);
+        LastRate = Rate;
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
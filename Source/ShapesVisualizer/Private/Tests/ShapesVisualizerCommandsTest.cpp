@@ -0,0 +1,95 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+#include "UObject/Package.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "ShapesVisualizerCommands.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerCommandsTest - commands flooded from several threads are applied exactly once, in order
+//
+// Producer threads append one point and add one batch shape per command while the game thread flushes the
+// queue. Every point carries its thread and sequence number, so a lost, doubled or reordered command of any
+// producer shows up in the points of the component. The components are not registered, nothing is drawn.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerCommandsTest, "ShapesVisualizer.Commands.Threads",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerCommandsTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumThreads = 8;
+    constexpr int32 CommandsPerThread = 5000;
+
+    UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(GetTransientPackage());
+    UShapesVisualizerBatchComponent* const Batch = NewObject<UShapesVisualizerBatchComponent>(GetTransientPackage());
+    Component->SetPointsShape(TArray<FVector>{});
+
+    const TWeakObjectPtr<UShapesVisualizerComponent> WeakComponent{ Component };
+    const TWeakObjectPtr<UShapesVisualizerBatchComponent> WeakBatch{ Batch };
+
+    TArray<TFuture<void>> Producers;
+    for (int32 Thread = 0; Thread < NumThreads; Thread++)
+    {
+        Producers.Add(Async(EAsyncExecution::Thread, [Thread, WeakComponent, WeakBatch]()
+        {
+            FShapesVisualizerBatchShape Shape;
+            Shape.Shape = EVisualShape::Sphere;
+            for (int32 Sequence = 0; Sequence < CommandsPerThread; Sequence++)
+            {
+                FShapesVisualizerCommands::AppendPoints(WeakComponent, TArray<FVector>{ FVector{ static_cast<float>(Thread), static_cast<float>(Sequence), 0.f } });
+                FShapesVisualizerCommands::AddShape(WeakBatch, Shape);
+            }
+        }));
+    }
+
+    // Flushes race the producers, like the frames of a game with busy workers
+    auto ProducersDone = [&Producers]()
+    {
+        for (const TFuture<void>& Producer : Producers)
+        {
+            if (!Producer.IsReady())
+                return false;
+        }
+        return true;
+    };
+    int32 NumFlushes = 0;
+    while (!ProducersDone())
+    {
+        FShapesVisualizerCommands::Flush();
+        NumFlushes++;
+    }
+    for (TFuture<void>& Producer : Producers)
+        Producer.Wait();
+    FShapesVisualizerCommands::Flush();
+
+    constexpr int32 NumCommands = NumThreads * CommandsPerThread;
+    AddInfo(FString::Printf(TEXT("%d commands of %d threads in %d flushes"), NumCommands * 2, NumThreads, NumFlushes + 1));
+    TestEqual(TEXT("Every point is appended once"), Component->Points.Num(), NumCommands);
+    TestEqual(TEXT("Every batch shape is added once"), Batch->GetNumShapes(), NumCommands);
+
+    // Commands of one producer keep their order
+    int32 NextSequence[NumThreads] = {};
+    int32 NumOutOfOrder = 0;
+    for (const FVector& Point : Component->Points)
+    {
+        const int32 Thread = FMath::RoundToInt(Point.X);
+        if (Thread < 0 || Thread >= NumThreads || FMath::RoundToInt(Point.Y) != NextSequence[Thread]++)
+            NumOutOfOrder++;
+    }
+    TestEqual(TEXT("Points of every thread arrive in order"), NumOutOfOrder, 0);
+    for (int32 Thread = 0; Thread < NumThreads; Thread++)
+        TestEqual(FString::Printf(TEXT("All commands of thread %d are applied"), Thread), NextSequence[Thread], CommandsPerThread);
+
+    // Commands of a destroyed target are dropped
+    FShapesVisualizerCommands::AppendPoints(TWeakObjectPtr<UShapesVisualizerComponent>{}, TArray<FVector>{ FVector::ZeroVector });
+    FShapesVisualizerCommands::Flush();
+    TestEqual(TEXT("Commands without a target change nothing"), Component->Points.Num(), NumCommands);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,69 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "RenderingThread.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerGeometryPool.h"
+#include "ShapesVisualizerTessellation.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerGeometryPoolTest - element counts of the unit meshes the proxies draw
+//
+// Acquires every shape with 3 to 64 sides, solid and lines, on the render thread and compares the buffers with the
+// counts of ShapesVisualizerTessellation. Runs with -nullrhi, the buffers are created but nothing is drawn.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerGeometryPoolTest, "ShapesVisualizer.GeometryPool.ElementCounts",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerGeometryPoolTest::RunTest(const FString& Parameters)
+{
+    const EVisualShape Shapes[] = { EVisualShape::Sphere, EVisualShape::HalfSphere, EVisualShape::Box,
+        EVisualShape::Cylinder, EVisualShape::Cone, EVisualShape::Capsule };
+
+    for (const EVisualShape Shape : Shapes)
+    {
+        for (const int32 NumSides : { 3, 8, 16, 32, 64 })
+        {
+            int32 NumVertices = 0;
+            int32 NumIndices = 0;
+            int32 NumLineVertices = 0;
+            int32 NumLineIndices = 0;
+            int32 NumMeshes = 0;
+            int32 NumMeshesAfter = 0;
+
+            ENQUEUE_RENDER_COMMAND(ShapesVisualizerGeometryPoolTest)(
+                [&](FRHICommandListImmediate& RHICmdList)
+                {
+                    FShapesVisualizerGeometryPool& Pool = FShapesVisualizerGeometryPool::Get();
+                    NumMeshes = Pool.GetNumMeshes();
+
+                    const FShapesVisualizerUnitMesh* const Mesh = Pool.Acquire(Shape, NumSides, GMaxRHIFeatureLevel);
+                    const FShapesVisualizerUnitMesh* const LineMesh = Pool.Acquire(Shape, NumSides, GMaxRHIFeatureLevel, true);
+                    NumVertices = Mesh->Buffers.GetNumVertices();
+                    NumIndices = Mesh->Buffers.GetNumIndices();
+                    NumLineVertices = LineMesh->Buffers.GetNumVertices();
+                    NumLineIndices = LineMesh->Buffers.GetNumIndices();
+                    Pool.Release(Mesh);
+                    Pool.Release(LineMesh);
+
+                    NumMeshesAfter = Pool.GetNumMeshes();
+                });
+            FlushRenderingCommands();
+
+            const ShapesVisualizerTessellation::FCounts Counts = ShapesVisualizerTessellation::GetShapeCounts(
+                static_cast<ShapesVisualizerTessellation::EShape>(Shape), NumSides);
+            const FString What = FString::Printf(TEXT("shape %d with %d sides"), static_cast<int32>(Shape), NumSides);
+
+            TestEqual(TEXT("Solid vertices of ") + What, NumVertices, static_cast<int32>(Counts.NumVertices));
+            TestEqual(TEXT("Solid indices of ") + What, NumIndices, static_cast<int32>(Counts.NumIndices));
+            TestTrue(TEXT("Lines of ") + What, NumLineIndices > 0 && NumLineIndices % 2 == 0 && NumLineVertices > 0);
+            TestEqual(TEXT("Pool releases the meshes of ") + What, NumMeshesAfter, NumMeshes);
+        }
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
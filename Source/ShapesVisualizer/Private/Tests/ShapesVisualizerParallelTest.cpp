@@ -0,0 +1,85 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderingThread.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerPointStorage.h"
+#include "ShapesVisualizerPointsMesh.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerParallelBenchmark - speedup of the parallel geometry loops against the number of tasks
+//
+// Builds the merged mesh of 1M points and transforms them to world space with r.ShapesVisualizer.MaxParallelTasks
+// at 1, 2, 4, 8 and 16, then without a cap. The speedup is relative to one task, the best of three runs each.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerParallelBenchmark, "ShapesVisualizer.Parallel.Benchmark",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FShapesVisualizerParallelBenchmark::RunTest(const FString& Parameters)
+{
+    IConsoleVariable* const MaxTasksVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ShapesVisualizer.MaxParallelTasks"));
+    if (!TestNotNull(TEXT("r.ShapesVisualizer.MaxParallelTasks exists"), MaxTasksVar))
+        return false;
+    const int32 OldMaxTasks = MaxTasksVar->GetInt();
+
+    constexpr int32 NumPoints = 1000000;
+    FRandomStream Random{ 9 };
+    TArray<FVector> Points;
+    Points.SetNumUninitialized(NumPoints);
+    for (FVector& Point : Points)
+        Point = Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f);
+    const FShapesVisualizerPointStorage Storage{ EVisualPointsFormat::Vector, Points };
+    const FMatrix LocalToWorld = FTransform{ FRotator{ 10.f, 20.f, 30.f }, FVector{ 100.f }, FVector{ 2.f } }.ToMatrixWithScale();
+
+    double SerialBuild = 0.0;
+    double SerialTransform = 0.0;
+    for (const int32 MaxTasks : { 1, 2, 4, 8, 16, 0 })
+    {
+        MaxTasksVar->Set(MaxTasks, ECVF_SetByCode);
+
+        double BuildSeconds = MAX_dbl;
+        double TransformSeconds = MAX_dbl;
+        ENQUEUE_RENDER_COMMAND(ShapesVisualizerParallelBenchmark)(
+            [&](FRHICommandListImmediate& RHICmdList)
+            {
+                FShapesVisualizerPointsMesh Mesh{ GMaxRHIFeatureLevel };
+                TArray<FVector> WorldPoints;
+                WorldPoints.SetNumUninitialized(NumPoints);
+
+                for (int32 Run = 0; Run < 3; Run++)
+                {
+                    double StartTime = FPlatformTime::Seconds();
+                    Mesh.Build(Storage, 10.f, FVector::OneVector, 16, false);
+                    BuildSeconds = FMath::Min(BuildSeconds, FPlatformTime::Seconds() - StartTime);
+
+                    StartTime = FPlatformTime::Seconds();
+                    ShapesVisualizerGeometry::ParallelForChunks(NumPoints, [&](int32 StartIndex, int32 EndIndex)
+                    {
+                        Storage.TransformPositions(LocalToWorld, StartIndex, EndIndex, WorldPoints.GetData() + StartIndex);
+                    });
+                    TransformSeconds = FMath::Min(TransformSeconds, FPlatformTime::Seconds() - StartTime);
+                }
+            });
+        FlushRenderingCommands();
+
+        if (MaxTasks == 1)
+        {
+            SerialBuild = BuildSeconds;
+            SerialTransform = TransformSeconds;
+        }
+        AddInfo(FString::Printf(TEXT("%s tasks (%d workers): build %.2f ms (x%.2f), transform %.2f ms (x%.2f)"),
+            MaxTasks > 0 ? *FString::FromInt(MaxTasks) : TEXT("any"), FTaskGraphInterface::Get().GetNumWorkerThreads(),
+            BuildSeconds * 1000.0, SerialBuild / BuildSeconds, TransformSeconds * 1000.0, SerialTransform / TransformSeconds));
+    }
+
+    MaxTasksVar->Set(OldMaxTasks, ECVF_SetByCode);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,144 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderingThread.h"
+#include "UObject/Package.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerPointCloud.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    FString GetTestFile_Internal(const TCHAR* Name)
+    {
+        return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), Name));
+    }
+
+    // Random points in a cube of Extent, written a chunk at a time
+    bool WritePointCloud_Internal(const FString& FileName, int64 NumPoints, float Extent)
+    {
+        TUniquePtr<FArchive> Writer{ IFileManager::Get().CreateFileWriter(*FileName) };
+        if (!Writer)
+            return false;
+
+        FShapesVisualizerPointCloudLoader::FPointCloudHeader Header;
+        Header.Magic = FShapesVisualizerPointCloudLoader::Magic;
+        Header.Version = FShapesVisualizerPointCloudLoader::Version;
+        Header.NumPoints = static_cast<uint64>(NumPoints);
+        Writer->Serialize(&Header, sizeof(Header));
+
+        FRandomStream Random{ 25 };
+        TArray<float> Chunk;
+        for (int64 Written = 0; Written < NumPoints; Written += FShapesVisualizerPointCloudLoader::ChunkSize)
+        {
+            const int32 Count = static_cast<int32>(FMath::Min<int64>(FShapesVisualizerPointCloudLoader::ChunkSize, NumPoints - Written));
+            Chunk.SetNumUninitialized(Count * 3);
+            for (float& Value : Chunk)
+                Value = Random.FRandRange(-Extent, Extent);
+            Writer->Serialize(Chunk.GetData(), Chunk.Num() * sizeof(float));
+        }
+        return Writer->Close();
+    }
+}
+
+//
+// FShapesVisualizerPlyCountTest - the vertex count of an ascii header cannot outgrow the file
+//
+// A PLY file claims a million vertices and has ten lines of them. The loader has to read at most the
+// points the bytes of the file can hold, instead of reserving the million up front.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerPlyCountTest, "ShapesVisualizer.PointCloud.PlyAsciiCount",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerPlyCountTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumLines = 10;
+
+    FString Text = TEXT("ply\nformat ascii 1.0\nelement vertex 1000000\nproperty float x\nproperty float y\nproperty float z\nend_header\n");
+    for (int32 Index = 0; Index < NumLines; Index++)
+        Text += FString::Printf(TEXT("%d 0 0\n"), Index);
+
+    const FString FileName = GetTestFile_Internal(TEXT("PlyAsciiCount.ply"));
+    if (!TestTrue(TEXT("The file is written"), FFileHelper::SaveStringToFile(Text, *FileName)))
+        return false;
+
+    UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(GetTransientPackage());
+    TUniquePtr<FShapesVisualizerPointCloudLoader> Loader = FShapesVisualizerPointCloudLoader::Load(Component, FileName, EVisualShape::Points);
+    if (TestNotNull(TEXT("The file loads"), Loader.Get()))
+    {
+        // Every line has the shortest values, three digits and three separators
+        AddInfo(FString::Printf(TEXT("The header claims 1000000 points, %lld are read"), Loader->GetNumPoints()));
+        TestEqual(TEXT("The points fit into the file"), Loader->GetNumPoints(), static_cast<int64>(NumLines));
+    }
+
+    Loader.Reset();
+    IFileManager::Get().Delete(*FileName);
+    return true;
+}
+
+//
+// FShapesVisualizerPointCloudLoadTest - load time and peak memory of a cloud of ten million points
+//
+// A .svpc of NumPoints random points is written to the automation transient directory and streamed into
+// a Points visualizer of a game world. The frames are pumped by hand, every one flushes the proxy updates.
+// Reports the load time and the peak used physical memory, the whole cloud has to reach the component.
+// The reserved points mesh keeps the stride of the whole cloud within ShapesVisualizerGeometry::MaxPointsVertices.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerPointCloudLoadTest, "ShapesVisualizer.PointCloud.Load10M",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FShapesVisualizerPointCloudLoadTest::RunTest(const FString& Parameters)
+{
+    constexpr int64 NumPoints = 10 * 1000 * 1000;
+    constexpr double TimeoutSeconds = 600.0;
+
+    const FString FileName = GetTestFile_Internal(TEXT("PointCloudLoad.svpc"));
+    if (!TestTrue(TEXT("The cloud is written"), WritePointCloud_Internal(FileName, NumPoints, 100000.f)))
+        return false;
+
+    UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+    UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(World);
+    Component->Radii = 2.f;
+    Component->SetHiddenInGame(false);
+    Component->RegisterComponentWithWorld(World);
+    FlushRenderingCommands();
+
+    const uint64 StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+    TUniquePtr<FShapesVisualizerPointCloudLoader> Loader = FShapesVisualizerPointCloudLoader::Load(Component, FileName, EVisualShape::Points);
+    if (TestNotNull(TEXT("The cloud loads"), Loader.Get()))
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        while (!Loader->IsDone() && FPlatformTime::Seconds() - StartTime < TimeoutSeconds)
+        {
+            FCoreDelegates::OnBeginFrame.Broadcast();
+            FlushRenderingCommands();
+            FPlatformProcess::Sleep(0.f);
+        }
+
+        const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+        AddInfo(FString::Printf(TEXT("%lld of %lld points in %.2f s, peak used physical memory %.1f MB, %.1f MB at the start"),
+            Loader->GetNumAppended(), Loader->GetNumPoints(), Loader->GetLoadSeconds(),
+            MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0), StartUsedPhysical / (1024.0 * 1024.0)));
+        TestTrue(TEXT("The cloud loads in time"), Loader->IsDone());
+        TestEqual(TEXT("Every point is appended"), Loader->GetNumAppended(), NumPoints);
+        TestEqual(TEXT("The component has every point"), static_cast<int64>(Component->GetNumPoints()), NumPoints);
+    }
+
+    Loader.Reset();
+    IFileManager::Get().Delete(*FileName);
+    Component->DestroyComponent();
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,126 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "UObject/Package.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerPointStorage.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // Largest distance of the stored points from the ones they were made of
+    float GetMaxError_Internal(const FShapesVisualizerPointStorage& Storage, TArrayView<const FVector> Points)
+    {
+        float MaxError = 0.f;
+        for (int32 Index = 0; Index < Points.Num(); Index++)
+            MaxError = FMath::Max(MaxError, static_cast<float>(FVector::Dist(Storage[Index], Points[Index])));
+        return MaxError;
+    }
+}
+
+//
+// FShapesVisualizerQuantizationTest - the quantization box follows the points both ways
+//
+// A cloud of a kilometer is overwritten by one of a meter, point by point and all at once, and is cut down
+// by removals. Points written after the box is refit have to get the step of the small cloud instead of the
+// step of the box the large one left behind. Points written before keep their error, it is not recovered.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerQuantizationTest, "ShapesVisualizer.PointStorage.Quantization",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerQuantizationTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumPoints = 4000;
+    // Half a step of a box twice the size of the small cloud, per axis
+    const float SmallError = FVector{ 200.f / 65535.f }.Size();
+
+    FRandomStream Random{ 11 };
+    TArray<FVector> Large;
+    TArray<FVector> Small;
+    for (int32 Index = 0; Index < NumPoints; Index++)
+    {
+        Large.Add(Random.GetUnitVector() * Random.FRandRange(0.f, 100000.f));
+        Small.Add(Random.GetUnitVector() * Random.FRandRange(0.f, 100.f));
+    }
+
+    // The first lap of single point writes refits the box, the second one gets its step
+    FShapesVisualizerPointStorage Storage{ EVisualPointsFormat::Quantized, Large };
+    for (int32 Lap = 0; Lap < 2; Lap++)
+    {
+        for (int32 Index = 0; Index < NumPoints; Index++)
+            Storage.Set(Index, Small[Index]);
+    }
+    TestTrue(TEXT("Points overwritten one by one refit the box"), GetMaxError_Internal(Storage, Small) <= SmallError);
+
+    Storage.Reset(EVisualPointsFormat::Quantized, Large);
+    Storage.Update(0, Small);
+    TestTrue(TEXT("Points overwritten at once refit the box"), GetMaxError_Internal(Storage, Small) <= SmallError);
+
+    // The large points are left only at the end, removing them shrinks the box
+    TArray<FVector> Mixed = Small;
+    Mixed.Append(Large);
+    Storage.Reset(EVisualPointsFormat::Quantized, Mixed);
+    Storage.RemoveAt(NumPoints, NumPoints);
+    TestEqual(TEXT("Removal keeps the rest"), Storage.Num(), NumPoints);
+    const TArrayView<const FVector> Written = MakeArrayView(Small.GetData(), 100);
+    Storage.Update(0, Written);
+    TestTrue(TEXT("Removal refits the box"), GetMaxError_Internal(Storage, Written) <= SmallError);
+
+    // Streamed points grow the box without losing the ones already stored
+    Storage.Reset(EVisualPointsFormat::Quantized, Small);
+    Storage.Update(NumPoints, Large);
+    TestTrue(TEXT("Growth keeps the stored points"), GetMaxError_Internal(Storage, Mixed) <= FVector{ 400000.f / 65535.f }.Size());
+    return true;
+}
+
+//
+// FShapesVisualizerCompactPointsTest - a component without KeepPoints holds only the compact points
+//
+// The component is not registered, so it counts as outside of an editor world. Points has to stay empty
+// through the setters, while GetPoints returns the decoded points and SetKeepPoints brings them back.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerCompactPointsTest, "ShapesVisualizer.PointStorage.CompactComponent",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerCompactPointsTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random{ 13 };
+    TArray<FVector> Points;
+    for (int32 Index = 0; Index < 10000; Index++)
+        Points.Add(Random.GetUnitVector() * Random.FRandRange(0.f, 1000.f));
+
+    UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(GetTransientPackage());
+    Component->SetPointsFormat(EVisualPointsFormat::Quantized);
+    Component->SetKeepPoints(false);
+    Component->SetPointsShape(Points);
+    Component->AppendPoints(TArray<FVector>{ FVector{ 500.f } });
+    Component->UpdatePointRange(0, TArray<FVector>{ FVector::ZeroVector });
+    Component->RemovePointRange(1, 1);
+
+    const FShapesVisualizerPointStorage* const Compact = Component->GetCompactPoints();
+    TestNotNull(TEXT("The component keeps compact points"), Compact);
+    TestEqual(TEXT("Points stays empty"), Component->Points.Num(), 0);
+    TestEqual(TEXT("Edits reach the compact points"), Component->GetNumPoints(), Points.Num());
+    if (Compact)
+    {
+        AddInfo(FString::Printf(TEXT("%d points in %llu bytes instead of %llu"), Compact->Num(),
+            static_cast<uint64>(Compact->GetAllocatedSize()), static_cast<uint64>(Points.GetAllocatedSize())));
+        TestTrue(TEXT("Compact points take less than the vectors"), Compact->GetAllocatedSize() < Points.GetAllocatedSize());
+    }
+
+    const TArray<FVector> Decoded = Component->GetPoints();
+    const float Step = FVector{ 2000.f * 1.5f / 65535.f }.Size();
+    TestTrue(TEXT("The first point is overwritten"), Decoded.Num() > 0 && Decoded[0].Equals(FVector::ZeroVector, Step));
+    TestTrue(TEXT("The appended point is last"), Decoded.Num() > 0 && Decoded.Last().Equals(FVector{ 500.f }, Step));
+
+    Component->SetKeepPoints(true);
+    TestNull(TEXT("KeepPoints decodes the compact points"), Component->GetCompactPoints());
+    TestEqual(TEXT("Points holds them again"), Component->Points.Num(), Decoded.Num());
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
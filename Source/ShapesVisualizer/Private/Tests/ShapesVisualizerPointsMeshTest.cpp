@@ -0,0 +1,74 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "RenderingThread.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerPointStorage.h"
+#include "ShapesVisualizerPointsMesh.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerPointsMeshBenchmark - one draw and bounded buffers from 100 to 10M points
+//
+// Builds the merged mesh the way the scene proxy does, then moves one point and rescales the component.
+// Run with -nullrhi on machines without a GPU, the timings are the render thread work of the proxy.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerPointsMeshBenchmark, "ShapesVisualizer.PointsMesh.Benchmark",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FShapesVisualizerPointsMeshBenchmark::RunTest(const FString& Parameters)
+{
+    FRandomStream Random{ 3 };
+    for (const int32 NumPoints : { 100, 1000, 10000, 100000, 1000000, 10000000 })
+    {
+        TArray<FVector> Points;
+        Points.SetNumUninitialized(NumPoints);
+        for (FVector& Point : Points)
+            Point = Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f);
+        const FShapesVisualizerPointStorage Storage{ EVisualPointsFormat::Vector, Points };
+
+        double BuildSeconds = 0.0;
+        double UpdateSeconds = 0.0;
+        double ScaleSeconds = 0.0;
+        int32 NumVertices = 0;
+        int32 NumDrawIndices = 0;
+        int32 Stride = 0;
+        int32 Sides = 0;
+
+        ENQUEUE_RENDER_COMMAND(ShapesVisualizerPointsMeshBenchmark)(
+            [&](FRHICommandListImmediate& RHICmdList)
+            {
+                FShapesVisualizerPointsMesh Mesh{ GMaxRHIFeatureLevel };
+
+                double StartTime = FPlatformTime::Seconds();
+                Mesh.Build(Storage, 10.f, FVector::OneVector, 16, false);
+                BuildSeconds = FPlatformTime::Seconds() - StartTime;
+
+                StartTime = FPlatformTime::Seconds();
+                Mesh.Update(Storage, 0, 1);
+                UpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+                StartTime = FPlatformTime::Seconds();
+                Mesh.SetScale(Storage, FVector{ 2.f });
+                ScaleSeconds = FPlatformTime::Seconds() - StartTime;
+
+                NumVertices = Mesh.GetBuffers().GetNumVertices();
+                NumDrawIndices = Mesh.GetBuffers().GetNumDrawIndices();
+                Stride = Mesh.GetStride();
+                Sides = Mesh.GetNumSides(0);
+            });
+        FlushRenderingCommands();
+
+        AddInfo(FString::Printf(TEXT("%d points: 1 draw, %d sides, stride %d, %d vertices, %d indices, build %.2f ms, update %.3f ms, rescale %.2f ms"),
+            NumPoints, Sides, Stride, NumVertices, NumDrawIndices, BuildSeconds * 1000.0, UpdateSeconds * 1000.0, ScaleSeconds * 1000.0));
+        TestTrue(TEXT("Points mesh stays within MaxPointsVertices"), NumVertices <= ShapesVisualizerGeometry::MaxPointsVertices);
+        TestTrue(TEXT("Every drawn slot has its indices"), NumDrawIndices > 0);
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
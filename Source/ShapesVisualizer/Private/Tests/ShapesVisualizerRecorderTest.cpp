@@ -0,0 +1,134 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerRecorder.h"
+#include "ShapesVisualizerRecording.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerPointCodecTest - quantized points survive the delta varints, damaged runs are refused
+//
+// Random and extreme coordinates are encoded and decoded back. Runs cut short, with extra bytes or with
+// a varint longer than 32 bits have to fail instead of reading past their bytes.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerPointCodecTest, "ShapesVisualizer.Recording.PointCodec",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerPointCodecTest::RunTest(const FString& Parameters)
+{
+    using namespace ShapesVisualizerRecording;
+
+    FRandomStream Random{ 17 };
+    TArray<int32> Quantized;
+    for (int32 Index = 0; Index < 3000; Index++)
+        Quantized.Add(QuantizeCoordinate(Random.FRandRange(-1e6f, 1e6f), 0.1f));
+    Quantized.Append({ MIN_int32, MAX_int32, 0, MAX_int32, MIN_int32, -1 });
+
+    TArray<uint8> Data;
+    const int32 Bytes = EncodePoints(Quantized, Data);
+    TestEqual(TEXT("Encoded runs are padded to 4 bytes"), Data.Num(), Align(Bytes, 4));
+    TestTrue(TEXT("Deltas take less than the floats"), Bytes < Quantized.Num() * static_cast<int32>(sizeof(float)));
+
+    const int32 Count = Quantized.Num() / 3;
+    TArray<int32> Decoded;
+    Decoded.SetNumZeroed(Quantized.Num());
+    TestTrue(TEXT("The run decodes"), DecodePoints(Data.GetData(), Bytes, Count, Decoded.GetData()));
+    TestTrue(TEXT("Decoded points match the encoded ones"), Decoded == Quantized);
+
+    TestFalse(TEXT("A run cut short fails"), DecodePoints(Data.GetData(), Bytes - 1, Count, Decoded.GetData()));
+    TestFalse(TEXT("A run with bytes left over fails"), DecodePoints(Data.GetData(), Bytes, Count - 1, Decoded.GetData()));
+    const uint8 Overlong[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0x00, 0x00 };
+    TestFalse(TEXT("A varint over 32 bits fails"), DecodePoints(Overlong, UE_ARRAY_COUNT(Overlong), 1, Decoded.GetData()));
+    return true;
+}
+
+//
+// FShapesVisualizerRecorderOverheadTest - recording cost of 5000 visualizers against a 60 Hz frame
+//
+// A game world with 4000 sized shapes and 1000 point sets of 100 points. Every frame moves 5% of
+// them and changes a point of 2% of the point sets, then the recorder ticks. Only the tick is timed,
+// the target is below 1% of the frame. The file goes to the automation transient directory.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerRecorderOverheadTest, "ShapesVisualizer.Recording.Overhead",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FShapesVisualizerRecorderOverheadTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 NumComponents = 5000;
+    constexpr int32 NumPointSets = 1000;
+    constexpr int32 NumFrames = 300;
+    constexpr float FrameSeconds = 1.f / 60.f;
+
+    UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+    UShapesVisualizerRecorder* const Recorder = World->GetSubsystem<UShapesVisualizerRecorder>();
+    if (!TestNotNull(TEXT("The world has the recorder"), Recorder))
+    {
+        World->DestroyWorld(false);
+        return false;
+    }
+
+    FRandomStream Random{ 3 };
+    TArray<UShapesVisualizerComponent*> Components;
+    for (int32 Index = 0; Index < NumComponents; Index++)
+    {
+        UShapesVisualizerComponent* const Component = NewObject<UShapesVisualizerComponent>(World);
+        Component->SetWorldLocation(Random.GetUnitVector() * Random.FRandRange(0.f, 100000.f));
+        if (Index < NumPointSets)
+        {
+            TArray<FVector> Points;
+            for (int32 Point = 0; Point < 100; Point++)
+                Points.Add(Random.GetUnitVector() * Random.FRandRange(0.f, 1000.f));
+            Component->SetPointsShape(MoveTemp(Points));
+        }
+        else
+            Component->SetSizedShape(static_cast<EVisualShape>(Index % 6), 50.f, 100.f, FVector{ 50.f });
+        Component->RegisterComponentWithWorld(World);
+        Components.Add(Component);
+    }
+
+    const FString FileName = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("RecorderOverhead.svrec")));
+    TestTrue(TEXT("Recording starts"), Recorder->StartRecording(FileName));
+
+    double TickSeconds = 0.0;
+    for (int32 Frame = 0; Frame < NumFrames; Frame++)
+    {
+        for (int32 Move = 0; Move < NumComponents / 20; Move++)
+        {
+            UShapesVisualizerComponent* const Component = Components[Random.RandHelper(NumComponents)];
+            Component->SetWorldLocation(Component->GetComponentLocation() + Random.GetUnitVector() * 10.f);
+        }
+        for (int32 Change = 0; Change < NumPointSets / 50; Change++)
+        {
+            UShapesVisualizerComponent* const Component = Components[Random.RandHelper(NumPointSets)];
+            Component->UpdatePointRange(Random.RandHelper(100), TArray<FVector>{ Random.GetUnitVector() * 1000.f });
+        }
+
+        const double StartTime = FPlatformTime::Seconds();
+        Recorder->Tick(FrameSeconds);
+        TickSeconds += FPlatformTime::Seconds() - StartTime;
+    }
+    Recorder->Stop();
+
+    const double FrameMs = TickSeconds * 1000.0 / NumFrames;
+    const double Percent = TickSeconds / NumFrames / FrameSeconds * 100.0;
+    AddInfo(FString::Printf(TEXT("%d components: %.3f ms per frame, %.2f%% of a 60 Hz frame, %lld bytes written"),
+        NumComponents, FrameMs, Percent, IFileManager::Get().FileSize(*FileName)));
+    if (Percent >= 1.0)
+        AddWarning(FString::Printf(TEXT("Recording takes %.2f%% of the frame, the target is below 1%%"), Percent));
+
+    IFileManager::Get().Delete(*FileName);
+    for (UShapesVisualizerComponent* Component : Components)
+        Component->DestroyComponent();
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
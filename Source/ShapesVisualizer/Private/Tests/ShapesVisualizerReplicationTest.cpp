@@ -0,0 +1,79 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Components/ShapesVisualizerComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // Writes State against OldState like a connection would, the written bits stay in Writer
+    bool WriteDelta_Internal(FShapesVisualizerNetState& State, INetDeltaBaseState* OldState,
+        TSharedPtr<INetDeltaBaseState>& OutNewState, FBitWriter& Writer)
+    {
+        FNetDeltaSerializeInfo Parms;
+        Parms.Writer = &Writer;
+        Parms.OldState = OldState;
+        Parms.NewState = &OutNewState;
+        return State.NetDeltaSerialize(Parms);
+    }
+
+    bool ReadDelta_Internal(FShapesVisualizerNetState& State, FBitWriter& Writer)
+    {
+        FBitReader Reader{ Writer.GetData(), Writer.GetNumBits() };
+        FNetDeltaSerializeInfo Parms;
+        Parms.Reader = &Reader;
+        return State.NetDeltaSerialize(Parms) && Reader.AtEnd();
+    }
+}
+
+//
+// FShapesVisualizerNetStateTest - connections get only the members changed since their last state
+//
+// A new connection gets the members which differ from the defaults, a connection which has the state gets
+// nothing, and a moved component sends only its location. The bits written have to be the bits counted,
+// and the client has to end up with the server state after every delta.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerNetStateTest, "ShapesVisualizer.Replication.NetStateDelta",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerNetStateTest::RunTest(const FString& Parameters)
+{
+    FShapesVisualizerNetState Server;
+    Server.Location = FVector{ 100.f, -20.f, 5.f };
+    Server.Shape = EVisualShape::Polyline;
+    Server.Color = FColor::Red;
+    Server.NumPoints = 1000;
+    Server.TrailCapacity = 1024;
+    Server.TrailPushes = 1000;
+
+    FShapesVisualizerNetState Client;
+    TSharedPtr<INetDeltaBaseState> ConnectionState;
+    FBitWriter FirstWriter{ 0, true };
+    TestTrue(TEXT("A new connection gets the state"), WriteDelta_Internal(Server, nullptr, ConnectionState, FirstWriter));
+    TestTrue(TEXT("The connection has a state to write the next delta against"), ConnectionState.IsValid());
+    TestTrue(TEXT("The client reads the whole delta"), ReadDelta_Internal(Client, FirstWriter));
+    TestEqual(TEXT("The client has the server state"), Client.GetChangedMembers(Server), 0u);
+    TestEqual(TEXT("Written bits are counted"), Server.TakeBitsSent(), FirstWriter.GetNumBits());
+
+    FBitWriter SameWriter{ 0, true };
+    TSharedPtr<INetDeltaBaseState> SameState;
+    TestFalse(TEXT("An unchanged state writes nothing"), WriteDelta_Internal(Server, ConnectionState.Get(), SameState, SameWriter));
+    TestEqual(TEXT("Nothing is counted"), Server.TakeBitsSent(), static_cast<int64>(0));
+
+    Server.Location = FVector{ 110.f, -20.f, 5.f };
+    FBitWriter MoveWriter{ 0, true };
+    TSharedPtr<INetDeltaBaseState> MovedState;
+    TestTrue(TEXT("A moved component writes a delta"), WriteDelta_Internal(Server, ConnectionState.Get(), MovedState, MoveWriter));
+    TestTrue(TEXT("The client reads the move"), ReadDelta_Internal(Client, MoveWriter));
+    TestEqual(TEXT("The client follows the move"), Client.GetChangedMembers(Server), 0u);
+    AddInfo(FString::Printf(TEXT("First state %lld bits, move %lld bits"), FirstWriter.GetNumBits(), MoveWriter.GetNumBits()));
+    TestTrue(TEXT("Only the location goes"), MoveWriter.GetNumBits() < FirstWriter.GetNumBits());
+    TestFalse(TEXT("The moved state differs from the old one"), MovedState->IsStateEqual(ConnectionState.Get()));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
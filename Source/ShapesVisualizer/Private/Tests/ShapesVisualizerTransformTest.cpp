@@ -0,0 +1,79 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerGeometry.h"
+#include "ShapesVisualizerPointStorage.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// FShapesVisualizerTransformTest - the vectorized position transform matches the scalar one
+//
+// Random transforms with rotation, translation and non uniform, also mirrored, scale. Compares separate
+// and in place output, and the chunked transform of every point format against its decoded points.
+//
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShapesVisualizerTransformTest, "ShapesVisualizer.Geometry.TransformPositions",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShapesVisualizerTransformTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random{ 5 };
+
+    // Odd count, so the tail after any unrolled part is covered too
+    TArray<FVector> Positions;
+    Positions.SetNumUninitialized(1027);
+    for (FVector& Position : Positions)
+        Position = Random.GetUnitVector() * Random.FRandRange(0.f, 100000.f);
+
+    for (int32 Run = 0; Run < 8; Run++)
+    {
+        const FVector Scale{ Random.FRandRange(-4.f, 4.f), Random.FRandRange(0.1f, 4.f), Random.FRandRange(0.1f, 4.f) };
+        const FTransform Transform{ FRotator{ Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f) },
+            Random.GetUnitVector() * Random.FRandRange(0.f, 100000.f), Scale };
+        const FMatrix LocalToWorld = Transform.ToMatrixWithScale();
+
+        TArray<FVector> Scalar;
+        TArray<FVector> Vectorized;
+        Scalar.SetNumUninitialized(Positions.Num());
+        Vectorized.SetNumUninitialized(Positions.Num());
+        ShapesVisualizerGeometry::TransformPositionsScalar(LocalToWorld, Positions, Scalar.GetData());
+        ShapesVisualizerGeometry::TransformPositions(LocalToWorld, Positions, Vectorized.GetData());
+
+        TArray<FVector> InPlace = Positions;
+        ShapesVisualizerGeometry::TransformPositions(LocalToWorld, InPlace, InPlace.GetData());
+
+        // Fused multiply adds round differently, the error is relative to the size of the result
+        int32 NumMismatches = 0;
+        for (int32 Index = 0; Index < Positions.Num(); Index++)
+        {
+            const float Tolerance = 1e-5f * FMath::Max(Scalar[Index].GetAbsMax(), 1.f);
+            if (!Vectorized[Index].Equals(Scalar[Index], Tolerance) || !InPlace[Index].Equals(Scalar[Index], Tolerance))
+                NumMismatches++;
+        }
+        TestEqual(FString::Printf(TEXT("Vectorized and scalar transforms match, run %d"), Run), NumMismatches, 0);
+
+        for (const EVisualPointsFormat Format : { EVisualPointsFormat::Vector, EVisualPointsFormat::Float, EVisualPointsFormat::Quantized })
+        {
+            const FShapesVisualizerPointStorage Storage{ Format, Positions };
+            TArray<FVector> Stored;
+            Stored.SetNumUninitialized(Storage.Num());
+            Storage.TransformPositions(LocalToWorld, 0, Storage.Num(), Stored.GetData());
+
+            int32 NumStorageMismatches = 0;
+            for (int32 Index = 0; Index < Storage.Num(); Index++)
+            {
+                const FVector Expected = LocalToWorld.TransformPosition(Storage[Index]);
+                if (!Stored[Index].Equals(Expected, 1e-5f * FMath::Max(Expected.GetAbsMax(), 1.f)))
+                    NumStorageMismatches++;
+            }
+            TestEqual(FString::Printf(TEXT("Storage format %d transforms its decoded points, run %d"), static_cast<int32>(Format), Run),
+                NumStorageMismatches, 0);
+        }
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,222 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "Components/PrimitiveComponent.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "RenderCommandFence.h"
+#include "ShapesVisualizerBatchComponent.generated.h"
+
+//
+// FShapesVisualizerBatchShape - description of one shape of the batch
+//
+
+USTRUCT(BlueprintType)
+struct FShapesVisualizerBatchShape
+{
+    GENERATED_BODY()
+
+    // Points and Polyline are not supported by the batch
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    EVisualShape Shape = EVisualShape::Sphere;
+
+    // Relative to the component
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    FTransform Transform;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape", meta = (ClampMin = "0.0"))
+    float Radii = 50.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    float Height = 100.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    FVector Extent { 50.f, 50.f, 50.f };
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Appearance")
+    FColor Color { 223, 149, 157 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Appearance")
+    bool Wireframe = false;
+};
+
+//
+// FShapesVisualizerBatchHandle - reference to a shape of the batch
+//
+
+USTRUCT(BlueprintType)
+struct FShapesVisualizerBatchHandle
+{
+    GENERATED_BODY()
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+
+    int32 Index = INDEX_NONE;
+    // Tells apart the shapes which reused the same slot
+    uint32 Serial = 0;
+};
+
+//
+// FShapesVisualizerBatchArrays - shapes of the batch in structure of arrays form
+//
+// Removed shapes keep their slots with the Used flag cleared until the slot is reused.
+//
+
+struct FShapesVisualizerBatchArrays
+{
+    enum : uint8
+    {
+        FlagUsed = 1 << 0,
+        FlagWireframe = 1 << 1
+    };
+
+    TArray<EVisualShape> Shapes;
+    TArray<FTransform> Transforms;
+    TArray<float> Radii;
+    TArray<float> Heights;
+    TArray<FVector> Extents;
+    TArray<FColor> Colors;
+    TArray<uint8> Flags;
+
+    int32 Num() const { return Shapes.Num(); }
+    bool IsUsed(int32 Index) const { return (Flags[Index] & FlagUsed) != 0; }
+    bool IsWireframe(int32 Index) const { return (Flags[Index] & FlagWireframe) != 0; }
+
+    // Grows the arrays when Index is past the end
+    void Set(int32 Index, const FShapesVisualizerBatchShape& InShape);
+    void Clear(int32 Index);
+    void Empty();
+    // Removes every slot, the memory is kept for the next shapes
+    void Reset();
+    void CopyFrom(const FShapesVisualizerBatchArrays& Other);
+    // Every slot, the used ones and the free ones
+    void Serialize(FArchive& Ar);
+
+    FBox GetShapeBox(int32 Index) const;
+    SIZE_T GetAllocatedSize() const;
+};
+
+//
+// UShapesVisualizerBatchComponent - many shapes drawn by one primitive
+//
+
+UCLASS(Blueprintable, ClassGroup=Utility,
+    hideCategories = (Activation, Lighting, Navigation, Physics, Collision, Tags, Cooking),
+    meta=(BlueprintSpawnableComponent))
+class UShapesVisualizerBatchComponent : public UPrimitiveComponent
+{
+    GENERATED_BODY()
+
+public:
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance", AdvancedDisplay, meta = (ClampMin = "0.0"))
+    float LineThickness = 0.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance", AdvancedDisplay, meta = (ClampMin = "8", ClampMax = "64"))
+    int32 NumSides = 24;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
+    bool ShowOnlyWhenSelected = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
+    bool WantsSelectionOutline = true;
+
+    // Order of the visualizers within r.ShapesVisualizer.Budget.*, the batch counts as one visualizer
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rendering")
+    int32 Priority = 0;
+
+public:
+
+    UShapesVisualizerBatchComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+    // UObject Interface
+
+    virtual void Serialize(FArchive& Ar) override;
+
+    // UPrimitiveComponent Interface
+
+    virtual void OnRegister() override;
+    virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+    virtual void GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials = false) const override;
+
+protected:
+
+    // The proxy merges the changed shapes once per frame
+    virtual void SendRenderDynamicData_Concurrent() override;
+
+public:
+
+    // Returns an invalid handle for Points and Polyline
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    FShapesVisualizerBatchHandle AddShape(const FShapesVisualizerBatchShape& InShape);
+
+    // False if the handle does not refer to a shape of the batch anymore
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    bool UpdateShape(const FShapesVisualizerBatchHandle& Handle, const FShapesVisualizerBatchShape& InShape);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    bool RemoveShape(const FShapesVisualizerBatchHandle& Handle);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void ClearShapes();
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetPriority(int32 InPriority = 0);
+
+    // Replaces every shape of the batch with InOutShapes, handles of the old shapes become invalid.
+    // InOutShapes gets the old arrays back, so batches rebuilt every frame reuse their memory
+    void SetShapes(FShapesVisualizerBatchArrays& InOutShapes);
+
+    UFUNCTION(BlueprintPure, Category = "Components|ShapesVisualizer")
+    int32 GetNumShapes() const { return NumShapes; }
+
+    const FShapesVisualizerBatchArrays& GetBatchArrays() const { return Batch; }
+
+    // Shape changes until the matching EndUpdate reach the proxy with one render command
+    // and update the bounds once. Scopes can be nested
+    void BeginUpdate();
+    void EndUpdate();
+
+private:
+
+    bool IsValidHandle(const FShapesVisualizerBatchHandle& Handle) const;
+    // Serials, free slots, count and bounds of the slots of Batch
+    void RebuildSlots();
+    // Sends the shape of the slot to the proxy, cleared if InShape is null
+    bool SendShape(int32 Index, const FShapesVisualizerBatchShape* InShape);
+    // Updates bounds and the render state after the shapes have been changed
+    void OnShapesChanged(bool Sent, bool BoundsChanged);
+    // Copies the batch into a snapshot the render thread is done with and sends it, OutSent as EnqueueBatchCommand.
+    // False if every snapshot is still in flight
+    bool SendSnapshot(bool& OutSent);
+
+private:
+
+    // Slot changes collected by the update scope, in order
+    struct FPendingShape
+    {
+        int32 Index;
+        bool Used;
+        FShapesVisualizerBatchShape Shape;
+    };
+
+    FShapesVisualizerBatchArrays Batch;
+    // Game thread only, the render thread needs neither serials nor the free list
+    TArray<uint32> Serials;
+    TArray<int32> FreeSlots;
+    int32 NumShapes = 0;
+    // Local bounds of the shapes, grown incrementally, exact again after registration
+    FBox ShapesBox{ ForceInit };
+
+    int32 UpdateDepth = 0;
+    TArray<FPendingShape> PendingShapes;
+    bool PendingBoundsChanged = false;
+
+    // Batches handed to the proxy by SetShapes, the proxy swaps one with its own arrays and the fence
+    // tells when the game thread may refill it. Three, so a game thread a frame ahead always finds one
+    FShapesVisualizerBatchArrays Snapshots[3];
+    FRenderCommandFence SnapshotFences[3];
+    // SetShapes found no free snapshot, the core ticker sends the batch as soon as one is free
+    bool SnapshotPending = false;
+};
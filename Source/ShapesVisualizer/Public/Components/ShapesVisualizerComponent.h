@@ -3,8 +3,12 @@
 #pragma once
 
 #include "Components/PrimitiveComponent.h"
+#include "Engine/NetSerialization.h"
+#include "Net/Serialization/FastArraySerializer.h"
 #include "ShapesVisualizerComponent.generated.h"
 
+class FShapesVisualizerPointStorage;
+
 //
 // EVisualShape - enum of all available shapes
 //
@@ -21,7 +25,179 @@ enum class EVisualShape : uint8
     // Drawing an array of points with specified radii
     Points,
     // Drawing a polyline by specified array of points
-    Polyline
+    Polyline,
+    // Drawing a 3D grid of colored cells, merged into greedy quads of the visible faces
+    Grid
+};
+
+//
+// EVisualPointsFormat - how the scene proxy keeps the points
+//
+
+UENUM(BlueprintType)
+enum class EVisualPointsFormat : uint8
+{
+    // Full precision, same as Points
+    Vector,
+    // 3 floats per point, half the size of Points in double precision builds
+    Float,
+    // 16 bits per axis inside the bounds of the points
+    Quantized
+};
+
+//
+// FShapesVisualizerNetState - quantized state of a replicated component
+//
+// Every connection gets only the members changed since the state it was sent last,
+// the bits written to the connections are counted for the bandwidth stats.
+//
+
+USTRUCT()
+struct FShapesVisualizerNetState
+{
+    GENERATED_BODY()
+
+    // Relative transform
+    UPROPERTY()
+    FVector_NetQuantize10 Location{ FVector::ZeroVector };
+
+    UPROPERTY()
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    UPROPERTY()
+    FVector_NetQuantize100 Scale{ FVector::OneVector };
+
+    // Shape, Radii, Height and LineThickness are packed into Dimensions
+    UPROPERTY()
+    EVisualShape Shape = EVisualShape::Sphere;
+
+    UPROPERTY()
+    FVector_NetQuantize10 Dimensions{ FVector::ZeroVector };
+
+    UPROPERTY()
+    FVector_NetQuantize10 Extent{ FVector::ZeroVector };
+
+    // Appearance
+    UPROPERTY()
+    FColor Color = FColor::White;
+
+    UPROPERTY()
+    uint8 Flags = 0;
+
+    UPROPERTY()
+    uint8 NumSides = 0;
+
+    // Points storage, the points themselves are in FShapesVisualizerNetPoints
+    UPROPERTY()
+    int32 NumPoints = 0;
+
+    UPROPERTY()
+    int32 TrailCapacity = 0;
+
+    UPROPERTY()
+    int32 TrailHead = 0;
+
+    // Points pushed to the trail so far, clients push the same points to their ring
+    UPROPERTY()
+    uint32 TrailPushes = 0;
+
+    // Changes of the points other than chunk updates and trail pushes, clients rebuild the points
+    UPROPERTY()
+    uint32 PointsResets = 0;
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+    // Server, bits written to all connections since the last call
+    int64 TakeBitsSent();
+    // One bit per member above which differs from Old
+    uint32 GetChangedMembers(const FShapesVisualizerNetState& Old) const;
+
+private:
+
+    void SerializeMembers(FArchive& Ar, uint32 Members, UPackageMap* Map);
+
+    int64 BitsSent = 0;
+};
+
+template <>
+struct TStructOpsTypeTraits<FShapesVisualizerNetState> : public TStructOpsTypeTraitsBase2<FShapesVisualizerNetState>
+{
+    enum { WithNetDeltaSerializer = true };
+};
+
+//
+// FShapesVisualizerNetPoints - points replicated in fixed size chunks
+//
+// The server compares the quantized points with the chunks and marks the changed ones,
+// so appended points, updated ranges and trail points send only their chunks.
+// Clients collect the chunks they receive and apply only those.
+//
+
+USTRUCT()
+struct FShapesVisualizerNetPointChunk : public FFastArraySerializerItem
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    int32 ChunkIndex = 0;
+
+    UPROPERTY()
+    TArray<FVector_NetQuantize10> Points;
+};
+
+USTRUCT()
+struct FShapesVisualizerNetPoints : public FFastArraySerializer
+{
+    GENERATED_BODY()
+
+    static constexpr int32 ChunkSize = 64;
+
+    UPROPERTY()
+    TArray<FShapesVisualizerNetPointChunk> Chunks;
+
+    // Client, indices of the chunks received since they were taken
+    TArray<int32> ReceivedChunks;
+
+    // Server, marks the changed chunks
+    void SetPoints(TArrayView<const FVector> InPoints);
+    // Client, received points in storage order, missing chunks are zero
+    void GetPoints(int32 NumPoints, TArray<FVector>& OutPoints) const;
+    // Client, points [StartIndex, StartIndex + Count), false if a chunk of them is missing
+    bool GetPoints(int32 StartIndex, int32 Count, FVector* OutPoints) const;
+    // Server, bits written to all connections since the last call
+    int64 TakeBitsSent();
+
+    void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+    void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+private:
+
+    int64 BitsSent = 0;
+};
+
+template <>
+struct TStructOpsTypeTraits<FShapesVisualizerNetPoints> : public TStructOpsTypeTraitsBase2<FShapesVisualizerNetPoints>
+{
+    enum { WithNetDeltaSerializer = true };
+};
+
+//
+// FShapesVisualizerSolidMesh - triangles of a solid visualizer in local space, for baking
+//
+
+struct FShapesVisualizerSolidMesh
+{
+    TArray<FVector> Positions;
+    TArray<FVector> TangentsX;
+    TArray<FVector> TangentsY;
+    TArray<FVector> Normals;
+    TArray<FVector2D> UVs;
+    TArray<uint32> Indices;
+    // Per vertex colors, empty if the whole mesh is of the component color
+    TArray<FColor> Colors;
+    // Scale of the unit mesh to the size of the shape, one for the meshes built at their size
+    FVector Scale = FVector::OneVector;
 };
 
 //
@@ -31,7 +207,7 @@ enum class EVisualShape : uint8
 UCLASS(Blueprintable, ClassGroup=Utility,
     hideCategories = (Activation, Lighting, Navigation, Physics, Collision, Tags, Cooking),
     meta=(BlueprintSpawnableComponent))
-class UShapesVisualizerComponent : public UPrimitiveComponent
+class SHAPESVISUALIZER_API UShapesVisualizerComponent : public UPrimitiveComponent
 {
     GENERATED_BODY()
 
@@ -40,7 +216,7 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape")
     EVisualShape Shape = EVisualShape::Sphere;
 
-    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (ClampMin = "0.0", EditConditionHides, EditCondition = "Shape != EVisualShape::Box && Shape != EVisualShape::Polyline"))
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (ClampMin = "0.0", EditConditionHides, EditCondition = "Shape != EVisualShape::Box && Shape != EVisualShape::Polyline && Shape != EVisualShape::Grid"))
     float Radii = 50.f;
 
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (EditConditionHides, EditCondition = "Shape == EVisualShape::Cylinder || Shape == EVisualShape::Cone || Shape == EVisualShape::Capsule"))
@@ -52,6 +228,28 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (EditConditionHides, EditCondition = "Shape == EVisualShape::Points || Shape == EVisualShape::Polyline"))
     TArray<FVector> Points;
 
+    // Render side copy of Points, compact formats trade precision for memory of large point sets
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", AdvancedDisplay, meta = (EditConditionHides, EditCondition = "Shape == EVisualShape::Points || Shape == EVisualShape::Polyline"))
+    EVisualPointsFormat PointsFormat = EVisualPointsFormat::Vector;
+
+    // Off with a compact PointsFormat, the component keeps its points in that format too and Points stays
+    // empty in game worlds, so no full precision copy is left. GetPoints decodes them. Trails keep Points.
+    // The proxy shares the compact points until one of the two changes them
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", AdvancedDisplay, meta = (EditConditionHides, EditCondition = "Shape == EVisualShape::Points || Shape == EVisualShape::Polyline"))
+    bool KeepPoints = true;
+
+    // Number of cells per axis, the grid is centered on the component
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (ClampMin = "0", EditConditionHides, EditCondition = "Shape == EVisualShape::Grid"))
+    FIntVector GridSize { 8, 8, 8 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Shape", meta = (EditConditionHides, EditCondition = "Shape == EVisualShape::Grid"))
+    FVector CellSize { 10.f, 10.f, 10.f };
+
+    // Colors of the cells, X fastest, then Y and Z. Cells of zero alpha are empty.
+    // Drawn with vertex colors, Color is not used
+    UPROPERTY(BlueprintReadOnly, Category = "Shape")
+    TArray<FColor> GridCells;
+
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
     FColor Color { 223, 149, 157 };
 
@@ -70,14 +268,37 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
     bool WantsSelectionOutline = true;
 
+    // Order of the visualizers within r.ShapesVisualizer.Budget.*, higher ones are drawn first
+    // and the lower ones wait for the next frames once the budget is spent
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rendering")
+    int32 Priority = 0;
+
+    // Replicated components sample their state at most this often, changes in between are sent together
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication", meta = (ClampMin = "0.0"))
+    float NetUpdateInterval = 0.1f;
+
+    // Builds the solid mesh once and draws it through the static mesh path.
+    // Suited for visualizers that never change after placement
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rendering", meta = (EditCondition = "!Wireframe && Shape != EVisualShape::Points && Shape != EVisualShape::Polyline && Shape != EVisualShape::Grid"))
+    bool StaticDraw = false;
+
 public:
 
     UShapesVisualizerComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
     // UPrimitiveComponent Interface
 
+    virtual void OnRegister() override;
     virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    virtual void SendRenderDynamicData_Concurrent() override;
     virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+    virtual void GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials = false) const override;
+
+    // UActorComponent Interface
+
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+    virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+    virtual void PostRepNotifies() override;
 
 public:
 
@@ -99,12 +320,94 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
     void SetCapsuleShape(float InRadii = 50.f, float InHeight = 100.f);
 
+    // Any shape but Points and Polyline, Radii, Height and Extent are used as the matching Set*Shape needs them
+    void SetSizedShape(EVisualShape InShape, float InRadii, float InHeight, const FVector& InExtent);
+
     UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
     void SetPointsShape(const TArray<FVector>& InPoints);
 
     UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
     void SetPolylineShape(const TArray<FVector>& InPoints);
 
+    // Appends points to the end of Points, only the new points are sent to the render thread
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void AppendPoints(const TArray<FVector>& InPoints);
+
+    // Overwrites points starting at StartIndex, the ones past the end are appended
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void UpdatePointRange(int32 StartIndex, const TArray<FVector>& InPoints);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void RemovePointRange(int32 StartIndex, int32 Count);
+
+    // Turns the polyline into a trail of the last InCapacity points, the newest points of the current
+    // polyline are kept. Point ranges of a trail are counted from the oldest point
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetTrailShape(int32 InCapacity = 1024);
+
+    // Adds the point to the trail in O(1), the oldest point is dropped when the trail is full.
+    // Without a trail the point is appended
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void PushTrailPoint(const FVector& InPoint);
+
+    int32 GetTrailCapacity() const { return TrailCapacity; }
+    int32 GetTrailHead() const { return TrailHead; }
+    // Changes with every change of Points made through the setters
+    uint32 GetPointsSerial() const { return PointsSerial; }
+
+    // Points, decoded if the component keeps them compact
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    TArray<FVector> GetPoints() const;
+
+    int32 GetNumPoints() const;
+    // Points as they are, or decoded into Scratch if the component keeps them compact
+    TArrayView<const FVector> GetPoints(TArray<FVector>& Scratch) const;
+    // Compact points of the component, null while Points holds them
+    const FShapesVisualizerPointStorage* GetCompactPoints() const { return CompactPoints.Get(); }
+    // The compact points for the proxy to share, read only while the component holds them too
+    TSharedPtr<FShapesVisualizerPointStorage, ESPMode::ThreadSafe> ShareCompactPoints() const { return CompactPoints; }
+    // Room for Number points wherever the component keeps them, the proxy sizes its points mesh for
+    // them as well. Holds until the points are set again
+    void ReservePoints(int32 Number);
+    int32 GetReservedPoints() const { return ReservedPoints; }
+
+    // Bytes written to all connections for the state and the points, averaged over the last second
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    float GetNetBytesPerSecond() const { return NetBytesPerSecond; }
+
+    void SetPointsShape(TArray<FVector>&& InPoints);
+    void SetPolylineShape(TArray<FVector>&& InPoints);
+    void AppendPoints(TArray<FVector>&& InPoints);
+    void UpdatePointRange(int32 StartIndex, TArray<FVector>&& InPoints);
+
+    // Cells must hold GridSize.X * GridSize.Y * GridSize.Z colors, grids are not replicated
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetGridShape(const FIntVector& InGridSize, const FVector& InCellSize, const TArray<FColor>& InCells);
+
+    // Overwrites the cells of the box [Start, Start + Size), only the chunks around it are remeshed
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetGridCells(const FIntVector& Start, const FIntVector& Size, const TArray<FColor>& InCells);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetGridCell(const FIntVector& Cell, const FColor& InColor);
+
+    // Colors the cells by value, values below MinValue are empty. The colors are quantized to NumSteps
+    // steps from LowColor to HighColor, so cells of close values merge into larger quads
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetGridValues(const TArray<float>& Values, float MinValue = 0.f, float MaxValue = 1.f,
+        FColor LowColor = FColor::Blue, FColor HighColor = FColor::Red, int32 NumSteps = 8);
+
+    void SetGridShape(const FIntVector& InGridSize, const FVector& InCellSize, TArray<FColor>&& InCells);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetPriority(int32 InPriority = 0);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetPointsFormat(EVisualPointsFormat InPointsFormat = EVisualPointsFormat::Vector);
+
+    UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
+    void SetKeepPoints(bool InKeepPoints = true);
+
     UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
     void SetColor(const FColor& InColor = FColor::White);
 
@@ -113,4 +416,82 @@ public:
 
     UFUNCTION(BlueprintCallable, Category = "Components|ShapesVisualizer")
     void SetNumSides(int32 InNumSides = 24);
+
+    // Solid mesh drawn by the proxy, whatever Wireframe is. Sphere, HalfSphere, Box, Cylinder and Cone
+    // come at unit size with OutMesh.Scale, so equal shapes of any size share one mesh.
+    // Grids come with the vertex colors of their cells. False for Polyline, empty Points and empty grids
+    bool GetSolidMesh(FShapesVisualizerSolidMesh& OutMesh) const;
+
+private:
+
+    void ResetPoints(EVisualShape InShape, TArray<FVector>&& InPoints);
+    // Moves Points into CompactPoints or back as KeepPoints, PointsFormat and the trail need
+    void UpdateCompactPoints();
+    void DecodeCompactPoints();
+    // CompactPoints to write, copied first while the proxy shares them
+    FShapesVisualizerPointStorage& GetMutableCompactPoints();
+    // Updates bounds and the render state after the points have been changed
+    void OnPointsChanged(bool Sent, bool BoundsChanged);
+    // Sends color, wireframe and sides to the existing proxy
+    void MarkAppearanceDirty();
+    // Rotates the trail so the oldest point is the first one
+    void LinearizeTrail();
+    // Game thread part of the trail pushes, the ring and its bounds
+    void AddTrailPoints(TArrayView<const FVector> InPoints);
+    // Server, samples the component into the replicated state
+    void UpdateNetState();
+    void AddNetBytes(int32 Bytes, float TimeSeconds);
+    // Client, received chunks go through UpdatePointRange, false if the points have to be rebuilt
+    bool ApplyNetChunks(TArray<int32>&& Chunks);
+    // Client, the newest points of the replicated ring are pushed to the trail, their chunks have to be in Chunks
+    bool ApplyNetTrailPushes(const TArray<int32>& Chunks);
+
+    UFUNCTION()
+    void OnRep_NetState();
+
+    UFUNCTION()
+    void OnRep_NetPoints();
+
+private:
+
+    // Local bounds of Points, grown incrementally by the points updates
+    FBox PointsBox{ ForceInit };
+
+    // Points in PointsFormat instead of Points, see KeepPoints
+    TSharedPtr<FShapesVisualizerPointStorage, ESPMode::ThreadSafe> CompactPoints;
+
+    // See ReservePoints
+    int32 ReservedPoints = 0;
+
+    // Points is a ring buffer of TrailCapacity points with the oldest one at TrailHead, 0 if not a trail
+    UPROPERTY()
+    int32 TrailCapacity = 0;
+
+    UPROPERTY()
+    int32 TrailHead = 0;
+
+    uint32 PointsSerial = 0;
+    // Server, see FShapesVisualizerNetState
+    uint32 TrailPushes = 0;
+    uint32 PointsResets = 0;
+
+    // Replication
+    UPROPERTY(ReplicatedUsing = OnRep_NetState)
+    FShapesVisualizerNetState NetState;
+
+    UPROPERTY(ReplicatedUsing = OnRep_NetPoints)
+    FShapesVisualizerNetPoints NetPoints;
+
+    uint32 NetPointsSerial = MAX_uint32;
+    float LastNetUpdateTime = -FLT_MAX;
+    // Client, the state the notifies were applied for, NetState has no old value in its notify
+    FShapesVisualizerNetState AppliedNetState;
+    // Client, points are applied once after all replicated properties of the update
+    bool NetPointsDirty = false;
+    uint32 NetTrailPushes = 0;
+    uint32 NetPointsResets = 0;
+    // Bandwidth of the last second
+    int32 NetBytes = 0;
+    float NetBytesTime = 0.f;
+    float NetBytesPerSecond = 0.f;
 };
@@ -0,0 +1,48 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+enum class EVisualShape : uint8;
+class UShapesVisualizerComponent;
+class UShapesVisualizerBatchComponent;
+struct FShapesVisualizerBatchShape;
+struct FShapesVisualizerBatchHandle;
+
+//
+// FShapesVisualizerCommands - shape changes submitted from any thread
+//
+// Commands go to a lock free multi producer queue and are applied on the game thread at the
+// beginning of the next frame, in the submission order of every producer. Producers never lock
+// or touch UObjects, they only allocate the queue node. Commands of destroyed components are
+// dropped, the changes of one batch component reach its proxy with one render command.
+// Take the weak pointers on the game thread and hand them to the workers.
+//
+
+class SHAPESVISUALIZER_API FShapesVisualizerCommands
+{
+public:
+
+    // Sized shapes, Radii, Height and Extent are used as the matching Set*Shape needs them
+    static void SetShape(const TWeakObjectPtr<UShapesVisualizerComponent>& Component,
+        EVisualShape Shape, float Radii, float Height, const FVector& Extent);
+    // Points or Polyline
+    static void SetPoints(const TWeakObjectPtr<UShapesVisualizerComponent>& Component,
+        EVisualShape Shape, TArray<FVector>&& Points);
+    static void AppendPoints(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, TArray<FVector>&& Points);
+    static void PushTrailPoint(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, const FVector& Point);
+    static void SetColor(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, const FColor& Color);
+    static void SetWireframe(const TWeakObjectPtr<UShapesVisualizerComponent>& Component, bool Wireframe, float LineThickness = 0.f);
+
+    // The handle of the added shape is not returned, use it for fire and forget shapes
+    static void AddShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch, const FShapesVisualizerBatchShape& Shape);
+    static void UpdateShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch,
+        const FShapesVisualizerBatchHandle& Handle, const FShapesVisualizerBatchShape& Shape);
+    static void RemoveShape(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch, const FShapesVisualizerBatchHandle& Handle);
+    static void ClearShapes(const TWeakObjectPtr<UShapesVisualizerBatchComponent>& Batch);
+
+    // Game thread. Applies the commands queued so far, the module calls it at the beginning of every frame
+    static void Flush();
+};
@@ -0,0 +1,122 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include <atomic>
+
+enum class EVisualShape : uint8;
+class FEvent;
+class FRunnableThread;
+class IMappedFileHandle;
+class IMappedFileRegion;
+class UShapesVisualizerComponent;
+
+//
+// FShapesVisualizerPointCloudLoader - streams a point cloud file into a Points or Polyline visualizer
+//
+// The file is memory mapped and converted on its own thread in chunks of ChunkSize points. At the beginning
+// of every frame the converted chunks are appended to the component, which sends only the new points to its
+// proxy and grows its bounds by them, so the cloud shows up while it loads. At most MaxPendingChunks wait for
+// the game thread, the loader never holds the whole cloud. The component reserves all points up front, and a
+// Points proxy builds its mesh once for all of them: clouds past ShapesVisualizerGeometry::MaxPointsVertices draw
+// every Nth point with the stride of the whole cloud. The count of the header is clamped to what the file can hold.
+//
+// Formats:
+//  - .svpc: FPointCloudHeader and NumPoints points of 3 little endian floats.
+//  - .ply: ascii or binary_little_endian, the vertex element must come first and have float or double
+//    x, y and z properties. Other properties are skipped, list properties of the vertices are not supported.
+//
+
+class SHAPESVISUALIZER_API FShapesVisualizerPointCloudLoader : public FRunnable
+{
+public:
+
+    static constexpr uint32 Magic = 0x43505653; // SVPC
+    static constexpr uint32 Version = 1;
+    static constexpr int32 ChunkSize = 64 * 1024;
+    static constexpr int32 MaxPendingChunks = 16;
+
+    struct FPointCloudHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        uint64 NumPoints;
+    };
+
+    // Game thread. Replaces the points of the component with the ones of the file, Shape is Points or Polyline.
+    // Null if the file is missing or not a point cloud
+    static TUniquePtr<FShapesVisualizerPointCloudLoader> Load(UShapesVisualizerComponent* Component,
+        const FString& FileName, EVisualShape Shape);
+    // Stops the loading, the points appended so far stay in the component
+    virtual ~FShapesVisualizerPointCloudLoader() override;
+
+    int64 GetNumPoints() const { return NumPoints; }
+    int64 GetNumAppended() const { return NumAppended; }
+    // All points are in the component, or the component is gone
+    bool IsDone() const { return Done; }
+    // From Load to the last appended chunk, or to now while loading
+    double GetLoadSeconds() const;
+
+    // FRunnable Interface
+
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+
+    enum class EFormat : uint8
+    {
+        Binary,
+        PlyAscii
+    };
+
+    FShapesVisualizerPointCloudLoader() = default;
+
+    bool Open(const FString& FileName);
+    bool ParsePlyHeader();
+    // Converts the next chunk into the queue, false once the file is read
+    bool ReadChunk();
+    // Game thread, appends the converted chunks to the component
+    void AppendChunks();
+
+private:
+
+    TWeakObjectPtr<UShapesVisualizerComponent> Component;
+    TUniquePtr<IMappedFileHandle> Handle;
+    TUniquePtr<IMappedFileRegion> Region;
+    const uint8* Data = nullptr;
+    int64 Size = 0;
+
+    // Layout of the points, binary vertices are Stride bytes with the coordinates at Offsets
+    EFormat Format = EFormat::Binary;
+    int64 DataOffset = 0;
+    int32 Stride = 0;
+    int32 Offsets[3] = {};
+    bool Doubles = false;
+    // Ascii vertices are lines of NumProperties values, the coordinates are at PropertyIndices
+    int32 NumProperties = 0;
+    int32 PropertyIndices[3] = {};
+    int64 NumPoints = 0;
+
+    // Worker thread
+    int64 NumRead = 0;
+    int64 ReadOffset = 0;
+
+    TQueue<TArray<FVector>, EQueueMode::Spsc> Chunks;
+    std::atomic<int32> NumPendingChunks{ 0 };
+    std::atomic<bool> ReadDone{ false };
+    std::atomic<bool> Stopping{ false };
+    FEvent* SpaceEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    FDelegateHandle BeginFrameHandle;
+
+    // Game thread
+    int64 NumAppended = 0;
+    bool Done = false;
+    double StartTime = 0.0;
+    double EndTime = 0.0;
+};
@@ -0,0 +1,85 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Components/ShapesVisualizerBatchComponent.h"
+#include "ShapesVisualizerSubsystem.generated.h"
+
+//
+// FShapesVisualizerDrawParams - size and appearance of an immediate mode shape
+//
+
+USTRUCT(BlueprintType)
+struct FShapesVisualizerDrawParams
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape", meta = (ClampMin = "0.0"))
+    float Radii = 50.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    float Height = 100.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shape")
+    FVector Extent { 50.f, 50.f, 50.f };
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Appearance")
+    FColor Color { 223, 149, 157 };
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Appearance")
+    bool Wireframe = false;
+};
+
+//
+// UShapesVisualizerSubsystem - immediate mode shapes of the world
+//
+// Shapes drawn for one frame live in a frame arena dropped as a whole every tick, the ones
+// with a lifetime are dropped once it is over. Both arenas keep their memory, so drawing
+// does not allocate in the steady state. Everything is drawn by one batch component
+// created on demand, the shapes reach its proxy with one render command per frame.
+//
+
+UCLASS()
+class SHAPESVISUALIZER_API UShapesVisualizerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+    GENERATED_BODY()
+
+public:
+
+    // Game thread. The shape is drawn for Duration seconds of world time, or one frame if Duration
+    // is zero. Points, Polyline and Grid are not supported, use the component for them
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer", meta = (AdvancedDisplay = "Duration"))
+    void DrawShape(EVisualShape Shape, const FTransform& Transform, const FShapesVisualizerDrawParams& Params, float Duration = 0.f);
+
+    UFUNCTION(BlueprintCallable, Category = "ShapesVisualizer")
+    void ClearShapes();
+
+    int32 GetNumShapes() const { return FrameShapes.Num() + TimedShapes.Num(); }
+
+    // USubsystem Interface
+
+    virtual void Deinitialize() override;
+
+    // FTickableGameObject Interface
+
+    virtual void Tick(float DeltaTime) override;
+    virtual ETickableTickType GetTickableTickType() const override;
+    virtual bool IsTickableInEditor() const override { return true; }
+    virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+    virtual TStatId GetStatId() const override;
+
+private:
+
+    TArray<FShapesVisualizerBatchShape> FrameShapes;
+    TArray<FShapesVisualizerBatchShape> TimedShapes;
+    // World time when the timed shape expires
+    TArray<float> ExpireTimes;
+    // Both arenas in the batch form, swapped with the arrays of the component every frame
+    FShapesVisualizerBatchArrays BatchShapes;
+    bool WasEmpty = true;
+
+    UPROPERTY(Transient)
+    UShapesVisualizerBatchComponent* BatchComponent = nullptr;
+};
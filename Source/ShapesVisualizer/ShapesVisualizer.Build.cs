@@ -9,6 +9,6 @@ public class ShapesVisualizer : ModuleRules
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
-		PrivateDependencyModuleNames.AddRange(new string[] { "CoreUObject", "RenderCore", "Engine" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "CoreUObject", "RenderCore", "Engine", "NetCore" });
 	}
 }
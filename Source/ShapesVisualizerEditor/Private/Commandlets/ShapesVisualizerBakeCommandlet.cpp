@@ -0,0 +1,117 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Commandlets/ShapesVisualizerBakeCommandlet.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "FileHelpers.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "ShapesVisualizerBaker.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogShapesVisualizerBakeCommandlet, Log, All);
+
+namespace
+{
+    // Map names are long package names, short names are searched on disk
+    bool GetMapPackageName_Internal(const FString& MapName, FString& OutPackageName)
+    {
+        if (FPackageName::IsValidLongPackageName(MapName))
+        {
+            OutPackageName = MapName;
+            return true;
+        }
+        return FPackageName::SearchForPackageOnDisk(MapName + FPackageName::GetMapPackageExtension(), &OutPackageName);
+    }
+
+    // Editor world of the map, initialized so actors can be spawned into it
+    UWorld* LoadWorld_Internal(const FString& PackageName)
+    {
+        UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+        UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+        if (!World)
+            return nullptr;
+
+        World->WorldType = EWorldType::Editor;
+        World->AddToRoot();
+        if (!World->bIsWorldInitialized)
+        {
+            World->InitWorld(UWorld::InitializationValues()
+                .AllowAudioPlayback(false)
+                .CreatePhysicsScene(false)
+                .RequiresHitProxies(false)
+                .CreateNavigation(false)
+                .CreateAISystem(false)
+                .ShouldSimulatePhysics(false)
+                .SetTransactional(false));
+        }
+        GEngine->CreateNewWorldContext(EWorldType::Editor).SetCurrentWorld(World);
+        World->UpdateWorldComponents(true, false);
+        return World;
+    }
+
+    void UnloadWorld_Internal(UWorld* World)
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+        World->RemoveFromRoot();
+        CollectGarbage(RF_NoFlags);
+    }
+}
+
+//
+// UShapesVisualizerBakeCommandlet
+//
+
+UShapesVisualizerBakeCommandlet::UShapesVisualizerBakeCommandlet()
+{
+    IsClient = false;
+    IsEditor = true;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UShapesVisualizerBakeCommandlet::Main(const FString& Params)
+{
+    FString MapsParam;
+    FString OutputPath = FShapesVisualizerBaker::DefaultPackagePath;
+    TArray<FString> MapNames;
+    if (FParse::Value(*Params, TEXT("Maps="), MapsParam))
+        MapsParam.ParseIntoArray(MapNames, TEXT("+"));
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+    const bool KeepSources = FParse::Param(*Params, TEXT("KeepSources"));
+
+    if (MapNames.Num() == 0 || !FPackageName::IsValidLongPackageName(OutputPath))
+    {
+        UE_LOG(LogShapesVisualizerBakeCommandlet, Error,
+            TEXT("Usage: -run=ShapesVisualizerBake -Maps=/Game/Maps/A+/Game/Maps/B [-Output=%s] [-KeepSources]"),
+            FShapesVisualizerBaker::DefaultPackagePath);
+        return 1;
+    }
+
+    // Streamed levels are maps of their own, they are baked when listed
+    int32 Result = 0;
+    for (const FString& MapName : MapNames)
+    {
+        FString PackageName;
+        UWorld* World = GetMapPackageName_Internal(MapName, PackageName) ? LoadWorld_Internal(PackageName) : nullptr;
+        if (!World)
+        {
+            UE_LOG(LogShapesVisualizerBakeCommandlet, Error, TEXT("Failed to load map %s"), *MapName);
+            Result = 1;
+            continue;
+        }
+
+        // Mesh assets are found again by name after the garbage collection of the previous map
+        FShapesVisualizerBaker Baker{ OutputPath, KeepSources };
+        const int32 NumBaked = Baker.BakeWorld(World);
+        UE_LOG(LogShapesVisualizerBakeCommandlet, Display, TEXT("%s: %d visualizers baked"), *PackageName, NumBaked);
+
+        if (Baker.GetDirtyPackages().Num() > 0 && !UEditorLoadingAndSavingUtils::SavePackages(Baker.GetDirtyPackages(), false))
+        {
+            UE_LOG(LogShapesVisualizerBakeCommandlet, Error, TEXT("Failed to save the packages of %s"), *PackageName);
+            Result = 1;
+        }
+        UnloadWorld_Internal(World);
+    }
+    return Result;
+}
@@ -0,0 +1,375 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "ShapesVisualizerBaker.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/Level.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Materials/Material.h"
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "Runtime/Launch/Resources/Version.h"
+#if ENGINE_MAJOR_VERSION == 5
+#include "AssetRegistry/AssetRegistryModule.h"
+#else
+#include "AssetRegistryModule.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogShapesVisualizerBaker, Log, All);
+
+namespace
+{
+    // Element types of the mesh description attributes
+#if ENGINE_MAJOR_VERSION == 5
+    using FMeshVector_Internal = FVector3f;
+    using FMeshVector2D_Internal = FVector2f;
+    using FMeshVector4_Internal = FVector4f;
+#else
+    using FMeshVector_Internal = FVector;
+    using FMeshVector2D_Internal = FVector2D;
+    using FMeshVector4_Internal = FVector4;
+#endif
+
+    const FName MaterialSlotName_Internal{ TEXT("Visualizer") };
+
+    // Equal meshes of equal color share the asset whatever component they come from
+    uint32 GetMeshHash_Internal(const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color)
+    {
+        uint32 Hash = FCrc::MemCrc32(SolidMesh.Positions.GetData(), SolidMesh.Positions.Num() * sizeof(FVector));
+        Hash = FCrc::MemCrc32(SolidMesh.Indices.GetData(), SolidMesh.Indices.Num() * sizeof(uint32), Hash);
+        Hash = FCrc::MemCrc32(SolidMesh.Colors.GetData(), SolidMesh.Colors.Num() * sizeof(FColor), Hash);
+        return HashCombine(Hash, Color.DWColor());
+    }
+
+    FMeshVector4_Internal GetVertexColor_Internal(const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color, int32 Index)
+    {
+        return FMeshVector4_Internal{ FLinearColor{ SolidMesh.Colors.Num() == SolidMesh.Positions.Num() ? SolidMesh.Colors[Index] : Color } };
+    }
+
+    FMeshDescription BuildMeshDescription_Internal(const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color)
+    {
+        FMeshDescription Description;
+        FStaticMeshAttributes Attributes{ Description };
+        Attributes.Register();
+
+        auto Positions = Attributes.GetVertexPositions();
+        auto Normals = Attributes.GetVertexInstanceNormals();
+        auto Tangents = Attributes.GetVertexInstanceTangents();
+        auto BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+        auto UVs = Attributes.GetVertexInstanceUVs();
+        auto Colors = Attributes.GetVertexInstanceColors();
+
+        const int32 NumVertices = SolidMesh.Positions.Num();
+        Description.ReserveNewVertices(NumVertices);
+        Description.ReserveNewVertexInstances(NumVertices);
+        Description.ReserveNewTriangles(SolidMesh.Indices.Num() / 3);
+
+        // The vertices of the tessellation are already split along the hard edges, so every vertex has one instance.
+        // Grids bring the colors of their cells, other meshes are of the component color
+        TArray<FVertexInstanceID> Instances;
+        Instances.SetNumUninitialized(NumVertices);
+        for (int32 Index = 0; Index < NumVertices; Index++)
+        {
+            const FVertexID VertexID = Description.CreateVertex();
+            Positions[VertexID] = FMeshVector_Internal{ SolidMesh.Positions[Index] };
+
+            const FVertexInstanceID InstanceID = Description.CreateVertexInstance(VertexID);
+            const FVector& TangentX = SolidMesh.TangentsX[Index];
+            const FVector& Normal = SolidMesh.Normals[Index];
+            Normals[InstanceID] = FMeshVector_Internal{ Normal };
+            Tangents[InstanceID] = FMeshVector_Internal{ TangentX };
+            BinormalSigns[InstanceID] = ((Normal ^ TangentX) | SolidMesh.TangentsY[Index]) < 0.f ? -1.f : 1.f;
+            UVs.Set(InstanceID, 0, FMeshVector2D_Internal{ SolidMesh.UVs[Index] });
+            Colors[InstanceID] = GetVertexColor_Internal(SolidMesh, Color, Index);
+            Instances[Index] = InstanceID;
+        }
+
+        const FPolygonGroupID GroupID = Description.CreatePolygonGroup();
+        Attributes.GetPolygonGroupMaterialSlotNames()[GroupID] = MaterialSlotName_Internal;
+        for (int32 Index = 0; Index + 2 < SolidMesh.Indices.Num(); Index += 3)
+        {
+            const FVertexInstanceID Corners[3] = {
+                Instances[SolidMesh.Indices[Index]],
+                Instances[SolidMesh.Indices[Index + 1]],
+                Instances[SolidMesh.Indices[Index + 2]] };
+            Description.CreateTriangle(GroupID, MakeArrayView(Corners));
+        }
+        return Description;
+    }
+
+    // Asset names hold only a hash of the mesh, an asset found by its name has to be the same mesh
+    bool MatchesMesh_Internal(const UStaticMesh& Mesh, const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color)
+    {
+        const FMeshDescription* const Description = Mesh.GetMeshDescription(0);
+        const int32 NumVertices = SolidMesh.Positions.Num();
+        if (!Description || Description->Vertices().Num() != NumVertices || Description->VertexInstances().Num() != NumVertices
+            || Description->Triangles().Num() != SolidMesh.Indices.Num() / 3)
+            return false;
+
+        // Built with one instance per vertex in the order of the solid mesh, see BuildMeshDescription_Internal
+        FStaticMeshConstAttributes Attributes{ *Description };
+        const auto Positions = Attributes.GetVertexPositions();
+        const auto Colors = Attributes.GetVertexInstanceColors();
+        for (int32 Index = 0; Index < NumVertices; Index++)
+        {
+            if (Positions[FVertexID{ Index }] != FMeshVector_Internal{ SolidMesh.Positions[Index] }
+                || Colors[FVertexInstanceID{ Index }] != GetVertexColor_Internal(SolidMesh, Color, Index))
+                return false;
+        }
+
+        int32 Corner = 0;
+        for (const FTriangleID TriangleID : Description->Triangles().GetElementIDs())
+        {
+            for (const FVertexInstanceID InstanceID : Description->GetTriangleVertexInstances(TriangleID))
+            {
+                if (InstanceID.GetValue() != static_cast<int32>(SolidMesh.Indices[Corner++]))
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+//
+// FShapesVisualizerBaker
+//
+
+const TCHAR* FShapesVisualizerBaker::DefaultPackagePath = TEXT("/Game/ShapesVisualizer/Baked");
+const FName FShapesVisualizerBaker::BakedTag{ TEXT("ShapesVisualizerBaked") };
+
+FShapesVisualizerBaker::FShapesVisualizerBaker(const FString& InPackagePath, bool InKeepSources)
+    : PackagePath(InPackagePath)
+    , KeepSources(InKeepSources)
+{
+}
+
+bool FShapesVisualizerBaker::CanBake(const UShapesVisualizerComponent& Component)
+{
+    switch (Component.Shape)
+    {
+    case EVisualShape::Polyline:
+        return false;
+    case EVisualShape::Points:
+        if (Component.GetNumPoints() == 0)
+            return false;
+        break;
+    case EVisualShape::Grid:
+        if (Component.GridCells.Num() == 0)
+            return false;
+        break;
+    }
+    // Half spheres and grids are always drawn solid, selection has no meaning once baked.
+    // Invisible visualizers are not drawn anywhere, a baked mesh would show them
+    const bool Wireframe = Component.Wireframe && Component.Shape != EVisualShape::HalfSphere && Component.Shape != EVisualShape::Grid;
+    return !Wireframe && !Component.ShowOnlyWhenSelected && Component.IsVisible();
+}
+
+int32 FShapesVisualizerBaker::BakeComponents(TArrayView<UShapesVisualizerComponent* const> Components)
+{
+    TMap<ULevel*, TArray<UShapesVisualizerComponent*>> LevelComponents;
+    for (UShapesVisualizerComponent* Component : Components)
+    {
+        if (!Component)
+            continue;
+        if (!CanBake(*Component))
+        {
+            UE_LOG(LogShapesVisualizerBaker, Warning, TEXT("%s is invisible or has no solid mesh to bake, it stays dynamic"), *Component->GetPathName());
+            continue;
+        }
+        if (ULevel* Level = Component->GetComponentLevel())
+            LevelComponents.FindOrAdd(Level).AddUnique(Component);
+    }
+
+    // The baked actor is rebuilt, so it takes the visualizers baked into the level before
+    int32 NumBaked = 0;
+    for (auto& Pair : LevelComponents)
+    {
+        TArray<UShapesVisualizerComponent*>& LevelList = Pair.Value;
+        for (AActor* Actor : Pair.Key->Actors)
+        {
+            if (!Actor)
+                continue;
+            TInlineComponentArray<UShapesVisualizerComponent*> ActorComponents{ Actor };
+            for (UShapesVisualizerComponent* Component : ActorComponents)
+            {
+                if (Component->ComponentHasTag(BakedTag) && CanBake(*Component))
+                    LevelList.AddUnique(Component);
+            }
+        }
+        if (BakeLevel(Pair.Key, LevelList))
+            NumBaked += LevelList.Num();
+    }
+    return NumBaked;
+}
+
+int32 FShapesVisualizerBaker::BakeWorld(UWorld* World)
+{
+    TArray<UShapesVisualizerComponent*> Components;
+    for (ULevel* Level : World->GetLevels())
+    {
+        if (!Level)
+            continue;
+        for (AActor* Actor : Level->Actors)
+        {
+            if (!Actor || Actor->ActorHasTag(BakedTag))
+                continue;
+            TInlineComponentArray<UShapesVisualizerComponent*> ActorComponents{ Actor };
+            for (UShapesVisualizerComponent* Component : ActorComponents)
+            {
+                // Editor only visualizers never reach cooked builds, unless they are editor only because of a bake
+                if (!Component->bIsEditorOnly || Component->ComponentHasTag(BakedTag))
+                    Components.Add(Component);
+            }
+        }
+    }
+    return BakeComponents(Components);
+}
+
+AActor* FShapesVisualizerBaker::BakeLevel(ULevel* Level, const TArray<UShapesVisualizerComponent*>& Components)
+{
+    UWorld* World = Level->OwningWorld;
+    if (!World)
+        return nullptr;
+
+    TArray<AActor*> OldActors;
+    for (AActor* Actor : Level->Actors)
+    {
+        if (Actor && Actor->ActorHasTag(BakedTag))
+            OldActors.Add(Actor);
+    }
+    for (AActor* Actor : OldActors)
+        World->EditorDestroyActor(Actor, true);
+
+    FActorSpawnParameters SpawnParameters;
+    SpawnParameters.OverrideLevel = Level;
+    AActor* BakedActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+    if (!BakedActor)
+        return nullptr;
+
+    BakedActor->SetActorLabel(BakedTag.ToString());
+    BakedActor->Tags.Add(BakedTag);
+
+    USceneComponent* Root = NewObject<USceneComponent>(BakedActor, TEXT("Root"), RF_Transactional);
+    Root->SetMobility(EComponentMobility::Static);
+    BakedActor->SetRootComponent(Root);
+    BakedActor->AddInstanceComponent(Root);
+    Root->RegisterComponent();
+
+    // Visualizers are hidden in game by default, those stay editor only views in their own instances
+    TMap<TPair<UStaticMesh*, bool>, UHierarchicalInstancedStaticMeshComponent*> Instances;
+    for (UShapesVisualizerComponent* Component : Components)
+    {
+        FTransform MeshTransform;
+        UStaticMesh* Mesh = GetMesh(*Component, MeshTransform);
+        if (!Mesh)
+            continue;
+
+        const bool HiddenInGame = Component->bHiddenInGame;
+        UHierarchicalInstancedStaticMeshComponent*& Instanced = Instances.FindOrAdd(TPair<UStaticMesh*, bool>{ Mesh, HiddenInGame });
+        if (!Instanced)
+        {
+            Instanced = NewObject<UHierarchicalInstancedStaticMeshComponent>(BakedActor, NAME_None, RF_Transactional);
+            Instanced->SetStaticMesh(Mesh);
+            Instanced->SetHiddenInGame(HiddenInGame);
+            Instanced->SetMobility(EComponentMobility::Static);
+            Instanced->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+            Instanced->SetCanEverAffectNavigation(false);
+            Instanced->SetCastShadow(false);
+            Instanced->SetupAttachment(Root);
+            BakedActor->AddInstanceComponent(Instanced);
+            Instanced->RegisterComponent();
+        }
+        // The baked actor sits at the origin, so its local space is the world space
+        Instanced->AddInstance(MeshTransform * Component->GetComponentTransform());
+
+        Component->Modify();
+        Component->ComponentTags.AddUnique(BakedTag);
+        if (!KeepSources)
+            Component->bIsEditorOnly = true;
+    }
+
+    for (auto& Pair : Instances)
+        Pair.Value->BuildTreeIfOutdated(false, true);
+
+    Level->MarkPackageDirty();
+    DirtyPackages.AddUnique(Level->GetOutermost());
+    UE_LOG(LogShapesVisualizerBaker, Log, TEXT("Baked %d visualizers into %d meshes of %s"),
+        Components.Num(), Instances.Num(), *Level->GetOutermost()->GetName());
+    return BakedActor;
+}
+
+UStaticMesh* FShapesVisualizerBaker::GetMesh(const UShapesVisualizerComponent& Component, FTransform& OutMeshTransform)
+{
+    FShapesVisualizerSolidMesh SolidMesh;
+    if (!Component.GetSolidMesh(SolidMesh))
+        return nullptr;
+
+    OutMeshTransform = FTransform{ FQuat::Identity, FVector::ZeroVector, SolidMesh.Scale };
+
+    // Colliding hashes take the next free suffix
+    const FString BaseName = FString::Printf(TEXT("SM_%s_%08X"),
+        *StaticEnum<EVisualShape>()->GetNameStringByValue(static_cast<int64>(Component.Shape)),
+        GetMeshHash_Internal(SolidMesh, Component.Color));
+    for (int32 Suffix = 0;; Suffix++)
+    {
+        const FString AssetName = Suffix == 0 ? BaseName : FString::Printf(TEXT("%s_%d"), *BaseName, Suffix);
+
+        // Assets of the previous bakes are reused
+        UStaticMesh* Mesh = Meshes.FindRef(AssetName);
+        if (!Mesh)
+        {
+            const FString PackageName = PackagePath / AssetName;
+            const FString ObjectPath = PackageName + TEXT(".") + AssetName;
+            Mesh = FindObject<UStaticMesh>(nullptr, *ObjectPath);
+            if (!Mesh && FPackageName::DoesPackageExist(PackageName))
+                Mesh = LoadObject<UStaticMesh>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+        }
+        if (!Mesh)
+        {
+            Mesh = CreateMesh(AssetName, SolidMesh, Component.Color);
+            Meshes.Add(AssetName, Mesh);
+            return Mesh;
+        }
+
+        if (MatchesMesh_Internal(*Mesh, SolidMesh, Component.Color))
+        {
+            Meshes.Add(AssetName, Mesh);
+            return Mesh;
+        }
+        UE_LOG(LogShapesVisualizerBaker, Log, TEXT("%s holds another mesh of the same hash as %s"), *AssetName, *Component.GetPathName());
+    }
+}
+
+UStaticMesh* FShapesVisualizerBaker::CreateMesh(const FString& AssetName, const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color)
+{
+    UPackage* Package = CreatePackage(*(PackagePath / AssetName));
+    UStaticMesh* Mesh = NewObject<UStaticMesh>(Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+
+    // The tessellation has its own normals and tangents, and the shapes need no lightmaps
+    FStaticMeshSourceModel& SourceModel = Mesh->AddSourceModel();
+    SourceModel.BuildSettings.bRecomputeNormals = false;
+    SourceModel.BuildSettings.bRecomputeTangents = false;
+    SourceModel.BuildSettings.bGenerateLightmapUVs = false;
+    Mesh->CreateMeshDescription(0, BuildMeshDescription_Internal(SolidMesh, Color));
+    Mesh->CommitMeshDescription(0);
+
+    // The color is in the vertices, as the proxy colors the debug material
+    UMaterialInterface* Material = GEngine ? GEngine->VertexColorMaterial : nullptr;
+#if ENGINE_MAJOR_VERSION == 5
+    Mesh->GetStaticMaterials().Add(FStaticMaterial{ Material, MaterialSlotName_Internal, MaterialSlotName_Internal });
+#else
+    Mesh->StaticMaterials.Add(FStaticMaterial{ Material, MaterialSlotName_Internal, MaterialSlotName_Internal });
+#endif
+
+    Mesh->Build(true);
+    Mesh->PostEditChange();
+    Mesh->MarkPackageDirty();
+    FAssetRegistryModule::AssetCreated(Mesh);
+    DirtyPackages.AddUnique(Package);
+    return Mesh;
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class ULevel;
+class UPackage;
+class UStaticMesh;
+class UWorld;
+class UShapesVisualizerComponent;
+struct FShapesVisualizerSolidMesh;
+
+//
+// FShapesVisualizerBaker - visualizers baked into static mesh assets and one instanced actor per level
+//
+// Every solid visualizer becomes an instance of a vertex colored static mesh asset built from its own
+// tessellation, equal shapes share one asset and unit shapes are sized by the instance transform.
+// Grids keep the colors of their cells. Assets are named by a hash of the mesh and checked against it.
+// The baked actor of a level holds one hierarchical instanced static mesh per asset and hidden in game
+// state, so cooked builds draw the visible ones through the static, instanced and culled path. It is
+// rebuilt from all the visualizers baked into the level so far, baking again replaces it. The baked
+// visualizers become editor only unless KeepSources, wireframes, polylines and invisible visualizers
+// are left as they are.
+//
+
+class FShapesVisualizerBaker
+{
+public:
+
+    static const TCHAR* DefaultPackagePath;
+    // Tag of the baked actors and of the visualizers baked into them
+    static const FName BakedTag;
+
+    explicit FShapesVisualizerBaker(const FString& InPackagePath = DefaultPackagePath, bool InKeepSources = false);
+
+    static bool CanBake(const UShapesVisualizerComponent& Component);
+
+    // Visualizers of any levels, returns the number of baked ones
+    int32 BakeComponents(TArrayView<UShapesVisualizerComponent* const> Components);
+    // All visualizers of the loaded levels of the world
+    int32 BakeWorld(UWorld* World);
+
+    // Levels and mesh assets changed by the bakes, left for the caller to save
+    const TArray<UPackage*>& GetDirtyPackages() const { return DirtyPackages; }
+
+private:
+
+    AActor* BakeLevel(ULevel* Level, const TArray<UShapesVisualizerComponent*>& Components);
+    // Shared asset of the component and the transform of the mesh within the component
+    UStaticMesh* GetMesh(const UShapesVisualizerComponent& Component, FTransform& OutMeshTransform);
+    UStaticMesh* CreateMesh(const FString& AssetName, const FShapesVisualizerSolidMesh& SolidMesh, const FColor& Color);
+
+private:
+
+    FString PackagePath;
+    bool KeepSources;
+    TMap<FString, UStaticMesh*> Meshes;
+    TArray<UPackage*> DirtyPackages;
+};
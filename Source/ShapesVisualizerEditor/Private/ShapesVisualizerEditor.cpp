@@ -0,0 +1,108 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+#include "LevelEditor.h"
+#include "ScopedTransaction.h"
+#include "Framework/MultiBox/MultiBoxBuilder.h"
+#include "Framework/MultiBox/MultiBoxExtender.h"
+#include "GameFramework/Actor.h"
+#include "Components/ShapesVisualizerComponent.h"
+#include "ShapesVisualizerBaker.h"
+
+#define LOCTEXT_NAMESPACE "ShapesVisualizerEditor"
+
+namespace
+{
+    TArray<TWeakObjectPtr<UShapesVisualizerComponent>> GetBakeableComponents_Internal(const TArray<AActor*>& Actors)
+    {
+        TArray<TWeakObjectPtr<UShapesVisualizerComponent>> Result;
+        for (AActor* Actor : Actors)
+        {
+            if (!Actor)
+                continue;
+            TInlineComponentArray<UShapesVisualizerComponent*> Components{ Actor };
+            for (UShapesVisualizerComponent* Component : Components)
+            {
+                if (FShapesVisualizerBaker::CanBake(*Component))
+                    Result.Add(Component);
+            }
+        }
+        return Result;
+    }
+
+    void BakeComponents_Internal(TArray<TWeakObjectPtr<UShapesVisualizerComponent>> WeakComponents)
+    {
+        TArray<UShapesVisualizerComponent*> Components;
+        for (const TWeakObjectPtr<UShapesVisualizerComponent>& Component : WeakComponents)
+        {
+            if (Component.IsValid())
+                Components.Add(Component.Get());
+        }
+
+        // The new mesh assets are left dirty for the user to save with the levels
+        const FScopedTransaction Transaction{ LOCTEXT("BakeTransaction", "Bake Shapes Visualizers") };
+        FShapesVisualizerBaker Baker;
+        Baker.BakeComponents(Components);
+    }
+
+    TSharedRef<FExtender> ExtendActorMenu_Internal(const TSharedRef<FUICommandList> CommandList, const TArray<AActor*> Actors)
+    {
+        TSharedRef<FExtender> Extender = MakeShared<FExtender>();
+        TArray<TWeakObjectPtr<UShapesVisualizerComponent>> Components = GetBakeableComponents_Internal(Actors);
+        if (Components.Num() == 0)
+            return Extender;
+
+        Extender->AddMenuExtension("ActorControl", EExtensionHook::After, CommandList,
+            FMenuExtensionDelegate::CreateLambda([Components](FMenuBuilder& MenuBuilder)
+            {
+                MenuBuilder.AddMenuEntry(
+                    LOCTEXT("BakeLabel", "Bake Shapes Visualizers"),
+                    LOCTEXT("BakeTooltip", "Bakes the solid visualizers of the selected actors into static mesh assets "
+                        "and one instanced static mesh actor per level. The baked visualizers become editor only."),
+                    FSlateIcon{},
+                    FUIAction{ FExecuteAction::CreateLambda([Components]() { BakeComponents_Internal(Components); }) });
+            }));
+        return Extender;
+    }
+}
+
+//
+// FShapesVisualizerEditorModule
+//
+
+class FShapesVisualizerEditorModule : public IModuleInterface
+{
+public:
+
+    virtual void StartupModule() override
+    {
+        // The bake commandlet runs without the level editor
+        if (IsRunningCommandlet())
+            return;
+
+        FLevelEditorModule& LevelEditor = FModuleManager::LoadModuleChecked<FLevelEditorModule>("LevelEditor");
+        auto& Extenders = LevelEditor.GetAllLevelViewportContextMenuExtenders();
+        Extenders.Add(FLevelEditorModule::FLevelViewportMenuExtender_SelectedActors::CreateStatic(&ExtendActorMenu_Internal));
+        MenuExtenderHandle = Extenders.Last().GetHandle();
+    }
+
+    virtual void ShutdownModule() override
+    {
+        if (FLevelEditorModule* LevelEditor = FModuleManager::GetModulePtr<FLevelEditorModule>("LevelEditor"))
+        {
+            LevelEditor->GetAllLevelViewportContextMenuExtenders().RemoveAll(
+                [this](const FLevelEditorModule::FLevelViewportMenuExtender_SelectedActors& Delegate)
+                {
+                    return Delegate.GetHandle() == MenuExtenderHandle;
+                });
+        }
+    }
+
+private:
+
+    FDelegateHandle MenuExtenderHandle;
+};
+
+IMPLEMENT_MODULE(FShapesVisualizerEditorModule, ShapesVisualizerEditor)
+
+#undef LOCTEXT_NAMESPACE
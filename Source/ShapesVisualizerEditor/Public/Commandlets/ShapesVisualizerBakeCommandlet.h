@@ -0,0 +1,31 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ShapesVisualizerBakeCommandlet.generated.h"
+
+//
+// UShapesVisualizerBakeCommandlet - bakes the visualizers of maps without the editor UI
+//
+// UnrealEditor-Cmd <Project> -run=ShapesVisualizerBake -Maps=/Game/Maps/A+/Game/Maps/B
+//     [-Output=/Game/ShapesVisualizer/Baked] [-KeepSources] -unattended -nullrhi
+//
+// Every map gets its baked actor, then the maps and the mesh assets are saved. Streamed levels are
+// maps of their own and are baked when listed. Returns 0 on success, 1 on bad arguments, maps that
+// failed to load or unsaved packages.
+//
+
+UCLASS()
+class UShapesVisualizerBakeCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+
+    UShapesVisualizerBakeCommandlet();
+
+    // UCommandlet Interface
+
+    virtual int32 Main(const FString& Params) override;
+};
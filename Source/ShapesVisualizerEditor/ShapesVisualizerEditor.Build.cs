@@ -0,0 +1,15 @@
+// Copyright (c) 2003-2022 rionix. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ShapesVisualizerEditor : ModuleRules
+{
+	public ShapesVisualizerEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "UnrealEd", "LevelEditor", "Slate", "SlateCore",
+			"AssetRegistry", "MeshDescription", "StaticMeshDescription", "ShapesVisualizer" });
+	}
+}